@@ -20,6 +20,7 @@ class map(ConanFile):
         self.requires("grpc/1.50.1")
         self.requires("rapidjson/cci.20220822")
         self.test_requires("gtest/cci.20210126")
+        self.test_requires("benchmark/1.8.3")
 
     def layout(self):
         cmake_layout(self)
@@ -30,9 +31,13 @@ class map(ConanFile):
         if self.settings.build_type == "Debug":
             tc.cache_variables["BUILD_TESTING"] = True
             tc.cache_variables["ADD_CWS_MAP"] = True
+            tc.cache_variables["ADD_CWS_MAP_RUN"] = True
             tc.cache_variables["ADD_PROTO"] = True
             tc.cache_variables["ADD_GRPC_SERVER"] = True
 
+        if self.settings.build_type == "Release":
+            tc.cache_variables["BUILD_BENCHMARKS"] = True
+
         tc.generate()
 
     def build(self):
@@ -0,0 +1,402 @@
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <sstream>
+
+#include "cws/profiler.hpp"
+#include "cws/scenario/scenario.hpp"
+#include "cws/simulation/building.hpp"
+#include "cws/simulation/checkpoint.hpp"
+#include "cws/simulation/journal.hpp"
+#include "cws/simulation/partition.hpp"
+#include "cws/simulation/snapshot.hpp"
+#include "output.hpp"
+#include "stats.hpp"
+
+struct RunOptions {
+  std::optional<std::string> scenarioPath;
+  std::optional<std::size_t> ticks;
+  std::optional<std::filesystem::path> outputDir;
+  std::list<OutputLayer> outputLayers;
+  std::size_t outputEvery = 1;
+  std::optional<std::filesystem::path> tracePath;
+  std::optional<std::filesystem::path> savePath;
+  std::optional<PartitionOptions> partitions;
+  AirStepping airStepping;
+  AirSleeping airSleeping;
+
+  // replay, map is taken from snapshot or checkpoint instead of scenario
+  std::optional<std::string> journalPath;
+  std::optional<std::string> snapshotPath;
+  std::size_t fromTick = 0;
+  std::optional<std::string> checkpointDir;
+  std::optional<std::size_t> toTick;
+};
+
+void printUsage(const char * program) {
+  std::cout << "Usage: " << program << " <scenario> [options]" << std::endl
+            << "       " << program
+            << " --journal <file> (--snapshot <file> [--from <tick>] | "
+               "--checkpoint-dir <dir>) [--to <tick>] [options]"
+            << std::endl
+            << "  --ticks <n>          count of ticks, overrides scenario" << std::endl
+            << "  --output <dir>       directory to write layers to" << std::endl
+            << "  --layers <a,b,...>   layers to write: air_temperature, "
+               "illumination, light_obstruction, air_obstruction, subject_count"
+            << std::endl
+            << "  --every <k>          write layers every k ticks" << std::endl
+            << "  --trace <file>       write stage timings of last ticks as chrome "
+               "trace"
+            << std::endl
+            << "  --save-snapshot <f>  write snapshot of map after last tick"
+            << std::endl
+            << "  --air-substeps <n>   adaptive air step, at most n sub-steps a tick"
+            << std::endl
+            << "  --air-sleep <size>   tiles of air at equilibrium sleep" << std::endl
+            << "  --partitions <c>x<r> compute map by c*r worker processes"
+            << std::endl
+            << "  --journal <file>     replay queries of journal" << std::endl
+            << "  --snapshot <file>    map to replay from, published at --from tick"
+            << std::endl
+            << "  --checkpoint-dir <d> replay from newest checkpoint not after --to"
+            << std::endl
+            << "  --to <tick>          tick to replay to, end of journal by default"
+            << std::endl;
+}
+
+PartitionOptions parsePartitions(const std::string & value) {
+  PartitionOptions partitions;
+  char separator = 0;
+  std::istringstream in(value);
+  in >> partitions.columns >> separator >> partitions.rows;
+  if (!in || separator != 'x' || !in.eof()) {
+    throw std::invalid_argument("Bad partitions: " + value);
+  }
+  return partitions;
+}
+
+std::list<OutputLayer> parseLayers(const std::string & value) {
+  std::list<OutputLayer> layers;
+  std::istringstream in(value);
+  std::string name;
+  while (std::getline(in, name, ',')) {
+    auto layer = fromOutputLayerName(name);
+    if (!layer) {
+      throw std::invalid_argument("Unknown layer: " + name);
+    }
+    layers.push_back(*layer);
+  }
+  return layers;
+}
+
+RunOptions parseOptions(int argc, char * argv[]) {
+  if (argc < 2) {
+    throw std::invalid_argument("Scenario file is not specified.");
+  }
+
+  RunOptions options;
+  int first = 1;
+  if (!std::string(argv[1]).starts_with("--")) {
+    options.scenarioPath = argv[1];
+    first = 2;
+  }
+
+  for (int i = first; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) {
+      throw std::invalid_argument("Missing value for " + arg);
+    }
+    std::string value = argv[++i];
+
+    if (arg == "--ticks") {
+      options.ticks = std::stoul(value);
+    } else if (arg == "--output") {
+      options.outputDir = value;
+    } else if (arg == "--layers") {
+      options.outputLayers = parseLayers(value);
+    } else if (arg == "--every") {
+      options.outputEvery = std::max(std::stoul(value), 1ul);
+    } else if (arg == "--trace") {
+      options.tracePath = value;
+    } else if (arg == "--save-snapshot") {
+      options.savePath = value;
+    } else if (arg == "--air-substeps") {
+      options.airStepping.adaptive = true;
+      options.airStepping.maxSubsteps = std::max(std::stoi(value), 1);
+    } else if (arg == "--air-sleep") {
+      options.airSleeping.enabled = true;
+      options.airSleeping.tileSize = std::stoi(value);
+    } else if (arg == "--partitions") {
+      options.partitions = parsePartitions(value);
+    } else if (arg == "--journal") {
+      options.journalPath = value;
+    } else if (arg == "--snapshot") {
+      options.snapshotPath = value;
+    } else if (arg == "--from") {
+      options.fromTick = std::stoul(value);
+    } else if (arg == "--checkpoint-dir") {
+      options.checkpointDir = value;
+    } else if (arg == "--to") {
+      options.toTick = std::stoul(value);
+    } else {
+      throw std::invalid_argument("Unknown option: " + arg);
+    }
+  }
+
+  if (options.scenarioPath.has_value() == options.journalPath.has_value()) {
+    throw std::invalid_argument("Either scenario or journal should be specified.");
+  }
+  if (options.journalPath &&
+      options.snapshotPath.has_value() == options.checkpointDir.has_value()) {
+    throw std::invalid_argument("Either snapshot or checkpoint directory should be "
+                                "specified for journal.");
+  }
+
+  if (options.partitions && options.journalPath) {
+    throw std::invalid_argument("Partitions are supported for scenario only.");
+  }
+  // partitions would choose steps on their own
+  if (options.partitions && options.airStepping.adaptive) {
+    throw std::invalid_argument("Adaptive air step isn't supported with partitions.");
+  }
+  if (options.partitions && options.airSleeping.enabled) {
+    throw std::invalid_argument("Air sleeping isn't supported with partitions.");
+  }
+
+  if (options.outputDir && options.outputLayers.empty()) {
+    options.outputLayers = {OutputLayer::AIR_TEMPERATURE, OutputLayer::ILLUMINATION};
+  }
+
+  return options;
+}
+
+Scenario loadScenario(const std::string & path) {
+  std::ifstream in(path);
+  if (!in) {
+    throw std::invalid_argument("Can't open scenario: " + path);
+  }
+  return readScenario(in);
+}
+
+/*
+ * Map to start from with its tick: empty one of scenario or the one journal is
+ * replayed from
+ */
+struct Start final {
+  std::unique_ptr<SimulationMap> map;
+  std::size_t tick = 0;
+};
+
+Start loadStart(const RunOptions & options, const Scenario * scenario,
+                const JournalReplay * journal) {
+  if (scenario) {
+    return Start{std::make_unique<SimulationMap>(scenario->getDimension()), 0};
+  }
+
+  if (options.snapshotPath) {
+    return Start{loadSnapshot(*options.snapshotPath), options.fromTick};
+  }
+
+  auto toTick = options.toTick.value_or(journal->getEndTick());
+  auto restored = Checkpointer::restore(*options.checkpointDir, toTick);
+  if (!restored.map) {
+    throw std::runtime_error("No checkpoint to replay from in " +
+                             *options.checkpointDir);
+  }
+  return Start{std::move(restored.map), restored.tick};
+}
+
+/*
+ * Floors of scenario are computed in parallel as one building, layers of floor k are
+ * written to floor-k subdirectory of output. Stats and trace count each floor as a
+ * map of its own
+ */
+int runBuilding(const RunOptions & options, const Scenario & scenario) {
+  if (options.partitions) {
+    throw std::invalid_argument("Partitions aren't supported for several floors.");
+  }
+  if (options.savePath) {
+    throw std::invalid_argument("Snapshot isn't supported for several floors.");
+  }
+
+  std::size_t endTick = options.ticks.value_or(scenario.getTicks());
+  Building curr = scenario.makeBuilding();
+  for (std::size_t k = 0; k < curr.getFloorCount(); ++k) {
+    curr.accessFloor(k).setAirStepping(options.airStepping);
+    curr.accessFloor(k).setAirSleeping(options.airSleeping);
+    if (options.outputDir) {
+      std::filesystem::create_directories(*options.outputDir /
+                                          ("floor-" + std::to_string(k)));
+    }
+  }
+  Building next(curr);
+
+  StageStats stats;
+  TickProfiler profiler;
+  std::vector<MapStageTimes> times;
+
+  for (std::size_t tick = 0; tick < endTick; ++tick) {
+    scenario.apply(next, tick);
+    next.next(curr, 0, &times);
+
+    for (std::size_t k = 0; k < times.size(); ++k) {
+      stats.add(times[k]);
+      profiler.record(tick, times[k]);
+    }
+
+    if (options.outputDir && tick % options.outputEvery == 0) {
+      for (std::size_t k = 0; k < next.getFloorCount(); ++k) {
+        auto dir = *options.outputDir / ("floor-" + std::to_string(k));
+        for (auto layer : options.outputLayers) {
+          writeLayer(dir, next.getFloor(k), layer, tick);
+        }
+      }
+    }
+
+    curr = next;
+  }
+
+  Dimension dim = scenario.getDimension();
+  std::cout << "map: " << dim.width << "x" << dim.height
+            << ", floors: " << curr.getFloorCount()
+            << ", portals: " << curr.getPortals().size() << ", ticks: " << endTick
+            << std::endl
+            << stats;
+
+  if (options.tracePath) {
+    std::ofstream trace(*options.tracePath);
+    if (!trace) {
+      throw std::runtime_error("Can't open trace file: " + options.tracePath->string());
+    }
+    profiler.writeChromeTrace(trace);
+  }
+
+  return 0;
+}
+
+/*
+ * Same order as SimulationMaster does but without threads and tick rate: queries are
+ * applied to next map, next map is computed from current one and then copied.
+ * Queries are taken from scenario or journal.
+ *
+ * Partitioned map is computed by workers instead, events are passed to partitions
+ * they touch. Map is gathered from workers only to write layers or to be saved
+ */
+int run(const RunOptions & options) {
+  std::optional<Scenario> scenario;
+  std::unique_ptr<JournalReplay> journal;
+  if (options.scenarioPath) {
+    scenario = loadScenario(*options.scenarioPath);
+    if (scenario->getFloorCount() > 1) {
+      return runBuilding(options, *scenario);
+    }
+  } else {
+    journal = std::make_unique<JournalReplay>(*options.journalPath);
+  }
+
+  auto [map, startTick] = loadStart(options, scenario ? &*scenario : nullptr,
+                                    journal.get());
+  std::size_t endTick =
+      scenario ? options.ticks.value_or(scenario->getTicks())
+               : options.toTick.value_or(journal->getEndTick());
+  if (journal && startTick < journal->getResetTick()) {
+    throw std::runtime_error("Map of tick " + std::to_string(startTick) +
+                             " is before reset of journal at " +
+                             std::to_string(journal->getResetTick()));
+  }
+
+  if (options.outputDir) {
+    std::filesystem::create_directories(*options.outputDir);
+  }
+
+  Dimension dim = map->getDimension();
+  // map of snapshot keeps air stepping and sleeping it was saved with unless they
+  // are set by options
+  if (options.airStepping.adaptive) {
+    map->setAirStepping(options.airStepping);
+  }
+  if (options.airSleeping.enabled) {
+    map->setAirSleeping(options.airSleeping);
+  }
+
+  StageStats stats;
+  TickProfiler profiler;
+  MapStageTimes times;
+
+  // cells are kept by partitions, map is left as target of gather if it is needed
+  std::unique_ptr<PartitionedMap> partitioned;
+  std::unique_ptr<SimulationMap> nextMap;
+  if (options.partitions) {
+    partitioned = std::make_unique<PartitionedMap>(*map, *options.partitions);
+    if (!options.outputDir && !options.savePath) {
+      map.reset();
+    }
+  } else {
+    nextMap = std::make_unique<SimulationMap>(*map);
+  }
+
+  for (std::size_t tick = startTick; tick < endTick; ++tick) {
+    bool doOutput = options.outputDir && tick % options.outputEvery == 0;
+
+    if (partitioned) {
+      scenario->apply(*partitioned, tick);
+      partitioned->next(&times);
+      if (doOutput) {
+        partitioned->gather(*map);
+      }
+    } else {
+      if (scenario) {
+        scenario->apply(*nextMap, tick);
+      } else {
+        journal->apply(*nextMap, tick);
+      }
+      nextMap->next(*map, &times);
+    }
+    stats.add(times);
+    profiler.record(tick, times);
+
+    if (doOutput) {
+      for (auto layer : options.outputLayers) {
+        writeLayer(*options.outputDir, partitioned ? *map : *nextMap, layer, tick);
+      }
+    }
+
+    if (!partitioned) {
+      *map = *nextMap;
+    }
+  }
+
+  if (partitioned && options.savePath) {
+    partitioned->gather(*map);
+  }
+
+  std::cout << "map: " << dim.width << "x" << dim.height
+            << ", ticks: " << endTick - startTick << std::endl
+            << stats;
+
+  if (options.tracePath) {
+    std::ofstream trace(*options.tracePath);
+    if (!trace) {
+      throw std::runtime_error("Can't open trace file: " + options.tracePath->string());
+    }
+    profiler.writeChromeTrace(trace);
+  }
+
+  if (options.savePath) {
+    saveSnapshot(options.savePath->string(), *map);
+  }
+
+  return 0;
+}
+
+int main(int argc, char * argv[]) {
+  try {
+    return run(parseOptions(argc, argv));
+  } catch (std::invalid_argument & e) {
+    std::cout << e.what() << std::endl;
+    printUsage(argv[0]);
+  } catch (std::exception & e) {
+    std::cout << e.what() << std::endl;
+  }
+  return 1;
+}
@@ -0,0 +1,74 @@
+#include "output.hpp"
+
+#include <fstream>
+#include <stdexcept>
+
+static const std::pair<OutputLayer, const char *> OUTPUT_LAYER_NAMES[] = {
+    {OutputLayer::AIR_TEMPERATURE, "air_temperature"},
+    {OutputLayer::ILLUMINATION, "illumination"},
+    {OutputLayer::LIGHT_OBSTRUCTION, "light_obstruction"},
+    {OutputLayer::AIR_OBSTRUCTION, "air_obstruction"},
+    {OutputLayer::SUBJECT_COUNT, "subject_count"},
+};
+
+std::optional<OutputLayer> fromOutputLayerName(const std::string & name) {
+  for (const auto & [layer, layerName] : OUTPUT_LAYER_NAMES) {
+    if (name == layerName) {
+      return layer;
+    }
+  }
+  return std::nullopt;
+}
+
+const char * toOutputLayerName(OutputLayer layer) {
+  for (const auto & [l, layerName] : OUTPUT_LAYER_NAMES) {
+    if (l == layer) {
+      return layerName;
+    }
+  }
+  return "unknown";
+}
+
+static double getCellValue(const Layers & layers, OutputLayer layer, Coordinates c) {
+  switch (layer) {
+  case OutputLayer::AIR_TEMPERATURE: {
+    const auto & container = layers.airLayer.getAirContainer(c);
+    return container.empty() ? 0 : container.getTemperature().get();
+  }
+  case OutputLayer::ILLUMINATION:
+    return layers.illuminationLayer.getIllumination(c).get();
+  case OutputLayer::LIGHT_OBSTRUCTION:
+    return layers.obstructionLayer.getLightObstruction(c).get();
+  case OutputLayer::AIR_OBSTRUCTION:
+    return layers.obstructionLayer.getAirObstruction(c).get();
+  case OutputLayer::SUBJECT_COUNT:
+    return layers.subjectLayer.getSubjectList(c).size();
+  default:
+    return 0;
+  }
+}
+
+void writeLayer(const std::filesystem::path & dir, const Map & map, OutputLayer layer,
+                std::size_t tick) {
+  auto path =
+      dir / (std::string(toOutputLayerName(layer)) + "-" + std::to_string(tick) + ".tsv");
+
+  std::ofstream out(path);
+  if (!out) {
+    throw std::runtime_error("can't open " + path.string());
+  }
+
+  Dimension dim = map.getDimension();
+  const auto & layers = map.getLayers();
+
+  Coordinates c;
+  for (c.y = 0; c.y < dim.height; ++c.y) {
+    for (c.x = 0; c.x < dim.width; ++c.x) {
+      if (c.x != 0) {
+        out << '\t';
+      }
+      out << getCellValue(layers, layer, c);
+    }
+    out << '\n';
+  }
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string>
+
+#include "cws/map.hpp"
+
+enum class OutputLayer {
+  AIR_TEMPERATURE = 0,
+  ILLUMINATION = 1,
+  LIGHT_OBSTRUCTION = 2,
+  AIR_OBSTRUCTION = 3,
+  SUBJECT_COUNT = 4,
+};
+
+std::optional<OutputLayer> fromOutputLayerName(const std::string & name);
+const char * toOutputLayerName(OutputLayer layer);
+
+// writes layer as tab separated grid: row per y, column per x
+void writeLayer(const std::filesystem::path & dir, const Map & map, OutputLayer layer,
+                std::size_t tick);
@@ -0,0 +1,70 @@
+#include "stats.hpp"
+
+#include <iomanip>
+
+static void addStat(auto & stat, std::chrono::nanoseconds duration) {
+  stat.total += duration;
+  stat.min = std::min(stat.min, duration);
+  stat.max = std::max(stat.max, duration);
+}
+
+void StageStats::add(const MapStageTimes & times) {
+  for (std::size_t i = 0; i < MAP_STAGE_COUNT; ++i) {
+    addStat(stages_[i], times.duration[i]);
+  }
+  addStat(tick_, times.getTotal());
+  ++ticks_;
+
+  airSubsteps_ += times.airSubsteps;
+  maxAirSubsteps_ = std::max(maxAirSubsteps_, times.airSubsteps);
+  if (times.airSubsteps == 0) {
+    ++airSkipped_;
+  }
+  activeAirTiles_ += times.activeAirTiles;
+  sleepingAirTiles_ += times.sleepingAirTiles;
+}
+
+static void printStat(std::ostream & out, const char * name, const auto & stat,
+                      std::size_t ticks, std::chrono::nanoseconds total) {
+  using ms = std::chrono::duration<double, std::milli>;
+
+  double mean = ms(stat.total).count() / ticks;
+  double share = total.count() ? 100. * stat.total.count() / total.count() : 0;
+
+  out << std::left << std::setw(22) << name << std::right << std::fixed
+      << std::setprecision(3) << std::setw(12) << ms(stat.total).count()
+      << std::setw(12) << mean << std::setw(12) << ms(stat.min).count()
+      << std::setw(12) << ms(stat.max).count() << std::setprecision(1)
+      << std::setw(8) << share << '\n';
+}
+
+std::ostream & operator<<(std::ostream & out, const StageStats & stats) {
+  if (stats.ticks_ == 0) {
+    return out << "no ticks processed\n";
+  }
+
+  out << std::left << std::setw(22) << "stage" << std::right << std::setw(12)
+      << "total, ms" << std::setw(12) << "mean, ms" << std::setw(12) << "min, ms"
+      << std::setw(12) << "max, ms" << std::setw(8) << "%" << '\n';
+
+  for (std::size_t i = 0; i < MAP_STAGE_COUNT; ++i) {
+    printStat(out, toString(static_cast<MapStage>(i)), stats.stages_[i], stats.ticks_,
+              stats.tick_.total);
+  }
+  printStat(out, "tick", stats.tick_, stats.ticks_, stats.tick_.total);
+
+  // fixed air step is one sub-step every tick
+  if (stats.maxAirSubsteps_ > 1 || stats.airSkipped_ > 0) {
+    out << "air sub-steps: " << std::setprecision(2)
+        << static_cast<double>(stats.airSubsteps_) / stats.ticks_ << " per tick, max "
+        << stats.maxAirSubsteps_ << ", skipped ticks " << stats.airSkipped_ << '\n';
+  }
+  if (stats.activeAirTiles_ + stats.sleepingAirTiles_ > 0) {
+    out << "air tiles per tick: " << std::setprecision(1)
+        << static_cast<double>(stats.activeAirTiles_) / stats.ticks_ << " active, "
+        << static_cast<double>(stats.sleepingAirTiles_) / stats.ticks_ << " sleeping"
+        << '\n';
+  }
+
+  return out;
+}
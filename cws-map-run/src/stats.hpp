@@ -0,0 +1,33 @@
+#pragma once
+
+#include <ostream>
+
+#include "cws/map_stage.hpp"
+
+/*
+ * Accumulates stage timings over all ticks of the run
+ */
+class StageStats final {
+  struct Stat {
+    std::chrono::nanoseconds total{0};
+    std::chrono::nanoseconds min = std::chrono::nanoseconds::max();
+    std::chrono::nanoseconds max{0};
+  };
+
+  std::array<Stat, MAP_STAGE_COUNT> stages_;
+  Stat tick_;
+  std::size_t ticks_ = 0;
+
+  std::size_t airSubsteps_ = 0;
+  int maxAirSubsteps_ = 0;
+  std::size_t airSkipped_ = 0;// ticks at equilibrium
+  std::size_t activeAirTiles_ = 0;// sums over ticks
+  std::size_t sleepingAirTiles_ = 0;
+
+public:
+  void add(const MapStageTimes & times);
+
+  std::size_t getTicks() const { return ticks_; }
+
+  friend std::ostream & operator<<(std::ostream & out, const StageStats & stats);
+};
@@ -0,0 +1,56 @@
+#include <benchmark/benchmark.h>
+
+#include "cws/air/container.hpp"
+
+static std::unique_ptr<Air::Plain> makeAir(int idx) {
+  return std::make_unique<Air::Plain>(Physical(1, 1000, Temperature{20.0 + idx % 5}),
+                                      idx, 0.3);
+}
+
+static Air::Container makeContainer(int count) {
+  Air::Container container;
+  for (int i = 0; i < count; ++i) {
+    container.add(makeAir(i));
+  }
+  return container;
+}
+
+static void BM_AirContainerAdd(benchmark::State & state) {
+  for (auto _ : state) {
+    Air::Container container;
+    for (int i = 0; i < state.range(0); ++i) {
+      container.add(makeAir(i));
+    }
+    benchmark::DoNotOptimize(container);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_AirContainerAdd)->RangeMultiplier(4)->Range(1, 64);
+
+static void BM_AirContainerFind(benchmark::State & state) {
+  Air::Container container = makeContainer(state.range(0));
+  // new air is inserted at front, so the first one is the farthest
+  Air::Plain first(Physical(), 0, 0);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(container.findOrNull(first));
+  }
+}
+BENCHMARK(BM_AirContainerFind)->RangeMultiplier(4)->Range(1, 64);
+
+static void BM_AirContainerUpdateTemperature(benchmark::State & state) {
+  Air::Container container = makeContainer(state.range(0));
+  for (auto _ : state) {
+    container.updateTemperature(1);
+    benchmark::DoNotOptimize(container.getTemperature());
+  }
+}
+BENCHMARK(BM_AirContainerUpdateTemperature)->RangeMultiplier(4)->Range(1, 64);
+
+static void BM_AirContainerCopy(benchmark::State & state) {
+  Air::Container container = makeContainer(state.range(0));
+  for (auto _ : state) {
+    Air::Container copy(container);
+    benchmark::DoNotOptimize(copy);
+  }
+}
+BENCHMARK(BM_AirContainerCopy)->RangeMultiplier(4)->Range(1, 64);
@@ -0,0 +1,45 @@
+#include "fixture.hpp"
+
+#include "cws/subject/camera.hpp"
+
+/*
+ * Visibility search of camera placed in the middle of the map
+ */
+template<typename Camera>
+static void BM_CameraVisibleSubjects(benchmark::State & state) {
+  Layers layers = getBenchMap(state).getLayers();
+  layers.obstructionLayer.updateLightObstruction(layers.subjectLayer);
+  layers.illuminationLayer.updateIllumination(layers.obstructionLayer,
+                                              layers.subjectLayer);
+
+  Coordinates center{static_cast<int>(state.range(0) / 2),
+                     static_cast<int>(state.range(0) / 2)};
+  Subject::Plain plain(Physical(), -1, 0, Obstruction{});
+
+  Camera * camera;
+  if constexpr (std::is_same_v<Camera, Subject::LightCamera>) {
+    camera = new Camera(std::move(plain), state.range(2), 1, 0);
+  } else {
+    camera = new Camera(std::move(plain), state.range(2), 1);
+  }
+  layers.subjectLayer.accessSubjectList(center).emplace_back(camera);
+  layers.subjectLayer.setupSubjects(layers.airLayer, layers.obstructionLayer,
+                                    layers.illuminationLayer);
+
+  std::size_t visible = 0;
+  for (auto _ : state) {
+    visible = camera->getVisibleSubjects().size();
+  }
+  state.counters["visible"] = visible;
+  setCellsProcessed(state);
+}
+
+// third argument is camera power, search stops when residual power is below 1
+static void applyCameraArgs(benchmark::internal::Benchmark * bench) {
+  bench->ArgNames({"size", "density", "power"})
+      ->ArgsProduct({benchmark::CreateRange(64, 4096, 4), {1, 10, 50}, {100, 10000}})
+      ->Unit(benchmark::kMillisecond);
+}
+
+BENCHMARK(BM_CameraVisibleSubjects<Subject::InfraredCamera>)->Apply(applyCameraArgs);
+BENCHMARK(BM_CameraVisibleSubjects<Subject::LightCamera>)->Apply(applyCameraArgs);
@@ -0,0 +1,57 @@
+#include "fixture.hpp"
+
+#include "cws/scenario/generator.hpp"
+#include "cws/subject/network.hpp"
+
+using namespace Subject;
+
+static SimulationMap makeBenchMap(int size, int density) {
+  SimulationMap map({size, size});
+  generateFloor(map, FloorParams{.density = density / 100.0});
+  return map;
+}
+
+// only the last map is kept, large ones take gigabytes
+const SimulationMap & getBenchMap(int size, int density) {
+  static std::pair<int, int> key{-1, -1};
+  static std::unique_ptr<SimulationMap> map;
+
+  if (!map || key != std::make_pair(size, density)) {
+    map.reset();
+    map = std::make_unique<SimulationMap>(makeBenchMap(size, density));
+    key = {size, density};
+  }
+  return *map;
+}
+
+const SimulationMap & getBenchMap(const benchmark::State & state) {
+  return getBenchMap(state.range(0), state.range(1));
+}
+
+void applyMapArgs(benchmark::internal::Benchmark * bench) {
+  bench->ArgNames({"size", "density"})
+      ->ArgsProduct({benchmark::CreateRange(64, 4096, 4), {1, 10, 50}})
+      ->Unit(benchmark::kMillisecond);
+}
+
+void queueBenchPackets(Layers & layers) {
+  Dimension dim = layers.subjectLayer.getDimension();
+
+  Coordinates c;
+  for (c.x = 0; c.x < dim.width; ++c.x) {
+    for (c.y = 0; c.y < dim.height; ++c.y) {
+      for (auto & sub : layers.subjectLayer.accessSubjectList(c)) {
+        if (auto device = dynamic_cast<NetworkDevice *>(sub.get())) {
+          std::list<std::unique_ptr<Network::Packet>> packets;
+          packets.push_back(
+              std::make_unique<Network::Packet>(std::vector<std::byte>(64)));
+          device->transmitPackets(std::move(packets));
+        }
+      }
+    }
+  }
+}
+
+void setCellsProcessed(benchmark::State & state) {
+  state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(0));
+}
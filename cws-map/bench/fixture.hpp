@@ -0,0 +1,20 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include "cws/simulation/simulation_map.hpp"
+
+/*
+ * Benchmarks take map size and density (percent of free cells with desks) of
+ * generated floor as arguments, maps are built once per arguments and copied.
+ */
+const SimulationMap & getBenchMap(int size, int density);
+const SimulationMap & getBenchMap(const benchmark::State & state);
+
+// size from 64 to 4096, density from sparse to dense
+void applyMapArgs(benchmark::internal::Benchmark * bench);
+
+// each wireless device gets one packet to be transmitted on next tick
+void queueBenchPackets(Layers & layers);
+
+void setCellsProcessed(benchmark::State & state);
@@ -0,0 +1,169 @@
+#include "fixture.hpp"
+
+/*
+ * Stages of Map::next in the same order, each one is measured on its own
+ */
+
+static void BM_SubjectTemperature(benchmark::State & state) {
+  Layers layers = getBenchMap(state).getLayers();
+  for (auto _ : state) {
+    layers.subjectLayer.nextTemperature();
+  }
+  setCellsProcessed(state);
+}
+BENCHMARK(BM_SubjectTemperature)->Apply(applyMapArgs);
+
+static void BM_AirConvection(benchmark::State & state) {
+  Layers layers = getBenchMap(state).getLayers();
+  for (auto _ : state) {
+    layers.airLayer.nextConvection(layers.subjectLayer);
+  }
+  setCellsProcessed(state);
+}
+BENCHMARK(BM_AirConvection)->Apply(applyMapArgs);
+
+static void BM_AirObstruction(benchmark::State & state) {
+  Layers layers = getBenchMap(state).getLayers();
+  for (auto _ : state) {
+    layers.obstructionLayer.updateAirObstruction(layers.subjectLayer);
+  }
+  setCellsProcessed(state);
+}
+BENCHMARK(BM_AirObstruction)->Apply(applyMapArgs);
+
+static void BM_AirCirculation(benchmark::State & state) {
+  Layers cur = getBenchMap(state).getLayers();
+  cur.obstructionLayer.updateAirObstruction(cur.subjectLayer);
+  Layers next = cur;
+  for (auto _ : state) {
+    next.airLayer.nextCirculation(cur.airLayer, next.obstructionLayer);
+  }
+  setCellsProcessed(state);
+}
+BENCHMARK(BM_AirCirculation)->Apply(applyMapArgs);
+
+static void BM_LightObstruction(benchmark::State & state) {
+  Layers layers = getBenchMap(state).getLayers();
+  for (auto _ : state) {
+    layers.obstructionLayer.updateLightObstruction(layers.subjectLayer);
+  }
+  setCellsProcessed(state);
+}
+BENCHMARK(BM_LightObstruction)->Apply(applyMapArgs);
+
+static void BM_Illumination(benchmark::State & state) {
+  Layers layers = getBenchMap(state).getLayers();
+  layers.obstructionLayer.updateLightObstruction(layers.subjectLayer);
+  for (auto _ : state) {
+    layers.illuminationLayer.updateIllumination(layers.obstructionLayer,
+                                                layers.subjectLayer);
+  }
+  setCellsProcessed(state);
+}
+BENCHMARK(BM_Illumination)->Apply(applyMapArgs);
+
+// devices transmit only once, so packets are queued again before each iteration
+static void BM_NetworkCollect(benchmark::State & state) {
+  Layers layers = getBenchMap(state).getLayers();
+  for (auto _ : state) {
+    state.PauseTiming();
+    layers.subjectLayer.clearNetworkBuffers();
+    queueBenchPackets(layers);
+    state.ResumeTiming();
+
+    layers.networkWireless.clearNetwork();
+    layers.networkWireless.collectTransmittableContainers(layers.subjectLayer);
+  }
+  setCellsProcessed(state);
+}
+BENCHMARK(BM_NetworkCollect)->Apply(applyMapArgs);
+
+static void BM_NetworkSpread(benchmark::State & state) {
+  Layers layers = getBenchMap(state).getLayers();
+  layers.obstructionLayer.updateLightObstruction(layers.subjectLayer);
+  for (auto _ : state) {
+    state.PauseTiming();
+    layers.subjectLayer.clearNetworkBuffers();
+    queueBenchPackets(layers);
+    layers.networkWireless.clearNetwork();
+    layers.networkWireless.collectTransmittableContainers(layers.subjectLayer);
+    state.ResumeTiming();
+
+    layers.networkWireless.updateNetwork(layers.obstructionLayer);
+  }
+  setCellsProcessed(state);
+}
+BENCHMARK(BM_NetworkSpread)->Apply(applyMapArgs);
+
+static void BM_NetworkReceive(benchmark::State & state) {
+  Layers layers = getBenchMap(state).getLayers();
+  queueBenchPackets(layers);
+  layers.networkWireless.collectTransmittableContainers(layers.subjectLayer);
+  layers.networkWireless.updateNetwork(layers.obstructionLayer);
+  for (auto _ : state) {
+    layers.subjectLayer.clearNetworkBuffers();
+    layers.subjectLayer.receiveContainers(layers.networkWireless);
+  }
+  setCellsProcessed(state);
+}
+BENCHMARK(BM_NetworkReceive)->Apply(applyMapArgs);
+
+static void BM_SubjectSetup(benchmark::State & state) {
+  Layers layers = getBenchMap(state).getLayers();
+  for (auto _ : state) {
+    layers.subjectLayer.setupSubjects(layers.airLayer, layers.obstructionLayer,
+                                      layers.illuminationLayer);
+  }
+  setCellsProcessed(state);
+}
+BENCHMARK(BM_SubjectSetup)->Apply(applyMapArgs);
+
+static void BM_MapNext(benchmark::State & state) {
+  SimulationMap cur = getBenchMap(state);
+  SimulationMap next = cur;
+  MapStageTimes times;
+  for (auto _ : state) {
+    next.next(cur, &times);
+  }
+  setCellsProcessed(state);
+}
+BENCHMARK(BM_MapNext)->Apply(applyMapArgs);
+
+static Layers makeSteppingLayers(int size, bool idle) {
+  if (!idle) {
+    return getBenchMap(size, 10).getLayers();
+  }
+  Dimension dim{size, size};
+  Layers layers = SimulationMap(dim).getLayers();
+  layers.airLayer.fill(getCellSpans(CellRegion{{0, 0}, dim}, dim),
+                       Air::Plain(Physical(1.2, 1005, Temperature{20}), 0, 0.3));
+  return layers;
+}
+
+/*
+ * Air stepped tick after tick with fixed step or adaptive one, on idle floor of
+ * uniform air and on generated one. Adaptive step saves time of skipped ticks only
+ * over many ticks
+ */
+static void BM_AirStepping(benchmark::State & state) {
+  Layers cur = makeSteppingLayers(state.range(0), state.range(1) == 0);
+  cur.obstructionLayer.updateAirObstruction(cur.subjectLayer);
+  cur.airLayer.setStepping(AirStepping{.adaptive = state.range(2) != 0});
+  Layers next = cur;
+  std::size_t substeps = 0;
+  for (auto _ : state) {
+    next.airLayer.nextConvection(next.subjectLayer);
+    next.airLayer.nextCirculation(cur.airLayer, next.obstructionLayer);
+    substeps += next.airLayer.getSubsteps();
+    state.PauseTiming();
+    cur.airLayer = next.airLayer;
+    state.ResumeTiming();
+  }
+  state.counters["substeps"] =
+      benchmark::Counter(substeps, benchmark::Counter::kAvgIterations);
+  setCellsProcessed(state);
+}
+BENCHMARK(BM_AirStepping)
+    ->ArgNames({"size", "floor", "adaptive"})
+    ->ArgsProduct({{64, 256}, {0, 1}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
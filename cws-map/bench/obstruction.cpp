@@ -0,0 +1,23 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+#include "cws/map_layer/obstruction.hpp"
+
+static void BM_CalcResidualMax(benchmark::State & state) {
+  std::mt19937 gen(1);
+  std::uniform_real_distribution<double> dist(0, 1);
+
+  std::vector<Obstruction> source(state.range(0));
+  for (auto & obs : source) {
+    obs = Obstruction{dist(gen)};
+  }
+
+  // vector is sorted in place, so copy is measured too like callers build it per cell
+  for (auto _ : state) {
+    auto obsV = source;
+    benchmark::DoNotOptimize(calcResidualMax(obsV));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CalcResidualMax)->RangeMultiplier(4)->Range(1, 256);
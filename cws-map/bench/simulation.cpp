@@ -0,0 +1,24 @@
+#include "fixture.hpp"
+
+#include <memory>
+
+static void BM_MapClone(benchmark::State & state) {
+  const SimulationMap & map = getBenchMap(state);
+  SimulationMap copy = map;
+  for (auto _ : state) {
+    copy = map;
+  }
+  setCellsProcessed(state);
+}
+BENCHMARK(BM_MapClone)->Apply(applyMapArgs);
+
+// same copy SimulationInterface::masterSet does for readers every tick
+static void BM_MasterSetSnapshot(benchmark::State & state) {
+  const SimulationMap & map = getBenchMap(state);
+  std::shared_ptr<const SimulationMap> snapshot;
+  for (auto _ : state) {
+    snapshot = std::make_shared<SimulationMap>(map);
+  }
+  setCellsProcessed(state);
+}
+BENCHMARK(BM_MasterSetSnapshot)->Apply(applyMapArgs);
@@ -24,12 +24,14 @@ class cws_map(ConanFile):
         copy(self, "src/*", self.recipe_folder, es_sub)
         copy(self, "include/*", self.recipe_folder, es_sub)
         copy(self, "test/*", self.recipe_folder, es_sub)
+        copy(self, "bench/*", self.recipe_folder, es_sub)
 
     def source(self):
         pass
 
     def requirements(self):
         self.test_requires("gtest/cci.20210126")
+        self.test_requires("benchmark/1.8.3")
 
     def layout(self):
         self.folders.root = self._folders_rel_root
@@ -66,6 +66,9 @@ public:
   Temperature getTemperature() const;
   double getWeight() const;
   void updateTemperature(double heatAirTransfer);
+  void setTemperature(Temperature temperature);
+  // temperature is kept, air scaled to zero weight is removed
+  void scaleWeight(double factor);
 
 private:
   void normalizeTemperature();
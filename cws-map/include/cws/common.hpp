@@ -2,6 +2,7 @@
 
 #include <list>
 #include <ostream>
+#include <vector>
 
 /*
  * Coordinates of a cell on the map
@@ -62,3 +63,24 @@ std::pair<int, int> getVector(Coordinates p1, Coordinates p2);
 int getScalarMultiplication(std::pair<int, int> v1, std::pair<int, int> v2);
 
 int getDistanceSquare(std::pair<int, int> v);
+
+/*
+ * Rectangle or polygon of cells. Vertices of polygon are corners of cells, cell
+ * belongs to it if its center is inside (even-odd rule, top edge is included and
+ * bottom one is not, so polygons sharing edge don't overlap)
+ */
+struct CellRegion final {
+  Coordinates origin;
+  Dimension size;
+  std::vector<Coordinates> polygon;// used instead of rectangle if not empty
+};
+
+// cells [yBegin, yEnd) of column x
+struct CellSpan final {
+  int x;
+  int yBegin;
+  int yEnd;
+};
+
+// spans of region clipped by map, in order of columns
+std::vector<CellSpan> getCellSpans(const CellRegion & region, Dimension dim);
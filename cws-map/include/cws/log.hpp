@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <ostream>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+namespace Log {
+
+enum class Level {
+  DEBUG = 0,
+  INFO,
+  WARN,
+  ERROR,
+};
+
+const char * toString(Level level);
+std::optional<Level> fromLevelName(const std::string & name);
+
+constexpr std::size_t MESSAGE_SIZE = 240;
+
+struct Record final {
+  std::chrono::system_clock::time_point time;
+  Level level;
+  const char * source;// string literal, not copied
+  std::size_t length;
+  std::array<char, MESSAGE_SIZE> message;
+};
+
+/*
+ * Records are written by background thread as logfmt lines:
+ *   time=2024-01-01T00:00:00.000Z level=info source=master msg="..."
+ *
+ * Writers never wait for sink or each other: record is copied into bounded
+ * queue and dropped if it is full, count of dropped records is logged later.
+ */
+class Logger final {
+  struct Slot {
+    std::atomic<std::size_t> sequence;
+    Record record;
+  };
+
+  std::vector<Slot> slots_;
+  std::size_t mask_;
+
+  std::atomic<std::size_t> enqueuePos_ = 0;
+  std::atomic<std::size_t> dequeuePos_ = 0;
+  std::atomic<std::size_t> dropped_ = 0;
+
+#ifdef NDEBUG
+  std::atomic<Level> level_ = Level::INFO;
+#else
+  std::atomic<Level> level_ = Level::DEBUG;
+#endif
+
+  std::ostream & sink_;
+  std::jthread worker_;
+
+public:
+  explicit Logger(std::ostream & sink, std::size_t capacity = 4096);
+  ~Logger();
+
+  Logger(const Logger &) = delete;
+  Logger & operator=(const Logger &) = delete;
+
+  // global logger writing to stderr, level may be set with CWS_LOG_LEVEL
+  static Logger & get();
+
+  bool isEnabled(Level level) const {
+    return level >= level_.load(std::memory_order_relaxed);
+  }
+  void setLevel(Level level) { level_.store(level, std::memory_order_relaxed); }
+
+  // false if record is dropped
+  bool push(const Record & record);
+
+  std::size_t getDropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+  // waits until records pushed before the call are written
+  void flush();
+
+private:
+  bool pop(Record & record);
+  void execute(std::stop_token stoken);
+  void write(const Record & record);
+};
+
+/*
+ * Formats message into record without allocations, longer messages are cut
+ */
+class RecordStream final : private std::streambuf, public std::ostream {
+  Record record_;
+
+public:
+  RecordStream(Level level, const char * source);
+
+  const Record & getRecord();
+
+private:
+  std::streambuf::int_type overflow(std::streambuf::int_type ch) override;
+};
+
+}// namespace Log
+
+#define CWS_LOG(level, source, expr)                                                  \
+  do {                                                                                \
+    auto & cwsLogger_ = ::Log::Logger::get();                                         \
+    if (cwsLogger_.isEnabled(level)) {                                                \
+      ::Log::RecordStream cwsLogStream_(level, source);                               \
+      cwsLogStream_ << expr;                                                          \
+      cwsLogger_.push(cwsLogStream_.getRecord());                                     \
+    }                                                                                 \
+  } while (0)
+
+#ifdef NDEBUG
+#define CWS_LOG_DEBUG(source, expr)                                                   \
+  do {                                                                                \
+  } while (0)
+#else
+#define CWS_LOG_DEBUG(source, expr) CWS_LOG(::Log::Level::DEBUG, source, expr)
+#endif
+
+#define CWS_LOG_INFO(source, expr) CWS_LOG(::Log::Level::INFO, source, expr)
+#define CWS_LOG_WARN(source, expr) CWS_LOG(::Log::Level::WARN, source, expr)
+#define CWS_LOG_ERROR(source, expr) CWS_LOG(::Log::Level::ERROR, source, expr)
@@ -6,6 +6,7 @@
 #include "cws/map_layer/illumination.hpp"
 #include "cws/map_layer/network.hpp"
 #include "cws/map_layer/subject.hpp"
+#include "cws/map_stage.hpp"
 
 struct Layers final {
 public:
@@ -14,11 +15,13 @@ public:
   MapLayerIllumination illuminationLayer;
   MapLayerAir airLayer;
   MapLayerNetworkWireless networkWireless;
+  MapLayerNetworkWired networkWired;
 
 public:
   explicit Layers(Dimension dimension)
       : subjectLayer(dimension), obstructionLayer(dimension),
-        illuminationLayer(dimension), airLayer(dimension), networkWireless(dimension) {}
+        illuminationLayer(dimension), airLayer(dimension), networkWireless(dimension),
+        networkWired(dimension) {}
 
 public:
   friend std::ostream & operator<<(std::ostream & out, const Layers * map);
@@ -32,13 +35,44 @@ protected:
 public:
   explicit Map(Dimension dimension) : layers(dimension), dimension(dimension) {}
 
+  // moved map keeps its subjects, so index of SimulationMap stays valid. Cameras
+  // of both copied and moved map look at layers of this map
+  Map(const Map & map);
+  Map(Map && map);
+  Map & operator=(const Map & map);
+  Map & operator=(Map && map);
+
   virtual ~Map() = default;
 
   const Layers & getLayers() const { return layers; }
 
   Dimension getDimension() const { return dimension; }
 
-  void next(const Map & cur);
+  // set for current and next map, kept by copies
+  void setAirStepping(const AirStepping & stepping) {
+    layers.airLayer.setStepping(stepping);
+  }
+  void setAirSleeping(const AirSleeping & sleeping) {
+    layers.airLayer.setSleeping(sleeping);
+  }
+
+  // times are filled for each stage if passed
+  void next(const Map & cur, MapStageTimes * times = nullptr);
+
+  // next in two parts for partitions of map: illumination and wireless signal are
+  // set for whole map between them, so these stages have no times here
+  void nextBeforeSpread(const Map & cur, MapStageTimes * times = nullptr);
+  void nextAfterSpread(MapStageTimes * times = nullptr);
 
   friend std::ostream & operator<<(std::ostream & out, const Map * map);
+
+private:
+  void nextUntilIllumination(const Map & cur, MapStageClock & clock,
+                             MapStageTimes * times);
+  void collectNetwork(MapStageClock & clock);
+  void receiveNetwork(MapStageClock & clock);
+
+  void setupCameras() {
+    layers.subjectLayer.setupCameras(layers.obstructionLayer, layers.illuminationLayer);
+  }
 };
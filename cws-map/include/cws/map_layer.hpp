@@ -52,6 +52,12 @@ public:
             dimension.width,
             std::vector<CellLayer<T>>(dimension.height, CellLayer<T>(base)))) {}
 
+  // cells are moved, not copied, as destructor is declared
+  MapLayer(const MapLayer & layer) = default;
+  MapLayer(MapLayer && layer) = default;
+  MapLayer & operator=(const MapLayer & layer) = default;
+  MapLayer & operator=(MapLayer && layer) = default;
+
   virtual ~MapLayer() = default;
 
   Dimension getDimension() const { return dimension_; }
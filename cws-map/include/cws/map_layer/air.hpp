@@ -4,38 +4,217 @@
 #include "cws/map_layer/base.hpp"
 #include "cws/map_layer/obstruction.hpp"
 #include "cws/map_layer/subject.hpp"
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+/*
+ * Circulation step chosen by gradients of current air. Near equilibrium ticks are
+ * skipped and their time is stepped at once later. Step that would overshoot cells
+ * out of equilibrium is split into sub-steps. Off by default, one step per tick
+ */
+struct AirStepping final {
+  bool adaptive = false;
+  int maxSubsteps = 8;
+  int maxSkippedTicks = 8;
+  double equilibriumRatio = 1e-3;// of air value difference between cells
+  double equilibriumTemperature = 0.01;
+};
+
+/*
+ * Map is split into square tiles of air. Tile which cells changed by less than
+ * deltas for calm ticks in a row sleeps: convection and circulation skip it. It
+ * wakes when air of its cells is accessed, when its border cells differ from cells of
+ * awake neighbour by more than deltas, when heat of its subjects would change a cell
+ * by more than deltas, or when air obstruction of its cells changes. Off by default
+ */
+struct AirSleeping final {
+  bool enabled = false;
+  int tileSize = 16;
+  int calmTicks = 8;
+  double temperatureDelta = 1e-3;// of cell per tick
+  double weightDelta = 1e-4;
+};
 
 /*
  * Extended logic for subject layer
  */
 class MapLayerAir : public MapLayerBase<LayerAir> {
+  // changes of sub-step read from this layer, applied after the whole sub-step
+  struct Deferred final {
+    std::vector<std::list<std::unique_ptr<Air::Plain>>> air;// by cell index
+    std::vector<double> heat;
+  };
+
+  struct Tile final {
+    bool sleeping = false;
+    int calmTicks = 0;
+    double activity = 0;// largest change of cell this tick, 1 is delta
+  };
+
+  struct TileBounds final {
+    Coordinates begin;
+    Coordinates end;// exclusive
+  };
+
+  AirStepping stepping_;
+  int pendingTicks_ = 0;    // skipped near equilibrium
+  int substeps_ = 1;        // of last circulation, 0 if skipped
+  bool equilibrium_ = false;// of air read by last step
+  // air changed outside of simulation is read by step of next tick, not this one
+  int disturbedSteps_ = 2;
+  double stiffness_ = 0;// part of difference between cells closed by one step
+  double heating_ = 0;  // by subjects since last step, most of cell a tick
+
+  AirSleeping sleeping_;
+  std::vector<Tile> tiles_;// row by row, empty if sleeping is off
+  int tileColumns_ = 0;
+
 public:
+  /*
+   * Stepping and tiles carried from tick to tick, stored in snapshots so map loaded
+   * from one goes on as the saved map would
+   */
+  struct State final {
+    AirStepping stepping;
+    int pendingTicks = 0;
+    bool equilibrium = false;
+    int disturbedSteps = 0;
+    double stiffness = 0;
+    double heating = 0;
+
+    AirSleeping sleeping;
+    std::vector<std::pair<bool, int>> tiles;// sleeping and calm ticks, row by row
+  };
+
   MapLayerAir(Dimension dimension) : MapLayerBase<LayerAir>(dimension) {}
 
+  const AirStepping & getStepping() const { return stepping_; }
+  void setStepping(const AirStepping & stepping) { stepping_ = stepping; }
+  int getSubsteps() const { return substeps_; }
+
+  const AirSleeping & getSleeping() const { return sleeping_; }
+  // tiles keep their state if tile size is the same, otherwise all are awake after
+  // it, throws std::invalid_argument on bad tile size
+  void setSleeping(const AirSleeping & sleeping);
+
+  State getState() const;
+  // throws std::invalid_argument if tiles don't fit the map
+  void setState(const State & state);
+  bool isSleeping(Coordinates c) const {
+    return !tiles_.empty() && tiles_[getTileIndex(c)].sleeping;
+  }
+  std::size_t getActiveTiles() const { return tiles_.size() - getSleepingTiles(); }
+  std::size_t getSleepingTiles() const;
+
   const Air::Container & getAirContainer(Coordinates c) const {
     return getCell(c).getElement().getAirContainer();
   }
 
+  // air is going to be changed outside of simulation, so tile of cell wakes
   Air::Container & accessAirContainer(Coordinates c) {
+    wake(c);
+    disturbedSteps_ = 2;
     return accessCell(c).accessElement().accessAirContainer();
   }
 
+  // air is cloned into every cell of spans
+  void fill(std::span<const CellSpan> spans, const Air::Plain & air);
+  void scaleWeight(std::span<const CellSpan> spans, double factor);
+  void setTemperature(std::span<const CellSpan> spans, Temperature temperature);
+
   void nextConvection(MapLayerSubject & subjectLayer);
 
+  // tiles which cells got other air obstruction than in current map wake
+  void wakeObstructed(const MapLayerObstruction & curObstructionLayer,
+                      const MapLayerObstruction & obstructionLayer);
+
   void nextCirculation(const MapLayerAir & curLayerAir,
                        const MapLayerObstruction & obstructionLayer);
+  // step of scale 1 is one tick long
   void nextCirculationMassTemp(const MapLayerAir & curLayerAir,
-                               const MapLayerObstruction & obstructionLayer);
+                               const MapLayerObstruction & obstructionLayer,
+                               double scale = 1);
   void nextCirculationTemp(const MapLayerAir & curLayerAir,
-                           const MapLayerObstruction & obstructionLayer);
+                           const MapLayerObstruction & obstructionLayer,
+                           double scale = 1);
 
 private:
-  void nextConvection(MapLayerSubject & subjectLayer, Coordinates c);
+  std::size_t getTileIndex(Coordinates c) const {
+    return (c.y / sleeping_.tileSize) * tileColumns_ + c.x / sleeping_.tileSize;
+  }
+  void wake(Coordinates c) {
+    if (!tiles_.empty()) {
+      auto & tile = tiles_[getTileIndex(c)];
+      tile.sleeping = false;
+      tile.calmTicks = 0;
+    }
+  }
+  TileBounds getTileBounds(std::size_t i) const;
+  template<typename F>
+  void forEachTileCell(std::size_t i, F && f) const;
+  // cells of awake tiles, all cells if sleeping is off
+  template<typename F>
+  void forEachAwakeCell(F && f) const;
+  // sleeping tiles which border cells differ from cells of awake neighbours wake
+  void wakeDisturbed(const MapLayerAir & curLayerAir,
+                     const MapLayerObstruction & obstructionLayer);
+  // change of cells since current layer, then tiles fall asleep or wake
+  void updateTiles(const MapLayerAir & curLayerAir);
 
+  // count of sub-steps is returned
+  int stepCirculation(const MapLayerAir & curLayerAir,
+                      const MapLayerObstruction & obstructionLayer);
+  // sub-step after the first one, reads air of this layer instead of a copy
+  void nextSubstep(const MapLayerObstruction & obstructionLayer, double scale,
+                   Deferred & deferred);
+  double measureStiffness(const MapLayerAir & curLayerAir,
+                          const MapLayerObstruction & obstructionLayer) const;
+
+  // change of air temperature is returned
+  double nextConvection(MapLayerSubject & subjectLayer, Coordinates c);
+  double getConvectionChange(const MapLayerSubject & subjectLayer,
+                             Coordinates c) const;
+
+  // changes are written to this layer, or to deferred if it's set
   void nextCirculationCellMassTemp(const MapLayerAir & curLayerAir,
                                    const MapLayerObstruction & obstructionLayer,
-                                   Coordinates c);
+                                   Coordinates c, double scale, Deferred * deferred);
   void nextCirculationCellTemp(const MapLayerAir & curLayerAir,
                                const MapLayerObstruction & obstructionLayer,
-                               Coordinates c);
+                               Coordinates c, double scale, Deferred * deferred);
 };
+
+template<typename F>
+void MapLayerAir::forEachTileCell(std::size_t i, F && f) const {
+  auto bounds = getTileBounds(i);
+  Coordinates c;
+  for (c.x = bounds.begin.x; c.x < bounds.end.x; ++c.x) {
+    for (c.y = bounds.begin.y; c.y < bounds.end.y; ++c.y) {
+      f(c);
+    }
+  }
+}
+
+template<typename F>
+void MapLayerAir::forEachAwakeCell(F && f) const {
+  if (!tiles_.empty()) {
+    for (std::size_t i = 0; i < tiles_.size(); ++i) {
+      if (!tiles_[i].sleeping) {
+        forEachTileCell(i, f);
+      }
+    }
+    return;
+  }
+
+  Dimension dim = getDimension();
+  Coordinates c;
+  for (c.x = 0; c.x < dim.width; ++c.x) {
+    for (c.y = 0; c.y < dim.height; ++c.y) {
+      f(c);
+    }
+  }
+}
@@ -6,8 +6,22 @@
 #include "cws/map_layer/base.hpp"
 #include "cws/map_layer/obstruction.hpp"
 #include "cws/map_layer/subject.hpp"
+#include <utility>
+#include <vector>
 
+/*
+ * Light coming through portal from other floor is spread from its cell like light
+ * of source on next update. Illumination of such cells without it is kept, so light
+ * isn't passed back to floor it came from
+ */
 class MapLayerIllumination : public MapLayerBase<LayerIllumination> {
+  struct PortalLight final {
+    Coordinates coordinates;
+    Illumination incoming;
+    Illumination own;
+  };
+
+  std::vector<PortalLight> portalLight_;
 
 public:
   MapLayerIllumination(Dimension dimension)
@@ -16,8 +30,14 @@ public:
   MapLayerIllumination(Dimension dimension, Illumination base)
       : MapLayerBase<LayerIllumination>(dimension, base) {}
 
+  // raw illumination of active sources with their cells
+  using LightSources = std::vector<std::pair<Coordinates, Illumination>>;
+
   void updateIllumination(const MapLayerObstruction & obstructionLayer,
                           const MapLayerSubject & subjectLayer);
+  // sources collected elsewhere, e.g. from partitions of map, in order of cells
+  void updateIllumination(const MapLayerObstruction & obstructionLayer,
+                          const LightSources & sources);
 
   void setIllumination(Coordinates coord, Illumination illum) {
     accessCell(coord).accessElement().setIllumination(illum);
@@ -26,4 +46,9 @@ public:
   Illumination getIllumination(Coordinates coord) const {
     return getCell(coord).getElement().getIllumination();
   }
+
+  // added to light of portal cell until next update
+  void addPortalLight(Coordinates coord, Illumination illum);
+  // illumination without light of portals
+  Illumination getOwnIllumination(Coordinates coord) const;
 };
@@ -4,6 +4,10 @@
 #include "cws/map_layer/base.hpp"
 #include "cws/map_layer/obstruction.hpp"
 #include "cws/network/type.hpp"
+#include "cws/subject/plain.hpp"
+#include <memory>
+#include <unordered_map>
+#include <vector>
 
 class MapLayerNetwork {
   Network::Type networkType_;
@@ -40,7 +44,7 @@ public:
   Network::Type getNetworkType() const { return networkType_; }
   Dimension getDimension() const;
 
-  void clearNetwork();
+  virtual void clearNetwork();
   virtual void collectTransmittableContainers(const MapLayerSubject & layerSubject);
   virtual void updateNetwork(const MapLayerObstruction & obstruction) = 0;
 
@@ -56,13 +60,91 @@ protected:
   }
 };
 
+/*
+ * Containers relayed from other floor are transmitted from their cell with
+ * containers of subjects on next collection
+ */
 class MapLayerNetworkWireless : public MapLayerNetwork {
+  std::vector<std::pair<Coordinates, LayerNetwork>> relayed_;
+
 public:
   MapLayerNetworkWireless(Dimension dimension)
       : MapLayerNetwork(dimension, Network::Type::WIRELESS) {}
 
+  void relay(Coordinates c, std::list<std::unique_ptr<Network::Container>> && list);
+  // containers spread by layer of whole map, e.g. by coordinator of partitions of
+  // map: transmitted ones are added before update, received ones instead of it
+  void transmit(Coordinates c, std::list<std::unique_ptr<Network::Container>> && list);
+  void receive(Coordinates c, std::list<std::unique_ptr<Network::Container>> && list);
+
+  void collectTransmittableContainers(const MapLayerSubject & layerSubject) override;
   void updateNetwork(const MapLayerObstruction & obstruction) override;
 
 private:
   void updateNetworkCell(const MapLayerObstruction & obstruction, Coordinates c);
 };
+
+/*
+ * Cables between subjects form graph, wired devices are its nodes as well as any
+ * other subjects (switches) that only pass packets on. Packet of device is
+ * delivered to every other wired device reachable from it.
+ *
+ * Routes are computed with breadth-first search from each node when cables change,
+ * so tick costs only lookup of routes of transmitting devices. Table of routes is
+ * shared by copies of layer until cables of one of them change. Ids of subjects
+ * connected with cables are expected to be unique on map.
+ *
+ * Cells of wired devices are kept by SimulationMap as subjects are inserted and
+ * deleted, so collection and receiving touch only cells of devices
+ */
+class MapLayerNetworkWired : public MapLayerNetwork {
+public:
+  struct Route final {
+    Subject::Id destination;
+    int hops;
+  };
+
+private:
+  using Links =
+      std::unordered_map<Subject::Id, std::vector<Subject::Id>, Subject::IdHash>;
+  using Routes = std::unordered_map<Subject::Id, std::vector<Route>, Subject::IdHash>;
+
+  Links links_;
+  std::shared_ptr<const Routes> routes_;// nullptr if there are no cables
+  bool routesValid_ = true;
+
+  std::unordered_map<Subject::Id, Coordinates, Subject::IdHash> devices_;
+  // cells touched by last tick
+  std::vector<Coordinates> transmitCells_;
+  std::vector<Coordinates> receiveCells_;
+
+public:
+  MapLayerNetworkWired(Dimension dimension)
+      : MapLayerNetwork(dimension, Network::Type::WIRED) {}
+
+  // false if cable already exists or both ends are the same
+  bool connect(const Subject::Id & first, const Subject::Id & second);
+  // false if there is no such cable
+  bool disconnect(const Subject::Id & first, const Subject::Id & second);
+
+  const std::vector<Subject::Id> & getLinks(const Subject::Id & node) const;
+  // every cable once
+  std::vector<std::pair<Subject::Id, Subject::Id>> getCables() const;
+  // nodes reachable from source ordered by hops, empty until network is updated
+  const std::vector<Route> & getRoutes(const Subject::Id & source) const;
+
+  // subjects other than wired devices are ignored
+  void addDevice(const Subject::Id & id, Coordinates c);
+  void removeDevice(const Subject::Id & id, Coordinates c);
+  // cells with containers received on last tick
+  const std::vector<Coordinates> & getReceiveCells() const { return receiveCells_; }
+
+  // clears only cells used on previous tick
+  void clearNetwork() override;
+  void collectTransmittableContainers(const MapLayerSubject & layerSubject) override;
+  // obstruction doesn't affect cables
+  void updateNetwork(const MapLayerObstruction & obstruction) override;
+
+private:
+  void updateRoutes();
+};
@@ -3,6 +3,10 @@
 #include "cws/common.hpp"
 #include "cws/layer/obstruction.hpp"
 #include "cws/map_layer/subject.hpp"
+#include <vector>
+
+// combined obstruction of several obstacles in one cell, vector is sorted in place
+Obstruction calcResidualMax(std::vector<Obstruction> & obsV);
 
 class MapLayerObstruction : public MapLayerBase<LayerObstruction> {
 public:
@@ -2,6 +2,7 @@
 
 #include "cws/layer/subject.hpp"
 #include "cws/map_layer/base.hpp"
+#include <vector>
 
 class MapLayerNetwork;
 class MapLayerObstruction;
@@ -31,11 +32,18 @@ public:
   void setupSubjects(const MapLayerAir & airLayer,
                      const MapLayerObstruction & obstructionLayer,
                      const MapLayerIllumination & illuminationLayer);
+  // cameras look at passed layers, as after setupSubjects, e.g. in copy of map
+  void setupCameras(const MapLayerObstruction & obstructionLayer,
+                    const MapLayerIllumination & illuminationLayer);
 
   void receiveContainers(const MapLayerNetwork & networkLayer);
+  // only cells that may have received containers, e.g. of wired devices
+  void receiveContainers(const MapLayerNetwork & networkLayer,
+                         const std::vector<Coordinates> & cells);
   void clearNetworkBuffers();
 
 private:
+  void receiveContainers(const MapLayerNetwork & networkLayer, Coordinates c);
   void setupSubject(Subject::Plain & subject, Coordinates c,
                     const MapLayerAir & airLayer,
                     const MapLayerObstruction & obstructionLayer,
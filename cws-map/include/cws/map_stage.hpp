@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+/*
+ * Stages of Map::next in order of execution
+ */
+enum class MapStage {
+  SUBJECT_TEMPERATURE = 0,
+  AIR_CONVECTION = 1,
+  AIR_OBSTRUCTION = 2,
+  AIR_CIRCULATION = 3,
+  LIGHT_OBSTRUCTION = 4,
+  ILLUMINATION = 5,
+  NETWORK_COLLECT = 6,
+  NETWORK_SPREAD = 7,
+  NETWORK_RECEIVE = 8,
+  SUBJECT_SETUP = 9,
+};
+
+constexpr std::size_t MAP_STAGE_COUNT = 10;
+
+const char * toString(MapStage stage);
+
+/*
+ * Timings of the stages of one Map::next call
+ */
+struct MapStageTimes final {
+  using Clock = std::chrono::steady_clock;
+
+  std::array<Clock::time_point, MAP_STAGE_COUNT> start;
+  std::array<std::chrono::nanoseconds, MAP_STAGE_COUNT> duration;
+  int airSubsteps = 1;// steps of air circulation, 0 if it was skipped at equilibrium
+  // tiles of air after the tick, both are 0 if sleeping is off
+  std::size_t activeAirTiles = 0;
+  std::size_t sleepingAirTiles = 0;
+
+  const Clock::time_point & getStart(MapStage stage) const {
+    return start[static_cast<std::size_t>(stage)];
+  }
+
+  std::chrono::nanoseconds getDuration(MapStage stage) const {
+    return duration[static_cast<std::size_t>(stage)];
+  }
+
+  std::chrono::nanoseconds getTotal() const;
+};
+
+/*
+ * Measures stages one after another, each lap closes the current stage. Does nothing
+ * if no times are passed, so untimed ticks don't pay for clock reads.
+ */
+class MapStageClock final {
+  MapStageTimes * times_;
+  MapStageTimes::Clock::time_point lapStart_;
+
+public:
+  explicit MapStageClock(MapStageTimes * times) : times_(times) {
+    if (times_) {
+      lapStart_ = MapStageTimes::Clock::now();
+    }
+  }
+
+  void lap(MapStage stage) {
+    if (!times_) {
+      return;
+    }
+    auto now = MapStageTimes::Clock::now();
+    auto idx = static_cast<std::size_t>(stage);
+    times_->start[idx] = lapStart_;
+    times_->duration[idx] = now - lapStart_;
+    lapStart_ = now;
+  }
+};
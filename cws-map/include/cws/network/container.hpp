@@ -1,6 +1,7 @@
 #pragma once
 
 #include "cws/network/packet.hpp"
+#include "cws/subject/plain.hpp"
 #include <memory>
 #include <vector>
 
@@ -32,6 +33,7 @@ public:
 
 class WirelessContainer : public Container {
   double signalPower_;
+  bool relayed_ = false;// came through portal from other floor
 
 public:
   WirelessContainer(std::unique_ptr<Packet> && packet, double signalPower)
@@ -39,11 +41,34 @@ public:
 
   WirelessContainer * clone() const override { return new WirelessContainer(*this); }
   WirelessContainer * cloneWithSignal(double signalPower) const;
+  WirelessContainer * cloneRelayed(double signalPower) const;
 
   double getSignalPower() const { return signalPower_; }
+  bool isRelayed() const { return relayed_; }
 
 protected:
   void setSignalPower(double signalPower) { signalPower_ = signalPower; }
 };
 
+/*
+ * Packet sent by wired device, destination is set when it is routed to receiver
+ */
+class WiredContainer : public Container {
+  Subject::Id source_;
+  Subject::Id destination_;
+  int hops_;
+
+public:
+  WiredContainer(std::unique_ptr<Packet> && packet, Subject::Id source)
+      : Container(std::move(packet)), source_(source), destination_(source),
+        hops_(0) {}
+
+  WiredContainer * clone() const override { return new WiredContainer(*this); }
+  WiredContainer * cloneRouted(Subject::Id destination, int hops) const;
+
+  Subject::Id getSource() const { return source_; }
+  Subject::Id getDestination() const { return destination_; }
+  int getHops() const { return hops_; }
+};
+
 }// namespace Network
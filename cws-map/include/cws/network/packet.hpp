@@ -1,21 +1,36 @@
 #pragma once
 
+#include <cstddef>
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace Network {
 
+/*
+ * Content of packet is immutable and shared by all its copies: containers on every
+ * cell, received packets and copies of map refer to the same buffer
+ */
 class Packet {
-  std::vector<std::byte> content_;
+public:
+  using Payload = std::vector<std::byte>;
+  using PayloadPtr = std::shared_ptr<const Payload>;
+
+private:
+  PayloadPtr content_;
 
 public:
-  Packet(std::vector<std::byte> && content) : content_(content) {}
+  Packet(Payload && content)
+      : content_(std::make_shared<const Payload>(std::move(content))) {}
+
+  Packet(PayloadPtr content) : content_(std::move(content)) {}
 
   virtual ~Packet() = default;
 
   virtual Packet * clone() { return new Packet(*this); }
 
-  const std::vector<std::byte> & getContent() const { return content_; }
+  const Payload & getContent() const { return *content_; }
+  const PayloadPtr & getPayload() const { return content_; }
 };
 
 };// namespace Network
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#include "cws/map_stage.hpp"
+
+// bucket i holds durations in [2^(i-1), 2^i) microseconds, first one is below 1 and
+// last one holds all longer durations
+constexpr std::size_t PROFILE_BUCKET_COUNT = 32;
+
+struct StageProfile final {
+  std::size_t count;
+  std::chrono::nanoseconds mean, min, max;
+  std::chrono::nanoseconds p50, p90, p99;
+  std::array<std::size_t, PROFILE_BUCKET_COUNT> histogram;
+};
+
+struct TickProfile final {
+  std::size_t window;// count of ticks profile is built from
+  std::size_t lastTick;
+  std::array<StageProfile, MAP_STAGE_COUNT> stages;
+  StageProfile tick;
+  // of last tick, both are 0 if air sleeping is off
+  std::size_t activeAirTiles;
+  std::size_t sleepingAirTiles;
+  double airSubsteps;// mean per tick, 1 unless air stepping is adaptive
+};
+
+/*
+ * Keeps stage timings of last ticks in a ring buffer. Written by simulation once per
+ * tick and read by clients, lock is held only to copy or store one record.
+ */
+class TickProfiler final {
+  struct Record {
+    std::size_t tick;
+    MapStageTimes times;
+  };
+
+  std::vector<Record> records_;
+  std::size_t next_ = 0;
+  std::size_t size_ = 0;
+
+  // rolling histograms of window, last one is for whole tick
+  std::array<std::array<std::size_t, PROFILE_BUCKET_COUNT>, MAP_STAGE_COUNT + 1>
+      histograms_{};
+
+  MapStageTimes::Clock::time_point epoch_;
+
+  mutable std::mutex mutex_;
+
+public:
+  explicit TickProfiler(std::size_t window = 512);
+
+  std::size_t getWindow() const { return records_.size(); }
+
+  void record(std::size_t tick, const MapStageTimes & times);
+  void reset();
+
+  TickProfile getProfile() const;
+
+  // trace event format, opens in chrome://tracing and Perfetto
+  void writeChromeTrace(std::ostream & out) const;
+
+  static std::chrono::nanoseconds getBucketBound(std::size_t bucket);
+
+private:
+  std::vector<Record> copyRecords() const;
+};
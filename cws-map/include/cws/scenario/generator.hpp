@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+#include "cws/scenario/scenario.hpp"
+
+/*
+ * Coworking floor split into rooms by walls with doors. Each room gets a heater,
+ * sensors and a camera, lamps are placed on a grid and desks, some of them with
+ * wireless devices, take `density` share of free cells. Every cell gets air, rooms
+ * use air ids 0..airKinds-1 in turn.
+ *
+ * Same parameters and dimension give the same floor on any platform.
+ */
+struct FloorParams final {
+  std::uint32_t seed = 1;
+  int roomSize = 12;// distance between walls
+  int lampSpacing = 4;
+  double density = 0.1;
+  int airKinds = 2;
+};
+
+// events are added on tick 0
+void generateFloor(Scenario & scenario, const FloorParams & params);
+
+// same floor built directly in map, for maps too large to keep twice
+void generateFloor(SimulationMap & map, const FloorParams & params);
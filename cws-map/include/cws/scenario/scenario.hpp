@@ -0,0 +1,96 @@
+#pragma once
+
+#include <istream>
+#include <map>
+#include <variant>
+
+#include "cws/simulation/building.hpp"
+#include "cws/simulation/partition.hpp"
+#include "cws/simulation/simulation_map.hpp"
+#include "cws/subject/extension/turnable.hpp"
+
+/*
+ * Switch turnable subject on a certain tick
+ */
+struct ScenarioTurnQuery final {
+  SubjectSelectQuery select;
+  Subject::TurnableStatus status;
+};
+
+using ScenarioEvent = std::variant<SubjectModifyQuery, AirInsertQuery, AirRegionQuery,
+                                   ScenarioTurnQuery, CableModifyQuery>;
+
+/*
+ * Map description and changes applied to it at certain ticks. Used to run map
+ * without grpc server.
+ *
+ * Text format, one entry per line, '#' starts a comment:
+ *
+ *   dimension <width> <height>
+ *   ticks <count>
+ *   [@<tick>] subject <type> x=<x> y=<y> idx=<idx> [<param>=<value> ...]
+ *   [@<tick>] air x=<x> y=<y> idx=<idx> [<param>=<value> ...]
+ *   [@<tick>] air_region fill <region> idx=<idx> [<param>=<value> ...]
+ *   [@<tick>] air_region scale <region> factor=<f>
+ *   [@<tick>] air_region temperature <region> temp=<t>
+ *   [@<tick>] turn <type> x=<x> y=<y> idx=<idx> status=<on|off>
+ *   [@<tick>] cable from=<type>:<idx> to=<type>:<idx> [status=<on|off>]
+ *   generate [seed=<n>] [room=<n>] [lamps=<n>] [density=<d>] [air_kinds=<n>]
+ *   floor
+ *   portal lower=<floor>:<x>:<y> upper=<floor>:<x>:<y> [air=<r>] [light=<r>]
+ *          [wireless=<r>]
+ *
+ * Region is x=<x> y=<y> width=<w> height=<h> or polygon=<x>:<y>,<x>:<y>,... with
+ * corners of cells, it is clipped by map. Cable with status=off is removed. Cameras
+ * take optional view: range=<cells> direction=<degrees> fov=<degrees>.
+ * Entries without tick are applied on tick 0. `generate` fills the whole map with a
+ * floor (check cws/scenario/generator.hpp).
+ *
+ * Map is floor 0 of building. `floor` starts next floor of the same dimension, later
+ * entries belong to it. `portal` links cells of floors declared before it with rates
+ * of air, light and wireless (0 by default, check cws/simulation/building.hpp).
+ */
+class Scenario final {
+  Dimension dimension_;
+  std::size_t ticks_;
+  std::vector<std::multimap<std::size_t, ScenarioEvent>> floors_;// events of floors
+  std::vector<Portal> portals_;
+
+public:
+  Scenario(Dimension dimension, std::size_t ticks = 0)
+      : dimension_(dimension), ticks_(ticks), floors_(1) {}
+
+  Dimension getDimension() const { return dimension_; }
+
+  std::size_t getTicks() const { return ticks_; }
+  void setTicks(std::size_t ticks) { ticks_ = ticks; }
+
+  std::size_t getFloorCount() const { return floors_.size(); }
+  const std::multimap<std::size_t, ScenarioEvent> &
+  getEvents(std::size_t floor = 0) const {
+    return floors_.at(floor);
+  }
+  const std::vector<Portal> & getPortals() const { return portals_; }
+
+  // event is added to last floor
+  void addEvent(std::size_t tick, ScenarioEvent && event);
+  // next events are added to new floor
+  void addFloor() { floors_.emplace_back(); }
+  // throws std::invalid_argument if floors or cells don't exist or rates are wrong
+  void addPortal(const Portal & portal);
+
+  // events are copied so scenario can be applied several times
+  void apply(SimulationMap & map, std::size_t tick, std::size_t floor = 0) const;
+  void apply(Building & building, std::size_t tick) const;
+  // events of floor 0 are passed to partitions they touch
+  void apply(PartitionedMap & map, std::size_t tick) const;
+
+  // empty floors linked by portals, events are applied to them later
+  Building makeBuilding() const;
+};
+
+// throws std::invalid_argument with line number on bad input
+Scenario readScenario(std::istream & in);
+
+Subject::Type fromSubjectTypeName(const std::string & name);
+const char * toSubjectTypeName(Subject::Type type);
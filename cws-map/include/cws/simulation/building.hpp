@@ -0,0 +1,70 @@
+#pragma once
+
+#include "cws/map_stage.hpp"
+#include "cws/simulation/simulation_map.hpp"
+#include "cws/simulation/workers.hpp"
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <vector>
+
+/*
+ * Portal couples cell of one floor with cell of another one, e.g. stairwell or HVAC
+ * shaft. Rates are shares passed through it on each tick:
+ * - air: share of air of both cells mixed between them
+ * - light: share of illumination of cell spread from the other cell
+ * - wireless: share of signal power of packets relayed to the other cell
+ */
+struct Portal final {
+  std::size_t lowerFloor;
+  Coordinates lower;
+  std::size_t upperFloor;
+  Coordinates upper;
+  double airRate = 0;
+  double lightRate = 0;
+  double wirelessRate = 0;
+};
+
+// throws std::invalid_argument if floors or cells don't exist or rates are wrong
+void checkPortal(const Portal & portal, std::span<const Dimension> floors);
+
+/*
+ * Floors of a building linked by portals. Floors are computed in parallel as
+ * separate maps, then portals exchange air, light and wireless packets between them.
+ *
+ * Air is mixed on the same tick, light and packets are spread on the other floor on
+ * next one. Light and packets pass one portal, so shaft through several floors is
+ * linked by portal to each of them.
+ */
+class Building final {
+  std::vector<SimulationMap> floors_;
+  std::vector<Portal> portals_;
+  // shared by copies, current and next building compute in turn
+  std::shared_ptr<ParallelWorkers> workers_;
+
+public:
+  Building() = default;
+
+  // index of floor
+  std::size_t addFloor(SimulationMap && floor);
+  // throws std::invalid_argument if floors or cells don't exist or rates are wrong
+  void addPortal(const Portal & portal);
+
+  std::size_t getFloorCount() const { return floors_.size(); }
+  const SimulationMap & getFloor(std::size_t floor) const { return floors_.at(floor); }
+  SimulationMap & accessFloor(std::size_t floor) { return floors_.at(floor); }
+  const std::vector<Portal> & getPortals() const { return portals_; }
+
+  /*
+   * Current state (this) is equal to passed one, like in Map::next. Floors are
+   * computed by `threads` threads (hardware concurrency if 0) kept between ticks,
+   * times of floors are filled if passed
+   */
+  void next(const Building & cur, unsigned threads = 0,
+            std::vector<MapStageTimes> * times = nullptr);
+
+private:
+  void exchangeAir(const Portal & portal);
+  void exchangeLight(const Portal & portal);
+  void exchangeWireless(const Portal & portal);
+};
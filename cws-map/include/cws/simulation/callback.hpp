@@ -2,10 +2,17 @@
 
 #include "cws/network/packet.hpp"
 #include "cws/subject/plain.hpp"
+#include <list>
 #include <memory>
 
+/*
+ * Callbacks of SubjectCallbackQuery used by services and scenario. Journal
+ * recognizes them, so queries with them are replayed
+ */
 using PacketList = std::list<std::unique_ptr<Network::Packet>>;
 
+// data is PacketList
 void addPacketToTransmitQueue(Subject::Plain * plain, void * data);
 
+// data is Subject::TurnableStatus
 void setTurnableStatus(Subject::Plain * plain, void * data);
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "cws/simulation/interface.hpp"
+#include "cws/simulation/simulation_map.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct CheckpointOptions final {
+  std::string directory;
+  std::size_t everyTicks = 0;       // 0 to disable
+  std::chrono::seconds every{0};    // 0 to disable
+  std::size_t deltasPerFull = 9;    // written between full checkpoints
+  std::size_t keepFull = 2;         // full checkpoints kept with their deltas
+};
+
+struct RestoredCheckpoint final {
+  std::size_t tick = 0;
+  std::unique_ptr<SimulationMap> map;// nullptr if directory has no checkpoint
+};
+
+/*
+ * Writes published maps to directory from its own thread, so master is never
+ * waited for. Checkpoint is a full snapshot or delta of cells changed since last
+ * full one, files are named `<sequence>-<tick>.full` and
+ * `<sequence>-<tick>-<base sequence>.delta`
+ */
+class Checkpointer final {
+  const SimulationInterface & interface_;
+  CheckpointOptions options_;
+
+  // accessed by worker only
+  std::size_t sequence_ = 0;
+  std::size_t baseSequence_ = 0;
+  Dimension baseDim_{0, 0};
+  std::vector<std::uint64_t> baseHashes_;// empty if next checkpoint is full
+  std::size_t deltas_ = 0;
+
+  std::jthread worker_;
+
+public:
+  // worker is started if any period is set, throws std::system_error if directory
+  // can't be created
+  Checkpointer(const SimulationInterface & interface, CheckpointOptions options);
+
+  Checkpointer(const Checkpointer &) = delete;
+  Checkpointer & operator=(const Checkpointer &) = delete;
+
+  // newest checkpoint which can be read not after `maxTick`, older ones are tried
+  // if it is broken
+  static RestoredCheckpoint
+  restore(const std::string & directory,
+          std::size_t maxTick = std::numeric_limits<std::size_t>::max());
+
+  // called by worker, public to write checkpoint of map explicitly
+  void write(std::size_t tick, const SimulationMap & map);
+
+private:
+  void execute(std::stop_token stoken);
+  void removeExpired();
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "cws/simulation/general.hpp"
+#include "cws/simulation/simulation_map.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <span>
+#include <string>
+#include <vector>
+
+/*
+ * Map import is built from chunks of subjects and air, e.g. messages of client
+ * stream or parts of file. Chunks are produced and checked by pool of threads, then
+ * whole import is queued as one query, so it is applied at tick boundary at once
+ */
+class MapImporter final {
+public:
+  using Chunk = std::function<MapImportQuery()>;
+
+private:
+  Dimension dimension_;
+  const SimulationMap * map_;
+  std::vector<Chunk> chunks_;
+
+public:
+  // subjects are checked not to be in map if it is passed
+  explicit MapImporter(Dimension dimension, const SimulationMap * map = nullptr)
+      : dimension_(dimension), map_(map) {}
+
+  // chunk may throw std::invalid_argument, it is called by one of threads of build
+  void add(Chunk chunk) { chunks_.push_back(std::move(chunk)); }
+  std::size_t getChunkCount() const { return chunks_.size(); }
+
+  // items keep order of chunks, throws std::invalid_argument for first broken chunk
+  MapImportQuery build(unsigned threads = 0);
+
+private:
+  void check(const MapImportQuery & chunk) const;
+};
+
+/*
+ * File of map import: optional dimension of new map, then chunks of subjects and air
+ * with their coordinates in records of snapshot. Chunks are stored with their sizes,
+ * so they are parsed in parallel
+ */
+constexpr std::uint32_t MAP_IMPORT_VERSION = 1;
+
+struct MapImport final {
+  Optional<Dimension> dimension;// new map is created for import if set
+  MapImportQuery query;
+};
+
+// chunk has up to `chunkSize` subjects and as many air
+void writeMapImport(std::ostream & out, const MapImport & import,
+                    std::size_t chunkSize = 4096);
+
+// checked against map if import has no dimension, throws std::invalid_argument
+MapImport readMapImport(std::span<const std::byte> data, const SimulationMap * map);
+
+// throws std::system_error if file can't be read
+MapImport loadMapImport(const std::string & path, const SimulationMap * map);
@@ -1,14 +1,24 @@
 #pragma once
 
+#include <chrono>
+#include <condition_variable>
 #include <cstddef>
 #include <mutex>
 #include <queue>
 #include <shared_mutex>
 
+#include "cws/profiler.hpp"
 #include "cws/simulation/general.hpp"
 #include "cws/simulation/simulation_map.hpp"
 
 class SimulationMaster;
+class Journal;
+
+struct MapSnapshot final {
+  std::size_t version = 0;// incremented on every published map
+  std::size_t tick = 0;
+  std::shared_ptr<const SimulationMap> map;
+};
 
 class SimulationInterface final {
   friend SimulationMaster;
@@ -18,6 +28,10 @@ class SimulationInterface final {
 
 private:
   SimulationMaster * master;
+  Journal * journal = nullptr;// applied queries are recorded to it if set
+  std::size_t maxCells = 0;   // of map set by clients, no limit if 0
+  AirSleeping airSleeping;    // of every map of simulation
+  AirStepping airStepping;
 
   struct {
     SimulationStateIn state;
@@ -29,39 +43,76 @@ private:
     Queue<AirInsertQuery> airQueries;
     mutable std::mutex airQMutex;
 
+    Queue<AirRegionQuery> airRegionQueries;
+    mutable std::mutex airRegionMutex;
+
     Queue<std::unique_ptr<SubjectCallbackQ>> callbQueries;
     mutable std::mutex callbMutex;
 
+    Queue<MapImportQuery> importQueries;
+    mutable std::mutex importMutex;
+
     Optional<Dimension> dimension;// if set then new map creation request
+    std::unique_ptr<SimulationMap> map;// if set then replaces map, after dimension
     mutable std::mutex dimensionMutex;
   } in;
 
   struct {
     SimulationState state;
     std::shared_ptr<const SimulationMap> map;
+    std::size_t mapVersion = 0;
+    std::size_t mapTick = 0;
     mutable std::shared_mutex mutex;
+    mutable std::condition_variable_any mapPublished;
   } out;
 
+  TickProfiler profiler;// recorded by master once per processed tick
+
 public:
   SimulationInterface(){};
 
   void setSimulationMaster(SimulationMaster * master) { this->master = master; }
+  // set before run
+  void setJournal(Journal * journal) { this->journal = journal; }
+  // set before run, memory of map grows with its cells
+  void setMaxCells(std::size_t maxCells) { this->maxCells = maxCells; }
+  // set before run
+  void setAirSleeping(const AirSleeping & airSleeping) {
+    this->airSleeping = airSleeping;
+  }
+  // set before run
+  void setAirStepping(const AirStepping & airStepping) {
+    this->airStepping = airStepping;
+  }
 
   SimulationState getState() const;
   void setState(const SimulationStateIn & newState);
 
-  void setDimension(const Dimension & dimension);
+  // false if map would exceed cell limit, nothing is set then
+  bool setDimension(const Dimension & dimension);
+  // map is taken by master on next tick, e.g. restored from snapshot
+  bool setMap(std::unique_ptr<SimulationMap> && map);
 
   std::shared_ptr<const SimulationMap> getMap() const;
 
+  // waits until map newer than `version` is published, current snapshot on timeout
+  MapSnapshot waitMap(std::size_t version, std::chrono::milliseconds timeout) const;
+
+  const TickProfiler & getProfiler() const { return profiler; }
+
   void addModifyQuery(SubjectModifyQuery && query);
   void addModifyQuery(AirInsertQuery && query);
+  // applied after air inserts of the same tick
+  void addModifyQuery(AirRegionQuery && query);
   void addModifyQuery(std::unique_ptr<SubjectCallbackQ> && query);
+  // applied after other queries of the same tick
+  void addModifyQuery(MapImportQuery && query);
 
 private:
   SimulationStateIn masterGetState();
 
   Optional<Dimension> masterGetDimension();
+  std::unique_ptr<SimulationMap> masterGetMap();
 
   std::pair<std::unique_lock<std::mutex> &&, Queue<SubjectModifyQuery> &>
   masterAccessSubjectMQs();
@@ -69,9 +120,15 @@ private:
   std::pair<std::unique_lock<std::mutex> &&, Queue<AirInsertQuery> &>
   masterAccessAirMQs();
 
+  std::pair<std::unique_lock<std::mutex> &&, Queue<AirRegionQuery> &>
+  masterAccessAirRegionMQs();
+
   std::pair<std::unique_lock<std::mutex> &&, Queue<std::unique_ptr<SubjectCallbackQ>> &>
   masterAccessCallbackMQs();
 
+  std::pair<std::unique_lock<std::mutex> &&, Queue<MapImportQuery> &>
+  masterAccessImportMQs();
+
   void masterSet(const SimulationState & state, const SimulationMap * map);
   void masterSet(const SimulationState & state);
 
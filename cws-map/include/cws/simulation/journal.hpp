@@ -0,0 +1,115 @@
+#pragma once
+
+#include "cws/simulation/record.hpp"
+#include "cws/simulation/simulation_map.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Append-only journal of queries applied by master, each with tick it was applied
+ * on. Master only copies records to memory, own thread writes them in batches with
+ * one write and fdatasync per batch (group commit). Batch is stored with its size
+ * and tick reached by master, so batch torn by crash is dropped on read.
+ *
+ * Callback queries are recorded for callbacks of cws/simulation/callback.hpp only.
+ * Reset is recorded when map is replaced or tick is set, replay starts after the
+ * last one
+ */
+constexpr std::uint32_t JOURNAL_VERSION = 1;
+
+class Journal final {
+  static constexpr std::size_t BATCH_SIZE = 1 << 20;// committed early if exceeded
+
+  int fd_;
+  std::chrono::milliseconds interval_;
+
+  std::mutex mutex_;
+  std::condition_variable_any wake_;
+  std::condition_variable committed_;
+  RecordWriter pending_;
+  std::size_t recordedCount_ = 0;
+  std::size_t committedCount_ = 0;
+  bool commitRequested_ = false;
+
+  std::atomic<std::size_t> tick_ = 0;
+  std::size_t writtenTick_ = 0;// worker only
+  std::size_t skipped_ = 0;    // callbacks which can't be recorded, master only
+
+  std::jthread worker_;
+
+public:
+  // opened for append, throws std::system_error
+  explicit Journal(const std::string & path,
+                   std::chrono::milliseconds interval = std::chrono::milliseconds(100));
+  ~Journal();
+
+  Journal(const Journal &) = delete;
+  Journal & operator=(const Journal &) = delete;
+
+  // tick whose map is computed, stored with next batch
+  void setTick(std::size_t tick) { tick_.store(tick, std::memory_order_relaxed); }
+
+  void recordReset(std::size_t tick);
+  void record(std::size_t tick, const SubjectModifyQuery & query);
+  void record(std::size_t tick, const AirInsertQuery & query);
+  void record(std::size_t tick, const AirRegionQuery & query);
+  void record(std::size_t tick, SubjectCallbackQ & query);
+  void record(std::size_t tick, const MapImportQuery & query);
+
+  // blocks until everything recorded before is written
+  void commit();
+
+private:
+  void execute(std::stop_token stoken);
+  void write(const std::string & batch, std::size_t tick);
+
+  template<typename Body>
+  void append(std::size_t tick, std::uint8_t type, Body && body);
+};
+
+/*
+ * Records of journal after its last reset. Map published at some tick is brought
+ * to later one as master does: records of tick are applied to next map, next map
+ * is computed from current one
+ */
+class JournalReplay final {
+  struct Record final {
+    std::size_t tick;
+    std::uint8_t type;
+    std::span<const std::byte> body;
+  };
+
+  std::vector<std::byte> data_;
+  std::vector<Record> records_;
+  std::size_t resetTick_ = 0;
+  std::size_t endTick_ = 0;
+
+public:
+  // throws std::system_error if file can't be read and std::invalid_argument if
+  // it is not journal
+  explicit JournalReplay(const std::string & path);
+
+  // records refer to data
+  JournalReplay(const JournalReplay &) = delete;
+  JournalReplay & operator=(const JournalReplay &) = delete;
+
+  std::size_t getResetTick() const { return resetTick_; }
+  // tick reached by master before journal ended
+  std::size_t getEndTick() const { return endTick_; }
+
+  // applies records of tick in order they were applied, returns their count
+  std::size_t apply(SimulationMap & map, std::size_t tick) const;
+
+  // map published at `tick` brought to `toTick`, tick can't be before reset
+  std::unique_ptr<SimulationMap> replay(std::unique_ptr<SimulationMap> map,
+                                        std::size_t tick, std::size_t toTick) const;
+};
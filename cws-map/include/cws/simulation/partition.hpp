@@ -0,0 +1,112 @@
+#pragma once
+
+#include "cws/map_stage.hpp"
+#include "cws/simulation/record.hpp"
+#include "cws/simulation/simulation_map.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+#include <vector>
+
+struct CellRect final {
+  Coordinates origin;
+  Dimension size;
+
+  bool empty() const { return size.width <= 0 || size.height <= 0; }
+  // empty if rectangles don't overlap
+  CellRect intersect(const CellRect & other) const;
+  // grown by `cells` on each side and clipped by map
+  CellRect expand(int cells, Dimension dim) const;
+};
+
+// columns x rows rectangles, sizes differ by one cell at most, row by row
+std::vector<CellRect> splitMap(Dimension dim, int columns, int rows);
+
+struct PartitionOptions final {
+  int columns = 2;
+  int rows = 1;
+  // cells copied from neighbours around partition, air needs 2
+  int halo = 2;
+};
+
+/*
+ * Map split into rectangles, each one computed by own worker process forked on
+ * construction. Worker keeps its rectangle with halo of neighbour cells around it.
+ * After each tick workers send their cells from halos of neighbours to them over
+ * unix sockets, so air and obstruction are the same as of one map.
+ *
+ * Light and wireless signal cross partitions further than halo, so their stages run
+ * here over the whole map in the middle of tick: workers send light obstruction
+ * changed by tick, active light sources and transmitted containers of their cells,
+ * illumination and containers received by their devices are sent back. Cameras are
+ * read from gathered map, which has illumination of the whole map. Cables connect
+ * subjects of the same partition only.
+ *
+ * Queries are passed to partitions whose cells or halo they touch and applied before
+ * next tick. Partitioned map should be created before other threads are started, as
+ * process is forked
+ */
+class PartitionedMap final {
+  struct Worker final {
+    pid_t pid = -1;
+    int socket = -1;// to coordinator
+    CellRect owned;
+    CellRect extended;   // with halo
+    RecordWriter queries;// sent with next tick
+  };
+
+  Dimension dimension_;
+  PartitionOptions options_;
+  std::vector<Worker> workers_;
+
+  // of the whole map, obstruction is kept up to date by changes sent by workers
+  MapLayerObstruction obstruction_;
+  MapLayerIllumination illumination_;
+  MapLayerIllumination nextIllumination_;
+  MapLayerNetworkWireless wireless_;
+
+public:
+  // throws std::invalid_argument on bad options, std::system_error if not forked
+  PartitionedMap(const SimulationMap & map, PartitionOptions options);
+  ~PartitionedMap();
+
+  PartitionedMap(const PartitionedMap &) = delete;
+  PartitionedMap & operator=(const PartitionedMap &) = delete;
+
+  Dimension getDimension() const { return dimension_; }
+  std::size_t getPartitionCount() const { return workers_.size(); }
+  const CellRect & getPartition(std::size_t i) const { return workers_.at(i).owned; }
+
+  // replaces cells of all partitions
+  void load(const SimulationMap & map);
+
+  // as of SimulationMap, out of map ones are dropped. Callback queries are passed
+  // for callbacks of cws/simulation/callback.hpp only, others throw
+  // std::invalid_argument
+  void modify(SubjectModifyQuery && query);
+  void modify(AirInsertQuery && query);
+  void modify(AirRegionQuery && query);
+  void modify(SubjectCallbackQ && query);
+  void modify(CableModifyQuery && query);
+
+  // one tick of all partitions, stage time is the longest one of partitions
+  void next(MapStageTimes * times = nullptr);
+
+  // cells of partitions are written to map of the same dimension and set up as after
+  // tick, cables are kept
+  void gather(SimulationMap & map) const;
+
+private:
+  // query is put for each partition whose extended rectangle has cell `c`, with
+  // coordinates local to it
+  template<typename Put>
+  void queue(Coordinates c, Put && put);
+
+  void send(std::size_t i, std::uint32_t command, std::string_view payload) const;
+  // payload of reply, throws std::runtime_error if worker failed
+  std::string receive(std::size_t i) const;
+  // workers are asked to exit and waited
+  void stop();
+};
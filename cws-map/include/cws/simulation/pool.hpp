@@ -0,0 +1,54 @@
+#pragma once
+
+#include "cws/simulation/simulation.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Masters of many small simulations stepped by fixed count of threads instead of two
+ * own threads each. Master due earliest is stepped first, and its next tick is due
+ * one task period after start of this one. So when pool is overloaded, every
+ * simulation is slowed down the same and none is starved or catches up in bursts.
+ * Tick rate of simulation may be capped below its task frequency
+ */
+class SimulationPool final {
+  using Clock = std::chrono::steady_clock;
+
+  struct Entry final {
+    SimulationMaster * master;
+    std::chrono::nanoseconds minPeriod;// by tick rate limit
+    Clock::time_point due;
+    bool busy = false;
+    bool removed = false;
+    bool failed = false;// by exception of tick, it isn't stepped anymore
+  };
+
+  std::mutex mutex_;
+  std::condition_variable_any changed_;
+  std::list<Entry> entries_;
+  std::size_t version_ = 0;// changed when entry is added, removed or stepped
+  std::vector<std::jthread> workers_;
+
+public:
+  // hardware concurrency if threads is 0
+  explicit SimulationPool(unsigned threads = 0);
+
+  SimulationPool(const SimulationPool &) = delete;
+  SimulationPool & operator=(const SimulationPool &) = delete;
+
+  // stepped until removed, not more than maxTickRate times per second if it's set
+  void add(SimulationMaster & master, double maxTickRate = 0);
+  // waits for tick of master in progress
+  void remove(SimulationMaster & master);
+
+  std::size_t size();
+  unsigned getThreadCount() const { return workers_.size(); }
+
+private:
+  void execute(std::stop_token stoken);
+};
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "cws/air/plain.hpp"
+#include "cws/common.hpp"
+#include "cws/network/packet.hpp"
+#include "cws/subject/extension/turnable.hpp"
+#include "cws/subject/plain.hpp"
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+/*
+ * Binary form of subjects, air and packets shared by snapshots and journal. Values are
+ * appended to buffer in byte order of host, subject is stored with its id first
+ * and then parameters of its type
+ */
+class RecordWriter {
+protected:
+  std::string buffer_;
+
+public:
+  const std::string & getBuffer() const { return buffer_; }
+  void clear() { buffer_.clear(); }
+  std::string release() { return std::exchange(buffer_, {}); }
+
+  std::size_t mark() const { return buffer_.size(); }
+  // drops values put after mark
+  void rollback(std::size_t mark) { buffer_.resize(mark); }
+
+  void putBytes(const void * data, std::size_t size) {
+    buffer_.append(static_cast<const char *>(data), size);
+  }
+
+  template<typename T>
+  void put(T value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    putBytes(&value, sizeof(T));
+  }
+
+  // overwrites value put at mark, e.g. size known after record is written
+  template<typename T>
+  void putAt(std::size_t mark, T value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    std::memcpy(buffer_.data() + mark, &value, sizeof(T));
+  }
+
+  void putCoordinates(Coordinates c) {
+    put<std::int32_t>(c.x);
+    put<std::int32_t>(c.y);
+  }
+
+  void putPhysical(const Physical & physical);
+  void putSubjectId(const Subject::Id & id);
+  void putSubject(const Subject::Plain & subject);
+  void putAir(const Air::Plain & air);
+  // content only, size first
+  void putPacket(const Network::Packet & packet);
+};
+
+// throws std::invalid_argument on truncated or malformed data
+class RecordReader {
+protected:
+  std::span<const std::byte> data_;
+  std::size_t offset_ = 0;
+  const char * source_;// prefix of errors
+
+public:
+  RecordReader(std::span<const std::byte> data, const char * source)
+      : data_(data), source_(source) {}
+
+  std::size_t getOffset() const { return offset_; }
+  std::size_t getRemaining() const { return data_.size() - offset_; }
+
+  [[noreturn]] void error(const std::string & what) const;
+
+  template<typename T>
+  T get() {
+    static_assert(std::is_trivially_copyable_v<T>);
+    if (getRemaining() < sizeof(T)) {
+      error("unexpected end of data");
+    }
+    T value;
+    std::memcpy(&value, data_.data() + offset_, sizeof(T));
+    offset_ += sizeof(T);
+    return value;
+  }
+
+  std::span<const std::byte> getBytes(std::size_t size);
+
+  // checked to be inside of dimension
+  Coordinates getCoordinates(Dimension dim);
+  // any, e.g. of item made for other map and dropped when applied
+  Coordinates getCoordinates();
+
+  Physical getPhysical();
+  Subject::Id getSubjectId();
+  Subject::TurnableStatus getStatus();
+  std::unique_ptr<Subject::Plain> getSubject();
+  std::unique_ptr<Air::Plain> getAir();
+  std::unique_ptr<Network::Packet> getPacket();
+
+private:
+  template<typename Camera>
+  std::unique_ptr<Subject::Plain> getCamera(Subject::Plain && plain);
+};
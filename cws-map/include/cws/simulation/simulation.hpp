@@ -4,6 +4,7 @@
 #include "cws/map.hpp"
 #include "cws/simulation/general.hpp"
 #include "cws/simulation/simulation_map.hpp"
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
 #include <shared_mutex>
@@ -48,6 +49,7 @@ class SimulationMaster final {
 
   std::unique_ptr<SimulationMap> currMap;
   std::unique_ptr<SimulationMap> nextMap;
+  MapStageTimes nextMapTimes;
 
   bool runReady = false;
   bool runProcessed = false;
@@ -61,12 +63,20 @@ public:
   void wait();
   void exit();
 
+  /*
+   * One tick processed on calling thread instead of run, e.g. by SimulationPool.
+   * Returns time tick should take by task frequency
+   */
+  std::chrono::nanoseconds step();
+
   bool mapsExist();
 
 private:
   void execute(std::stop_token stoken);
 
   bool processStopRequest(const std::stop_token & stoken);
+  // next map is computed by slave or on calling thread
+  void processTick(bool bySlave);
 
   void updateState();
   void updateMap();
@@ -76,4 +86,5 @@ private:
   void waitDurationExceeds(
       const SimulationState & state,
       const std::chrono::time_point<std::chrono::high_resolution_clock> & start);
+  static std::chrono::nanoseconds getTickDuration(const SimulationState & state);
 };
@@ -2,6 +2,8 @@
 
 #include "cws/map.hpp"
 #include <functional>
+#include <unordered_map>
+#include <vector>
 
 enum SubjectModifyType {
   UNSPECIFIED = 0,
@@ -44,6 +46,39 @@ public:
   AirSelectQuery(Coordinates c, Air::Id id) : coordinates(c), id(id) {}
 };
 
+enum class AirRegionModifyType {
+  FILL = 1,
+  SCALE = 2,
+  SET_TEMPERATURE = 3,
+};
+
+// air of all cells of region changed in one pass
+struct AirRegionQuery final {
+  AirRegionModifyType queryType;
+  CellRegion region;
+  std::unique_ptr<Air::Plain> air;// FILL, added to every cell with its weight
+  double factor = 1;              // SCALE, air scaled to zero is removed
+  Temperature temperature{0};     // SET_TEMPERATURE, of cells with air
+};
+
+// subjects and air inserted at once, e.g. floor built by client
+struct MapImportQuery final {
+  std::vector<SubjectModifyQuery> subjects;// INSERT only
+  std::vector<AirInsertQuery> air;
+};
+
+enum class CableModifyType {
+  CONNECT = 1,
+  DISCONNECT = 2,
+};
+
+// cable of wired network between two subjects
+struct CableModifyQuery final {
+  CableModifyType queryType;
+  Subject::Id first;
+  Subject::Id second;
+};
+
 struct SubjectCallbackQ {
   SubjectSelectQuery select;
   std::function<void(Subject::Plain *, void * data)> callback;
@@ -74,26 +109,76 @@ public:
 
 /*
  * Map with extended feature to update map from queries
+ *
+ * Subjects are indexed by id, so they are found without scanning cells and
+ * without coordinates. Index is copied and remapped to own subjects on copy.
  */
 class SimulationMap : public Map {
+  friend class SnapshotReader;
+  friend class Building;
+  friend class PartitionedMap;
+  friend class PartitionWorker;
+
+  using SubjectSlot = std::list<std::unique_ptr<Subject::Plain>>::iterator;
+  using SubjectSlotConst = std::list<std::unique_ptr<Subject::Plain>>::const_iterator;
+
+  struct SubjectLocation final {
+    Coordinates coordinates;
+    SubjectSlot slot;
+  };
+
+  // ids are unique within cell only
+  using SubjectIndex =
+      std::unordered_multimap<Subject::Id, SubjectLocation, Subject::IdHash>;
+  SubjectIndex subjectIndex_;
 
 public:
   explicit SimulationMap(Dimension dimension) : Map(dimension) {}
 
+  SimulationMap(const SimulationMap & map);
+  SimulationMap(SimulationMap && map) = default;
+  SimulationMap & operator=(const SimulationMap & map);
+  SimulationMap & operator=(SimulationMap && map) = default;
+
   virtual SimulationMap * clone() { return new SimulationMap(*this); }
 
+  bool isInside(Coordinates c) const {
+    return c.x >= 0 && c.x < dimension.width && c.y >= 0 && c.y < dimension.height;
+  }
+
+  /*
+   * Queries are checked against map they were made for, but map may be replaced
+   * by other dimension before they are applied, so items out of map are dropped
+   */
   void modify(SubjectModifyQuery && query);
   const Subject::Plain * select(const SubjectSelectQuery & query) const;
+  // subject in any cell, nullptr if none, coordinates are set if passed
+  const Subject::Plain * select(const Subject::Id & id,
+                                Coordinates * coordinates = nullptr) const;
 
   void modify(AirInsertQuery && query);
   const Air::Plain * select(const AirSelectQuery & query) const;
+  void modify(AirRegionQuery && query);
 
   void modify(SubjectCallbackQ && query);
 
+  // index is grown once, air of each cell is added and normalized once
+  void modify(MapImportQuery && query);
+
+  // false if nothing changed
+  bool modify(CableModifyQuery && query);
+
 private:
   Subject::Plain * select(const SubjectSelectQuery & query);
   void modifyInsert(SubjectModifyQuery && query);
   void modifyInsert(AirInsertQuery && query);
   void modifyUpdate(SubjectModifyQuery && query);
   void modifyDelete(SubjectModifyQuery && query);
+
+  void rebuildSubjectIndex();
+  void remapSubjectIndex(const SimulationMap & source);
+  // subjects of cell, e.g. before and after its list is replaced
+  void unindexCell(Coordinates c);
+  void indexCell(Coordinates c);
+  SubjectIndex::const_iterator findIndexed(const SubjectSelectQuery & query) const;
 };
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "cws/simulation/simulation_map.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <span>
+#include <string>
+#include <vector>
+
+/*
+ * Binary snapshot of simulation map: dimension, then record of every cell with its
+ * obstruction, illumination, air by Air::Id and subjects by Subject::Type, then
+ * cables of wired network and state of air stepping and sleeping tiles. Values are
+ * stored in byte order of host. Packets in buffers of network devices are stored
+ * after records of their devices.
+ *
+ * Delta has records of cells changed since base snapshot only, cells are compared
+ * by hashes of their records returned on write of base.
+ *
+ * Snapshot is written from published (const) map, so simulation keeps running
+ * while it is saved
+ */
+constexpr std::uint32_t SNAPSHOT_VERSION = 4;
+
+// returns hashes of cell records, x outer
+std::vector<std::uint64_t> writeSnapshot(std::ostream & out, const SimulationMap & map);
+
+// written to temporary file first and renamed, throws std::system_error
+std::vector<std::uint64_t> saveSnapshot(const std::string & path,
+                                        const SimulationMap & map);
+
+// returns number of changed cells, base must have same dimension
+std::size_t writeSnapshotDelta(std::ostream & out, const SimulationMap & map,
+                               std::uint64_t baseId,
+                               std::span<const std::uint64_t> baseHashes);
+
+std::size_t saveSnapshotDelta(const std::string & path, const SimulationMap & map,
+                              std::uint64_t baseId,
+                              std::span<const std::uint64_t> baseHashes);
+
+// throws std::invalid_argument if data is not snapshot of supported version
+std::unique_ptr<SimulationMap> readSnapshot(std::span<const std::byte> data);
+
+// file is mapped into memory and read in place, throws std::system_error
+std::unique_ptr<SimulationMap> loadSnapshot(const std::string & path);
+
+// applied on top of base snapshot, returns id of base passed on write
+std::uint64_t readSnapshotDelta(SimulationMap & map, std::span<const std::byte> data);
+
+std::uint64_t loadSnapshotDelta(SimulationMap & map, const std::string & path);
+
+/*
+ * Records of cells of rectangle without cables, e.g. cells passed between partitions
+ * of map. Rectangle is clipped by map
+ */
+std::string writeSnapshotRegion(const SimulationMap & map, Coordinates origin,
+                                Dimension size);
+
+// cells are placed from `origin` of map, subjects are indexed but not set up
+void readSnapshotRegion(SimulationMap & map, Coordinates origin,
+                        std::span<const std::byte> data);
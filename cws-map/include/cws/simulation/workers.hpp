@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Threads kept between parallel loops, so loop run on every tick doesn't start
+ * threads each time. Calling thread takes part in loop, one loop runs at a time
+ */
+class ParallelWorkers final {
+  std::mutex runMutex_;// held by whole loop
+
+  std::mutex mutex_;
+  std::condition_variable_any started_;
+  std::condition_variable finished_;
+  const std::function<void(std::size_t)> * task_ = nullptr;
+  std::size_t count_ = 0;
+  std::atomic<std::size_t> next_ = 0;
+  std::size_t loop_ = 0;// changed when loop starts
+  unsigned running_ = 0;
+  std::exception_ptr error_;
+
+  unsigned threadCount_;
+  std::vector<std::jthread> workers_;
+
+public:
+  // hardware concurrency if threads is 0
+  explicit ParallelWorkers(unsigned threads = 0);
+
+  ParallelWorkers(const ParallelWorkers &) = delete;
+  ParallelWorkers & operator=(const ParallelWorkers &) = delete;
+
+  unsigned getThreadCount() const { return threadCount_; }
+
+  // task(i) for each i of [0, count), first exception of tasks is rethrown
+  void run(std::size_t count, const std::function<void(std::size_t)> & task);
+
+private:
+  void execute(std::stop_token stoken);
+  void work();
+};
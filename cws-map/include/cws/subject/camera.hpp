@@ -4,18 +4,44 @@
 #include "cws/map_layer/obstruction.hpp"
 #include "cws/subject/extension/camera.hpp"
 #include "cws/subject/plain.hpp"
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace Subject {
 
+/*
+ * Part of map camera looks at. Cells farther than range from camera or outside of
+ * cone of fov degrees around direction are not searched
+ */
+struct CameraView final {
+  int range = 0;         // cells, 0 - unlimited
+  double direction = 0;  // degrees, 0 - along x, 90 - along y
+  double fov = 360;      // degrees, 360 - all directions
+};
+
 class BaseCamera : public Plain, public ExtCamera {
 public:
   using PCoordPlain = std::pair<Coordinates, Plain &>;
 
+  struct VisibleSubject final {
+    Coordinates coordinates;
+    Id id;
+  };
+
 private:
   Coordinates cameraCoord_;
   const MapLayerSubject * layerSubject_;
   double power_;
   double powerThreshold_;
+  CameraView view_;
+
+  // result of search, filled on first read and shared by clones of camera
+  struct VisibleCache final {
+    std::once_flag filled;
+    std::vector<VisibleSubject> subjects;
+  };
+  std::shared_ptr<VisibleCache> visible_ = std::make_shared<VisibleCache>();
 
 public:
   BaseCamera(Plain && plain, double power, double powerThreshold)
@@ -28,10 +54,25 @@ public:
   double getPower() const { return power_; }
   double getPowerThreshold() const { return powerThreshold_; }
 
+  const CameraView & getView() const { return view_; }
+  void setView(const CameraView & view) {
+    view_ = view;
+    visible_ = std::make_shared<VisibleCache>();
+  }
+
+  // result of previous setup is dropped
   void setup(Coordinates cameraCoord, const MapLayerSubject & layerSubject) {
     cameraCoord_ = cameraCoord;
     layerSubject_ = &layerSubject;
+    visible_ = std::make_shared<VisibleCache>();
   }
+
+  /*
+   * Result of getVisibleSubjects searched on first call after setup, so cameras
+   * nobody looks at cost nothing. Later calls, also from other threads and clones,
+   * return the same result until next setup
+   */
+  const std::vector<VisibleSubject> & getVisible() const;
 };
 
 class InfraredCamera : public BaseCamera {
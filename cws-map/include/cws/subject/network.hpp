@@ -49,6 +49,10 @@ public:
   }
 
   void clearReceiveBuffer() final override { receivedPackets_.clear(); }
+  // e.g. restored from snapshot
+  void setReceivedPackets(std::list<PacketUPTR> && packets) {
+    receivedPackets_ = std::move(packets);
+  }
 };
 
 class WirelessNetworkDevice : public NetworkDevice {
@@ -79,4 +83,25 @@ public:
       Network::Type type) override;
 };
 
+/*
+ * Device connected to wired network by cables, it receives packets routed to its
+ * id only. Cables are kept by MapLayerNetworkWired
+ */
+class WiredNetworkDevice : public NetworkDevice {
+public:
+  WiredNetworkDevice(Plain && plain)
+      : NetworkDevice(std::move(plain), Network::Type::WIRED) {
+    setType(Type::WIRED_NETWORK_DEVICE);
+  }
+
+  WiredNetworkDevice * clone() const override { return new WiredNetworkDevice(*this); }
+
+  virtual std::list<std::unique_ptr<Network::Container>>
+  collectNetworkContainers(Network::Type type) const override;
+
+  virtual void placeNetworkContainers(
+      const std::list<std::unique_ptr<Network::Container>> & containerList,
+      Network::Type type) override;
+};
+
 }// namespace Subject
@@ -2,6 +2,7 @@
 
 #include "cws/physical.hpp"
 #include "cws/subject/type.hpp"
+#include <functional>
 
 namespace Subject {
 
@@ -16,6 +17,12 @@ protected:
   friend bool operator==(const Id &, const Id &);
 };
 
+struct IdHash final {
+  std::size_t operator()(const Id & id) const {
+    return std::hash<int>()(id.idx) ^ (static_cast<std::size_t>(id.type) << 20);
+  }
+};
+
 class Plain : public Physical {
   Id id_;
   double surfaceArea_;
@@ -15,6 +15,7 @@ enum class Type {
   TURNABLE = 9,
   AIR_TEMPERATURE_SENSOR = 10,
   ILLUMINATION_SENSOR = 11,
+  WIRED_NETWORK_DEVICE = 12,
 };
 
 }
@@ -76,6 +76,22 @@ void Container::updateTemperature(double heatAirTransfer) {
   normalizeTemperature();
 }
 
+void Container::setTemperature(Temperature temperature) {
+  for (const auto & air : airList) {
+    air->setTemperature(temperature);
+  }
+}
+
+void Container::scaleWeight(double factor) {
+  if (factor <= 0) {
+    airList.clear();
+    return;
+  }
+  for (auto & air : airList) {
+    air.reset(air->cloneWithWeight(air->getWeight() * factor));
+  }
+}
+
 void Container::normalizeTemperature() {
   double totalEnergy = 0;
   double totalWC = 0;
@@ -1,5 +1,6 @@
 #include "cws/air/plain.hpp"
 #include <cassert>
+#include <cmath>
 #include <iostream>
 
 using namespace Air;
@@ -44,7 +45,9 @@ Plain Plain::operator+(const Plain & rhs) {
   auto rhsHTC = rhs.getHeatTransferCoef();
 
   auto resW = lhsW + rhsW;
-  auto resHC = proportion(lhsHC, lhsW, rhsHC, rhsW);
+  // rounded, as truncation lowers heat capacity of the same air on every merge
+  auto resHC = static_cast<int>(
+      std::lround(proportion<double>(lhsHC, lhsW, rhsHC, rhsW)));
   Temperature resT = {.value = proportion(lhsT, lhsW * lhsHC, rhsT, rhsW * rhsHC)};
   Obstruction resA = {.value = proportion(lhsA, lhsW, rhsA, rhsW)};
   double resHTC = proportion(lhsHTC, lhsW, rhsHTC, rhsW);
@@ -1,4 +1,6 @@
 #include "cws/common.hpp"
+#include <algorithm>
+#include <cmath>
 #include <list>
 
 // Coordinates
@@ -100,3 +102,73 @@ int getScalarMultiplication(std::pair<int, int> v1, std::pair<int, int> v2) {
 int getDistanceSquare(std::pair<int, int> v) {
   return v.first * v.first + v.second * v.second;
 }
+
+// region comes from clients, so its ends are summed in 64 bits before clipping
+static std::vector<CellSpan> getRectangleSpans(Coordinates origin, Dimension size,
+                                               Dimension dim) {
+  std::vector<CellSpan> spans;
+  int yBegin = std::max(origin.y, 0);
+  int yEnd = static_cast<int>(std::min<long long>(
+      static_cast<long long>(origin.y) + size.height, dim.height));
+  int xEnd = static_cast<int>(
+      std::min<long long>(static_cast<long long>(origin.x) + size.width, dim.width));
+  if (yBegin >= yEnd) {
+    return spans;
+  }
+  for (int x = std::max(origin.x, 0); x < xEnd; ++x) {
+    spans.push_back(CellSpan{x, yBegin, yEnd});
+  }
+  return spans;
+}
+
+// column is crossed by its center line, which never passes through vertices
+static std::vector<CellSpan> getPolygonSpans(const std::vector<Coordinates> & polygon,
+                                             Dimension dim) {
+  std::vector<CellSpan> spans;
+  if (polygon.size() < 3) {
+    return spans;
+  }
+
+  auto [minX, maxX] = std::minmax_element(
+      polygon.begin(), polygon.end(),
+      [](const auto & a, const auto & b) { return a.x < b.x; });
+  int xBegin = std::max(minX->x, 0);
+  int xEnd = std::min(maxX->x, dim.width);
+
+  std::vector<double> crossings;
+  for (int x = xBegin; x < xEnd; ++x) {
+    double center = x + 0.5;
+    crossings.clear();
+    for (std::size_t i = 0; i < polygon.size(); ++i) {
+      auto a = polygon[i];
+      auto b = polygon[(i + 1) % polygon.size()];
+      if ((a.x < center) != (b.x < center)) {
+        // vertices are any ints, so differences are taken in double
+        crossings.push_back(a.y + (center - a.x) * (double(b.y) - a.y) /
+                                      (double(b.x) - a.x));
+      }
+    }
+    std::sort(crossings.begin(), crossings.end());
+
+    // clipped before conversion, crossing may be out of range of int
+    auto toRow = [&](double crossing) {
+      return static_cast<int>(
+          std::clamp(std::ceil(crossing - 0.5), 0., double(dim.height)));
+    };
+    for (std::size_t i = 0; i + 1 < crossings.size(); i += 2) {
+      int yBegin = toRow(crossings[i]);
+      int yEnd = toRow(crossings[i + 1]);
+      if (yBegin < yEnd) {
+        spans.push_back(CellSpan{x, yBegin, yEnd});
+      }
+    }
+  }
+  return spans;
+}
+
+std::vector<CellSpan> getCellSpans(const CellRegion & region, Dimension dim) {
+  if (!region.polygon.empty()) {
+    return getPolygonSpans(region.polygon, dim);
+  }
+  return getRectangleSpans(region.origin, region.size, dim);
+}
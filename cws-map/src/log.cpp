@@ -0,0 +1,192 @@
+#include "cws/log.hpp"
+
+#include <bit>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+
+namespace Log {
+
+const char * toString(Level level) {
+  switch (level) {
+  case Level::DEBUG:
+    return "debug";
+  case Level::INFO:
+    return "info";
+  case Level::WARN:
+    return "warn";
+  case Level::ERROR:
+    return "error";
+  }
+  return "unknown";
+}
+
+std::optional<Level> fromLevelName(const std::string & name) {
+  for (auto level : {Level::DEBUG, Level::INFO, Level::WARN, Level::ERROR}) {
+    if (name == toString(level)) {
+      return level;
+    }
+  }
+  return std::nullopt;
+}
+
+Logger::Logger(std::ostream & sink, std::size_t capacity)
+    : slots_(std::bit_ceil(std::max<std::size_t>(capacity, 2))),
+      mask_(slots_.size() - 1), sink_(sink) {
+  for (std::size_t i = 0; i < slots_.size(); ++i) {
+    slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  worker_ = std::jthread(std::bind_front(&Logger::execute, this));
+}
+
+Logger::~Logger() {
+  worker_.request_stop();
+  worker_.join();
+}
+
+static std::unique_ptr<Logger> makeLogger() {
+  auto logger = std::make_unique<Logger>(std::clog);
+  if (auto name = std::getenv("CWS_LOG_LEVEL")) {
+    if (auto level = fromLevelName(name)) {
+      logger->setLevel(*level);
+    }
+  }
+  return logger;
+}
+
+Logger & Logger::get() {
+  static std::unique_ptr<Logger> logger = makeLogger();
+  return *logger;
+}
+
+// bounded MPSC queue: slot sequence tells whether it is free for position or filled
+bool Logger::push(const Record & record) {
+  std::size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+  Slot * slot;
+
+  while (true) {
+    slot = &slots_[pos & mask_];
+    std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+    auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+
+    if (diff == 0) {
+      if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    } else {
+      pos = enqueuePos_.load(std::memory_order_relaxed);
+    }
+  }
+
+  slot->record = record;
+  slot->sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+bool Logger::pop(Record & record) {
+  std::size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+  Slot & slot = slots_[pos & mask_];
+
+  if (slot.sequence.load(std::memory_order_acquire) != pos + 1) {
+    return false;
+  }
+
+  record = slot.record;
+  slot.sequence.store(pos + slots_.size(), std::memory_order_release);
+  dequeuePos_.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+void Logger::flush() {
+  std::size_t target = enqueuePos_.load(std::memory_order_acquire);
+  while (dequeuePos_.load(std::memory_order_acquire) < target) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+void Logger::execute(std::stop_token stoken) {
+  Record record;
+  std::size_t droppedReported = 0;
+
+  while (true) {
+    bool stop = stoken.stop_requested();
+    bool written = false;
+
+    while (pop(record)) {
+      write(record);
+      written = true;
+    }
+
+    std::size_t dropped = getDropped();
+    if (dropped != droppedReported) {
+      RecordStream stream(Level::WARN, "log");
+      stream << dropped - droppedReported << " records dropped, queue is full";
+      write(stream.getRecord());
+      droppedReported = dropped;
+      written = true;
+    }
+
+    if (written) {
+      sink_.flush();
+    }
+
+    if (stop) {
+      return;
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+}
+
+void Logger::write(const Record & record) {
+  using namespace std::chrono;
+
+  auto time = system_clock::to_time_t(record.time);
+  auto ms = duration_cast<milliseconds>(record.time.time_since_epoch()).count() % 1000;
+  std::tm tm;
+  gmtime_r(&time, &tm);
+
+  sink_ << "time=" << std::put_time(&tm, "%Y-%m-%dT%H:%M:%S") << "."
+        << std::setfill('0') << std::setw(3) << ms << "Z"
+        << " level=" << toString(record.level) << " source=" << record.source
+        << " msg=\"";
+
+  for (std::size_t i = 0; i < record.length; ++i) {
+    char c = record.message[i];
+    if (c == '"' || c == '\\') {
+      sink_ << '\\' << c;
+    } else if (c == '\n') {
+      sink_ << "\\n";
+    } else {
+      sink_ << c;
+    }
+  }
+
+  sink_ << "\"\n";
+}
+
+RecordStream::RecordStream(Level level, const char * source)
+    : std::ostream(static_cast<std::streambuf *>(this)) {
+  record_.time = std::chrono::system_clock::now();
+  record_.level = level;
+  record_.source = source;
+  record_.length = 0;
+  setp(record_.message.data(), record_.message.data() + record_.message.size());
+}
+
+const Record & RecordStream::getRecord() {
+  record_.length = pptr() - pbase();
+  return record_;
+}
+
+std::streambuf::int_type RecordStream::overflow(std::streambuf::int_type ch) {
+  return std::streambuf::traits_type::not_eof(ch);// buffer is full, cut the rest
+}
+
+}// namespace Log
@@ -1,5 +1,27 @@
 #include <cws/map.hpp>
 
+Map::Map(const Map & map) : layers(map.layers), dimension(map.dimension) {
+  setupCameras();
+}
+
+Map::Map(Map && map) : layers(std::move(map.layers)), dimension(map.dimension) {
+  setupCameras();
+}
+
+Map & Map::operator=(const Map & map) {
+  layers = map.layers;
+  dimension = map.dimension;
+  setupCameras();
+  return *this;
+}
+
+Map & Map::operator=(Map && map) {
+  layers = std::move(map.layers);
+  dimension = map.dimension;
+  setupCameras();
+  return *this;
+}
+
 /*
  * Current state (this) of map is equal to passed by argument
  *
@@ -10,31 +32,83 @@
  * Update light obstruction == done
  * Update illumination == done
  *
- * Clear wireless network from previous frame == done
+ * Clear wireless and wired networks from previous frame == done
  * Collect packages from subjects == done
  * Update network (spread containers where packets are stored) == done
+ * Route wired containers by precomputed routes == done
  * Place packages in subjects == done
  *
  * Setup subjects (cameras and so on) == done
  */
-void Map::next(const Map & curMap) {
+void Map::next(const Map & curMap, MapStageTimes * times) {
+  MapStageClock clock(times);
+
+  nextUntilIllumination(curMap, clock, times);
+  layers.illuminationLayer.updateIllumination(layers.obstructionLayer,
+                                              layers.subjectLayer);
+  clock.lap(MapStage::ILLUMINATION);
+  collectNetwork(clock);
+  layers.networkWireless.updateNetwork(layers.obstructionLayer);
+  layers.networkWired.updateNetwork(layers.obstructionLayer);
+  clock.lap(MapStage::NETWORK_SPREAD);
+  receiveNetwork(clock);
+}
+
+void Map::nextBeforeSpread(const Map & curMap, MapStageTimes * times) {
+  MapStageClock clock(times);
+
+  nextUntilIllumination(curMap, clock, times);
+  collectNetwork(clock);
+  // cables don't leave map, only wireless signal is spread elsewhere
+  layers.networkWired.updateNetwork(layers.obstructionLayer);
+  clock.lap(MapStage::NETWORK_SPREAD);
+}
+
+void Map::nextAfterSpread(MapStageTimes * times) {
+  MapStageClock clock(times);
+  receiveNetwork(clock);
+}
+
+void Map::nextUntilIllumination(const Map & curMap, MapStageClock & clock,
+                                MapStageTimes * times) {
   layers.subjectLayer.nextTemperature();
+  clock.lap(MapStage::SUBJECT_TEMPERATURE);
   layers.airLayer.nextConvection(layers.subjectLayer);
+  clock.lap(MapStage::AIR_CONVECTION);
   layers.obstructionLayer.updateAirObstruction(layers.subjectLayer);
+  layers.airLayer.wakeObstructed(curMap.layers.obstructionLayer,
+                                 layers.obstructionLayer);
+  clock.lap(MapStage::AIR_OBSTRUCTION);
   layers.airLayer.nextCirculation(curMap.layers.airLayer, layers.obstructionLayer);
+  clock.lap(MapStage::AIR_CIRCULATION);
+  if (times) {
+    times->airSubsteps = layers.airLayer.getSubsteps();
+    times->activeAirTiles = layers.airLayer.getActiveTiles();
+    times->sleepingAirTiles = layers.airLayer.getSleepingTiles();
+  }
   layers.obstructionLayer.updateLightObstruction(layers.subjectLayer);
-  layers.illuminationLayer.updateIllumination(layers.obstructionLayer,
-                                              layers.subjectLayer);
+  clock.lap(MapStage::LIGHT_OBSTRUCTION);
+}
+
+void Map::collectNetwork(MapStageClock & clock) {
   // clear network from previous state
   layers.networkWireless.clearNetwork();
   layers.networkWireless.collectTransmittableContainers(layers.subjectLayer);
-  layers.networkWireless.updateNetwork(layers.obstructionLayer);
+  layers.networkWired.clearNetwork();
+  layers.networkWired.collectTransmittableContainers(layers.subjectLayer);
+  clock.lap(MapStage::NETWORK_COLLECT);
+}
 
+void Map::receiveNetwork(MapStageClock & clock) {
   layers.subjectLayer.clearNetworkBuffers();
   layers.subjectLayer.receiveContainers(layers.networkWireless);
+  layers.subjectLayer.receiveContainers(layers.networkWired,
+                                        layers.networkWired.getReceiveCells());
+  clock.lap(MapStage::NETWORK_RECEIVE);
   // like cameras and so on
   layers.subjectLayer.setupSubjects(layers.airLayer, layers.obstructionLayer,
                                     layers.illuminationLayer);
+  clock.lap(MapStage::SUBJECT_SETUP);
 }
 
 std::ostream & operator<<(std::ostream & out, const Layers * layers) {
@@ -1,22 +1,265 @@
 #include "cws/map_layer/air.hpp"
 #include "cws/common.hpp"
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <limits>
 #include <map>
+#include <stdexcept>
 
 using namespace Air;
 using PlainUPTR = std::unique_ptr<Air::Plain>;
 
 static const double MASS_TEMP_ITER_COEF = 0.1;
 static const double TEMP_ITER_COEF = 10;
+// step closing more of difference between cells overshoots
+static const double STABLE_STEP_PART = 1;
+
+void MapLayerAir::fill(std::span<const CellSpan> spans, const Air::Plain & air) {
+  for (const auto & span : spans) {
+    for (int y = span.yBegin; y < span.yEnd; ++y) {
+      accessAirContainer({span.x, y}).add(PlainUPTR(air.clone()));
+    }
+  }
+}
+
+void MapLayerAir::scaleWeight(std::span<const CellSpan> spans, double factor) {
+  for (const auto & span : spans) {
+    for (int y = span.yBegin; y < span.yEnd; ++y) {
+      accessAirContainer({span.x, y}).scaleWeight(factor);
+    }
+  }
+}
+
+void MapLayerAir::setTemperature(std::span<const CellSpan> spans,
+                                 Temperature temperature) {
+  for (const auto & span : spans) {
+    for (int y = span.yBegin; y < span.yEnd; ++y) {
+      accessAirContainer({span.x, y}).setTemperature(temperature);
+    }
+  }
+}
+
+void MapLayerAir::setSleeping(const AirSleeping & sleeping) {
+  if (sleeping.tileSize < 1) {
+    throw std::invalid_argument("air: tile size should be positive");
+  }
+  bool keepTiles = sleeping.enabled && sleeping_.enabled &&
+                   sleeping.tileSize == sleeping_.tileSize;
+  sleeping_ = sleeping;
+  if (keepTiles) {
+    return;
+  }
+  tiles_.clear();
+  tileColumns_ = 0;
+  if (!sleeping_.enabled) {
+    return;
+  }
+
+  Dimension dim = getDimension();
+  int size = sleeping_.tileSize;
+  tileColumns_ = (dim.width + size - 1) / size;
+  int tileRows = (dim.height + size - 1) / size;
+  tiles_.resize(static_cast<std::size_t>(tileColumns_) * tileRows);
+}
+
+MapLayerAir::State MapLayerAir::getState() const {
+  State state{.stepping = stepping_,
+              .pendingTicks = pendingTicks_,
+              .equilibrium = equilibrium_,
+              .disturbedSteps = disturbedSteps_,
+              .stiffness = stiffness_,
+              .heating = heating_,
+              .sleeping = sleeping_};
+  state.tiles.reserve(tiles_.size());
+  for (const auto & tile : tiles_) {
+    state.tiles.emplace_back(tile.sleeping, tile.calmTicks);
+  }
+  return state;
+}
+
+void MapLayerAir::setState(const State & state) {
+  // tiles are made anew rather than kept
+  sleeping_.enabled = false;
+  setSleeping(state.sleeping);
+  if (state.tiles.size() != tiles_.size()) {
+    throw std::invalid_argument("air: tiles don't fit the map");
+  }
+  for (std::size_t i = 0; i < tiles_.size(); ++i) {
+    tiles_[i].sleeping = state.tiles[i].first;
+    tiles_[i].calmTicks = state.tiles[i].second;
+  }
+
+  stepping_ = state.stepping;
+  pendingTicks_ = state.pendingTicks;
+  equilibrium_ = state.equilibrium;
+  disturbedSteps_ = state.disturbedSteps;
+  stiffness_ = state.stiffness;
+  heating_ = state.heating;
+}
+
+std::size_t MapLayerAir::getSleepingTiles() const {
+  return std::count_if(tiles_.begin(), tiles_.end(),
+                       [](const Tile & tile) { return tile.sleeping; });
+}
+
+MapLayerAir::TileBounds MapLayerAir::getTileBounds(std::size_t i) const {
+  Dimension dim = getDimension();
+  int size = sleeping_.tileSize;
+  Coordinates begin{static_cast<int>(i % tileColumns_) * size,
+                    static_cast<int>(i / tileColumns_) * size};
+  return {begin, {std::min(begin.x + size, dim.width),
+                  std::min(begin.y + size, dim.height)}};
+}
+
+static double getHeatCapacity(const Container & container) {
+  double capacity = 0;
+  for (const auto & air : container.getList()) {
+    capacity += air->getWeight() * air->getHeatCapacity();
+  }
+  return capacity;
+}
 
 void MapLayerAir::nextConvection(MapLayerSubject & subjectLayer) {
+  // subjects heating air of sleeping tile wake it
+  for (std::size_t i = 0; i < tiles_.size(); ++i) {
+    if (!tiles_[i].sleeping) {
+      continue;
+    }
+    forEachTileCell(i, [&](Coordinates c) {
+      if (getConvectionChange(subjectLayer, c) > sleeping_.temperatureDelta) {
+        wake(c);
+      }
+    });
+  }
+
+  double maxChange = 0;
+  forEachAwakeCell([&](Coordinates c) {
+    double change = nextConvection(subjectLayer, c);
+    maxChange = std::max(maxChange, change);
+    if (!tiles_.empty()) {
+      auto & tile = tiles_[getTileIndex(c)];
+      tile.activity = std::max(tile.activity, change / sleeping_.temperatureDelta);
+    }
+  });
+  heating_ += maxChange;
+}
+
+void MapLayerAir::wakeObstructed(const MapLayerObstruction & curObstructionLayer,
+                                 const MapLayerObstruction & obstructionLayer) {
+  for (std::size_t i = 0; i < tiles_.size(); ++i) {
+    if (!tiles_[i].sleeping) {
+      continue;
+    }
+    forEachTileCell(i, [&](Coordinates c) {
+      if (curObstructionLayer.getAirObstruction(c).get() !=
+          obstructionLayer.getAirObstruction(c).get()) {
+        wake(c);
+      }
+    });
+  }
+}
+
+/*
+ * Flow between cells goes from the higher one only, so sleeping tile is woken by both
+ * hotter and colder awake neighbour. Difference is weighted by air obstruction
+ */
+void MapLayerAir::wakeDisturbed(const MapLayerAir & curLayerAir,
+                                const MapLayerObstruction & obstructionLayer) {
+  auto isDifferent = [&](Coordinates a, Coordinates b) {
+    const auto & containerA = curLayerAir.getAirContainer(a);
+    const auto & containerB = curLayerAir.getAirContainer(b);
+    if (containerA.empty() || containerB.empty()) {
+      return containerA.empty() != containerB.empty();
+    }
+    double trans = std::max(1 - obstructionLayer.getAirObstruction(a).get(), 0.) *
+                   std::max(1 - obstructionLayer.getAirObstruction(b).get(), 0.);
+    double temp = std::abs(containerA.getTemperature().get() -
+                           containerB.getTemperature().get());
+    double weight = std::abs(containerA.getWeight() - containerB.getWeight());
+    return trans * temp > sleeping_.temperatureDelta ||
+           trans * weight > sleeping_.weightDelta;
+  };
+
+  // tiles woken here don't wake their neighbours until next tick
+  std::vector<std::size_t> disturbed;
   Dimension dim = getDimension();
-  Coordinates c;
-  for (c.x = 0; c.x < dim.width; ++c.x) {
-    for (c.y = 0; c.y < dim.height; ++c.y) {
-      nextConvection(subjectLayer, c);
+  for (std::size_t i = 0; i < tiles_.size(); ++i) {
+    if (!tiles_[i].sleeping) {
+      continue;
+    }
+    auto bounds = getTileBounds(i);
+    bool found = false;
+    forEachTileCell(i, [&](Coordinates c) {
+      if (found || (c.x != bounds.begin.x && c.x != bounds.end.x - 1 &&
+                    c.y != bounds.begin.y && c.y != bounds.end.y - 1)) {
+        return;
+      }
+      for (const auto & nc : getNeighbours(dim, c)) {
+        if (!tiles_[getTileIndex(nc)].sleeping && isDifferent(c, nc)) {
+          found = true;
+          return;
+        }
+      }
+    });
+    if (found) {
+      disturbed.push_back(i);
+    }
+  }
+  for (auto i : disturbed) {
+    tiles_[i].sleeping = false;
+    tiles_[i].calmTicks = 0;
+  }
+  // woken air wasn't read by last step of adaptive circulation
+  if (!disturbed.empty()) {
+    disturbedSteps_ = std::max(disturbedSteps_, 1);
+  }
+}
+
+/*
+ * Cells of awake tile are compared with current layer, only border cells of sleeping
+ * one may be changed by flow of awake neighbours
+ */
+void MapLayerAir::updateTiles(const MapLayerAir & curLayerAir) {
+  auto getChange = [&](Coordinates c) {
+    const auto & curContainer = curLayerAir.getAirContainer(c);
+    const auto & container = getAirContainer(c);
+    if (curContainer.empty() || container.empty()) {
+      return curContainer.empty() == container.empty()
+                 ? 0.
+                 : std::numeric_limits<double>::infinity();
     }
+    double temp = std::abs(container.getTemperature().get() -
+                           curContainer.getTemperature().get());
+    double weight = std::abs(container.getWeight() - curContainer.getWeight());
+    return std::max(temp / sleeping_.temperatureDelta, weight / sleeping_.weightDelta);
+  };
+
+  for (std::size_t i = 0; i < tiles_.size(); ++i) {
+    auto & tile = tiles_[i];
+    if (tile.sleeping) {
+      auto bounds = getTileBounds(i);
+      forEachTileCell(i, [&](Coordinates c) {
+        if (c.x == bounds.begin.x || c.x == bounds.end.x - 1 ||
+            c.y == bounds.begin.y || c.y == bounds.end.y - 1) {
+          tile.activity = std::max(tile.activity, getChange(c));
+        }
+      });
+      if (tile.activity >= 1) {
+        tile.sleeping = false;
+        tile.calmTicks = 0;
+      }
+    } else {
+      forEachTileCell(i, [&](Coordinates c) {
+        tile.activity = std::max(tile.activity, getChange(c));
+      });
+      if (tile.activity >= 1) {
+        tile.calmTicks = 0;
+      } else if (++tile.calmTicks >= sleeping_.calmTicks) {
+        tile.sleeping = true;
+      }
+    }
+    tile.activity = 0;
   }
 }
 
@@ -25,11 +268,11 @@ void MapLayerAir::nextConvection(MapLayerSubject & subjectLayer) {
  * sum(airTr) + sum(subTr) = 0
  * deltaT = subTr - airTr
  */
-void MapLayerAir::nextConvection(MapLayerSubject & subjectLayer, Coordinates c) {
+double MapLayerAir::nextConvection(MapLayerSubject & subjectLayer, Coordinates c) {
   auto & airContainer = accessCell(c).accessElement().accessAirContainer();
   // if no air then there is no convection
   if (airContainer.empty()) {
-    return;
+    return 0;
   }
 
   airContainer.getHeatTransferCoef();
@@ -49,6 +292,26 @@ void MapLayerAir::nextConvection(MapLayerSubject & subjectLayer, Coordinates c)
   }
 
   airContainer.updateTemperature(totalHeatTransfer);
+  return std::abs(airContainer.getTemperature().get() - airTemp.get());
+}
+
+// the same transfer as of convection, but nothing is changed
+double MapLayerAir::getConvectionChange(const MapLayerSubject & subjectLayer,
+                                        Coordinates c) const {
+  const auto & airContainer = getAirContainer(c);
+  const auto & subList = subjectLayer.getSubjectList(c);
+  if (airContainer.empty() || subList.empty()) {
+    return 0;
+  }
+
+  auto airTemp = airContainer.getTemperature();
+  auto airCoef = airContainer.getHeatTransferCoef();
+  double totalHeatTransfer = 0;
+  for (const auto & sub : subList) {
+    auto deltaTemp = airTemp.get() - sub->getTemperature().get();
+    totalHeatTransfer += sub->getSurfaceArea() * deltaTemp * airCoef;
+  }
+  return std::abs(totalHeatTransfer) / getHeatCapacity(airContainer);
 }
 
 /*
@@ -98,40 +361,120 @@ void MapLayerAir::nextConvection(MapLayerSubject & subjectLayer, Coordinates c)
 
 void MapLayerAir::nextCirculation(const MapLayerAir & curLayerAir,
                                   const MapLayerObstruction & obstructionLayer) {
-  nextCirculationMassTemp(curLayerAir, obstructionLayer);
-  // MapLayerAir interLayerAir(*this); // road to 0 fps
-  // nextCirculationTemp(interLayerAir, obstructionLayer);
-  nextCirculationTemp(curLayerAir, obstructionLayer);
+  if (!tiles_.empty()) {
+    wakeDisturbed(curLayerAir, obstructionLayer);
+  }
+  substeps_ = stepCirculation(curLayerAir, obstructionLayer);
+  if (!tiles_.empty()) {
+    updateTiles(curLayerAir);
+  }
 }
 
-// Update state using mass and temp (upper formula)
-void MapLayerAir::nextCirculationMassTemp(
-    const MapLayerAir & curLayerAir, const MapLayerObstruction & obstructionLayer) {
-  Dimension dim = getDimension();
-  assert(this != &curLayerAir);
-  assert(obstructionLayer.getDimension() == dim);
+int MapLayerAir::stepCirculation(const MapLayerAir & curLayerAir,
+                                 const MapLayerObstruction & obstructionLayer) {
+  if (!stepping_.adaptive) {
+    nextCirculationMassTemp(curLayerAir, obstructionLayer);
+    // MapLayerAir interLayerAir(*this); // road to 0 fps
+    // nextCirculationTemp(interLayerAir, obstructionLayer);
+    nextCirculationTemp(curLayerAir, obstructionLayer);
+    return 1;
+  }
+
+  // heat of subjects is added while ticks are skipped, it ends skipping once it could
+  // break equilibrium
+  pendingTicks_ += 1;
+  if (equilibrium_ && disturbedSteps_ == 0 &&
+      heating_ <= stepping_.equilibriumTemperature &&
+      pendingTicks_ < stepping_.maxSkippedTicks) {
+    return 0;
+  }
+
+  double time = pendingTicks_;
+  pendingTicks_ = 0;
+  // air changes little from tick to tick, so stiffness of stable step is kept
+  if (time > 1 || disturbedSteps_ > 0 || stiffness_ * time > STABLE_STEP_PART) {
+    stiffness_ = measureStiffness(curLayerAir, obstructionLayer);
+  }
+  disturbedSteps_ = std::max(disturbedSteps_ - 1, 0);
+  double steps = std::ceil(stiffness_ * time / STABLE_STEP_PART);
+  int substeps = static_cast<int>(std::clamp(steps, 1., double(stepping_.maxSubsteps)));
+  // time beyond max sub-steps is dropped rather than overshoot
+  double scale = time / substeps;
+  if (stiffness_ * scale > STABLE_STEP_PART) {
+    scale = STABLE_STEP_PART / stiffness_;
+  }
+
+  // cleared by any difference out of equilibrium met by step
+  equilibrium_ = true;
+  heating_ = 0;
+  nextCirculationMassTemp(curLayerAir, obstructionLayer, scale);
+  nextCirculationTemp(curLayerAir, obstructionLayer, scale);
+  if (substeps > 1) {
+    Dimension dim = getDimension();
+    std::size_t cells = static_cast<std::size_t>(dim.width) * dim.height;
+    Deferred deferred{std::vector<std::list<PlainUPTR>>(cells),
+                      std::vector<double>(cells)};
+    for (int i = 1; i < substeps; ++i) {
+      nextSubstep(obstructionLayer, scale, deferred);
+    }
+  }
+  return substeps;
+}
+
+static std::size_t getCellIndex(Dimension dim, Coordinates c) {
+  return static_cast<std::size_t>(c.x) * dim.height + c.y;
+}
+
+void MapLayerAir::nextSubstep(const MapLayerObstruction & obstructionLayer,
+                              double scale, Deferred & deferred) {
+  forEachAwakeCell([&](Coordinates c) {
+    nextCirculationCellMassTemp(*this, obstructionLayer, c, scale, &deferred);
+  });
+  forEachAwakeCell([&](Coordinates c) {
+    nextCirculationCellTemp(*this, obstructionLayer, c, scale, &deferred);
+  });
 
+  // flow reaches border cells of sleeping tiles too, so every cell is applied
+  Dimension dim = getDimension();
   Coordinates c;
   for (c.x = 0; c.x < dim.width; ++c.x) {
     for (c.y = 0; c.y < dim.height; ++c.y) {
-      nextCirculationCellMassTemp(curLayerAir, obstructionLayer, c);
+      auto i = getCellIndex(dim, c);
+      auto & container = accessCell(c).accessElement().accessAirContainer();
+      if (!deferred.air[i].empty()) {
+        container.add(std::move(deferred.air[i]));
+        deferred.air[i].clear();
+      }
+      if (deferred.heat[i] != 0) {
+        container.updateTemperature(deferred.heat[i]);
+        deferred.heat[i] = 0;
+      }
     }
   }
 }
 
+// Update state using mass and temp (upper formula)
+void MapLayerAir::nextCirculationMassTemp(const MapLayerAir & curLayerAir,
+                                          const MapLayerObstruction & obstructionLayer,
+                                          double scale) {
+  assert(this != &curLayerAir);
+  assert(obstructionLayer.getDimension() == getDimension());
+
+  forEachAwakeCell([&](Coordinates c) {
+    nextCirculationCellMassTemp(curLayerAir, obstructionLayer, c, scale, nullptr);
+  });
+}
+
 // Update state only using temperature to approach all params to medium
 void MapLayerAir::nextCirculationTemp(const MapLayerAir & curLayerAir,
-                                      const MapLayerObstruction & obstructionLayer) {
-  Dimension dim = getDimension();
+                                      const MapLayerObstruction & obstructionLayer,
+                                      double scale) {
   assert(this != &curLayerAir);
-  assert(obstructionLayer.getDimension() == dim);
+  assert(obstructionLayer.getDimension() == getDimension());
 
-  Coordinates c;
-  for (c.x = 0; c.x < dim.width; ++c.x) {
-    for (c.y = 0; c.y < dim.height; ++c.y) {
-      nextCirculationCellTemp(curLayerAir, obstructionLayer, c);
-    }
-  }
+  forEachAwakeCell([&](Coordinates c) {
+    nextCirculationCellTemp(curLayerAir, obstructionLayer, c, scale, nullptr);
+  });
 }
 
 double cellMassTempValue(const Air::Plain * air) {
@@ -167,14 +510,15 @@ getMapToAddAir(const std::list<Coordinates> & neighList, const Coordinates & c)
 void moveToLayerFromAirMap(MapLayerAir & layer,
                            std::map<Coordinates, std::list<PlainUPTR>> && airMap) {
   for (auto & [key, value] : airMap) {
-    auto & container = layer.accessAirContainer(key);
+    // flow of simulation doesn't wake tiles
+    auto & container = layer.accessCell(key).accessElement().accessAirContainer();
     container.add(std::move(value));
   }
 }
 
 void MapLayerAir::nextCirculationCellMassTemp(
     const MapLayerAir & curLayerAir, const MapLayerObstruction & obstructionLayer,
-    Coordinates c) {
+    Coordinates c, double scale, Deferred * deferred) {
 
   const auto neighList = getNeighbours(this->getDimension(), c);
   auto airMap = getMapToAddAir(neighList, c);
@@ -193,26 +537,41 @@ void MapLayerAir::nextCirculationCellMassTemp(
     }
     // Calculate air value change
     double neighCoef = std::pow(suitableAirs.size(), 0.5);
-    double iterCoef = MASS_TEMP_ITER_COEF;
+    double iterCoef = MASS_TEMP_ITER_COEF * scale;
     for (const auto & [nc, nair] : suitableAirs) {
       double curTrans = std::max(1 - obstructionLayer.getAirObstruction(c).get(), 0.);
       double neiTrans = std::max(1 - obstructionLayer.getAirObstruction(nc).get(), 0.);
 
-      double valueDiff = curAirValue - cellMassTempValue(nair);
+      double neighValue = cellMassTempValue(nair);
+      double valueDiff = curAirValue - neighValue;
       double normCoef = (iterCoef) / (neighCoef * getNeighDistance(c, nc));
       double normValueDiff = normCoef * curTrans * neiTrans * valueDiff;
+      double magnitude = std::max(std::abs(curAirValue), std::abs(neighValue));
+      if (equilibrium_ &&
+          curTrans * neiTrans * valueDiff > stepping_.equilibriumRatio * magnitude) {
+        equilibrium_ = false;
+      }
       // create air with weight
       airMap[nc].push_back(cloneWithValueMassTemp(*curAir, normValueDiff));
       airMap[c].push_back(cloneWithValueMassTemp(*curAir, -normValueDiff));
     }
   }
+  if (deferred) {
+    Dimension dim = getDimension();
+    for (auto & [key, value] : airMap) {
+      auto & air = deferred->air[getCellIndex(dim, key)];
+      air.splice(air.end(), value);
+    }
+    return;
+  }
   moveToLayerFromAirMap(*this, std::move(airMap));
 }
 
 // logic almost the same as with convection in-cell
 void MapLayerAir::nextCirculationCellTemp(const MapLayerAir & curLayerAir,
                                           const MapLayerObstruction & obstructionLayer,
-                                          Coordinates c) {
+                                          Coordinates c, double scale,
+                                          Deferred * deferred) {
   auto & curAirCon = curLayerAir.getAirContainer(c);
 
   if (curAirCon.empty()) {
@@ -225,6 +584,23 @@ void MapLayerAir::nextCirculationCellTemp(const MapLayerAir & curLayerAir,
   double totalHeatTransfer = 0;
   const auto neighList = getNeighbours(this->getDimension(), c);
 
+  // every neighbour is checked, while heat isn't exchanged past one without air
+  if (stepping_.adaptive && equilibrium_) {
+    double curTrans = std::max(1 - obstructionLayer.getAirObstruction(c).get(), 0.);
+    for (const auto & nc : neighList) {
+      auto & curNeighCon = curLayerAir.getAirContainer(nc);
+      if (curNeighCon.empty()) {
+        continue;
+      }
+      double neiTrans = std::max(1 - obstructionLayer.getAirObstruction(nc).get(), 0.);
+      double deltaTemp = curAirTemp.get() - curNeighCon.getTemperature().get();
+      double transfer = curTrans * neiTrans * std::abs(deltaTemp);
+      if (transfer > stepping_.equilibriumTemperature) {
+        equilibrium_ = false;
+      }
+    }
+  }
+
   for (const auto & nc : neighList) {
     auto & curNeighCon = curLayerAir.getAirContainer(nc);
     if (curNeighCon.empty()) {
@@ -237,14 +613,106 @@ void MapLayerAir::nextCirculationCellTemp(const MapLayerAir & curLayerAir,
     if (deltaTemp > 0) {
       double curTrans = std::max(1 - obstructionLayer.getAirObstruction(c).get(), 0.);
       double neiTrans = std::max(1 - obstructionLayer.getAirObstruction(nc).get(), 0.);
-      double normCoef = TEMP_ITER_COEF / getNeighDistance(c, nc);
+      double normCoef = TEMP_ITER_COEF * scale / getNeighDistance(c, nc);
 
       double heatTransfer = normCoef * curAirCon.getWeight() * curNeighCon.getWeight() *
                             curTrans * neiTrans * deltaTemp * curAirCoef;
-
-      this->accessAirContainer(nc).updateTemperature(heatTransfer);
+      if (deferred) {
+        deferred->heat[getCellIndex(getDimension(), nc)] += heatTransfer;
+      } else {
+        accessCell(nc).accessElement().accessAirContainer().updateTemperature(
+            heatTransfer);
+      }
       totalHeatTransfer -= heatTransfer;
     }
   }
-  this->accessAirContainer(c).updateTemperature(totalHeatTransfer);
+  if (deferred) {
+    deferred->heat[getCellIndex(getDimension(), c)] += totalHeatTransfer;
+    return;
+  }
+  accessCell(c).accessElement().accessAirContainer().updateTemperature(
+      totalHeatTransfer);
+}
+
+/*
+ * Stiffness of cell bounds part of difference with neighbours closed by step of
+ * scale 1: air value flows to every lower neighbour, heat is exchanged with every
+ * neighbour. Cells separated by obstruction don't change each other. Only cells out
+ * of equilibrium count, overshoot of difference within it isn't noticed
+ */
+double
+MapLayerAir::measureStiffness(const MapLayerAir & curLayerAir,
+                              const MapLayerObstruction & obstructionLayer) const {
+  double stiffness = 0;
+  Dimension dim = getDimension();
+  auto getTrans = [&obstructionLayer](Coordinates c) {
+    return std::max(1 - obstructionLayer.getAirObstruction(c).get(), 0.);
+  };
+
+  forEachAwakeCell([&](Coordinates c) {
+    const auto & container = curLayerAir.getAirContainer(c);
+    double curTrans = getTrans(c);
+    double capacity = getHeatCapacity(container);
+    if (container.empty() || curTrans == 0 || capacity <= 0) {
+      return;
+    }
+
+    double temp = container.getTemperature().get();
+    double weight = container.getWeight();
+    double coef = container.getHeatTransferCoef();
+
+    bool equilibrium = true;
+    double massPart = 0;
+    double tempPart = 0;
+    int neighbours = 0;
+    Coordinates nc;
+    for (nc.x = std::max(c.x - 1, 0); nc.x <= std::min(c.x + 1, dim.width - 1);
+         ++nc.x) {
+      for (nc.y = std::max(c.y - 1, 0); nc.y <= std::min(c.y + 1, dim.height - 1);
+           ++nc.y) {
+        double trans = curTrans * getTrans(nc);
+        if (nc == c || trans == 0) {
+          continue;
+        }
+        double distance = getNeighDistance(c, nc);
+        const auto & neighContainer = curLayerAir.getAirContainer(nc);
+
+        for (const auto & air : container.getList()) {
+          if (!equilibrium) {
+            break;
+          }
+          double value = cellMassTempValue(air.get());
+          double neighValue = cellMassTempValue(neighContainer.findOrNull(*air));
+          double magnitude = std::max(std::abs(value), std::abs(neighValue));
+          double diff = trans * std::abs(value - neighValue);
+          if (diff > stepping_.equilibriumRatio * magnitude) {
+            equilibrium = false;
+          }
+        }
+        ++neighbours;
+        massPart += 2 * MASS_TEMP_ITER_COEF * trans / distance;
+
+        double neighCapacity = getHeatCapacity(neighContainer);
+        if (neighContainer.empty() || neighCapacity <= 0) {
+          continue;
+        }
+        double neighTemp = neighContainer.getTemperature().get();
+        if (trans * std::abs(temp - neighTemp) > stepping_.equilibriumTemperature) {
+          equilibrium = false;
+        }
+        double exchange = TEMP_ITER_COEF * trans * coef * weight *
+                          neighContainer.getWeight() / distance;
+        tempPart += exchange * (1 / capacity + 1 / neighCapacity);
+      }
+    }
+
+    if (equilibrium) {
+      return;
+    }
+    if (neighbours > 0) {
+      massPart /= std::sqrt(neighbours);
+    }
+    stiffness = std::max(stiffness, massPart + tempPart);
+  });
+  return stiffness;
 }
@@ -50,24 +50,22 @@ void calcForCell(MapLayerIllumination & layer, const MapLayerObstruction & obstr
       p, max_n_illum.getActualIllumination(obstruction.getLightObstruction(p)));
 }
 
-MapLayerIllumination
-calcForLightSrc(Dimension dim, const MapLayerObstruction & obstructionLayer,
-                std::pair<Coordinates, const Subject::ExtLightSource *> src) {
+MapLayerIllumination calcForLightSrc(Dimension dim,
+                                     const MapLayerObstruction & obstructionLayer,
+                                     Coordinates src, Illumination rawIllumination) {
 
   // to check whether calculated for this cell
   MapLayerIllumination res(dim, ILLUMINATION_DEFAULT);
 
   {
-    auto obs = obstructionLayer.getLightObstruction(src.first);
-    auto illum =
-        src.second->getCurLightParams().rawIllumination.getActualIllumination(obs);
-    res.setIllumination(src.first, illum);
+    auto obs = obstructionLayer.getLightObstruction(src);
+    res.setIllumination(src, rawIllumination.getActualIllumination(obs));
   }
 
   Coordinates p;
   for (p.x = 0; p.x < dim.width; ++p.x) {
     for (p.y = 0; p.y < dim.height; ++p.y) {
-      calcForCell(res, obstructionLayer, src.first, p);
+      calcForCell(res, obstructionLayer, src, p);
     }
   }
 
@@ -77,6 +75,15 @@ calcForLightSrc(Dimension dim, const MapLayerObstruction & obstructionLayer,
 void MapLayerIllumination::updateIllumination(
     const MapLayerObstruction & obstructionLayer,
     const MapLayerSubject & subjectLayer) {
+  LightSources sources;
+  for (const auto & src : subjectLayer.getActiveLightSources()) {
+    sources.emplace_back(src.first, src.second->getCurLightParams().rawIllumination);
+  }
+  updateIllumination(obstructionLayer, sources);
+}
+
+void MapLayerIllumination::updateIllumination(
+    const MapLayerObstruction & obstructionLayer, const LightSources & sources) {
 
   auto dim = getDimension();
 
@@ -85,13 +92,46 @@ void MapLayerIllumination::updateIllumination(
     for (c.y = 0; c.y < dim.height; ++c.y)
       setIllumination(c, Illumination{0});
 
-  // illumination for each source is managed like simple addition for each source
-  for (const auto & src : subjectLayer.getActiveLightSources()) {
-    auto res = calcForLightSrc(dim, obstructionLayer, src);
+  auto addSource = [&](Coordinates src, Illumination rawIllumination) {
+    auto res = calcForLightSrc(dim, obstructionLayer, src, rawIllumination);
     for (c.x = 0; c.x < dim.width; ++c.x) {
       for (c.y = 0; c.y < dim.height; ++c.y) {
         setIllumination(c, getIllumination(c) + res.getIllumination(c));
       }
     }
+  };
+
+  // illumination for each source is managed like simple addition for each source
+  for (const auto & [src, rawIllumination] : sources) {
+    addSource(src, rawIllumination);
+  }
+
+  for (auto & portal : portalLight_) {
+    portal.own = getIllumination(portal.coordinates);
+  }
+  for (auto & portal : portalLight_) {
+    if (portal.incoming.get() > 0) {
+      addSource(portal.coordinates, portal.incoming);
+    }
+    portal.incoming = Illumination{0};
+  }
+}
+
+void MapLayerIllumination::addPortalLight(Coordinates coord, Illumination illum) {
+  for (auto & portal : portalLight_) {
+    if (portal.coordinates == coord) {
+      portal.incoming = portal.incoming + illum;
+      return;
+    }
+  }
+  portalLight_.push_back(PortalLight{coord, illum, getIllumination(coord)});
+}
+
+Illumination MapLayerIllumination::getOwnIllumination(Coordinates coord) const {
+  for (const auto & portal : portalLight_) {
+    if (portal.coordinates == coord) {
+      return portal.own;
+    }
   }
+  return getIllumination(coord);
 }
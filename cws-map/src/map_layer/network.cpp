@@ -1,5 +1,6 @@
 #include "cws/map_layer/network.hpp"
 #include <cassert>
+#include <iterator>
 #include <queue>
 
 Dimension MapLayerNetwork::getDimension() const {
@@ -42,6 +43,38 @@ void MapLayerNetwork::collectTransmittableContainers(
   }
 }
 
+void MapLayerNetworkWireless::relay(
+    Coordinates c, std::list<std::unique_ptr<Network::Container>> && list) {
+  if (list.empty()) {
+    return;
+  }
+  relayed_.emplace_back(c, LayerNetwork());
+  relayed_.back().second.getContainerList() = std::move(list);
+}
+
+void MapLayerNetworkWireless::transmit(
+    Coordinates c, std::list<std::unique_ptr<Network::Container>> && list) {
+  auto & layerContainers = getTransmittableContainers(c);
+  layerContainers.splice(layerContainers.end(), list);
+}
+
+void MapLayerNetworkWireless::receive(
+    Coordinates c, std::list<std::unique_ptr<Network::Container>> && list) {
+  auto & layerContainers = getReceivableContainers(c);
+  layerContainers.splice(layerContainers.end(), list);
+}
+
+void MapLayerNetworkWireless::collectTransmittableContainers(
+    const MapLayerSubject & layerSubject) {
+  MapLayerNetwork::collectTransmittableContainers(layerSubject);
+
+  for (auto & [c, layer] : relayed_) {
+    auto & layerContainers = getTransmittableContainers(c);
+    layerContainers.splice(layerContainers.end(), layer.getContainerList());
+  }
+  relayed_.clear();
+}
+
 void MapLayerNetworkWireless::updateNetwork(const MapLayerObstruction & obstruction) {
   Dimension dim = getDimension();
   assert(dim == obstruction.getDimension());
@@ -120,11 +153,14 @@ void MapLayerNetworkWireless::updateNetworkCell(const MapLayerObstruction & obsL
       }
     }
 
+    // best neighbour is closer to root and already has containers of this root
+    // appended last, containers of other roots are spread by their own pass
     const auto & bestNList = getReceivableContainers(best_n);
     auto & receiUList = getReceivableContainers(u);
 
-    for (const auto & bestN : bestNList) {
-      auto bestNWireless = static_cast<Network::WirelessContainer *>(bestN.get());
+    auto bestNIt = std::prev(bestNList.end(), transList.size());
+    for (; bestNIt != bestNList.end(); ++bestNIt) {
+      auto bestNWireless = static_cast<Network::WirelessContainer *>(bestNIt->get());
       receiUList.emplace_back(cloneApplyingObstruction(bestNWireless, u, obsLayer));
     }
 
@@ -0,0 +1,202 @@
+#include "cws/map_layer/network.hpp"
+#include "cws/map_layer/subject.hpp"
+#include "cws/subject/network.hpp"
+#include <algorithm>
+#include <cassert>
+#include <queue>
+#include <tuple>
+#include <unordered_set>
+
+bool MapLayerNetworkWired::connect(const Subject::Id & first,
+                                   const Subject::Id & second) {
+  if (first == second) {
+    return false;
+  }
+  auto & firstLinks = links_[first];
+  if (std::find(firstLinks.begin(), firstLinks.end(), second) != firstLinks.end()) {
+    return false;
+  }
+  firstLinks.push_back(second);
+  links_[second].push_back(first);
+  routesValid_ = false;
+  return true;
+}
+
+bool MapLayerNetworkWired::disconnect(const Subject::Id & first,
+                                      const Subject::Id & second) {
+  auto removeLink = [this](const Subject::Id & from, const Subject::Id & to) {
+    auto it = links_.find(from);
+    if (it == links_.end()) {
+      return false;
+    }
+    auto & links = it->second;
+    auto link = std::find(links.begin(), links.end(), to);
+    if (link == links.end()) {
+      return false;
+    }
+    links.erase(link);
+    if (links.empty()) {
+      links_.erase(it);
+    }
+    return true;
+  };
+
+  if (!removeLink(first, second)) {
+    return false;
+  }
+  removeLink(second, first);
+  routesValid_ = false;
+  return true;
+}
+
+const std::vector<Subject::Id> &
+MapLayerNetworkWired::getLinks(const Subject::Id & node) const {
+  static const std::vector<Subject::Id> empty;
+  auto it = links_.find(node);
+  return it == links_.end() ? empty : it->second;
+}
+
+std::vector<std::pair<Subject::Id, Subject::Id>>
+MapLayerNetworkWired::getCables() const {
+  auto less = [](const Subject::Id & lhs, const Subject::Id & rhs) {
+    return std::make_pair(lhs.type, lhs.idx) < std::make_pair(rhs.type, rhs.idx);
+  };
+
+  std::vector<std::pair<Subject::Id, Subject::Id>> cables;
+  for (const auto & [node, links] : links_) {
+    for (const auto & link : links) {
+      if (less(node, link)) {
+        cables.emplace_back(node, link);
+      }
+    }
+  }
+  return cables;
+}
+
+const std::vector<MapLayerNetworkWired::Route> &
+MapLayerNetworkWired::getRoutes(const Subject::Id & source) const {
+  static const std::vector<Route> empty;
+  if (!routes_) {
+    return empty;
+  }
+  auto it = routes_->find(source);
+  return it == routes_->end() ? empty : it->second;
+}
+
+void MapLayerNetworkWired::addDevice(const Subject::Id & id, Coordinates c) {
+  if (id.type == Subject::Type::WIRED_NETWORK_DEVICE) {
+    devices_[id] = c;
+  }
+}
+
+void MapLayerNetworkWired::removeDevice(const Subject::Id & id, Coordinates c) {
+  auto it = devices_.find(id);
+  if (it != devices_.end() && it->second == c) {
+    devices_.erase(it);
+  }
+}
+
+void MapLayerNetworkWired::updateRoutes() {
+  // copies of layer keep the table they share
+  auto allRoutes = std::make_shared<Routes>();
+
+  std::unordered_set<Subject::Id, Subject::IdHash> visited;
+  std::queue<Route> queue;
+
+  for (const auto & [source, sourceLinks] : links_) {
+    auto & routes = (*allRoutes)[source];
+    visited.clear();
+    visited.insert(source);
+    queue.push(Route{source, 0});
+
+    while (!queue.empty()) {
+      auto route = queue.front();
+      queue.pop();
+      if (route.hops > 0) {
+        routes.push_back(route);
+      }
+      for (const auto & next : getLinks(route.destination)) {
+        if (visited.insert(next).second) {
+          queue.push(Route{next, route.hops + 1});
+        }
+      }
+    }
+  }
+  routes_ = links_.empty() ? nullptr : std::move(allRoutes);
+  routesValid_ = true;
+}
+
+void MapLayerNetworkWired::clearNetwork() {
+  for (auto c : transmitCells_) {
+    getTransmittableContainers(c).clear();
+  }
+  for (auto c : receiveCells_) {
+    getReceivableContainers(c).clear();
+  }
+  transmitCells_.clear();
+  receiveCells_.clear();
+}
+
+void MapLayerNetworkWired::collectTransmittableContainers(
+    const MapLayerSubject & layerSubject) {
+  assert(layerSubject.getDimension() == getDimension());
+
+  // devices without cables can't send or receive anything
+  if (links_.empty()) {
+    return;
+  }
+
+  // cells in order of map, so packets are ordered as if all cells were scanned
+  std::vector<Coordinates> cells;
+  for (const auto & [id, c] : devices_) {
+    if (links_.contains(id)) {
+      cells.push_back(c);
+    }
+  }
+  std::ranges::sort(cells, [](Coordinates a, Coordinates b) {
+    return std::tie(a.x, a.y) < std::tie(b.x, b.y);
+  });
+  auto [last, end] = std::ranges::unique(cells);
+  cells.erase(last, end);
+
+  for (auto c : cells) {
+    for (const auto & sub : layerSubject.getSubjectList(c)) {
+      auto device = dynamic_cast<const Subject::WiredNetworkDevice *>(sub.get());
+      if (device == nullptr || !links_.contains(device->getId())) {
+        continue;
+      }
+      auto containers = device->collectNetworkContainers(Network::Type::WIRED);
+      if (!containers.empty()) {
+        auto & layerContainers = getTransmittableContainers(c);
+        if (layerContainers.empty()) {
+          transmitCells_.push_back(c);
+        }
+        layerContainers.splice(layerContainers.end(), containers);
+      }
+    }
+  }
+}
+
+void MapLayerNetworkWired::updateNetwork(const MapLayerObstruction &) {
+  if (!routesValid_) {
+    updateRoutes();
+  }
+
+  for (auto c : transmitCells_) {
+    for (const auto & container : getTransmittableContainers(c)) {
+      auto wired = static_cast<const Network::WiredContainer *>(container.get());
+
+      for (const auto & route : getRoutes(wired->getSource())) {
+        auto device = devices_.find(route.destination);
+        if (device == devices_.end()) {
+          continue;
+        }
+        auto & receivList = getReceivableContainers(device->second);
+        if (receivList.empty()) {
+          receiveCells_.push_back(device->second);
+        }
+        receivList.emplace_back(wired->cloneRouted(route.destination, route.hops));
+      }
+    }
+  }
+}
@@ -50,12 +50,13 @@ void MapLayerSubject::setupSubject(Subject::Plain & subject, Coordinates c,
 
   switch (subject.getId().type) {
   case Type::INFRARED_CAMERA: {
-    static_cast<InfraredCamera &>(subject).setup(c, *this, obstructionLayer);
+    auto & camera = static_cast<InfraredCamera &>(subject);
+    camera.setup(c, *this, obstructionLayer);
     break;
   }
   case Type::LIGHT_CAMERA: {
-    return static_cast<LightCamera &>(subject).setup(c, *this, obstructionLayer,
-                                                     illuminationLayer);
+    auto & camera = static_cast<LightCamera &>(subject);
+    camera.setup(c, *this, obstructionLayer, illuminationLayer);
     break;
   }
   case Type::AIR_TEMPERATURE_SENSOR: {
@@ -92,23 +93,54 @@ void MapLayerSubject::setupSubjects(const MapLayerAir & airLayer,
   }
 }
 
-void MapLayerSubject::receiveContainers(const MapLayerNetwork & networkLayer) {
+void MapLayerSubject::setupCameras(const MapLayerObstruction & obstructionLayer,
+                                   const MapLayerIllumination & illuminationLayer) {
   Dimension dim = getDimension();
 
   Coordinates c;
   for (c.x = 0; c.x < dim.width; ++c.x) {
     for (c.y = 0; c.y < dim.height; ++c.y) {
-      auto & cellSubs = this->accessSubjectList(c);
-      for (auto & sub : cellSubs) {
-        if (auto netSub = dynamic_cast<Subject::ExtReceiver *>(sub.get())) {
-          netSub->placeNetworkContainers(networkLayer.getReceivableContainers(c),
-                                         networkLayer.getNetworkType());
+      for (auto & sub : this->accessSubjectList(c)) {
+        auto type = sub->getId().type;
+        if (type == Type::INFRARED_CAMERA) {
+          static_cast<InfraredCamera &>(*sub).setup(c, *this, obstructionLayer);
+        } else if (type == Type::LIGHT_CAMERA) {
+          static_cast<LightCamera &>(*sub).setup(c, *this, obstructionLayer,
+                                                 illuminationLayer);
         }
       }
     }
   }
 }
 
+void MapLayerSubject::receiveContainers(const MapLayerNetwork & networkLayer) {
+  Dimension dim = getDimension();
+
+  Coordinates c;
+  for (c.x = 0; c.x < dim.width; ++c.x) {
+    for (c.y = 0; c.y < dim.height; ++c.y) {
+      receiveContainers(networkLayer, c);
+    }
+  }
+}
+
+void MapLayerSubject::receiveContainers(const MapLayerNetwork & networkLayer,
+                                        const std::vector<Coordinates> & cells) {
+  for (auto c : cells) {
+    receiveContainers(networkLayer, c);
+  }
+}
+
+void MapLayerSubject::receiveContainers(const MapLayerNetwork & networkLayer,
+                                        Coordinates c) {
+  for (auto & sub : this->accessSubjectList(c)) {
+    if (auto netSub = dynamic_cast<Subject::ExtReceiver *>(sub.get())) {
+      netSub->placeNetworkContainers(networkLayer.getReceivableContainers(c),
+                                     networkLayer.getNetworkType());
+    }
+  }
+}
+
 void MapLayerSubject::clearNetworkBuffers() {
   Dimension dim = getDimension();
 
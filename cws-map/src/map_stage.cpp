@@ -0,0 +1,36 @@
+#include "cws/map_stage.hpp"
+
+const char * toString(MapStage stage) {
+  switch (stage) {
+  case MapStage::SUBJECT_TEMPERATURE:
+    return "subject_temperature";
+  case MapStage::AIR_CONVECTION:
+    return "air_convection";
+  case MapStage::AIR_OBSTRUCTION:
+    return "air_obstruction";
+  case MapStage::AIR_CIRCULATION:
+    return "air_circulation";
+  case MapStage::LIGHT_OBSTRUCTION:
+    return "light_obstruction";
+  case MapStage::ILLUMINATION:
+    return "illumination";
+  case MapStage::NETWORK_COLLECT:
+    return "network_collect";
+  case MapStage::NETWORK_SPREAD:
+    return "network_spread";
+  case MapStage::NETWORK_RECEIVE:
+    return "network_receive";
+  case MapStage::SUBJECT_SETUP:
+    return "subject_setup";
+  default:
+    return "unknown";
+  }
+}
+
+std::chrono::nanoseconds MapStageTimes::getTotal() const {
+  std::chrono::nanoseconds total(0);
+  for (const auto & d : duration) {
+    total += d;
+  }
+  return total;
+}
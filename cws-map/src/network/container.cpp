@@ -7,3 +7,16 @@ WirelessContainer * WirelessContainer::cloneWithSignal(double signalPower) const
   eptr->setSignalPower(signalPower);
   return eptr;
 }
+
+WirelessContainer * WirelessContainer::cloneRelayed(double signalPower) const {
+  auto eptr = this->cloneWithSignal(signalPower);
+  eptr->relayed_ = true;
+  return eptr;
+}
+
+WiredContainer * WiredContainer::cloneRouted(Subject::Id destination, int hops) const {
+  auto eptr = this->clone();
+  eptr->destination_ = destination;
+  eptr->hops_ = hops;
+  return eptr;
+}
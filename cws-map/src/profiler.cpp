@@ -0,0 +1,170 @@
+#include "cws/profiler.hpp"
+
+#include <algorithm>
+#include <bit>
+
+using namespace std::chrono;
+
+static std::size_t getBucket(nanoseconds duration) {
+  auto us = static_cast<std::uint64_t>(std::max(duration_cast<microseconds>(duration),
+                                                microseconds(0))
+                                           .count());
+  return std::min<std::size_t>(std::bit_width(us), PROFILE_BUCKET_COUNT - 1);
+}
+
+TickProfiler::TickProfiler(std::size_t window)
+    : records_(std::max<std::size_t>(window, 1)),
+      epoch_(MapStageTimes::Clock::now()) {}
+
+nanoseconds TickProfiler::getBucketBound(std::size_t bucket) {
+  return microseconds(std::uint64_t(1) << bucket);
+}
+
+void TickProfiler::record(std::size_t tick, const MapStageTimes & times) {
+  std::scoped_lock lock(mutex_);
+
+  auto & slot = records_[next_];
+
+  if (size_ == records_.size()) {
+    for (std::size_t i = 0; i < MAP_STAGE_COUNT; ++i) {
+      --histograms_[i][getBucket(slot.times.duration[i])];
+    }
+    --histograms_[MAP_STAGE_COUNT][getBucket(slot.times.getTotal())];
+  } else {
+    ++size_;
+  }
+
+  slot.tick = tick;
+  slot.times = times;
+
+  for (std::size_t i = 0; i < MAP_STAGE_COUNT; ++i) {
+    ++histograms_[i][getBucket(times.duration[i])];
+  }
+  ++histograms_[MAP_STAGE_COUNT][getBucket(times.getTotal())];
+
+  next_ = (next_ + 1) % records_.size();
+}
+
+void TickProfiler::reset() {
+  std::scoped_lock lock(mutex_);
+  next_ = 0;
+  size_ = 0;
+  histograms_ = {};
+}
+
+// oldest first
+std::vector<TickProfiler::Record> TickProfiler::copyRecords() const {
+  std::vector<Record> records;
+  records.reserve(size_);
+
+  std::size_t first = size_ == records_.size() ? next_ : 0;
+  for (std::size_t i = 0; i < size_; ++i) {
+    records.push_back(records_[(first + i) % records_.size()]);
+  }
+  return records;
+}
+
+static StageProfile
+calcStageProfile(std::vector<nanoseconds> && durations,
+                 const std::array<std::size_t, PROFILE_BUCKET_COUNT> & histogram) {
+  StageProfile profile{};
+  profile.count = durations.size();
+  profile.histogram = histogram;
+
+  if (durations.empty()) {
+    return profile;
+  }
+
+  std::sort(durations.begin(), durations.end());
+
+  nanoseconds total(0);
+  for (const auto & d : durations) {
+    total += d;
+  }
+
+  auto percentile = [&durations](double p) {
+    auto idx = static_cast<std::size_t>(p * (durations.size() - 1) + 0.5);
+    return durations[idx];
+  };
+
+  profile.mean = total / durations.size();
+  profile.min = durations.front();
+  profile.max = durations.back();
+  profile.p50 = percentile(0.50);
+  profile.p90 = percentile(0.90);
+  profile.p99 = percentile(0.99);
+
+  return profile;
+}
+
+TickProfile TickProfiler::getProfile() const {
+  std::vector<Record> records;
+  decltype(histograms_) histograms;
+  {
+    std::scoped_lock lock(mutex_);
+    records = copyRecords();
+    histograms = histograms_;
+  }
+
+  TickProfile profile{};
+  profile.window = records.size();
+  profile.lastTick = records.empty() ? 0 : records.back().tick;
+  if (!records.empty()) {
+    profile.activeAirTiles = records.back().times.activeAirTiles;
+    profile.sleepingAirTiles = records.back().times.sleepingAirTiles;
+  }
+  for (const auto & record : records) {
+    profile.airSubsteps += record.times.airSubsteps;
+  }
+  if (!records.empty()) {
+    profile.airSubsteps /= records.size();
+  }
+
+  for (std::size_t i = 0; i <= MAP_STAGE_COUNT; ++i) {
+    std::vector<nanoseconds> durations;
+    durations.reserve(records.size());
+    for (const auto & record : records) {
+      durations.push_back(i < MAP_STAGE_COUNT ? record.times.duration[i]
+                                              : record.times.getTotal());
+    }
+
+    auto stage = calcStageProfile(std::move(durations), histograms[i]);
+    if (i < MAP_STAGE_COUNT) {
+      profile.stages[i] = stage;
+    } else {
+      profile.tick = stage;
+    }
+  }
+
+  return profile;
+}
+
+void TickProfiler::writeChromeTrace(std::ostream & out) const {
+  std::vector<Record> records;
+  {
+    std::scoped_lock lock(mutex_);
+    records = copyRecords();
+  }
+
+  auto toUs = [](nanoseconds d) { return duration<double, std::micro>(d).count(); };
+
+  out << "{\"traceEvents\":[";
+
+  bool first = true;
+  for (const auto & record : records) {
+    for (std::size_t i = 0; i < MAP_STAGE_COUNT; ++i) {
+      if (!first) {
+        out << ",";
+      }
+      first = false;
+
+      out << "{\"name\":\"" << toString(static_cast<MapStage>(i)) << "\""
+          << ",\"cat\":\"map\",\"ph\":\"X\",\"pid\":1,\"tid\":1"
+          << ",\"ts\":" << toUs(record.times.start[i] - epoch_)
+          << ",\"dur\":" << toUs(record.times.duration[i])
+          << ",\"args\":{\"tick\":" << record.tick << "}}";
+    }
+  }
+
+  out << "],\"displayTimeUnit\":\"ms\"}";
+}
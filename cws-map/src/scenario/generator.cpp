@@ -0,0 +1,216 @@
+#include "cws/scenario/generator.hpp"
+
+#include <random>
+#include <stdexcept>
+
+#include "cws/subject/camera.hpp"
+#include "cws/subject/light_emitter.hpp"
+#include "cws/subject/network.hpp"
+#include "cws/subject/sensor.hpp"
+#include "cws/subject/temp_emitter.hpp"
+#include "cws/subject/turnable.hpp"
+
+using namespace Subject;
+
+/*
+ * Uses raw engine output only: standard distributions differ between library
+ * implementations and would break reproducibility
+ */
+class FloorRandom final {
+  std::mt19937 engine_;
+
+public:
+  explicit FloorRandom(std::uint32_t seed) : engine_(seed) {}
+
+  // [0, 1)
+  double nextDouble() { return engine_() / 4294967296.0; }
+
+  double nextDouble(double from, double to) { return from + (to - from) * nextDouble(); }
+
+  // [0, n)
+  int nextInt(int n) { return static_cast<int>(nextDouble() * n); }
+
+  bool nextBool(double chance) { return nextDouble() < chance; }
+};
+
+template<typename Sink>
+class FloorGenerator final {
+  Sink & sink_;
+  const FloorParams & params_;
+  Dimension dim_;
+  FloorRandom random_;
+  int idx_ = 0;
+
+public:
+  FloorGenerator(Sink & sink, const FloorParams & params, Dimension dim)
+      : sink_(sink), params_(params), dim_(dim), random_(params.seed) {
+    if (params.roomSize < 3 || params.lampSpacing < 1 || params.airKinds < 1 ||
+        params.density < 0 || params.density > 1) {
+      throw std::invalid_argument("bad floor parameters");
+    }
+  }
+
+  void generate() {
+    Coordinates c;
+    for (c.x = 0; c.x < dim_.width; ++c.x) {
+      for (c.y = 0; c.y < dim_.height; ++c.y) {
+        addAir(c);
+
+        if (isDoor(c)) {
+          addDoor(c);
+        } else if (isWall(c)) {
+          addWall(c);
+        } else {
+          addRoomCell(c);
+        }
+      }
+    }
+  }
+
+private:
+  int getRoomSize() const { return params_.roomSize; }
+
+  bool isWall(Coordinates c) const {
+    return c.x % getRoomSize() == 0 || c.y % getRoomSize() == 0 ||
+           c.x == dim_.width - 1 || c.y == dim_.height - 1;
+  }
+
+  // one door in the middle of every inner wall segment
+  bool isDoor(Coordinates c) const {
+    bool outer = c.x == 0 || c.y == 0 || c.x == dim_.width - 1 || c.y == dim_.height - 1;
+    if (outer) {
+      return false;
+    }
+    bool onVertical = c.x % getRoomSize() == 0 && c.y % getRoomSize() != 0;
+    bool onHorizontal = c.y % getRoomSize() == 0 && c.x % getRoomSize() != 0;
+    int middle = getRoomSize() / 2;
+    return (onVertical && c.y % getRoomSize() == middle) ||
+           (onHorizontal && c.x % getRoomSize() == middle);
+  }
+
+  // position inside of room, walls are excluded
+  Coordinates getRoomOffset(Coordinates c) const {
+    return {c.x % getRoomSize(), c.y % getRoomSize()};
+  }
+
+  int getRoomIndex(Coordinates c) const {
+    return c.x / getRoomSize() + c.y / getRoomSize();
+  }
+
+  Temperature getRoomTemperature(Coordinates c) const {
+    return Temperature{20.0 + getRoomIndex(c) % 5};
+  }
+
+  void insert(Coordinates c, std::unique_ptr<Plain> && subject) {
+    sink_.modify(SubjectModifyQuery(SubjectModifyType::INSERT, c, std::move(subject)));
+  }
+
+  Plain makePlain(double weight, int heatCapacity, Coordinates c, double lightObs,
+                  double wirelessObs, double surface, double airObs) {
+    return Plain(Physical(weight, heatCapacity, getRoomTemperature(c),
+                          Obstruction{lightObs}, Obstruction{wirelessObs}),
+                 idx_++, surface, Obstruction{airObs});
+  }
+
+  void addAir(Coordinates c) {
+    int kind = isWall(c) ? 0 : getRoomIndex(c) % params_.airKinds;
+    double temp = getRoomTemperature(c).get() + random_.nextDouble(-0.5, 0.5);
+    double transfer = 0.2 + 0.05 * (kind % 4);
+
+    sink_.modify(AirInsertQuery(
+        c, std::make_unique<Air::Plain>(Physical(1.2, 1005, Temperature{temp}), kind,
+                                        transfer)));
+  }
+
+  void addWall(Coordinates c) {
+    insert(c, std::make_unique<Plain>(makePlain(500, 840, c, 0.95, 0.6, 1, 0.95)));
+  }
+
+  // closed when on
+  void addDoor(Coordinates c) {
+    auto status = random_.nextBool(0.5) ? TurnableStatus::ON : TurnableStatus::OFF;
+    insert(c, std::make_unique<Turnable>(makePlain(40, 1600, c, 0.9, 0.3, 1, 0.9),
+                                         status, Obstruction{0.05}, Obstruction{0.05},
+                                         Obstruction{0.05}));
+  }
+
+  void addRoomCell(Coordinates c) {
+    Coordinates offset = getRoomOffset(c);
+    int last = getRoomSize() - 1;
+    int spacing = params_.lampSpacing;
+
+    if (offset.x == 1 && offset.y == 1) {
+      addHeater(c);
+    } else if (offset.x == 1 && offset.y == 2) {
+      insert(c, std::make_unique<SensorAirTemperature>(
+                    makePlain(0.1, 900, c, 0, 0, 0.01, 0)));
+    } else if (offset.x == 2 && offset.y == 1) {
+      insert(c, std::make_unique<SensorIllumination>(
+                    makePlain(0.1, 900, c, 0, 0, 0.01, 0)));
+    } else if (offset.x == last && offset.y == last) {
+      addCamera(c);
+    } else if (c.x % spacing == spacing / 2 && c.y % spacing == spacing / 2) {
+      addLamp(c);
+    } else if (random_.nextBool(params_.density)) {
+      addDesk(c);
+    }
+  }
+
+  void addHeater(Coordinates c) {
+    TempEmitter heater(makePlain(15, 450, c, 0.2, 0.1, 0.6, 0.2),
+                       TempSourceParams{.heatProduction = 1000});
+    insert(c, std::make_unique<TurnableTempEmitter>(std::move(heater),
+                                                    TurnableStatus::ON,
+                                                    TempSourceParams{}));
+  }
+
+  void addLamp(Coordinates c) {
+    LightEmitter lamp(makePlain(1, 900, c, 0, 0, 0.05, 0),
+                      TempSourceParams{.heatProduction = 10},
+                      LightSourceParams{.rawIllumination = Illumination{400}});
+    insert(c, std::make_unique<TurnableLightEmitter>(
+                  std::move(lamp), TurnableStatus::ON, LightSourceParams{},
+                  TempSourceParams{}));
+  }
+
+  void addCamera(Coordinates c) {
+    auto plain = makePlain(0.5, 900, c, 0, 0, 0.02, 0);
+    if (random_.nextBool(0.5)) {
+      insert(c, std::make_unique<InfraredCamera>(std::move(plain), 100, 5));
+    } else {
+      insert(c, std::make_unique<LightCamera>(std::move(plain), 100, 5, 50));
+    }
+  }
+
+  // desk, every third one has a laptop on it
+  void addDesk(Coordinates c) {
+    insert(c, std::make_unique<Plain>(makePlain(30, 1700, c, 0.3, 0.1, 1.5, 0.3)));
+
+    if (random_.nextInt(3) == 0) {
+      insert(c, std::make_unique<WirelessNetworkDevice>(
+                    makePlain(2, 700, c, 0.05, 0.05, 0.1, 0.05), 40, 5));
+    }
+  }
+};
+
+/*
+ * Scenario has no modify, events are added to it on tick 0
+ */
+class ScenarioFloorSink final {
+  Scenario & scenario_;
+
+public:
+  explicit ScenarioFloorSink(Scenario & scenario) : scenario_(scenario) {}
+
+  void modify(SubjectModifyQuery && query) { scenario_.addEvent(0, std::move(query)); }
+  void modify(AirInsertQuery && query) { scenario_.addEvent(0, std::move(query)); }
+};
+
+void generateFloor(Scenario & scenario, const FloorParams & params) {
+  ScenarioFloorSink sink(scenario);
+  FloorGenerator(sink, params, scenario.getDimension()).generate();
+}
+
+void generateFloor(SimulationMap & map, const FloorParams & params) {
+  FloorGenerator(map, params, map.getDimension()).generate();
+}
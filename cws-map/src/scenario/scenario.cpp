@@ -0,0 +1,541 @@
+#include "cws/scenario/scenario.hpp"
+#include "cws/scenario/generator.hpp"
+
+#include <optional>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+
+#include "cws/simulation/callback.hpp"
+#include "cws/subject/camera.hpp"
+#include "cws/subject/light_emitter.hpp"
+#include "cws/subject/network.hpp"
+#include "cws/subject/sensor.hpp"
+#include "cws/subject/temp_emitter.hpp"
+#include "cws/subject/turnable.hpp"
+
+using namespace Subject;
+
+static const std::pair<Type, const char *> SUBJECT_TYPE_NAMES[] = {
+    {Type::PLAIN, "plain"},
+    {Type::TEMP_EMITTER, "temp_emitter"},
+    {Type::TURNABLE_TEMP_EMITTER, "turnable_temp_emitter"},
+    {Type::LIGHT_EMITTER, "light_emitter"},
+    {Type::TURNABLE_LIGHT_EMITTER, "turnable_light_emitter"},
+    {Type::WIRELESS_NETWORK_DEVICE, "wireless_network_device"},
+    {Type::INFRARED_CAMERA, "infrared_camera"},
+    {Type::LIGHT_CAMERA, "light_camera"},
+    {Type::TURNABLE, "turnable"},
+    {Type::AIR_TEMPERATURE_SENSOR, "air_temperature_sensor"},
+    {Type::ILLUMINATION_SENSOR, "illumination_sensor"},
+    {Type::WIRED_NETWORK_DEVICE, "wired_network_device"},
+};
+
+Type fromSubjectTypeName(const std::string & name) {
+  for (const auto & [type, typeName] : SUBJECT_TYPE_NAMES) {
+    if (name == typeName) {
+      return type;
+    }
+  }
+  return Type::UNSPECIFIED;
+}
+
+const char * toSubjectTypeName(Type type) {
+  for (const auto & [t, typeName] : SUBJECT_TYPE_NAMES) {
+    if (t == type) {
+      return typeName;
+    }
+  }
+  return "unspecified";
+}
+
+void Scenario::addEvent(std::size_t tick, ScenarioEvent && event) {
+  floors_.back().emplace(tick, std::move(event));
+}
+
+void Scenario::addPortal(const Portal & portal) {
+  checkPortal(portal, std::vector<Dimension>(floors_.size(), dimension_));
+  portals_.push_back(portal);
+}
+
+Building Scenario::makeBuilding() const {
+  Building building;
+  for (std::size_t i = 0; i < floors_.size(); ++i) {
+    building.addFloor(SimulationMap(dimension_));
+  }
+  for (const auto & portal : portals_) {
+    building.addPortal(portal);
+  }
+  return building;
+}
+
+void Scenario::apply(Building & building, std::size_t tick) const {
+  for (std::size_t i = 0; i < floors_.size(); ++i) {
+    apply(building.accessFloor(i), tick, i);
+  }
+}
+
+// events are copied so scenario can be applied several times
+template<typename Target>
+static void applyEvents(const std::multimap<std::size_t, ScenarioEvent> & events,
+                        Target & map, std::size_t tick) {
+  auto [begin, end] = events.equal_range(tick);
+
+  for (auto it = begin; it != end; ++it) {
+    const auto & event = it->second;
+
+    if (auto query = std::get_if<SubjectModifyQuery>(&event)) {
+      map.modify(SubjectModifyQuery(query->queryType, query->coordinates,
+                                    std::unique_ptr<Plain>(query->subject->clone())));
+    } else if (auto query = std::get_if<AirInsertQuery>(&event)) {
+      map.modify(AirInsertQuery(query->coordinates,
+                                std::unique_ptr<Air::Plain>(query->air->clone())));
+    } else if (auto query = std::get_if<AirRegionQuery>(&event)) {
+      AirRegionQuery copy{query->queryType, query->region};
+      if (query->air) {
+        copy.air.reset(query->air->clone());
+      }
+      copy.factor = query->factor;
+      copy.temperature = query->temperature;
+      map.modify(std::move(copy));
+    } else if (auto query = std::get_if<ScenarioTurnQuery>(&event)) {
+      auto status = query->status;
+      map.modify(SubjectCallbackQuery<TurnableStatus>(
+          SubjectSelectQuery(query->select), setTurnableStatus, std::move(status)));
+    } else if (auto query = std::get_if<CableModifyQuery>(&event)) {
+      map.modify(CableModifyQuery(*query));
+    }
+  }
+}
+
+void Scenario::apply(SimulationMap & map, std::size_t tick, std::size_t floor) const {
+  applyEvents(floors_.at(floor), map, tick);
+}
+
+void Scenario::apply(PartitionedMap & map, std::size_t tick) const {
+  applyEvents(floors_.at(0), map, tick);
+}
+
+/*
+ * Parameters of entry written as key=value, each should be used once
+ */
+class ScenarioParams final {
+  std::size_t line_;
+  std::map<std::string, std::string> values_;
+  std::set<std::string> used_;
+
+public:
+  ScenarioParams(std::size_t line, std::istringstream & in) : line_(line) {
+    std::string token;
+    while (in >> token) {
+      auto pos = token.find('=');
+      if (pos == std::string::npos || pos == 0) {
+        error("expected key=value, got '" + token + "'");
+      }
+      values_[token.substr(0, pos)] = token.substr(pos + 1);
+    }
+  }
+
+  [[noreturn]] void error(const std::string & what) const {
+    throw std::invalid_argument("line " + std::to_string(line_) + ": " + what);
+  }
+
+  const std::string * find(const std::string & key) {
+    auto it = values_.find(key);
+    if (it == values_.end()) {
+      return nullptr;
+    }
+    used_.insert(key);
+    return &it->second;
+  }
+
+  double getDouble(const std::string & key, double def = 0) {
+    auto value = find(key);
+    if (!value) {
+      return def;
+    }
+    try {
+      return std::stod(*value);
+    } catch (const std::exception &) {
+      error("bad number '" + *value + "' for " + key);
+    }
+  }
+
+  int getInt(const std::string & key) {
+    auto value = find(key);
+    if (!value) {
+      error("missing " + key);
+    }
+    try {
+      return std::stoi(*value);
+    } catch (const std::exception &) {
+      error("bad integer '" + *value + "' for " + key);
+    }
+  }
+
+  int getInt(const std::string & key, int def) {
+    return values_.contains(key) ? getInt(key) : def;
+  }
+
+  TurnableStatus getStatus(const std::string & key, TurnableStatus def) {
+    auto value = find(key);
+    if (!value) {
+      return def;
+    }
+    if (*value == "on") {
+      return TurnableStatus::ON;
+    }
+    if (*value == "off") {
+      return TurnableStatus::OFF;
+    }
+    error("bad status '" + *value + "', expected on|off");
+  }
+
+  // written as <type>:<idx>
+  Subject::Id getSubjectId(const std::string & key) {
+    auto value = find(key);
+    if (!value) {
+      error("missing parameter '" + key + "'");
+    }
+    auto pos = value->find(':');
+    Type type = fromSubjectTypeName(value->substr(0, pos));
+    if (pos == std::string::npos || type == Type::UNSPECIFIED) {
+      error("bad subject '" + *value + "', expected <type>:<idx>");
+    }
+    try {
+      return Subject::Id{.type = type, .idx = std::stoi(value->substr(pos + 1))};
+    } catch (const std::exception &) {
+      error("bad subject '" + *value + "', expected <type>:<idx>");
+    }
+  }
+
+  // written as <floor>:<x>:<y>
+  std::pair<std::size_t, Coordinates> getFloorCell(const std::string & key) {
+    auto value = find(key);
+    if (!value) {
+      error("missing parameter '" + key + "'");
+    }
+    std::istringstream in(*value);
+    int floor;
+    Coordinates c;
+    char first, second;
+    if (!(in >> floor >> first >> c.x >> second >> c.y) || first != ':' ||
+        second != ':' || floor < 0 || !in.eof()) {
+      error("bad cell '" + *value + "', expected <floor>:<x>:<y>");
+    }
+    return {static_cast<std::size_t>(floor), c};
+  }
+
+  // written as <x>:<y>,<x>:<y>,...
+  std::vector<Coordinates> getPolygon(const std::string & key) {
+    auto value = find(key);
+    std::vector<Coordinates> polygon;
+    std::istringstream in(value ? *value : "");
+    Coordinates vertex;
+    char colon, comma;
+    while (in >> vertex.x >> colon >> vertex.y && colon == ':') {
+      polygon.push_back(vertex);
+      if (!(in >> comma) || comma != ',') {
+        break;
+      }
+    }
+    if (polygon.size() < 3 || !in.eof()) {
+      error("bad polygon, expected at least 3 vertices <x>:<y>,...");
+    }
+    return polygon;
+  }
+
+  CellRegion getRegion() {
+    if (values_.contains("polygon")) {
+      return CellRegion{.polygon = getPolygon("polygon")};
+    }
+    CellRegion region{{getInt("x"), getInt("y")}, {getInt("width"), getInt("height")}};
+    if (region.size.width <= 0 || region.size.height <= 0) {
+      error("width and height should be positive");
+    }
+    return region;
+  }
+
+  Coordinates getCoordinates(Dimension dim) {
+    Coordinates c{getInt("x"), getInt("y")};
+    if (c.x < 0 || c.x >= dim.width || c.y < 0 || c.y >= dim.height) {
+      error("coordinates out of bounds");
+    }
+    return c;
+  }
+
+  void verifyAllUsed() const {
+    for (const auto & [key, value] : values_) {
+      if (!used_.contains(key)) {
+        error("unknown parameter '" + key + "'");
+      }
+    }
+  }
+};
+
+static Physical readPhysical(ScenarioParams & params) {
+  return Physical(params.getDouble("weight"), params.getInt("heat_capacity", 0),
+                  Temperature{params.getDouble("temp")},
+                  Obstruction{params.getDouble("light_obs")},
+                  Obstruction{params.getDouble("wireless_obs")});
+}
+
+static Plain readPlain(ScenarioParams & params) {
+  return Plain(readPhysical(params), params.getInt("idx"), params.getDouble("surface"),
+               Obstruction{params.getDouble("air_obs")});
+}
+
+static TempSourceParams readTempParams(ScenarioParams & params,
+                                       const std::string & key) {
+  return TempSourceParams{.heatProduction = params.getDouble(key)};
+}
+
+static LightSourceParams readLightParams(ScenarioParams & params,
+                                         const std::string & key) {
+  return LightSourceParams{.rawIllumination = Illumination{params.getInt(key, 0)}};
+}
+
+static std::unique_ptr<Plain> readCamera(std::unique_ptr<BaseCamera> camera,
+                                         ScenarioParams & params) {
+  camera->setView(CameraView{.range = params.getInt("range", 0),
+                             .direction = params.getDouble("direction"),
+                             .fov = params.getDouble("fov", 360)});
+  return camera;
+}
+
+static std::unique_ptr<Plain> readSubject(Type type, ScenarioParams & params) {
+  switch (type) {
+  case Type::PLAIN:
+    return std::make_unique<Plain>(readPlain(params));
+  case Type::TEMP_EMITTER:
+    return std::make_unique<TempEmitter>(readPlain(params),
+                                         readTempParams(params, "heat"));
+  case Type::TURNABLE_TEMP_EMITTER:
+    return std::make_unique<TurnableTempEmitter>(
+        TempEmitter(readPlain(params), readTempParams(params, "heat")),
+        params.getStatus("status", TurnableStatus::ON),
+        readTempParams(params, "off_heat"));
+  case Type::LIGHT_EMITTER:
+    return std::make_unique<LightEmitter>(readPlain(params),
+                                          readTempParams(params, "heat"),
+                                          readLightParams(params, "illumination"));
+  case Type::TURNABLE_LIGHT_EMITTER:
+    return std::make_unique<TurnableLightEmitter>(
+        LightEmitter(readPlain(params), readTempParams(params, "heat"),
+                     readLightParams(params, "illumination")),
+        params.getStatus("status", TurnableStatus::ON),
+        readLightParams(params, "off_illumination"),
+        readTempParams(params, "off_heat"));
+  case Type::WIRELESS_NETWORK_DEVICE:
+    return std::make_unique<WirelessNetworkDevice>(readPlain(params),
+                                                   params.getInt("transmit_power", 0),
+                                                   params.getInt("receive_threshold", 0));
+  case Type::WIRED_NETWORK_DEVICE:
+    return std::make_unique<WiredNetworkDevice>(readPlain(params));
+  case Type::INFRARED_CAMERA:
+    return readCamera(
+        std::make_unique<InfraredCamera>(readPlain(params), params.getDouble("power"),
+                                         params.getDouble("power_threshold")),
+        params);
+  case Type::LIGHT_CAMERA:
+    return readCamera(std::make_unique<LightCamera>(
+                          readPlain(params), params.getDouble("power"),
+                          params.getDouble("power_threshold"),
+                          params.getDouble("light_threshold")),
+                      params);
+  case Type::TURNABLE:
+    return std::make_unique<Turnable>(readPlain(params),
+                                      params.getStatus("status", TurnableStatus::ON),
+                                      Obstruction{params.getDouble("off_light_obs")},
+                                      Obstruction{params.getDouble("off_wireless_obs")},
+                                      Obstruction{params.getDouble("off_air_obs")});
+  case Type::AIR_TEMPERATURE_SENSOR:
+    return std::make_unique<SensorAirTemperature>(readPlain(params));
+  case Type::ILLUMINATION_SENSOR:
+    return std::make_unique<SensorIllumination>(readPlain(params));
+  default:
+    return nullptr;
+  }
+}
+
+static std::unique_ptr<Air::Plain> readAir(ScenarioParams & params) {
+  return std::make_unique<Air::Plain>(readPhysical(params), params.getInt("idx"),
+                                      params.getDouble("transfer"));
+}
+
+Scenario readScenario(std::istream & in) {
+  std::optional<Scenario> scenario;
+
+  std::string line;
+  std::size_t lineNumber = 0;
+
+  while (std::getline(in, line)) {
+    ++lineNumber;
+
+    if (auto pos = line.find('#'); pos != std::string::npos) {
+      line.erase(pos);
+    }
+
+    std::istringstream lineIn(line);
+    std::string keyword;
+    if (!(lineIn >> keyword)) {
+      continue;
+    }
+
+    auto error = [lineNumber](const std::string & what) {
+      throw std::invalid_argument("line " + std::to_string(lineNumber) + ": " + what);
+    };
+
+    std::size_t tick = 0;
+    if (keyword[0] == '@') {
+      try {
+        tick = std::stoul(keyword.substr(1));
+      } catch (const std::exception &) {
+        error("bad tick '" + keyword + "'");
+      }
+      if (!(lineIn >> keyword)) {
+        error("expected entry after tick");
+      }
+    }
+
+    if (keyword == "dimension") {
+      Dimension dim;
+      if (scenario || !(lineIn >> dim.width >> dim.height) || dim.width <= 0 ||
+          dim.height <= 0) {
+        error("dimension should be set once with positive width and height");
+      }
+      scenario.emplace(dim);
+      continue;
+    }
+
+    if (!scenario) {
+      error("dimension should be set first");
+    }
+
+    if (keyword == "ticks") {
+      std::size_t ticks;
+      if (!(lineIn >> ticks)) {
+        error("bad tick count");
+      }
+      scenario->setTicks(ticks);
+
+    } else if (keyword == "subject") {
+      std::string typeName;
+      lineIn >> typeName;
+      Type type = fromSubjectTypeName(typeName);
+      if (type == Type::UNSPECIFIED) {
+        error("unknown subject type '" + typeName + "'");
+      }
+      ScenarioParams params(lineNumber, lineIn);
+      auto coordinates = params.getCoordinates(scenario->getDimension());
+      auto subject = readSubject(type, params);
+      params.verifyAllUsed();
+      scenario->addEvent(tick, SubjectModifyQuery(SubjectModifyType::INSERT,
+                                                  coordinates, std::move(subject)));
+
+    } else if (keyword == "air") {
+      ScenarioParams params(lineNumber, lineIn);
+      auto coordinates = params.getCoordinates(scenario->getDimension());
+      auto air = readAir(params);
+      params.verifyAllUsed();
+      scenario->addEvent(tick, AirInsertQuery(coordinates, std::move(air)));
+
+    } else if (keyword == "air_region") {
+      std::string operation;
+      lineIn >> operation;
+      ScenarioParams params(lineNumber, lineIn);
+      AirRegionQuery query{AirRegionModifyType::FILL, params.getRegion()};
+      if (operation == "fill") {
+        query.air = readAir(params);
+      } else if (operation == "scale") {
+        query.queryType = AirRegionModifyType::SCALE;
+        query.factor = params.getDouble("factor", 1);
+        if (query.factor < 0) {
+          params.error("factor should not be negative");
+        }
+      } else if (operation == "temperature") {
+        query.queryType = AirRegionModifyType::SET_TEMPERATURE;
+        query.temperature = Temperature{params.getDouble("temp")};
+      } else {
+        error("unknown air region operation '" + operation + "'");
+      }
+      params.verifyAllUsed();
+      scenario->addEvent(tick, std::move(query));
+
+    } else if (keyword == "turn") {
+      std::string typeName;
+      lineIn >> typeName;
+      Type type = fromSubjectTypeName(typeName);
+      if (type == Type::UNSPECIFIED) {
+        error("unknown subject type '" + typeName + "'");
+      }
+      ScenarioParams params(lineNumber, lineIn);
+      auto coordinates = params.getCoordinates(scenario->getDimension());
+      Subject::Id id{.type = type, .idx = params.getInt("idx")};
+      auto status = params.getStatus("status", TurnableStatus::ON);
+      params.verifyAllUsed();
+      scenario->addEvent(tick, ScenarioTurnQuery{SubjectSelectQuery(coordinates, id),
+                                                 status});
+    } else if (keyword == "cable") {
+      ScenarioParams params(lineNumber, lineIn);
+      auto first = params.getSubjectId("from");
+      auto second = params.getSubjectId("to");
+      auto status = params.getStatus("status", TurnableStatus::ON);
+      params.verifyAllUsed();
+      scenario->addEvent(tick, CableModifyQuery{status == TurnableStatus::ON
+                                                    ? CableModifyType::CONNECT
+                                                    : CableModifyType::DISCONNECT,
+                                                first, second});
+    } else if (keyword == "generate") {
+      if (tick != 0) {
+        error("generated floor can be placed on tick 0 only");
+      }
+      ScenarioParams params(lineNumber, lineIn);
+      FloorParams floor;
+      floor.seed = params.getInt("seed", floor.seed);
+      floor.roomSize = params.getInt("room", floor.roomSize);
+      floor.lampSpacing = params.getInt("lamps", floor.lampSpacing);
+      floor.density = params.getDouble("density", floor.density);
+      floor.airKinds = params.getInt("air_kinds", floor.airKinds);
+      params.verifyAllUsed();
+      try {
+        generateFloor(*scenario, floor);
+      } catch (const std::invalid_argument & e) {
+        error(e.what());
+      }
+    } else if (keyword == "floor") {
+      if (tick != 0) {
+        error("floor can be added on tick 0 only");
+      }
+      ScenarioParams params(lineNumber, lineIn);
+      params.verifyAllUsed();
+      scenario->addFloor();
+    } else if (keyword == "portal") {
+      if (tick != 0) {
+        error("portal can be added on tick 0 only");
+      }
+      ScenarioParams params(lineNumber, lineIn);
+      Portal portal;
+      std::tie(portal.lowerFloor, portal.lower) = params.getFloorCell("lower");
+      std::tie(portal.upperFloor, portal.upper) = params.getFloorCell("upper");
+      portal.airRate = params.getDouble("air");
+      portal.lightRate = params.getDouble("light");
+      portal.wirelessRate = params.getDouble("wireless");
+      params.verifyAllUsed();
+      try {
+        scenario->addPortal(portal);
+      } catch (const std::invalid_argument & e) {
+        error(e.what());
+      }
+    } else {
+      error("unknown entry '" + keyword + "'");
+    }
+  }
+
+  if (!scenario) {
+    throw std::invalid_argument("scenario has no dimension");
+  }
+
+  return std::move(*scenario);
+}
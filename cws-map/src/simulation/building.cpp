@@ -0,0 +1,145 @@
+#include "cws/simulation/building.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+static bool isInside(Coordinates c, Dimension dim) {
+  return c.x >= 0 && c.x < dim.width && c.y >= 0 && c.y < dim.height;
+}
+
+static bool isRate(double rate) { return rate >= 0 && rate <= 1; }
+
+void checkPortal(const Portal & portal, std::span<const Dimension> floors) {
+  if (portal.lowerFloor >= floors.size() || portal.upperFloor >= floors.size()) {
+    throw std::invalid_argument("portal: floor doesn't exist");
+  }
+  if (portal.lowerFloor == portal.upperFloor) {
+    throw std::invalid_argument("portal: floors should be different");
+  }
+  if (!isInside(portal.lower, floors[portal.lowerFloor]) ||
+      !isInside(portal.upper, floors[portal.upperFloor])) {
+    throw std::invalid_argument("portal: cell is out of floor");
+  }
+  if (!isRate(portal.airRate) || !isRate(portal.lightRate) ||
+      !isRate(portal.wirelessRate)) {
+    throw std::invalid_argument("portal: rate should be in [0, 1]");
+  }
+}
+
+std::size_t Building::addFloor(SimulationMap && floor) {
+  floors_.push_back(std::move(floor));
+  return floors_.size() - 1;
+}
+
+void Building::addPortal(const Portal & portal) {
+  std::vector<Dimension> dims;
+  for (const auto & floor : floors_) {
+    dims.push_back(floor.getDimension());
+  }
+  checkPortal(portal, dims);
+  portals_.push_back(portal);
+}
+
+void Building::next(const Building & cur, unsigned threads,
+                    std::vector<MapStageTimes> * times) {
+  if (cur.floors_.size() != floors_.size()) {
+    throw std::invalid_argument("building: floors of states differ");
+  }
+  if (times) {
+    times->resize(floors_.size());
+  }
+
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  threads = std::max<std::size_t>(1, std::min<std::size_t>(threads, floors_.size()));
+
+  if (!workers_ || workers_->getThreadCount() != threads) {
+    workers_ = std::make_shared<ParallelWorkers>(threads);
+  }
+
+  // floors don't share anything until portals are passed
+  workers_->run(floors_.size(), [&](std::size_t k) {
+    floors_[k].next(cur.floors_[k], times ? &(*times)[k] : nullptr);
+  });
+
+  for (const auto & portal : portals_) {
+    exchangeAir(portal);
+    exchangeLight(portal);
+    exchangeWireless(portal);
+  }
+}
+
+/*
+ * Both cells give share of each of their air to the other one, so weight is kept and
+ * temperature is mixed by container
+ */
+void Building::exchangeAir(const Portal & portal) {
+  if (portal.airRate == 0) {
+    return;
+  }
+  auto & lower =
+      floors_[portal.lowerFloor].layers.airLayer.accessAirContainer(portal.lower);
+  auto & upper =
+      floors_[portal.upperFloor].layers.airLayer.accessAirContainer(portal.upper);
+
+  double share = portal.airRate / 2;
+  auto take = [share](const Air::Container & container) {
+    std::list<Air::Container::PlainUPTR> taken;
+    for (const auto & air : container.getList()) {
+      taken.emplace_back(air->cloneWithWeight(air->getWeight() * share));
+    }
+    return taken;
+  };
+
+  auto toUpper = take(lower);
+  auto toLower = take(upper);
+  lower.scaleWeight(1 - share);
+  upper.scaleWeight(1 - share);
+  lower.add(std::move(toLower));
+  upper.add(std::move(toUpper));
+}
+
+void Building::exchangeLight(const Portal & portal) {
+  if (portal.lightRate == 0) {
+    return;
+  }
+  auto & lower = floors_[portal.lowerFloor].layers.illuminationLayer;
+  auto & upper = floors_[portal.upperFloor].layers.illuminationLayer;
+
+  auto passed = [&portal](Illumination illum) {
+    return Illumination{static_cast<int>(illum.get() * portal.lightRate)};
+  };
+
+  auto toUpper = passed(lower.getOwnIllumination(portal.lower));
+  auto toLower = passed(upper.getOwnIllumination(portal.upper));
+  upper.addPortalLight(portal.upper, toUpper);
+  lower.addPortalLight(portal.lower, toLower);
+}
+
+void Building::exchangeWireless(const Portal & portal) {
+  if (portal.wirelessRate == 0) {
+    return;
+  }
+  auto & lower = floors_[portal.lowerFloor].layers.networkWireless;
+  auto & upper = floors_[portal.upperFloor].layers.networkWireless;
+
+  // relayed containers aren't relayed back
+  auto take = [&portal](const MapLayerNetworkWireless & layer, Coordinates c) {
+    std::list<std::unique_ptr<Network::Container>> taken;
+    for (const auto & container : layer.getReceivableContainers(c)) {
+      auto wireless = static_cast<const Network::WirelessContainer *>(container.get());
+      if (!wireless->isRelayed()) {
+        taken.emplace_back(
+            wireless->cloneRelayed(wireless->getSignalPower() * portal.wirelessRate));
+      }
+    }
+    return taken;
+  };
+
+  auto toUpper = take(lower, portal.lower);
+  auto toLower = take(upper, portal.upper);
+  upper.relay(portal.upper, std::move(toUpper));
+  lower.relay(portal.lower, std::move(toLower));
+}
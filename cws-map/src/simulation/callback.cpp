@@ -1,4 +1,4 @@
-#include "service/sv_device_cb.hpp"
+#include "cws/simulation/callback.hpp"
 
 #include "cws/subject/extension/turnable.hpp"
 #include "cws/subject/network.hpp"
@@ -0,0 +1,193 @@
+#include "cws/simulation/checkpoint.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <set>
+#include <stdexcept>
+#include <system_error>
+
+#include "cws/log.hpp"
+#include "cws/simulation/snapshot.hpp"
+
+namespace fs = std::filesystem;
+
+// stop request is checked at least this often
+static constexpr std::chrono::milliseconds WAIT_TIMEOUT(200);
+
+struct CheckpointFile final {
+  std::size_t sequence = 0;
+  std::size_t tick = 0;
+  std::size_t base = 0;// sequence of full checkpoint, 0 if file is full itself
+  fs::path path;
+};
+
+static std::string fullName(std::size_t sequence, std::size_t tick) {
+  return std::to_string(sequence) + "-" + std::to_string(tick) + ".full";
+}
+
+static std::string deltaName(std::size_t sequence, std::size_t tick,
+                             std::size_t base) {
+  return std::to_string(sequence) + "-" + std::to_string(tick) + "-" +
+         std::to_string(base) + ".delta";
+}
+
+// other files of directory are skipped, newest first
+static std::vector<CheckpointFile> listCheckpoints(const fs::path & directory) {
+  std::vector<CheckpointFile> files;
+  std::error_code ec;
+  for (const auto & entry : fs::directory_iterator(directory, ec)) {
+    auto name = entry.path().filename().string();
+    CheckpointFile file{.path = entry.path()};
+
+    // name is accepted only if it is the one written for parsed values
+    if (std::sscanf(name.c_str(), "%zu-%zu-%zu.delta", &file.sequence, &file.tick,
+                    &file.base) == 3 &&
+        name == deltaName(file.sequence, file.tick, file.base)) {
+      files.push_back(file);
+    } else if (std::sscanf(name.c_str(), "%zu-%zu.full", &file.sequence,
+                           &file.tick) == 2 &&
+               name == fullName(file.sequence, file.tick)) {
+      file.base = 0;
+      files.push_back(file);
+    }
+  }
+
+  std::sort(files.begin(), files.end(),
+            [](const auto & a, const auto & b) { return a.sequence > b.sequence; });
+  return files;
+}
+
+Checkpointer::Checkpointer(const SimulationInterface & interface,
+                           CheckpointOptions options)
+    : interface_(interface), options_(std::move(options)) {
+  fs::create_directories(options_.directory);
+
+  auto files = listCheckpoints(options_.directory);
+  if (!files.empty()) {
+    sequence_ = files.front().sequence;
+  }
+
+  if (options_.everyTicks != 0 || options_.every.count() != 0) {
+    worker_ = std::jthread(std::bind_front(&Checkpointer::execute, this));
+  }
+}
+
+RestoredCheckpoint Checkpointer::restore(const std::string & directory,
+                                         std::size_t maxTick) {
+  auto files = listCheckpoints(directory);
+
+  for (const auto & file : files) {
+    if (file.tick > maxTick) {
+      continue;
+    }
+    try {
+      if (file.base == 0) {
+        return RestoredCheckpoint{file.tick, loadSnapshot(file.path.string())};
+      }
+
+      auto base = std::find_if(files.begin(), files.end(), [&](const auto & other) {
+        return other.base == 0 && other.sequence == file.base;
+      });
+      if (base == files.end()) {
+        throw std::invalid_argument("full checkpoint is missing");
+      }
+
+      auto map = loadSnapshot(base->path.string());
+      if (loadSnapshotDelta(*map, file.path.string()) != file.base) {
+        throw std::invalid_argument("delta has other base");
+      }
+      return RestoredCheckpoint{file.tick, std::move(map)};
+
+    } catch (const std::exception & e) {
+      CWS_LOG_WARN("checkpoint", "skipped " << file.path.string() << ": " << e.what());
+    }
+  }
+  return RestoredCheckpoint{};
+}
+
+void Checkpointer::write(std::size_t tick, const SimulationMap & map) {
+  Dimension dim = map.getDimension();
+  bool full = baseHashes_.empty() || deltas_ >= options_.deltasPerFull ||
+              dim.width != baseDim_.width || dim.height != baseDim_.height;
+
+  fs::path directory(options_.directory);
+  sequence_ += 1;
+
+  try {
+    if (full) {
+      baseHashes_ = saveSnapshot((directory / fullName(sequence_, tick)).string(), map);
+      baseSequence_ = sequence_;
+      baseDim_ = dim;
+      deltas_ = 0;
+      removeExpired();
+      CWS_LOG_INFO("checkpoint", "full " << sequence_ << " of tick " << tick);
+    } else {
+      auto path = directory / deltaName(sequence_, tick, baseSequence_);
+      auto changed = saveSnapshotDelta(path.string(), map, baseSequence_, baseHashes_);
+      deltas_ += 1;
+      CWS_LOG_DEBUG("checkpoint", "delta " << sequence_ << " of tick " << tick
+                                            << ", cells: " << changed);
+    }
+  } catch (...) {
+    // next one is full, so failed write doesn't break chain
+    baseHashes_.clear();
+    throw;
+  }
+}
+
+void Checkpointer::execute(std::stop_token stoken) {
+  std::size_t version = 0;
+  std::size_t lastTick = 0;
+  bool written = false;
+  auto lastTime = std::chrono::steady_clock::now();
+
+  while (!stoken.stop_requested()) {
+    // published map is shared, so it is written without holding master
+    auto snapshot = interface_.waitMap(version, WAIT_TIMEOUT);
+    if (snapshot.version == version || !snapshot.map) {
+      version = snapshot.version;
+      continue;
+    }
+    version = snapshot.version;
+
+    auto now = std::chrono::steady_clock::now();
+    bool tickDue = options_.everyTicks != 0 &&
+                   (!written || snapshot.tick < lastTick ||
+                    snapshot.tick - lastTick >= options_.everyTicks);
+    bool timeDue = options_.every.count() != 0 && now - lastTime >= options_.every;
+    if (!tickDue && !timeDue) {
+      continue;
+    }
+
+    try {
+      write(snapshot.tick, *snapshot.map);
+    } catch (const std::exception & e) {
+      CWS_LOG_ERROR("checkpoint", "not written: " << e.what());
+    }
+    lastTick = snapshot.tick;
+    lastTime = now;
+    written = true;
+  }
+}
+
+void Checkpointer::removeExpired() {
+  auto files = listCheckpoints(options_.directory);
+
+  // the one just written is always kept
+  auto keepFull = std::max<std::size_t>(options_.keepFull, 1);
+  std::set<std::size_t> kept;
+  for (const auto & file : files) {
+    if (file.base == 0 && kept.size() < keepFull) {
+      kept.insert(file.sequence);
+    }
+  }
+
+  for (const auto & file : files) {
+    if (!kept.contains(file.base == 0 ? file.sequence : file.base)) {
+      std::error_code ec;
+      fs::remove(file.path, ec);
+    }
+  }
+}
@@ -0,0 +1,237 @@
+#include "cws/simulation/import.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <tuple>
+
+#include "cws/simulation/record.hpp"
+
+static constexpr char IMPORT_MAGIC[8] = {'C', 'W', 'S', 'I', 'M', 'P', 'T', '\0'};
+
+static bool isInside(Coordinates c, Dimension dim) {
+  return c.x >= 0 && c.x < dim.width && c.y >= 0 && c.y < dim.height;
+}
+
+void MapImporter::check(const MapImportQuery & chunk) const {
+  for (std::size_t i = 0; i < chunk.subjects.size(); ++i) {
+    const auto & query = chunk.subjects[i];
+    auto item = "subject " + std::to_string(i);
+    if (query.queryType != SubjectModifyType::INSERT || !query.subject) {
+      throw std::invalid_argument(item + " is not inserted");
+    }
+    if (!isInside(query.coordinates, dimension_)) {
+      throw std::invalid_argument(item + " is out of map");
+    }
+    SubjectSelectQuery select(query.coordinates, query.subject->getId());
+    if (map_ && map_->select(select) != nullptr) {
+      throw std::invalid_argument(item + " already exists");
+    }
+  }
+
+  for (std::size_t i = 0; i < chunk.air.size(); ++i) {
+    const auto & query = chunk.air[i];
+    auto item = "air " + std::to_string(i);
+    if (!query.air) {
+      throw std::invalid_argument(item + " is not set");
+    }
+    if (!isInside(query.coordinates, dimension_)) {
+      throw std::invalid_argument(item + " is out of map");
+    }
+  }
+}
+
+MapImportQuery MapImporter::build(unsigned threads) {
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  threads = std::min<std::size_t>(threads, chunks_.size());
+
+  std::vector<MapImportQuery> chunks(chunks_.size());
+  std::vector<std::exception_ptr> errors(chunks_.size());
+  std::atomic<std::size_t> next = 0;
+  {
+    std::vector<std::jthread> pool;
+    for (unsigned i = 0; i < threads; ++i) {
+      pool.emplace_back([&] {
+        for (auto k = next++; k < chunks_.size(); k = next++) {
+          try {
+            chunks[k] = chunks_[k]();
+            check(chunks[k]);
+          } catch (...) {
+            errors[k] = std::current_exception();
+          }
+        }
+      });
+    }
+  }
+  chunks_.clear();
+
+  for (std::size_t k = 0; k < errors.size(); ++k) {
+    if (!errors[k]) {
+      continue;
+    }
+    try {
+      std::rethrow_exception(errors[k]);
+    } catch (const std::exception & e) {
+      throw std::invalid_argument("map import: chunk " + std::to_string(k) + ": " +
+                                  e.what());
+    }
+  }
+
+  MapImportQuery result;
+  std::size_t subjectCount = 0;
+  std::size_t airCount = 0;
+  for (const auto & chunk : chunks) {
+    subjectCount += chunk.subjects.size();
+    airCount += chunk.air.size();
+  }
+  result.subjects.reserve(subjectCount);
+  result.air.reserve(airCount);
+  for (auto & chunk : chunks) {
+    std::move(chunk.subjects.begin(), chunk.subjects.end(),
+              std::back_inserter(result.subjects));
+    std::move(chunk.air.begin(), chunk.air.end(), std::back_inserter(result.air));
+  }
+
+  // ids are unique within cell, chunks are checked against each other here
+  std::vector<std::tuple<int, int, int, int>> keys;
+  keys.reserve(subjectCount);
+  for (const auto & query : result.subjects) {
+    auto id = query.subject->getId();
+    keys.emplace_back(query.coordinates.x, query.coordinates.y,
+                      static_cast<int>(id.type), id.idx);
+  }
+  std::sort(keys.begin(), keys.end());
+  auto repeated = std::adjacent_find(keys.begin(), keys.end());
+  if (repeated != keys.end()) {
+    std::ostringstream what;
+    what << "map import: subject " << std::get<3>(*repeated) << " is repeated at "
+         << Coordinates{std::get<0>(*repeated), std::get<1>(*repeated)};
+    throw std::invalid_argument(what.str());
+  }
+
+  return result;
+}
+
+void writeMapImport(std::ostream & out, const MapImport & import,
+                    std::size_t chunkSize) {
+  RecordWriter writer;
+  writer.putBytes(IMPORT_MAGIC, sizeof(IMPORT_MAGIC));
+  writer.put(MAP_IMPORT_VERSION);
+  bool hasDimension = import.dimension.isSet();
+  auto dim = hasDimension ? import.dimension.get() : Dimension{0, 0};
+  writer.put<std::uint8_t>(hasDimension);
+  writer.put<std::int32_t>(dim.width);
+  writer.put<std::int32_t>(dim.height);
+  out.write(writer.getBuffer().data(), writer.getBuffer().size());
+
+  const auto & subjects = import.query.subjects;
+  const auto & air = import.query.air;
+  chunkSize = std::max<std::size_t>(chunkSize, 1);
+
+  for (std::size_t first = 0; first < std::max(subjects.size(), air.size());
+       first += chunkSize) {
+    writer.clear();
+    writer.put<std::uint32_t>(0);
+
+    auto subjectEnd = std::min(first + chunkSize, subjects.size());
+    writer.put<std::uint32_t>(subjectEnd > first ? subjectEnd - first : 0);
+    for (auto i = first; i < subjectEnd; ++i) {
+      writer.putCoordinates(subjects[i].coordinates);
+      writer.putSubject(*subjects[i].subject);
+    }
+
+    auto airEnd = std::min(first + chunkSize, air.size());
+    writer.put<std::uint32_t>(airEnd > first ? airEnd - first : 0);
+    for (auto i = first; i < airEnd; ++i) {
+      writer.putCoordinates(air[i].coordinates);
+      writer.putAir(*air[i].air);
+    }
+
+    writer.putAt<std::uint32_t>(0, writer.mark() - sizeof(std::uint32_t));
+    out.write(writer.getBuffer().data(), writer.getBuffer().size());
+  }
+}
+
+MapImport readMapImport(std::span<const std::byte> data, const SimulationMap * map) {
+  RecordReader reader(data, "map import");
+  char magic[sizeof(IMPORT_MAGIC)];
+  for (auto & ch : magic) {
+    ch = reader.get<char>();
+  }
+  if (std::memcmp(magic, IMPORT_MAGIC, sizeof(magic)) != 0) {
+    reader.error("not a map import");
+  }
+  auto version = reader.get<std::uint32_t>();
+  if (version != MAP_IMPORT_VERSION) {
+    reader.error("unsupported version " + std::to_string(version));
+  }
+
+  MapImport result;
+  bool hasDimension = reader.get<std::uint8_t>() != 0;
+  Dimension dim{reader.get<std::int32_t>(), reader.get<std::int32_t>()};
+  if (hasDimension) {
+    if (dim.width <= 0 || dim.height <= 0) {
+      reader.error("bad dimension");
+    }
+    result.dimension.set(dim);
+    map = nullptr;
+  } else if (map == nullptr) {
+    reader.error("map is not created");
+  } else {
+    dim = map->getDimension();
+  }
+
+  // chunks refer to data, which outlives build
+  MapImporter importer(dim, map);
+  while (reader.getRemaining() > 0) {
+    auto chunk = reader.getBytes(reader.get<std::uint32_t>());
+    importer.add([chunk, dim] {
+      RecordReader reader(chunk, "record");
+      MapImportQuery query;
+
+      auto subjectCount = reader.get<std::uint32_t>();
+      for (std::uint32_t i = 0; i < subjectCount; ++i) {
+        auto c = reader.getCoordinates(dim);
+        query.subjects.emplace_back(SubjectModifyType::INSERT, c, reader.getSubject());
+      }
+      auto airCount = reader.get<std::uint32_t>();
+      for (std::uint32_t i = 0; i < airCount; ++i) {
+        auto c = reader.getCoordinates(dim);
+        query.air.emplace_back(c, reader.getAir());
+      }
+
+      if (reader.getRemaining() != 0) {
+        reader.error("unexpected data in chunk");
+      }
+      return query;
+    });
+  }
+
+  result.query = importer.build();
+  return result;
+}
+
+MapImport loadMapImport(const std::string & path, const SimulationMap * map) {
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  if (!in) {
+    throw std::system_error(errno, std::generic_category(), path);
+  }
+  std::vector<std::byte> data(static_cast<std::size_t>(in.tellg()));
+  in.seekg(0);
+  in.read(reinterpret_cast<char *>(data.data()),
+          static_cast<std::streamsize>(data.size()));
+  if (!in) {
+    throw std::system_error(errno, std::generic_category(), path);
+  }
+  return readMapImport(data, map);
+}
@@ -18,9 +18,28 @@ void SimulationInterface::setState(const SimulationStateIn & newState) {
   this->in.state.set(newState);
 }
 
-void SimulationInterface::setDimension(const Dimension & dimension) {
+static bool isWithinLimit(const Dimension & dimension, std::size_t maxCells) {
+  return maxCells == 0 || static_cast<std::size_t>(dimension.width) *
+                                  static_cast<std::size_t>(dimension.height) <=
+                              maxCells;
+}
+
+bool SimulationInterface::setDimension(const Dimension & dimension) {
+  if (!isWithinLimit(dimension, maxCells)) {
+    return false;
+  }
   std::unique_lock lock(in.dimensionMutex);
   in.dimension.set(dimension);
+  return true;
+}
+
+bool SimulationInterface::setMap(std::unique_ptr<SimulationMap> && map) {
+  if (!isWithinLimit(map->getDimension(), maxCells)) {
+    return false;
+  }
+  std::unique_lock lock(in.dimensionMutex);
+  in.map = std::move(map);
+  return true;
 }
 
 std::shared_ptr<const SimulationMap> SimulationInterface::getMap() const {
@@ -28,6 +47,13 @@ std::shared_ptr<const SimulationMap> SimulationInterface::getMap() const {
   return out.map;
 }
 
+MapSnapshot SimulationInterface::waitMap(std::size_t version,
+                                         std::chrono::milliseconds timeout) const {
+  std::shared_lock lock(out.mutex);
+  out.mapPublished.wait_for(lock, timeout, [&] { return out.mapVersion > version; });
+  return MapSnapshot{out.mapVersion, out.mapTick, out.map};
+}
+
 void SimulationInterface::addModifyQuery(SubjectModifyQuery && query) {
   std::unique_lock lock(in.subQMutex);
   in.subQueries.push(std::move(query));
@@ -38,11 +64,21 @@ void SimulationInterface::addModifyQuery(AirInsertQuery && query) {
   in.airQueries.push(std::move(query));
 }
 
+void SimulationInterface::addModifyQuery(AirRegionQuery && query) {
+  std::unique_lock lock(in.airRegionMutex);
+  in.airRegionQueries.push(std::move(query));
+}
+
 void SimulationInterface::addModifyQuery(std::unique_ptr<SubjectCallbackQ> && query) {
   std::unique_lock lock(in.callbMutex);
   in.callbQueries.push(std::move(query));
 }
 
+void SimulationInterface::addModifyQuery(MapImportQuery && query) {
+  std::unique_lock lock(in.importMutex);
+  in.importQueries.push(std::move(query));
+}
+
 SimulationStateIn SimulationInterface::masterGetState() {
   std::unique_lock lock(in.stateMutex);
   auto prev = this->in.state;
@@ -57,6 +93,11 @@ Optional<Dimension> SimulationInterface::masterGetDimension() {
   return prev;
 }
 
+std::unique_ptr<SimulationMap> SimulationInterface::masterGetMap() {
+  std::unique_lock lock(in.dimensionMutex);
+  return std::move(in.map);
+}
+
 void SimulationInterface::masterSet(const SimulationState & state,
                                     const SimulationMap * map) {
   std::unique_lock lock(out.mutex);
@@ -70,6 +111,11 @@ void SimulationInterface::masterSet(const SimulationState & state,
   } else {
     this->out.map = std::make_shared<SimulationMap>(*map);
   }
+  this->out.mapVersion += 1;
+  this->out.mapTick = state.currentTick;
+
+  lock.unlock();
+  this->out.mapPublished.notify_all();
 }
 
 void SimulationInterface::masterSet(const SimulationState & state) {
@@ -90,8 +136,20 @@ SimulationInterface::masterAccessAirMQs() {
   return std::make_pair(std::move(lock), std::ref(in.airQueries));
 }
 
+std::pair<std::unique_lock<std::mutex> &&, Queue<AirRegionQuery> &>
+SimulationInterface::masterAccessAirRegionMQs() {
+  std::unique_lock lock(in.airRegionMutex);
+  return std::make_pair(std::move(lock), std::ref(in.airRegionQueries));
+}
+
 std::pair<std::unique_lock<std::mutex> &&, Queue<std::unique_ptr<SubjectCallbackQ>> &>
 SimulationInterface::masterAccessCallbackMQs() {
   std::unique_lock lock(in.callbMutex);
   return std::make_pair(std::move(lock), std::ref(in.callbQueries));
 }
+
+std::pair<std::unique_lock<std::mutex> &&, Queue<MapImportQuery> &>
+SimulationInterface::masterAccessImportMQs() {
+  std::unique_lock lock(in.importMutex);
+  return std::make_pair(std::move(lock), std::ref(in.importQueries));
+}
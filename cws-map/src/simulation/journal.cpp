@@ -0,0 +1,439 @@
+#include "cws/simulation/journal.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+
+#include "cws/log.hpp"
+#include "cws/simulation/callback.hpp"
+
+static constexpr char JOURNAL_MAGIC[8] = {'C', 'W', 'S', 'J', 'R', 'N', 'L', '\0'};
+static constexpr std::size_t HEADER_SIZE =
+    sizeof(JOURNAL_MAGIC) + sizeof(std::uint32_t);
+// size of batch, then tick reached by master
+static constexpr std::size_t BATCH_HEADER_SIZE =
+    sizeof(std::uint32_t) + sizeof(std::uint64_t);
+
+enum JournalRecordType : std::uint8_t {
+  RESET = 0,
+  SUBJECT = 1,
+  AIR = 2,
+  TURN = 3,
+  TRANSMIT = 4,
+  IMPORT = 5,
+  AIR_REGION = 6,
+};
+
+static void writeAll(int fd, const char * data, std::size_t size) {
+  while (size > 0) {
+    auto written = ::write(fd, data, size);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::system_error(errno, std::generic_category(), "journal");
+    }
+    data += written;
+    size -= static_cast<std::size_t>(written);
+  }
+}
+
+// end of last complete batch, so torn one is cut off before appending
+static off_t findEnd(int fd, off_t size) {
+  off_t offset = HEADER_SIZE;
+  std::uint32_t batchSize;
+  while (size - offset >= static_cast<off_t>(sizeof(batchSize))) {
+    if (::pread(fd, &batchSize, sizeof(batchSize), offset) != sizeof(batchSize)) {
+      break;
+    }
+    off_t next = offset + sizeof(batchSize) + batchSize;
+    if (next > size) {
+      break;
+    }
+    offset = next;
+  }
+  return offset;
+}
+
+Journal::Journal(const std::string & path, std::chrono::milliseconds interval)
+    : interval_(interval) {
+  fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (fd_ < 0) {
+    throw std::system_error(errno, std::generic_category(), path);
+  }
+
+  try {
+    struct stat st;
+    if (::fstat(fd_, &st) != 0) {
+      throw std::system_error(errno, std::generic_category(), path);
+    }
+
+    if (st.st_size == 0) {
+      std::string header(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+      header.append(reinterpret_cast<const char *>(&JOURNAL_VERSION),
+                    sizeof(JOURNAL_VERSION));
+      writeAll(fd_, header.data(), header.size());
+    } else {
+      char header[HEADER_SIZE];
+      std::uint32_t version;
+      if (::pread(fd_, header, HEADER_SIZE, 0) != HEADER_SIZE ||
+          std::memcmp(header, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0) {
+        throw std::invalid_argument("journal: not a journal " + path);
+      }
+      std::memcpy(&version, header + sizeof(JOURNAL_MAGIC), sizeof(version));
+      if (version != JOURNAL_VERSION) {
+        throw std::invalid_argument("journal: unsupported version " +
+                                    std::to_string(version));
+      }
+
+      auto end = findEnd(fd_, st.st_size);
+      if (end != st.st_size) {
+        CWS_LOG_WARN("journal", "torn batch is cut off " << path);
+        if (::ftruncate(fd_, end) != 0) {
+          throw std::system_error(errno, std::generic_category(), path);
+        }
+      }
+    }
+  } catch (...) {
+    ::close(fd_);
+    throw;
+  }
+
+  worker_ = std::jthread(std::bind_front(&Journal::execute, this));
+}
+
+Journal::~Journal() {
+  // the rest is committed by worker before it exits
+  worker_.request_stop();
+  worker_.join();
+  ::close(fd_);
+}
+
+template<typename Body>
+void Journal::append(std::size_t tick, std::uint8_t type, Body && body) {
+  bool full;
+  {
+    std::scoped_lock lock(mutex_);
+    pending_.put<std::uint64_t>(tick);
+    pending_.put(type);
+    auto sizeMark = pending_.mark();
+    pending_.put<std::uint32_t>(0);
+    body(pending_);
+    pending_.putAt<std::uint32_t>(sizeMark,
+                                  pending_.mark() - sizeMark - sizeof(std::uint32_t));
+
+    recordedCount_ += 1;
+    full = pending_.getBuffer().size() >= BATCH_SIZE;
+  }
+  if (full) {
+    wake_.notify_one();
+  }
+}
+
+void Journal::recordReset(std::size_t tick) {
+  append(tick, RESET, [](RecordWriter &) {});
+}
+
+void Journal::record(std::size_t tick, const SubjectModifyQuery & query) {
+  append(tick, SUBJECT, [&query](RecordWriter & writer) {
+    writer.put<std::int32_t>(query.queryType);
+    writer.putCoordinates(query.coordinates);
+    writer.putSubject(*query.subject);
+  });
+}
+
+void Journal::record(std::size_t tick, const AirInsertQuery & query) {
+  append(tick, AIR, [&query](RecordWriter & writer) {
+    writer.putCoordinates(query.coordinates);
+    writer.putAir(*query.air);
+  });
+}
+
+void Journal::record(std::size_t tick, const AirRegionQuery & query) {
+  append(tick, AIR_REGION, [&query](RecordWriter & writer) {
+    writer.put<std::int32_t>(static_cast<std::int32_t>(query.queryType));
+    writer.putCoordinates(query.region.origin);
+    writer.put<std::int32_t>(query.region.size.width);
+    writer.put<std::int32_t>(query.region.size.height);
+    writer.put<std::uint32_t>(query.region.polygon.size());
+    for (auto vertex : query.region.polygon) {
+      writer.putCoordinates(vertex);
+    }
+    writer.put<std::uint8_t>(query.air != nullptr);
+    if (query.air) {
+      writer.putAir(*query.air);
+    }
+    writer.put(query.factor);
+    writer.put(query.temperature.get());
+  });
+}
+
+void Journal::record(std::size_t tick, SubjectCallbackQ & query) {
+  using Callback = void (*)(Subject::Plain *, void *);
+  auto callback = query.callback.target<Callback>();
+
+  auto putSelect = [&query](RecordWriter & writer) {
+    writer.putCoordinates(query.select.coordinates);
+    writer.putSubjectId(query.select.id);
+  };
+
+  if (callback && *callback == setTurnableStatus) {
+    auto status = *static_cast<Subject::TurnableStatus *>(query.getData());
+    append(tick, TURN, [&](RecordWriter & writer) {
+      putSelect(writer);
+      writer.put<std::int32_t>(static_cast<std::int32_t>(status));
+    });
+  } else if (callback && *callback == addPacketToTransmitQueue) {
+    const auto & packets = *static_cast<PacketList *>(query.getData());
+    append(tick, TRANSMIT, [&](RecordWriter & writer) {
+      putSelect(writer);
+      writer.put<std::uint32_t>(packets.size());
+      for (const auto & packet : packets) {
+        writer.putPacket(*packet);
+      }
+    });
+  } else if (skipped_++ == 0) {
+    CWS_LOG_WARN("journal", "query with unknown callback is not recorded");
+  }
+}
+
+void Journal::record(std::size_t tick, const MapImportQuery & query) {
+  // one record, so replay applies it at once as master does
+  append(tick, IMPORT, [&query](RecordWriter & writer) {
+    writer.put<std::uint32_t>(query.subjects.size());
+    for (const auto & subject : query.subjects) {
+      writer.putCoordinates(subject.coordinates);
+      writer.putSubject(*subject.subject);
+    }
+    writer.put<std::uint32_t>(query.air.size());
+    for (const auto & air : query.air) {
+      writer.putCoordinates(air.coordinates);
+      writer.putAir(*air.air);
+    }
+  });
+}
+
+void Journal::commit() {
+  std::unique_lock lock(mutex_);
+  auto target = recordedCount_;
+  commitRequested_ = true;
+  wake_.notify_one();
+  committed_.wait(lock, [&] { return committedCount_ >= target; });
+}
+
+void Journal::execute(std::stop_token stoken) {
+  bool stop = false;
+  while (!stop) {
+    std::string batch;
+    std::size_t count;
+    {
+      std::unique_lock lock(mutex_);
+      wake_.wait_for(lock, stoken, interval_, [this] {
+        return commitRequested_ || pending_.getBuffer().size() >= BATCH_SIZE;
+      });
+      stop = stoken.stop_requested();
+      batch = pending_.release();
+      count = recordedCount_;
+      commitRequested_ = false;
+    }
+
+    // batch without records keeps tick reached by master
+    auto tick = tick_.load(std::memory_order_relaxed);
+    if (!batch.empty() || tick != writtenTick_) {
+      try {
+        write(batch, tick);
+        writtenTick_ = tick;
+      } catch (const std::system_error & e) {
+        CWS_LOG_ERROR("journal", "batch is lost: " << e.what());
+      }
+    }
+
+    {
+      std::scoped_lock lock(mutex_);
+      committedCount_ = count;
+    }
+    committed_.notify_all();
+  }
+}
+
+void Journal::write(const std::string & batch, std::size_t tick) {
+  std::string frame;
+  frame.reserve(BATCH_HEADER_SIZE + batch.size());
+  auto size = static_cast<std::uint32_t>(sizeof(std::uint64_t) + batch.size());
+  auto tick64 = static_cast<std::uint64_t>(tick);
+  frame.append(reinterpret_cast<const char *>(&size), sizeof(size));
+  frame.append(reinterpret_cast<const char *>(&tick64), sizeof(tick64));
+  frame.append(batch);
+
+  writeAll(fd_, frame.data(), frame.size());
+  if (::fdatasync(fd_) != 0) {
+    throw std::system_error(errno, std::generic_category(), "journal");
+  }
+}
+
+JournalReplay::JournalReplay(const std::string & path) {
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  if (!in) {
+    throw std::system_error(errno, std::generic_category(), path);
+  }
+  data_.resize(static_cast<std::size_t>(in.tellg()));
+  in.seekg(0);
+  in.read(reinterpret_cast<char *>(data_.data()),
+          static_cast<std::streamsize>(data_.size()));
+  if (!in) {
+    throw std::system_error(errno, std::generic_category(), path);
+  }
+
+  RecordReader reader(data_, "journal");
+  char magic[sizeof(JOURNAL_MAGIC)];
+  for (auto & ch : magic) {
+    ch = reader.get<char>();
+  }
+  if (std::memcmp(magic, JOURNAL_MAGIC, sizeof(magic)) != 0) {
+    reader.error("not a journal");
+  }
+  auto version = reader.get<std::uint32_t>();
+  if (version != JOURNAL_VERSION) {
+    reader.error("unsupported version " + std::to_string(version));
+  }
+
+  // torn batch at the end is dropped
+  while (reader.getRemaining() >= sizeof(std::uint32_t)) {
+    auto size = reader.get<std::uint32_t>();
+    if (size > reader.getRemaining()) {
+      break;
+    }
+    RecordReader batch(reader.getBytes(size), "journal");
+    auto batchTick = static_cast<std::size_t>(batch.get<std::uint64_t>());
+
+    while (batch.getRemaining() > 0) {
+      Record record;
+      record.tick = static_cast<std::size_t>(batch.get<std::uint64_t>());
+      record.type = batch.get<std::uint8_t>();
+      record.body = batch.getBytes(batch.get<std::uint32_t>());
+
+      if (record.type == RESET) {
+        records_.clear();
+        resetTick_ = record.tick;
+        endTick_ = record.tick;
+        continue;
+      }
+      if (!records_.empty() && record.tick < records_.back().tick) {
+        batch.error("tick goes back without reset");
+      }
+      records_.push_back(record);
+      endTick_ = std::max(endTick_, record.tick + 1);
+    }
+    endTick_ = std::max(endTick_, batchTick);
+  }
+}
+
+std::size_t JournalReplay::apply(SimulationMap & map, std::size_t tick) const {
+  auto begin = std::lower_bound(
+      records_.begin(), records_.end(), tick,
+      [](const Record & record, std::size_t tick) { return record.tick < tick; });
+  auto end = std::upper_bound(
+      begin, records_.end(), tick,
+      [](std::size_t tick, const Record & record) { return tick < record.tick; });
+
+  // queries queued before map was replaced may be out of it, map dropped them when
+  // they were recorded and drops them again
+  for (auto it = begin; it != end; ++it) {
+    RecordReader reader(it->body, "journal");
+
+    switch (it->type) {
+    case SUBJECT: {
+      auto type = static_cast<SubjectModifyType>(reader.get<std::int32_t>());
+      auto c = reader.getCoordinates();
+      map.modify(SubjectModifyQuery(type, c, reader.getSubject()));
+      break;
+    }
+    case AIR: {
+      auto c = reader.getCoordinates();
+      map.modify(AirInsertQuery(c, reader.getAir()));
+      break;
+    }
+    case AIR_REGION: {
+      // region may lie outside of map, it is clipped on apply
+      auto type = static_cast<AirRegionModifyType>(reader.get<std::int32_t>());
+      AirRegionQuery query{type};
+      query.region.origin = {reader.get<std::int32_t>(), reader.get<std::int32_t>()};
+      query.region.size = {reader.get<std::int32_t>(), reader.get<std::int32_t>()};
+      auto vertexCount = reader.get<std::uint32_t>();
+      for (std::uint32_t i = 0; i < vertexCount; ++i) {
+        query.region.polygon.push_back(
+            {reader.get<std::int32_t>(), reader.get<std::int32_t>()});
+      }
+      if (reader.get<std::uint8_t>() != 0) {
+        query.air = reader.getAir();
+      }
+      query.factor = reader.get<double>();
+      query.temperature = Temperature{reader.get<double>()};
+      map.modify(std::move(query));
+      break;
+    }
+    case TURN: {
+      auto c = reader.getCoordinates();
+      auto id = reader.getSubjectId();
+      auto status = reader.getStatus();
+      map.modify(SubjectCallbackQuery<Subject::TurnableStatus>(
+          SubjectSelectQuery(c, id), setTurnableStatus, std::move(status)));
+      break;
+    }
+    case TRANSMIT: {
+      auto c = reader.getCoordinates();
+      auto id = reader.getSubjectId();
+      PacketList packets;
+      auto count = reader.get<std::uint32_t>();
+      for (std::uint32_t i = 0; i < count; ++i) {
+        packets.push_back(reader.getPacket());
+      }
+      map.modify(SubjectCallbackQuery<PacketList>(
+          SubjectSelectQuery(c, id), addPacketToTransmitQueue, std::move(packets)));
+      break;
+    }
+    case IMPORT: {
+      MapImportQuery query;
+      auto subjectCount = reader.get<std::uint32_t>();
+      for (std::uint32_t i = 0; i < subjectCount; ++i) {
+        auto c = reader.getCoordinates();
+        query.subjects.emplace_back(SubjectModifyType::INSERT, c, reader.getSubject());
+      }
+      auto airCount = reader.get<std::uint32_t>();
+      for (std::uint32_t i = 0; i < airCount; ++i) {
+        auto c = reader.getCoordinates();
+        query.air.emplace_back(c, reader.getAir());
+      }
+      map.modify(std::move(query));
+      break;
+    }
+    default:
+      reader.error("unknown record type " + std::to_string(it->type));
+    }
+  }
+  return static_cast<std::size_t>(end - begin);
+}
+
+std::unique_ptr<SimulationMap> JournalReplay::replay(std::unique_ptr<SimulationMap> map,
+                                                     std::size_t tick,
+                                                     std::size_t toTick) const {
+  if (tick < resetTick_) {
+    throw std::invalid_argument("journal: map of tick " + std::to_string(tick) +
+                                " is before reset at " + std::to_string(resetTick_));
+  }
+
+  SimulationMap nextMap(*map);
+  for (; tick < toTick; ++tick) {
+    apply(nextMap, tick);
+    nextMap.next(*map);
+    *map = nextMap;
+  }
+  return map;
+}
@@ -1,11 +1,12 @@
 #include <cassert>
 #include <chrono>
 #include <functional>
-#include <iostream>
 // #include <sys/prctl.h>
 #include <thread>
 
+#include "cws/log.hpp"
 #include "cws/simulation/interface.hpp"
+#include "cws/simulation/journal.hpp"
 #include "cws/simulation/simulation.hpp"
 #include "cws/simulation/simulation_map.hpp"
 
@@ -33,71 +34,73 @@ void SimulationMaster::execute(std::stop_token stoken) {
       return;
     }
 
-#ifndef NDEBUG
-    std::cout << "------------------------------------------" << std::endl;
-#endif
+    processTick(true);
+    waitDurationExceeds(state, clockStart);
+  };
+}
 
-    updateState();
+std::chrono::nanoseconds SimulationMaster::step() {
+  processTick(false);
+  return getTickDuration(state);
+}
 
-#ifndef NDEBUG
-    std::cout << "master: " << state << std::endl
-              << "  curMap: " << currMap.get() << std::endl
-              << "  newMap: " << nextMap.get() << std::endl;
-#endif
+void SimulationMaster::processTick(bool bySlave) {
+  updateState();
 
-    bool isStatusRunning = state.status == SimulationStatus::RUNNING;
-    bool isNotLastTick = state.currentTick < state.lastTick;
-    bool isSimTypeINF = state.type == SimulationType::INFINITE;
-    bool isRunning = isStatusRunning && (isSimTypeINF || isNotLastTick);
-    bool doSlave = isRunning && mapsExist();
+  CWS_LOG_DEBUG("master", state << ", curMap: " << currMap.get()
+                                << ", newMap: " << nextMap.get());
 
-    if (isRunning) {
-      updateMap();
-    }
+  bool isStatusRunning = state.status == SimulationStatus::RUNNING;
+  bool isNotLastTick = state.currentTick < state.lastTick;
+  bool isSimTypeINF = state.type == SimulationType::INFINITE;
+  bool isRunning = isStatusRunning && (isSimTypeINF || isNotLastTick);
+  bool doSlave = isRunning && mapsExist();
 
-    if (doSlave) {
-      notifySlaveReady();
-    }
+  if (isRunning) {
+    updateMap();
+  }
 
-    if (isRunning) {
-      interface.masterSet(state, currMap.get());
-#ifndef NDEBUG
-      std::cout << "master->interface: state set" << std::endl
-                << "  state: " << state << std::endl
-                << "  map: " << &*currMap << std::endl;
-#endif
-    } else {
-      interface.masterSet(state);
-#ifndef NDEBUG
-      std::cout << "master->interface: state set" << std::endl
-                << "  state: " << state << std::endl;
-#endif
-    }
+  if (doSlave && bySlave) {
+    notifySlaveReady();
+  }
 
-    if (isRunning) {
-      state.currentTick += 1;
-    }
+  if (isRunning) {
+    interface.masterSet(state, currMap.get());
+    CWS_LOG_DEBUG("master", "interface state set: " << state
+                                                    << ", map: " << currMap.get());
+  } else {
+    interface.masterSet(state);
+    CWS_LOG_DEBUG("master", "interface state set: " << state);
+  }
 
-    if (!isSimTypeINF && state.currentTick == state.lastTick) {
-      state.status = SimulationStatus::STOPPED;
-    }
+  std::size_t processedTick = state.currentTick;
+
+  if (isRunning) {
+    state.currentTick += 1;
+  }
 
-    if (doSlave) {
+  if (!isSimTypeINF && state.currentTick == state.lastTick) {
+    state.status = SimulationStatus::STOPPED;
+  }
+
+  if (doSlave) {
+    if (bySlave) {
       waitSlaveProcess();
+    } else {
+      nextMap->next(*currMap, &nextMapTimes);
     }
+    interface.profiler.record(processedTick, nextMapTimes);
+  }
 
-    if (isRunning) {
-      prepareMapsNextIter();
+  if (isRunning) {
+    prepareMapsNextIter();
+    if (interface.journal) {
+      interface.journal->setTick(state.currentTick);
     }
+  }
 
-#ifndef NDEBUG
-    std::cout << "master: map prepared" << std::endl
-              << "  curMap: " << currMap.get() << std::endl
-              << "  newMap: " << nextMap.get() << std::endl;
-#endif
-
-    waitDurationExceeds(state, clockStart);
-  };
+  CWS_LOG_DEBUG("master", "map prepared, curMap: " << currMap.get()
+                                                    << ", newMap: " << nextMap.get());
 }
 
 bool SimulationMaster::processStopRequest(const std::stop_token & stoken) {
@@ -118,6 +121,10 @@ void SimulationMaster::updateState() {
   }
   if (stateIn.currentTick.isSet()) {
     state.currentTick = stateIn.currentTick.get();
+    // journaled ticks would repeat or skip
+    if (interface.journal) {
+      interface.journal->recordReset(state.currentTick);
+    }
   }
   if (stateIn.lastTick.isSet()) {
     state.lastTick = stateIn.lastTick.get();
@@ -131,11 +138,27 @@ void SimulationMaster::updateMap() {
   // to be synced with slave
   std::scoped_lock<std::mutex> lock(msMutex);
 
+  auto journal = interface.journal;
   Optional<Dimension> dimension = interface.masterGetDimension();
 
   if (dimension.isSet()) {
     currMap.reset(new SimulationMap(dimension.get()));
-    nextMap.reset(new SimulationMap(dimension.get()));
+    currMap->setAirSleeping(interface.airSleeping);
+    currMap->setAirStepping(interface.airStepping);
+    nextMap.reset(new SimulationMap(*currMap));
+    if (journal) {
+      journal->recordReset(state.currentTick);
+    }
+  }
+
+  if (auto map = interface.masterGetMap()) {
+    currMap = std::move(map);
+    currMap->setAirSleeping(interface.airSleeping);
+    currMap->setAirStepping(interface.airStepping);
+    nextMap.reset(new SimulationMap(*currMap));
+    if (journal) {
+      journal->recordReset(state.currentTick);
+    }
   }
 
   if (!mapsExist()) {
@@ -146,11 +169,12 @@ void SimulationMaster::updateMap() {
     auto [qlock, subMQs] = interface.masterAccessSubjectMQs();
 
     while (!subMQs.empty()) {
+      if (journal) {
+        journal->record(state.currentTick, subMQs.front());
+      }
       nextMap->modify(std::move(subMQs.front()));
       subMQs.pop();
-#ifndef NDEBUG
-      std::cout << "master: subject query processed." << std::endl;
-#endif
+      CWS_LOG_DEBUG("master", "subject query processed");
     }
   }
 
@@ -158,22 +182,51 @@ void SimulationMaster::updateMap() {
     auto [qlock, airMQs] = interface.masterAccessAirMQs();
 
     while (!airMQs.empty()) {
+      if (journal) {
+        journal->record(state.currentTick, airMQs.front());
+      }
       nextMap->modify(std::move(airMQs.front()));
       airMQs.pop();
-#ifndef NDEBUG
-      std::cout << "master: air query processed." << std::endl;
-#endif
+      CWS_LOG_DEBUG("master", "air query processed");
+    }
+  }
+  {
+    auto [qlock, airRegionMQs] = interface.masterAccessAirRegionMQs();
+
+    while (!airRegionMQs.empty()) {
+      if (journal) {
+        journal->record(state.currentTick, airRegionMQs.front());
+      }
+      nextMap->modify(std::move(airRegionMQs.front()));
+      airRegionMQs.pop();
+      CWS_LOG_DEBUG("master", "air region query processed");
     }
   }
   {
     auto [qlock, callbMQs] = interface.masterAccessCallbackMQs();
 
     while (!callbMQs.empty()) {
+      if (journal) {
+        journal->record(state.currentTick, *callbMQs.front());
+      }
       nextMap->modify(std::move(*callbMQs.front()));
       callbMQs.pop();
-#ifndef NDEBUG
-      std::cout << "master: callback query processed." << std::endl;
-#endif
+      CWS_LOG_DEBUG("master", "callback query processed");
+    }
+  }
+  {
+    auto [qlock, importMQs] = interface.masterAccessImportMQs();
+
+    while (!importMQs.empty()) {
+      auto & query = importMQs.front();
+      if (journal) {
+        journal->record(state.currentTick, query);
+      }
+      CWS_LOG_INFO("master", "map import of " << query.subjects.size()
+                                               << " subjects and " << query.air.size()
+                                               << " air");
+      nextMap->modify(std::move(query));
+      importMQs.pop();
     }
   }
 }
@@ -203,13 +256,17 @@ void SimulationMaster::waitDurationExceeds(
     const SimulationState & state,
     const std::chrono::time_point<std::chrono::high_resolution_clock> & start) {
 
-  auto duration = static_cast<long>((long)1'000'000'000 / state.taskFrequency);
-  std::chrono::nanoseconds taskMaxDuration(duration);
-
+  auto taskMaxDuration = getTickDuration(state);
   auto leadTime = std::chrono::high_resolution_clock::now() - start;
   auto waitTime = std::max(taskMaxDuration - leadTime, std::chrono::nanoseconds(0));
 
   std::this_thread::sleep_for(waitTime);
 }
 
+std::chrono::nanoseconds
+SimulationMaster::getTickDuration(const SimulationState & state) {
+  auto duration = static_cast<long>((long)1'000'000'000 / state.taskFrequency);
+  return std::chrono::nanoseconds(duration);
+}
+
 bool SimulationMaster::mapsExist() { return currMap.get() && nextMap.get(); }
@@ -0,0 +1,875 @@
+#include "cws/simulation/partition.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <system_error>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include "cws/simulation/callback.hpp"
+#include "cws/simulation/record.hpp"
+#include "cws/simulation/snapshot.hpp"
+#include "cws/subject/extension/light_source.hpp"
+
+enum PartitionCommand : std::uint32_t {
+  LOAD = 1,
+  NEXT = 2,
+  GATHER = 3,
+  EXIT = 4,
+  // replies of worker
+  DONE = 5,
+  FAILED = 6,
+  // second half of tick, after light and wireless signal are spread
+  SPREAD = 7,
+};
+
+// queries sent with NEXT, coordinates are local to partition
+enum class PartitionQuery : std::uint8_t {
+  SUBJECT = 1,
+  AIR = 2,
+  AIR_SPANS = 3,// region cut to partition, each span is applied as rectangle
+  TURN = 4,
+  TRANSMIT = 5,
+  CABLE = 6,
+};
+
+CellRect CellRect::intersect(const CellRect & other) const {
+  Coordinates begin{std::max(origin.x, other.origin.x),
+                    std::max(origin.y, other.origin.y)};
+  Coordinates end{std::min(origin.x + size.width, other.origin.x + other.size.width),
+                  std::min(origin.y + size.height, other.origin.y + other.size.height)};
+  return CellRect{begin, {std::max(end.x - begin.x, 0), std::max(end.y - begin.y, 0)}};
+}
+
+CellRect CellRect::expand(int cells, Dimension dim) const {
+  CellRect grown{{origin.x - cells, origin.y - cells},
+                 {size.width + 2 * cells, size.height + 2 * cells}};
+  return grown.intersect(CellRect{{0, 0}, dim});
+}
+
+std::vector<CellRect> splitMap(Dimension dim, int columns, int rows) {
+  if (columns <= 0 || rows <= 0 || columns > dim.width || rows > dim.height) {
+    throw std::invalid_argument("partition: map can't be split into " +
+                                std::to_string(columns) + "x" + std::to_string(rows));
+  }
+
+  std::vector<CellRect> rects;
+  for (int row = 0; row < rows; ++row) {
+    int y0 = row * dim.height / rows;
+    int y1 = (row + 1) * dim.height / rows;
+    for (int column = 0; column < columns; ++column) {
+      int x0 = column * dim.width / columns;
+      int x1 = (column + 1) * dim.width / columns;
+      rects.push_back(CellRect{{x0, y0}, {x1 - x0, y1 - y0}});
+    }
+  }
+  return rects;
+}
+
+// MSG_NOSIGNAL, so exited peer is an error instead of SIGPIPE
+static void sendAll(int socket, const char * data, std::size_t size) {
+  while (size > 0) {
+    auto sent = ::send(socket, data, size, MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::system_error(errno, std::generic_category(), "partition");
+    }
+    data += sent;
+    size -= static_cast<std::size_t>(sent);
+  }
+}
+
+static void receiveAll(int socket, char * data, std::size_t size) {
+  while (size > 0) {
+    auto received = ::recv(socket, data, size, 0);
+    if (received < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::system_error(errno, std::generic_category(), "partition");
+    }
+    if (received == 0) {
+      throw std::system_error(ECONNRESET, std::generic_category(), "partition");
+    }
+    data += received;
+    size -= static_cast<std::size_t>(received);
+  }
+}
+
+// command, size of payload, then payload
+static void sendMessage(int socket, std::uint32_t command, std::string_view payload) {
+  RecordWriter header;
+  header.put(command);
+  header.put<std::uint64_t>(payload.size());
+  sendAll(socket, header.getBuffer().data(), header.getBuffer().size());
+  sendAll(socket, payload.data(), payload.size());
+}
+
+static std::uint32_t receiveMessage(int socket, std::string & payload) {
+  std::uint32_t command;
+  std::uint64_t size;
+  receiveAll(socket, reinterpret_cast<char *>(&command), sizeof(command));
+  receiveAll(socket, reinterpret_cast<char *>(&size), sizeof(size));
+  payload.resize(size);
+  receiveAll(socket, payload.data(), size);
+  return command;
+}
+
+static std::span<const std::byte> asBytes(const std::string & value) {
+  return {reinterpret_cast<const std::byte *>(value.data()), value.size()};
+}
+
+// wireless containers with their signal
+static void
+putContainers(RecordWriter & writer,
+              const std::list<std::unique_ptr<Network::Container>> & containers) {
+  writer.put<std::uint32_t>(containers.size());
+  for (const auto & container : containers) {
+    auto wireless = static_cast<const Network::WirelessContainer *>(container.get());
+    writer.put(wireless->getSignalPower());
+    writer.putPacket(*wireless->getPacket());
+  }
+}
+
+static std::list<std::unique_ptr<Network::Container>>
+getContainers(RecordReader & reader) {
+  std::list<std::unique_ptr<Network::Container>> containers;
+  for (auto count = reader.get<std::uint32_t>(); count > 0; --count) {
+    auto signalPower = reader.get<double>();
+    containers.push_back(
+        std::make_unique<Network::WirelessContainer>(reader.getPacket(), signalPower));
+  }
+  return containers;
+}
+
+static void closeSocket(int & socket) {
+  if (socket >= 0) {
+    ::close(socket);
+    socket = -1;
+  }
+}
+
+/*
+ * Link between partitions whose rectangles and halos overlap. Cells are sent to
+ * `send` part of halo of the other partition and received to `receive` part of own
+ * halo, rectangles are in coordinates of whole map
+ */
+struct PartitionLink final {
+  std::size_t first;
+  std::size_t second;
+  int sockets[2] = {-1, -1};// of first and second
+  CellRect toSecond;
+  CellRect toFirst;
+};
+
+/*
+ * Runs in forked process: keeps current and next state of partition with its halo
+ * and serves commands of coordinator until exit
+ */
+class PartitionWorker final {
+  struct Link final {
+    int socket;
+    bool sendsFirst;
+    CellRect send;
+    CellRect receive;
+  };
+
+  int socket_;
+  CellRect owned_;
+  CellRect extended_;
+  std::vector<Link> links_;
+
+  std::unique_ptr<SimulationMap> cur_;
+  std::unique_ptr<SimulationMap> next_;
+  MapStageTimes times_{};// of both halves of tick
+
+public:
+  PartitionWorker(int socket, std::size_t index, CellRect owned, CellRect extended,
+                  const std::vector<PartitionLink> & links)
+      : socket_(socket), owned_(owned), extended_(extended) {
+    // links are sorted by pair of partitions, all workers pass them in the same
+    // order and the lower partition sends first, so exchange doesn't deadlock
+    for (const auto & link : links) {
+      if (link.first == index) {
+        links_.push_back(Link{link.sockets[0], true, link.toSecond, link.toFirst});
+      } else if (link.second == index) {
+        links_.push_back(Link{link.sockets[1], false, link.toFirst, link.toSecond});
+      }
+    }
+  }
+
+  void run();
+
+private:
+  Coordinates toLocal(Coordinates c) const {
+    return {c.x - extended_.origin.x, c.y - extended_.origin.y};
+  }
+
+  Coordinates toGlobal(Coordinates c) const {
+    return {c.x + extended_.origin.x, c.y + extended_.origin.y};
+  }
+
+  bool isOwned(Coordinates local) const {
+    Coordinates c = toGlobal(local);
+    return c.x >= owned_.origin.x && c.x < owned_.origin.x + owned_.size.width &&
+           c.y >= owned_.origin.y && c.y < owned_.origin.y + owned_.size.height;
+  }
+
+  std::string load(const std::string & payload);
+  void apply(const std::string & payload);
+  std::string next(const std::string & payload);
+  std::string spread(const std::string & payload);
+  std::string gather() const;
+};
+
+void PartitionWorker::run() {
+  std::string payload;
+  while (true) {
+    auto command = receiveMessage(socket_, payload);
+    if (command == EXIT) {
+      return;
+    }
+
+    try {
+      std::string reply;
+      switch (command) {
+      case LOAD:
+        reply = load(payload);
+        break;
+      case NEXT:
+        reply = next(payload);
+        break;
+      case SPREAD:
+        reply = spread(payload);
+        break;
+      case GATHER:
+        reply = gather();
+        break;
+      default:
+        throw std::invalid_argument("unknown command " + std::to_string(command));
+      }
+      sendMessage(socket_, DONE, reply);
+    } catch (const std::invalid_argument & e) {
+      sendMessage(socket_, FAILED, e.what());
+    }
+  }
+}
+
+// region of partition with halo, then cables of whole map
+std::string PartitionWorker::load(const std::string & payload) {
+  RecordReader reader(asBytes(payload), "partition");
+  auto region = reader.getBytes(reader.get<std::uint64_t>());
+
+  cur_ = std::make_unique<SimulationMap>(extended_.size);
+  readSnapshotRegion(*cur_, {0, 0}, region);
+
+  auto cableCount = reader.get<std::uint64_t>();
+  for (std::uint64_t i = 0; i < cableCount; ++i) {
+    auto first = reader.getSubjectId();
+    auto second = reader.getSubjectId();
+    cur_->modify(CableModifyQuery{CableModifyType::CONNECT, first, second});
+  }
+
+  next_ = std::make_unique<SimulationMap>(*cur_);
+  return {};
+}
+
+void PartitionWorker::apply(const std::string & payload) {
+  RecordReader reader(asBytes(payload), "partition");
+  while (reader.getRemaining() > 0) {
+    auto type = static_cast<PartitionQuery>(reader.get<std::uint8_t>());
+    switch (type) {
+    case PartitionQuery::SUBJECT: {
+      auto queryType = static_cast<SubjectModifyType>(reader.get<std::int32_t>());
+      auto c = reader.getCoordinates();
+      next_->modify(SubjectModifyQuery(queryType, c, reader.getSubject()));
+      break;
+    }
+    case PartitionQuery::AIR: {
+      auto c = reader.getCoordinates();
+      next_->modify(AirInsertQuery(c, reader.getAir()));
+      break;
+    }
+    case PartitionQuery::AIR_SPANS: {
+      auto queryType = static_cast<AirRegionModifyType>(reader.get<std::int32_t>());
+      std::vector<CellSpan> spans(reader.get<std::uint32_t>());
+      for (auto & span : spans) {
+        span = CellSpan{reader.get<std::int32_t>(), reader.get<std::int32_t>(),
+                        reader.get<std::int32_t>()};
+      }
+      std::unique_ptr<Air::Plain> air;
+      if (reader.get<std::uint8_t>() != 0) {
+        air = reader.getAir();
+      }
+      auto factor = reader.get<double>();
+      Temperature temperature{reader.get<double>()};
+      for (auto span : spans) {
+        CellRegion region{{span.x, span.yBegin}, {1, span.yEnd - span.yBegin}};
+        AirRegionQuery query{queryType, std::move(region)};
+        if (air) {
+          query.air.reset(air->clone());
+        }
+        query.factor = factor;
+        query.temperature = temperature;
+        next_->modify(std::move(query));
+      }
+      break;
+    }
+    case PartitionQuery::TURN: {
+      auto c = reader.getCoordinates();
+      auto id = reader.getSubjectId();
+      auto status = reader.getStatus();
+      next_->modify(SubjectCallbackQuery<Subject::TurnableStatus>(
+          SubjectSelectQuery(c, id), setTurnableStatus, std::move(status)));
+      break;
+    }
+    case PartitionQuery::TRANSMIT: {
+      auto c = reader.getCoordinates();
+      auto id = reader.getSubjectId();
+      PacketList packets;
+      for (auto count = reader.get<std::uint32_t>(); count > 0; --count) {
+        packets.push_back(reader.getPacket());
+      }
+      next_->modify(SubjectCallbackQuery<PacketList>(
+          SubjectSelectQuery(c, id), addPacketToTransmitQueue, std::move(packets)));
+      break;
+    }
+    case PartitionQuery::CABLE: {
+      auto queryType = static_cast<CableModifyType>(reader.get<std::int32_t>());
+      auto first = reader.getSubjectId();
+      auto second = reader.getSubjectId();
+      next_->modify(CableModifyQuery{queryType, first, second});
+      break;
+    }
+    default:
+      reader.error("unknown query " + std::to_string(static_cast<int>(type)));
+    }
+  }
+}
+
+// queries of tick are applied first. Reply has light obstruction of own cells changed
+// by tick, active light sources, wireless containers to transmit and cells of
+// wireless devices, coordinates are of whole map
+std::string PartitionWorker::next(const std::string & payload) {
+  if (!cur_) {
+    throw std::invalid_argument("partition is not loaded");
+  }
+  apply(payload);
+
+  times_ = MapStageTimes{};
+  next_->nextBeforeSpread(*cur_, &times_);
+
+  const auto & layers = next_->getLayers();
+  const auto & curObstruction = cur_->getLayers().obstructionLayer;
+  RecordWriter reply;
+
+  auto countMark = reply.mark();
+  std::uint32_t count = 0;
+  reply.put(count);
+  Coordinates c;
+  for (c.x = 0; c.x < extended_.size.width; ++c.x) {
+    for (c.y = 0; c.y < extended_.size.height; ++c.y) {
+      auto obstruction = layers.obstructionLayer.getLightObstruction(c).get();
+      if (isOwned(c) && obstruction != curObstruction.getLightObstruction(c).get()) {
+        reply.putCoordinates(toGlobal(c));
+        reply.put(obstruction);
+        ++count;
+      }
+    }
+  }
+  reply.putAt(countMark, count);
+
+  countMark = reply.mark();
+  count = 0;
+  reply.put(count);
+  for (const auto & [source, light] : layers.subjectLayer.getActiveLightSources()) {
+    if (isOwned(source)) {
+      reply.putCoordinates(toGlobal(source));
+      reply.put<std::int32_t>(light->getCurLightParams().rawIllumination.get());
+      ++count;
+    }
+  }
+  reply.putAt(countMark, count);
+
+  countMark = reply.mark();
+  count = 0;
+  reply.put(count);
+  for (c.x = 0; c.x < extended_.size.width; ++c.x) {
+    for (c.y = 0; c.y < extended_.size.height; ++c.y) {
+      const auto & containers = layers.networkWireless.getTransmittableContainers(c);
+      if (containers.empty() || !isOwned(c)) {
+        continue;
+      }
+      reply.putCoordinates(toGlobal(c));
+      putContainers(reply, containers);
+      ++count;
+    }
+  }
+  reply.putAt(countMark, count);
+
+  countMark = reply.mark();
+  count = 0;
+  reply.put(count);
+  for (c.x = 0; c.x < extended_.size.width; ++c.x) {
+    for (c.y = 0; c.y < extended_.size.height; ++c.y) {
+      if (!isOwned(c)) {
+        continue;
+      }
+      for (const auto & subject : layers.subjectLayer.getSubjectList(c)) {
+        if (subject->getId().type == Subject::Type::WIRELESS_NETWORK_DEVICE) {
+          reply.putCoordinates(toGlobal(c));
+          ++count;
+          break;
+        }
+      }
+    }
+  }
+  reply.putAt(countMark, count);
+  return reply.release();
+}
+
+// illumination of cells changed by tick, then wireless containers of device cells
+std::string PartitionWorker::spread(const std::string & payload) {
+  if (!cur_) {
+    throw std::invalid_argument("partition is not loaded");
+  }
+
+  RecordReader reader(asBytes(payload), "partition");
+  auto & layers = next_->layers;
+  for (auto count = reader.get<std::uint32_t>(); count > 0; --count) {
+    auto c = reader.getCoordinates(extended_.size);
+    Illumination illumination{reader.get<std::int32_t>()};
+    layers.illuminationLayer.setIllumination(c, illumination);
+  }
+  for (auto cells = reader.get<std::uint32_t>(); cells > 0; --cells) {
+    auto c = reader.getCoordinates(extended_.size);
+    layers.networkWireless.receive(c, getContainers(reader));
+  }
+  next_->nextAfterSpread(&times_);
+
+  // one side of link may have nothing to send, its message is empty then
+  std::string cells;
+  for (const auto & link : links_) {
+    std::string sent;
+    if (!link.send.empty()) {
+      sent = writeSnapshotRegion(*next_, toLocal(link.send.origin), link.send.size);
+    }
+    if (link.sendsFirst) {
+      sendMessage(link.socket, DONE, sent);
+      receiveMessage(link.socket, cells);
+    } else {
+      receiveMessage(link.socket, cells);
+      sendMessage(link.socket, DONE, sent);
+    }
+    if (!cells.empty()) {
+      readSnapshotRegion(*next_, toLocal(link.receive.origin), asBytes(cells));
+    }
+  }
+
+  *cur_ = *next_;
+  return std::string(reinterpret_cast<const char *>(&times_), sizeof(times_));
+}
+
+std::string PartitionWorker::gather() const {
+  if (!cur_) {
+    throw std::invalid_argument("partition is not loaded");
+  }
+  return writeSnapshotRegion(*cur_, toLocal(owned_.origin), owned_.size);
+}
+
+PartitionedMap::PartitionedMap(const SimulationMap & map, PartitionOptions options)
+    : dimension_(map.getDimension()), options_(options), obstruction_(dimension_),
+      illumination_(dimension_), nextIllumination_(dimension_), wireless_(dimension_) {
+  if (options_.halo < 2) {
+    throw std::invalid_argument("partition: halo should be at least 2 cells");
+  }
+  auto rects = splitMap(dimension_, options_.columns, options_.rows);
+
+  std::vector<CellRect> extended;
+  for (const auto & rect : rects) {
+    extended.push_back(rect.expand(options_.halo, dimension_));
+  }
+
+  std::vector<PartitionLink> links;
+  for (std::size_t i = 0; i < rects.size(); ++i) {
+    for (std::size_t j = i + 1; j < rects.size(); ++j) {
+      PartitionLink link{i, j};
+      link.toSecond = rects[i].intersect(extended[j]);
+      link.toFirst = rects[j].intersect(extended[i]);
+      if (!link.toSecond.empty() || !link.toFirst.empty()) {
+        links.push_back(link);
+      }
+    }
+  }
+
+  auto closeLinks = [&links] {
+    for (auto & link : links) {
+      closeSocket(link.sockets[0]);
+      closeSocket(link.sockets[1]);
+    }
+  };
+
+  try {
+    for (auto & link : links) {
+      if (::socketpair(AF_UNIX, SOCK_STREAM, 0, link.sockets) != 0) {
+        throw std::system_error(errno, std::generic_category(), "partition");
+      }
+    }
+
+    for (std::size_t i = 0; i < rects.size(); ++i) {
+      int sockets[2];
+      if (::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0) {
+        throw std::system_error(errno, std::generic_category(), "partition");
+      }
+
+      pid_t pid = ::fork();
+      if (pid < 0) {
+        int err = errno;
+        ::close(sockets[0]);
+        ::close(sockets[1]);
+        throw std::system_error(err, std::generic_category(), "partition");
+      }
+
+      if (pid == 0) {
+        // sockets of coordinator and of other workers are not used by this one
+        ::close(sockets[0]);
+        for (auto & worker : workers_) {
+          ::close(worker.socket);
+        }
+        for (auto & link : links) {
+          if (link.first != i) {
+            closeSocket(link.sockets[0]);
+          }
+          if (link.second != i) {
+            closeSocket(link.sockets[1]);
+          }
+        }
+
+        int status = 0;
+        try {
+          PartitionWorker(sockets[1], i, rects[i], extended[i], links).run();
+        } catch (...) {
+          status = 1;
+        }
+        // coordinator owns everything else inherited, nothing is destroyed here
+        ::_exit(status);
+      }
+
+      ::close(sockets[1]);
+      workers_.push_back(Worker{pid, sockets[0], rects[i], extended[i]});
+    }
+    closeLinks();
+
+    load(map);
+
+  } catch (...) {
+    closeLinks();
+    stop();
+    throw;
+  }
+}
+
+PartitionedMap::~PartitionedMap() { stop(); }
+
+void PartitionedMap::stop() {
+  for (auto & worker : workers_) {
+    try {
+      sendMessage(worker.socket, EXIT, {});
+    } catch (const std::system_error &) {
+      // worker has already exited
+    }
+    closeSocket(worker.socket);
+  }
+  for (auto & worker : workers_) {
+    ::waitpid(worker.pid, nullptr, 0);
+  }
+  workers_.clear();
+}
+
+void PartitionedMap::send(std::size_t i, std::uint32_t command,
+                          std::string_view payload) const {
+  sendMessage(workers_[i].socket, command, payload);
+}
+
+std::string PartitionedMap::receive(std::size_t i) const {
+  std::string payload;
+  if (receiveMessage(workers_[i].socket, payload) != DONE) {
+    throw std::runtime_error("partition " + std::to_string(i) + ": " + payload);
+  }
+  return payload;
+}
+
+void PartitionedMap::load(const SimulationMap & map) {
+  auto dim = map.getDimension();
+  if (dim.width != dimension_.width || dim.height != dimension_.height) {
+    throw std::invalid_argument("partition: map has other dimension");
+  }
+  // workers send changes since loaded cells only
+  obstruction_ = map.getLayers().obstructionLayer;
+  illumination_ = map.getLayers().illuminationLayer;
+
+  RecordWriter cables;
+  auto cableList = map.getLayers().networkWired.getCables();
+  cables.put<std::uint64_t>(cableList.size());
+  for (const auto & [first, second] : cableList) {
+    cables.putSubjectId(first);
+    cables.putSubjectId(second);
+  }
+
+  for (std::size_t i = 0; i < workers_.size(); ++i) {
+    const auto & extended = workers_[i].extended;
+    RecordWriter payload;
+    auto region = writeSnapshotRegion(map, extended.origin, extended.size);
+    payload.put<std::uint64_t>(region.size());
+    payload.putBytes(region.data(), region.size());
+    payload.putBytes(cables.getBuffer().data(), cables.getBuffer().size());
+    send(i, LOAD, payload.getBuffer());
+  }
+  for (std::size_t i = 0; i < workers_.size(); ++i) {
+    receive(i);
+  }
+}
+
+template<typename Put>
+void PartitionedMap::queue(Coordinates c, Put && put) {
+  for (auto & worker : workers_) {
+    const auto & rect = worker.extended;
+    if (c.x >= rect.origin.x && c.x < rect.origin.x + rect.size.width &&
+        c.y >= rect.origin.y && c.y < rect.origin.y + rect.size.height) {
+      put(worker.queries, Coordinates{c.x - rect.origin.x, c.y - rect.origin.y});
+    }
+  }
+}
+
+void PartitionedMap::modify(SubjectModifyQuery && query) {
+  queue(query.coordinates, [&query](RecordWriter & writer, Coordinates c) {
+    writer.put(PartitionQuery::SUBJECT);
+    writer.put<std::int32_t>(query.queryType);
+    writer.putCoordinates(c);
+    writer.putSubject(*query.subject);
+  });
+}
+
+void PartitionedMap::modify(AirInsertQuery && query) {
+  queue(query.coordinates, [&query](RecordWriter & writer, Coordinates c) {
+    writer.put(PartitionQuery::AIR);
+    writer.putCoordinates(c);
+    writer.putAir(*query.air);
+  });
+}
+
+// region is split into spans once, so cells are the same as of one map
+void PartitionedMap::modify(AirRegionQuery && query) {
+  auto spans = getCellSpans(query.region, dimension_);
+
+  for (auto & worker : workers_) {
+    const auto & rect = worker.extended;
+    std::vector<CellSpan> local;
+    for (auto span : spans) {
+      int yBegin = std::max(span.yBegin, rect.origin.y);
+      int yEnd = std::min(span.yEnd, rect.origin.y + rect.size.height);
+      if (span.x >= rect.origin.x && span.x < rect.origin.x + rect.size.width &&
+          yBegin < yEnd) {
+        local.push_back(CellSpan{span.x - rect.origin.x, yBegin - rect.origin.y,
+                                 yEnd - rect.origin.y});
+      }
+    }
+    if (local.empty()) {
+      continue;
+    }
+
+    auto & writer = worker.queries;
+    writer.put(PartitionQuery::AIR_SPANS);
+    writer.put<std::int32_t>(static_cast<std::int32_t>(query.queryType));
+    writer.put<std::uint32_t>(local.size());
+    for (auto span : local) {
+      writer.put<std::int32_t>(span.x);
+      writer.put<std::int32_t>(span.yBegin);
+      writer.put<std::int32_t>(span.yEnd);
+    }
+    writer.put<std::uint8_t>(query.air != nullptr);
+    if (query.air) {
+      writer.putAir(*query.air);
+    }
+    writer.put(query.factor);
+    writer.put(query.temperature.get());
+  }
+}
+
+void PartitionedMap::modify(SubjectCallbackQ && query) {
+  using Callback = void (*)(Subject::Plain *, void *);
+  auto callback = query.callback.target<Callback>();
+
+  if (callback && *callback == setTurnableStatus) {
+    auto status = *static_cast<Subject::TurnableStatus *>(query.getData());
+    queue(query.select.coordinates, [&](RecordWriter & writer, Coordinates c) {
+      writer.put(PartitionQuery::TURN);
+      writer.putCoordinates(c);
+      writer.putSubjectId(query.select.id);
+      writer.put<std::int32_t>(static_cast<std::int32_t>(status));
+    });
+  } else if (callback && *callback == addPacketToTransmitQueue) {
+    const auto & packets = *static_cast<PacketList *>(query.getData());
+    queue(query.select.coordinates, [&](RecordWriter & writer, Coordinates c) {
+      writer.put(PartitionQuery::TRANSMIT);
+      writer.putCoordinates(c);
+      writer.putSubjectId(query.select.id);
+      writer.put<std::uint32_t>(packets.size());
+      for (const auto & packet : packets) {
+        writer.putPacket(*packet);
+      }
+    });
+  } else {
+    throw std::invalid_argument("partition: query with unknown callback");
+  }
+}
+
+// cables of whole map are kept by every partition
+void PartitionedMap::modify(CableModifyQuery && query) {
+  for (auto & worker : workers_) {
+    auto & writer = worker.queries;
+    writer.put(PartitionQuery::CABLE);
+    writer.put<std::int32_t>(static_cast<std::int32_t>(query.queryType));
+    writer.putSubjectId(query.first);
+    writer.putSubjectId(query.second);
+  }
+}
+
+void PartitionedMap::next(MapStageTimes * times) {
+  // all partitions are started before any of them is waited
+  for (std::size_t i = 0; i < workers_.size(); ++i) {
+    send(i, NEXT, workers_[i].queries.getBuffer());
+    workers_[i].queries.clear();
+  }
+
+  MapLayerIllumination::LightSources sources;
+  std::vector<std::vector<Coordinates>> receivers(workers_.size());
+  wireless_.clearNetwork();
+  for (std::size_t i = 0; i < workers_.size(); ++i) {
+    auto reply = receive(i);
+    RecordReader reader(asBytes(reply), "partition");
+    for (auto count = reader.get<std::uint32_t>(); count > 0; --count) {
+      auto c = reader.getCoordinates(dimension_);
+      obstruction_.setLightObstruction(c, Obstruction{reader.get<double>()});
+    }
+    for (auto count = reader.get<std::uint32_t>(); count > 0; --count) {
+      auto c = reader.getCoordinates(dimension_);
+      sources.emplace_back(c, Illumination{reader.get<std::int32_t>()});
+    }
+    for (auto cells = reader.get<std::uint32_t>(); cells > 0; --cells) {
+      auto c = reader.getCoordinates(dimension_);
+      wireless_.transmit(c, getContainers(reader));
+    }
+    for (auto count = reader.get<std::uint32_t>(); count > 0; --count) {
+      receivers[i].push_back(reader.getCoordinates(dimension_));
+    }
+  }
+
+  // sources of one cell come from one partition, so their order is kept as of one map
+  MapStageTimes central{};
+  MapStageClock clock(times ? &central : nullptr);
+  auto byCell = [](const auto & lhs, const auto & rhs) {
+    return lhs.first < rhs.first;
+  };
+  std::stable_sort(sources.begin(), sources.end(), byCell);
+  nextIllumination_.updateIllumination(obstruction_, sources);
+  clock.lap(MapStage::ILLUMINATION);
+  wireless_.updateNetwork(obstruction_);
+  clock.lap(MapStage::NETWORK_SPREAD);
+
+  for (std::size_t i = 0; i < workers_.size(); ++i) {
+    const auto & rect = workers_[i].extended;
+    RecordWriter payload;
+
+    auto countMark = payload.mark();
+    std::uint32_t count = 0;
+    payload.put(count);
+    Coordinates c;
+    for (c.x = rect.origin.x; c.x < rect.origin.x + rect.size.width; ++c.x) {
+      for (c.y = rect.origin.y; c.y < rect.origin.y + rect.size.height; ++c.y) {
+        auto illumination = nextIllumination_.getIllumination(c);
+        if (illumination != illumination_.getIllumination(c)) {
+          payload.putCoordinates({c.x - rect.origin.x, c.y - rect.origin.y});
+          payload.put<std::int32_t>(illumination.get());
+          ++count;
+        }
+      }
+    }
+    payload.putAt(countMark, count);
+
+    payload.put<std::uint32_t>(receivers[i].size());
+    for (auto receiver : receivers[i]) {
+      payload.putCoordinates({receiver.x - rect.origin.x, receiver.y - rect.origin.y});
+      putContainers(payload,
+                    std::as_const(wireless_).getReceivableContainers(receiver));
+    }
+    send(i, SPREAD, payload.getBuffer());
+  }
+  std::swap(illumination_, nextIllumination_);
+
+  for (std::size_t i = 0; i < workers_.size(); ++i) {
+    auto reply = receive(i);
+    if (!times) {
+      continue;
+    }
+    if (reply.size() != sizeof(MapStageTimes)) {
+      throw std::runtime_error("partition " + std::to_string(i) + ": bad times");
+    }
+    MapStageTimes partTimes;
+    std::memcpy(&partTimes, reply.data(), sizeof(partTimes));
+    for (std::size_t k = 0; k < MAP_STAGE_COUNT; ++k) {
+      if (i == 0 || partTimes.start[k] < times->start[k]) {
+        times->start[k] = partTimes.start[k];
+      }
+      if (i == 0 || partTimes.duration[k] > times->duration[k]) {
+        times->duration[k] = partTimes.duration[k];
+      }
+    }
+    if (i == 0 || partTimes.airSubsteps > times->airSubsteps) {
+      times->airSubsteps = partTimes.airSubsteps;
+    }
+  }
+
+  // illumination is computed here only, wireless signal after cables of partitions
+  if (times) {
+    auto illumination = static_cast<std::size_t>(MapStage::ILLUMINATION);
+    times->start[illumination] = central.start[illumination];
+    times->duration[illumination] = central.duration[illumination];
+    auto spread = static_cast<std::size_t>(MapStage::NETWORK_SPREAD);
+    times->duration[spread] =
+        std::max(times->duration[spread], central.duration[spread]);
+  }
+}
+
+void PartitionedMap::gather(SimulationMap & map) const {
+  auto dim = map.getDimension();
+  if (dim.width != dimension_.width || dim.height != dimension_.height) {
+    throw std::invalid_argument("partition: map has other dimension");
+  }
+
+  for (std::size_t i = 0; i < workers_.size(); ++i) {
+    send(i, GATHER, {});
+  }
+  for (std::size_t i = 0; i < workers_.size(); ++i) {
+    auto cells = receive(i);
+    readSnapshotRegion(map, workers_[i].owned.origin, asBytes(cells));
+  }
+
+  // cameras of gathered map see across partitions
+  auto & layers = map.layers;
+  layers.subjectLayer.setupSubjects(layers.airLayer, layers.obstructionLayer,
+                                    layers.illuminationLayer);
+}
@@ -0,0 +1,96 @@
+#include "cws/simulation/pool.hpp"
+
+#include "cws/log.hpp"
+#include <algorithm>
+#include <exception>
+#include <functional>
+
+SimulationPool::SimulationPool(unsigned threads) {
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (unsigned i = 0; i < threads; ++i) {
+    workers_.emplace_back(std::bind_front(&SimulationPool::execute, this));
+  }
+}
+
+void SimulationPool::add(SimulationMaster & master, double maxTickRate) {
+  std::chrono::nanoseconds minPeriod(0);
+  if (maxTickRate > 0) {
+    auto period = static_cast<long>(1'000'000'000 / maxTickRate);
+    minPeriod = std::chrono::nanoseconds(period);
+  }
+
+  std::unique_lock lock(mutex_);
+  entries_.push_back(Entry{&master, minPeriod, Clock::now()});
+  ++version_;
+  changed_.notify_all();
+}
+
+void SimulationPool::remove(SimulationMaster & master) {
+  std::unique_lock lock(mutex_);
+  auto it = std::find_if(entries_.begin(), entries_.end(),
+                         [&](const Entry & entry) { return entry.master == &master; });
+  if (it == entries_.end()) {
+    return;
+  }
+
+  it->removed = true;
+  changed_.wait(lock, [&] { return !it->busy; });
+  entries_.erase(it);
+  ++version_;
+  changed_.notify_all();
+}
+
+std::size_t SimulationPool::size() {
+  std::unique_lock lock(mutex_);
+  return entries_.size();
+}
+
+void SimulationPool::execute(std::stop_token stoken) {
+  std::unique_lock lock(mutex_);
+
+  while (!stoken.stop_requested()) {
+    auto next = entries_.end();
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+      bool ready = !it->busy && !it->removed && !it->failed;
+      if (ready && (next == entries_.end() || it->due < next->due)) {
+        next = it;
+      }
+    }
+
+    auto seen = version_;
+    auto changed = [&] { return version_ != seen; };
+    if (next == entries_.end()) {
+      changed_.wait(lock, stoken, changed);
+      continue;
+    }
+
+    auto start = Clock::now();
+    if (next->due > start) {
+      changed_.wait_until(lock, stoken, next->due, changed);
+      continue;
+    }
+
+    // entry isn't erased while busy
+    next->busy = true;
+    auto master = next->master;
+    lock.unlock();
+    // failed simulation is not stepped anymore, others keep running
+    std::chrono::nanoseconds period(0);
+    bool failed = false;
+    try {
+      period = master->step();
+    } catch (const std::exception & e) {
+      CWS_LOG_ERROR("pool", "simulation is stopped: " << e.what());
+      failed = true;
+    }
+    lock.lock();
+
+    next->busy = false;
+    next->failed = failed;
+    next->due = start + std::max(period, next->minPeriod);
+    ++version_;
+    changed_.notify_all();
+  }
+}
@@ -0,0 +1,247 @@
+#include "cws/simulation/record.hpp"
+#include "cws/subject/camera.hpp"
+#include "cws/subject/light_emitter.hpp"
+#include "cws/subject/network.hpp"
+#include "cws/subject/sensor.hpp"
+#include "cws/subject/temp_emitter.hpp"
+#include "cws/subject/turnable.hpp"
+#include <stdexcept>
+
+using namespace Subject;
+
+void RecordWriter::putPhysical(const Physical & physical) {
+  put(physical.getWeight());
+  put<std::int32_t>(physical.getHeatCapacity());
+  put(physical.getTemperature().get());
+  put(physical.getDefLightObstruction().get());
+  put(physical.getDefWirelessObstruction().get());
+}
+
+void RecordWriter::putSubjectId(const Subject::Id & id) {
+  put<std::int32_t>(static_cast<std::int32_t>(id.type));
+  put<std::int32_t>(id.idx);
+}
+
+void RecordWriter::putAir(const Air::Plain & air) {
+  put<std::int32_t>(static_cast<std::int32_t>(air.getId().type));
+  put<std::int32_t>(air.getId().idx);
+  putPhysical(air);
+  put(air.getHeatTransferCoef());
+}
+
+void RecordWriter::putPacket(const Network::Packet & packet) {
+  const auto & content = packet.getContent();
+  put<std::uint32_t>(content.size());
+  putBytes(content.data(), content.size());
+}
+
+static void putCamera(RecordWriter & writer, const BaseCamera & camera) {
+  writer.put(camera.getPower());
+  writer.put(camera.getPowerThreshold());
+  writer.put<std::int32_t>(camera.getView().range);
+  writer.put(camera.getView().direction);
+  writer.put(camera.getView().fov);
+}
+
+void RecordWriter::putSubject(const Plain & subject) {
+  putSubjectId(subject.getId());
+  putPhysical(subject);
+  put(subject.getSurfaceArea());
+  put(subject.getDefAirObstruction().get());
+
+  switch (subject.getId().type) {
+  case Type::TEMP_EMITTER: {
+    auto & emitter = static_cast<const TempEmitter &>(subject);
+    put(emitter.getDefTempParams().heatProduction);
+    break;
+  }
+  case Type::TURNABLE_TEMP_EMITTER: {
+    auto & emitter = static_cast<const TurnableTempEmitter &>(subject);
+    put(emitter.getDefTempParams().heatProduction);
+    put<std::int32_t>(static_cast<std::int32_t>(emitter.getStatus()));
+    put(emitter.getOffTempParams().heatProduction);
+    break;
+  }
+  case Type::LIGHT_EMITTER: {
+    auto & emitter = static_cast<const LightEmitter &>(subject);
+    put(emitter.getDefTempParams().heatProduction);
+    put<std::int32_t>(emitter.getDefLightParams().rawIllumination.get());
+    break;
+  }
+  case Type::TURNABLE_LIGHT_EMITTER: {
+    auto & emitter = static_cast<const TurnableLightEmitter &>(subject);
+    put(emitter.getDefTempParams().heatProduction);
+    put<std::int32_t>(emitter.getDefLightParams().rawIllumination.get());
+    put<std::int32_t>(static_cast<std::int32_t>(emitter.getStatus()));
+    put<std::int32_t>(emitter.getOffLightParams().rawIllumination.get());
+    put(emitter.getOffTempParams().heatProduction);
+    break;
+  }
+  case Type::WIRELESS_NETWORK_DEVICE: {
+    auto & device = static_cast<const WirelessNetworkDevice &>(subject);
+    put<std::int32_t>(device.getTransmitPower());
+    put<std::int32_t>(device.getReceiveThresh());
+    break;
+  }
+  case Type::INFRARED_CAMERA:
+    putCamera(*this, static_cast<const InfraredCamera &>(subject));
+    break;
+  case Type::LIGHT_CAMERA: {
+    auto & camera = static_cast<const LightCamera &>(subject);
+    putCamera(*this, camera);
+    put(camera.getLightThreshold());
+    break;
+  }
+  case Type::TURNABLE: {
+    auto & turnable = static_cast<const Turnable &>(subject);
+    put<std::int32_t>(static_cast<std::int32_t>(turnable.getStatus()));
+    put(turnable.getOffLightObstruction().get());
+    put(turnable.getOffWirelessObstruction().get());
+    put(turnable.getOffAirObstruction().get());
+    break;
+  }
+  default:
+    // plain, sensors and wired devices have no other parameters
+    break;
+  }
+}
+
+void RecordReader::error(const std::string & what) const {
+  throw std::invalid_argument(std::string(source_) + ": " + what);
+}
+
+std::span<const std::byte> RecordReader::getBytes(std::size_t size) {
+  if (getRemaining() < size) {
+    error("unexpected end of data");
+  }
+  auto bytes = data_.subspan(offset_, size);
+  offset_ += size;
+  return bytes;
+}
+
+Coordinates RecordReader::getCoordinates() {
+  return Coordinates{get<std::int32_t>(), get<std::int32_t>()};
+}
+
+Coordinates RecordReader::getCoordinates(Dimension dim) {
+  Coordinates c = getCoordinates();
+  if (c.x < 0 || c.x >= dim.width || c.y < 0 || c.y >= dim.height) {
+    error("coordinates out of bounds");
+  }
+  return c;
+}
+
+Physical RecordReader::getPhysical() {
+  auto weight = get<double>();
+  auto heatCapacity = get<std::int32_t>();
+  auto temperature = get<double>();
+  auto lightObstruction = get<double>();
+  auto wirelessObstruction = get<double>();
+  return Physical(weight, heatCapacity, Temperature{temperature},
+                  Obstruction{lightObstruction}, Obstruction{wirelessObstruction});
+}
+
+Subject::Id RecordReader::getSubjectId() {
+  auto type = static_cast<Type>(get<std::int32_t>());
+  return Subject::Id{.type = type, .idx = get<std::int32_t>()};
+}
+
+TurnableStatus RecordReader::getStatus() {
+  return static_cast<TurnableStatus>(get<std::int32_t>());
+}
+
+std::unique_ptr<Air::Plain> RecordReader::getAir() {
+  Air::Id id{.type = static_cast<Air::Type>(get<std::int32_t>()),
+             .idx = get<std::int32_t>()};
+  auto physical = getPhysical();
+  return std::make_unique<Air::Plain>(std::move(physical), id, get<double>());
+}
+
+std::unique_ptr<Network::Packet> RecordReader::getPacket() {
+  auto content = getBytes(get<std::uint32_t>());
+  return std::make_unique<Network::Packet>(
+      Network::Packet::Payload(content.begin(), content.end()));
+}
+
+template<typename Camera>
+std::unique_ptr<Plain> RecordReader::getCamera(Plain && plain) {
+  auto power = get<double>();
+  auto powerThreshold = get<double>();
+  CameraView view;
+  view.range = get<std::int32_t>();
+  view.direction = get<double>();
+  view.fov = get<double>();
+
+  std::unique_ptr<Camera> camera;
+  if constexpr (std::is_same_v<Camera, LightCamera>) {
+    camera = std::make_unique<Camera>(std::move(plain), power, powerThreshold,
+                                      get<double>());
+  } else {
+    camera = std::make_unique<Camera>(std::move(plain), power, powerThreshold);
+  }
+  camera->setView(view);
+  return camera;
+}
+
+// type of id is set by constructor of subject
+std::unique_ptr<Plain> RecordReader::getSubject() {
+  auto id = getSubjectId();
+  auto physical = getPhysical();
+  auto surfaceArea = get<double>();
+  auto airObstruction = get<double>();
+  Plain plain(std::move(physical), id.idx, surfaceArea, Obstruction{airObstruction});
+
+  switch (id.type) {
+  case Type::PLAIN:
+    return std::make_unique<Plain>(std::move(plain));
+  case Type::TEMP_EMITTER:
+    return std::make_unique<TempEmitter>(std::move(plain),
+                                         TempSourceParams{get<double>()});
+  case Type::TURNABLE_TEMP_EMITTER: {
+    TempEmitter emitter(std::move(plain), TempSourceParams{get<double>()});
+    auto status = getStatus();
+    return std::make_unique<TurnableTempEmitter>(std::move(emitter), status,
+                                                 TempSourceParams{get<double>()});
+  }
+  case Type::LIGHT_EMITTER: {
+    TempSourceParams temp{get<double>()};
+    LightSourceParams light{Illumination{get<std::int32_t>()}};
+    return std::make_unique<LightEmitter>(std::move(plain), temp, light);
+  }
+  case Type::TURNABLE_LIGHT_EMITTER: {
+    TempSourceParams temp{get<double>()};
+    LightSourceParams light{Illumination{get<std::int32_t>()}};
+    auto status = getStatus();
+    LightSourceParams offLight{Illumination{get<std::int32_t>()}};
+    TempSourceParams offTemp{get<double>()};
+    return std::make_unique<TurnableLightEmitter>(
+        LightEmitter(std::move(plain), temp, light), status, offLight, offTemp);
+  }
+  case Type::WIRELESS_NETWORK_DEVICE: {
+    auto transmitPower = get<std::int32_t>();
+    auto receiveThresh = get<std::int32_t>();
+    return std::make_unique<WirelessNetworkDevice>(std::move(plain), transmitPower,
+                                                   receiveThresh);
+  }
+  case Type::WIRED_NETWORK_DEVICE:
+    return std::make_unique<WiredNetworkDevice>(std::move(plain));
+  case Type::INFRARED_CAMERA:
+    return getCamera<InfraredCamera>(std::move(plain));
+  case Type::LIGHT_CAMERA:
+    return getCamera<LightCamera>(std::move(plain));
+  case Type::TURNABLE: {
+    auto status = getStatus();
+    Obstruction offLight{get<double>()};
+    Obstruction offWireless{get<double>()};
+    Obstruction offAir{get<double>()};
+    return std::make_unique<Turnable>(std::move(plain), status, offLight, offWireless,
+                                      offAir);
+  }
+  case Type::AIR_TEMPERATURE_SENSOR:
+    return std::make_unique<SensorAirTemperature>(std::move(plain));
+  case Type::ILLUMINATION_SENSOR:
+    return std::make_unique<SensorIllumination>(std::move(plain));
+  default:
+    error("unknown subject type " + std::to_string(static_cast<int>(id.type)));
+  }
+}
@@ -1,7 +1,14 @@
 #include "cws/simulation/simulation_map.hpp"
 #include "cws/subject/plain.hpp"
+#include <algorithm>
+#include <iterator>
+#include <tuple>
+#include <vector>
 
 void SimulationMap::modify(SubjectModifyQuery && query) {
+  if (!isInside(query.coordinates)) {
+    return;
+  }
   switch (query.queryType) {
   case SubjectModifyType::INSERT:
     modifyInsert(std::move(query));
@@ -17,61 +24,166 @@ void SimulationMap::modify(SubjectModifyQuery && query) {
   }
 }
 
-const Subject::Plain * SimulationMap::select(const SubjectSelectQuery & query) const {
+SimulationMap::SimulationMap(const SimulationMap & map)
+    : Map(map), subjectIndex_(map.subjectIndex_) {
+  remapSubjectIndex(map);
+}
+
+SimulationMap & SimulationMap::operator=(const SimulationMap & map) {
+  if (this != &map) {
+    Map::operator=(map);
+    // nodes of index are reused, so steady copies don't allocate for it
+    subjectIndex_ = map.subjectIndex_;
+    remapSubjectIndex(map);
+  }
+  return *this;
+}
+
+/*
+ * Copied index points to subjects of source map. Lists of cells are copied in the
+ * same order, so each slot is moved to subject at the same offset of own cell.
+ * Offsets are counted for short lists only, subjects of crowded cells are matched
+ * while both lists are walked once
+ */
+void SimulationMap::remapSubjectIndex(const SimulationMap & source) {
+  constexpr std::size_t maxCountedList = 16;
+  const auto & sourceLayer = source.layers.subjectLayer;
   auto & subjectLayer = layers.subjectLayer;
-  auto & subjectList = subjectLayer.getSubjectList(query.coordinates);
 
-  for (auto it = subjectList.begin(); it != subjectList.end(); ++it) {
-    if ((*it)->getId() == query.id) {
-      return it->get();
+  std::vector<Coordinates> crowdedCells;
+  for (auto & [id, location] : subjectIndex_) {
+    auto c = location.coordinates;
+    const auto & sourceList = sourceLayer.getSubjectList(c);
+    if (sourceList.size() > maxCountedList) {
+      crowdedCells.push_back(c);
+      continue;
+    }
+    auto offset = std::distance(sourceList.begin(), SubjectSlotConst(location.slot));
+    location.slot = std::next(subjectLayer.accessSubjectList(c).begin(), offset);
+  }
+
+  std::ranges::sort(crowdedCells, [](Coordinates a, Coordinates b) {
+    return std::tie(a.x, a.y) < std::tie(b.x, b.y);
+  });
+  auto [last, end] = std::ranges::unique(crowdedCells);
+  crowdedCells.erase(last, end);
+
+  for (auto c : crowdedCells) {
+    auto sourceIt = sourceLayer.getSubjectList(c).begin();
+    auto & subjectList = subjectLayer.accessSubjectList(c);
+    for (auto it = subjectList.begin(); it != subjectList.end(); ++it, ++sourceIt) {
+      auto [begin, end] = subjectIndex_.equal_range((*it)->getId());
+      for (auto entry = begin; entry != end; ++entry) {
+        if (entry->second.slot == sourceIt) {
+          entry->second.slot = it;
+          break;
+        }
+      }
     }
   }
-  return nullptr;
 }
 
-Subject::Plain * SimulationMap::select(const SubjectSelectQuery & query) {
-  auto & subjectLayer = layers.subjectLayer;
-  auto & subjectList = subjectLayer.accessSubjectList(query.coordinates);
+void SimulationMap::rebuildSubjectIndex() {
+  for (const auto & [id, location] : subjectIndex_) {
+    layers.networkWired.removeDevice(id, location.coordinates);
+  }
+  subjectIndex_.clear();
 
+  Coordinates c;
+  for (c.x = 0; c.x < dimension.width; ++c.x) {
+    for (c.y = 0; c.y < dimension.height; ++c.y) {
+      indexCell(c);
+    }
+  }
+}
+
+void SimulationMap::unindexCell(Coordinates c) {
+  for (const auto & subject : layers.subjectLayer.getSubjectList(c)) {
+    auto [begin, end] = subjectIndex_.equal_range(subject->getId());
+    for (auto it = begin; it != end; ++it) {
+      if (it->second.coordinates == c) {
+        subjectIndex_.erase(it);
+        layers.networkWired.removeDevice(subject->getId(), c);
+        break;
+      }
+    }
+  }
+}
+
+void SimulationMap::indexCell(Coordinates c) {
+  auto & subjectList = layers.subjectLayer.accessSubjectList(c);
   for (auto it = subjectList.begin(); it != subjectList.end(); ++it) {
-    if ((*it)->getId() == query.id) {
-      return it->get();
+    subjectIndex_.emplace((*it)->getId(), SubjectLocation{c, it});
+    layers.networkWired.addDevice((*it)->getId(), c);
+  }
+}
+
+SimulationMap::SubjectIndex::const_iterator
+SimulationMap::findIndexed(const SubjectSelectQuery & query) const {
+  auto [begin, end] = subjectIndex_.equal_range(query.id);
+  for (auto it = begin; it != end; ++it) {
+    if (it->second.coordinates == query.coordinates) {
+      return it;
     }
   }
-  return nullptr;
+  return subjectIndex_.end();
+}
+
+const Subject::Plain * SimulationMap::select(const SubjectSelectQuery & query) const {
+  auto it = findIndexed(query);
+  return it == subjectIndex_.end() ? nullptr : it->second.slot->get();
+}
+
+Subject::Plain * SimulationMap::select(const SubjectSelectQuery & query) {
+  auto it = findIndexed(query);
+  return it == subjectIndex_.end() ? nullptr : it->second.slot->get();
+}
+
+const Subject::Plain * SimulationMap::select(const Subject::Id & id,
+                                             Coordinates * coordinates) const {
+  auto it = subjectIndex_.find(id);
+  if (it == subjectIndex_.end()) {
+    return nullptr;
+  }
+  if (coordinates) {
+    *coordinates = it->second.coordinates;
+  }
+  return it->second.slot->get();
 }
 
 void SimulationMap::modifyInsert(SubjectModifyQuery && query) {
   auto & subjectLayer = layers.subjectLayer;
   auto & subjectList = subjectLayer.accessSubjectList(query.coordinates);
+  auto id = query.subject->getId();
   subjectList.push_front(std::move(query.subject));
+  subjectIndex_.emplace(id, SubjectLocation{query.coordinates, subjectList.begin()});
+  layers.networkWired.addDevice(id, query.coordinates);
 }
 
 void SimulationMap::modifyUpdate(SubjectModifyQuery && query) {
-  auto & subjectLayer = layers.subjectLayer;
-  auto & subjectList = subjectLayer.accessSubjectList(query.coordinates);
-
-  for (auto it = subjectList.begin(); it != subjectList.end(); ++it) {
-    if (**it == *query.subject) {
-      *it = std::move(query.subject);
-      break;
-    }
+  auto it = findIndexed(SubjectSelectQuery(query.coordinates, query.subject->getId()));
+  if (it != subjectIndex_.end()) {
+    *it->second.slot = std::move(query.subject);
   }
 }
+
 void SimulationMap::modifyDelete(SubjectModifyQuery && query) {
   auto & subjectLayer = layers.subjectLayer;
-  auto & cell = subjectLayer.accessCell(query.coordinates);
-  auto & subjectList = cell.accessElement().accessSubjectList();
+  auto & subjectList = subjectLayer.accessSubjectList(query.coordinates);
 
-  for (auto it = subjectList.begin(); it != subjectList.end(); ++it) {
-    if (**it == *query.subject) {
-      subjectList.erase(it);
-      break;
-    }
+  auto it = findIndexed(SubjectSelectQuery(query.coordinates, query.subject->getId()));
+  if (it != subjectIndex_.end()) {
+    subjectList.erase(it->second.slot);
+    subjectIndex_.erase(it);
+    layers.networkWired.removeDevice(query.subject->getId(), query.coordinates);
   }
 }
 
-void SimulationMap::modify(AirInsertQuery && query) { modifyInsert(std::move(query)); }
+void SimulationMap::modify(AirInsertQuery && query) {
+  if (isInside(query.coordinates)) {
+    modifyInsert(std::move(query));
+  }
+}
 
 void SimulationMap::modifyInsert(AirInsertQuery && query) {
   auto & airLayer = layers.airLayer;
@@ -79,6 +191,25 @@ void SimulationMap::modifyInsert(AirInsertQuery && query) {
   container.add(std::move(query.air));
 }
 
+void SimulationMap::modify(AirRegionQuery && query) {
+  auto spans = getCellSpans(query.region, dimension);
+  auto & airLayer = layers.airLayer;
+
+  switch (query.queryType) {
+  case AirRegionModifyType::FILL:
+    if (query.air) {
+      airLayer.fill(spans, *query.air);
+    }
+    break;
+  case AirRegionModifyType::SCALE:
+    airLayer.scaleWeight(spans, query.factor);
+    break;
+  case AirRegionModifyType::SET_TEMPERATURE:
+    airLayer.setTemperature(spans, query.temperature);
+    break;
+  }
+}
+
 const Air::Plain * SimulationMap::select(const AirSelectQuery & query) const {
   auto & airLayer = layers.airLayer;
   auto & airList = airLayer.getAirContainer(query.coordinates).getList();
@@ -97,3 +228,39 @@ void SimulationMap::modify(SubjectCallbackQ && query) {
     query.callback(subject, query.getData());
   }
 }
+
+void SimulationMap::modify(MapImportQuery && query) {
+  subjectIndex_.reserve(subjectIndex_.size() + query.subjects.size());
+  for (auto & subject : query.subjects) {
+    if (isInside(subject.coordinates)) {
+      modifyInsert(std::move(subject));
+    }
+  }
+
+  // air of cell keeps order it would have after inserts one by one
+  auto & air = query.air;
+  std::erase_if(air, [this](const auto & item) { return !isInside(item.coordinates); });
+  std::stable_sort(air.begin(), air.end(), [](const auto & a, const auto & b) {
+    return std::tie(a.coordinates.x, a.coordinates.y) <
+           std::tie(b.coordinates.x, b.coordinates.y);
+  });
+  for (auto it = air.begin(); it != air.end();) {
+    auto c = it->coordinates;
+    std::list<Air::Container::PlainUPTR> cellAir;
+    for (; it != air.end() && it->coordinates == c; ++it) {
+      cellAir.push_back(std::move(it->air));
+    }
+    layers.airLayer.accessAirContainer(c).add(std::move(cellAir));
+  }
+}
+
+bool SimulationMap::modify(CableModifyQuery && query) {
+  auto & wired = layers.networkWired;
+  switch (query.queryType) {
+  case CableModifyType::CONNECT:
+    return wired.connect(query.first, query.second);
+  case CableModifyType::DISCONNECT:
+    return wired.disconnect(query.first, query.second);
+  }
+  return false;
+}
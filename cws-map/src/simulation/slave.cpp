@@ -1,5 +1,7 @@
 #include "cws/simulation/simulation.hpp"
 
+#include "cws/log.hpp"
+
 // #include <sys/prctl.h>
 
 void SimulationSlave::run() {
@@ -51,8 +53,7 @@ void SimulationSlave::execute() {
 
 void SimulationSlave::updateSimulationMap() {
   if (master.mapsExist()) {
-    master.nextMap->next(*master.currMap);
+    master.nextMap->next(*master.currMap, &master.nextMapTimes);
   }
-  std::cout << "slave: "
-            << "map updated" << std::endl;
+  CWS_LOG_DEBUG("slave", "map updated");
 }
@@ -0,0 +1,548 @@
+#include "cws/simulation/snapshot.hpp"
+#include "cws/simulation/record.hpp"
+#include "cws/subject/network.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+#include <vector>
+
+static constexpr char SNAPSHOT_MAGIC[8] = {'C', 'W', 'S', 'S', 'N', 'A', 'P', '\0'};
+static constexpr char DELTA_MAGIC[8] = {'C', 'W', 'S', 'D', 'E', 'L', 'T', '\0'};
+static constexpr char REGION_MAGIC[8] = {'C', 'W', 'S', 'R', 'E', 'G', 'N', '\0'};
+
+/*
+ * Values are written to stream in large blocks. Record of cell has no coordinates
+ * and is hashed to find cells changed since base snapshot
+ */
+class SnapshotWriter final : public RecordWriter {
+  static constexpr std::size_t FLUSH_SIZE = 1 << 16;
+
+  std::ostream & out_;
+
+public:
+  explicit SnapshotWriter(std::ostream & out) : out_(out) {}
+
+  ~SnapshotWriter() { flush(); }
+
+  void flush() {
+    out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    buffer_.clear();
+  }
+
+  void flushIfFull() {
+    if (buffer_.size() >= FLUSH_SIZE) {
+      flush();
+    }
+  }
+
+  // returns hash of record
+  std::uint64_t putCell(const Layers & layers, Coordinates c);
+
+  void putCables(const Layers & layers) {
+    auto cables = layers.networkWired.getCables();
+    put<std::uint64_t>(cables.size());
+    for (const auto & [first, second] : cables) {
+      putSubjectId(first);
+      putSubjectId(second);
+    }
+  }
+
+  void putAirState(const MapLayerAir & airLayer) {
+    auto state = airLayer.getState();
+    const auto & stepping = state.stepping;
+    put<std::uint8_t>(stepping.adaptive);
+    put<std::int32_t>(stepping.maxSubsteps);
+    put<std::int32_t>(stepping.maxSkippedTicks);
+    put(stepping.equilibriumRatio);
+    put(stepping.equilibriumTemperature);
+    put<std::int32_t>(state.pendingTicks);
+    put<std::uint8_t>(state.equilibrium);
+    put<std::int32_t>(state.disturbedSteps);
+    put(state.stiffness);
+    put(state.heating);
+
+    const auto & sleeping = state.sleeping;
+    put<std::uint8_t>(sleeping.enabled);
+    put<std::int32_t>(sleeping.tileSize);
+    put<std::int32_t>(sleeping.calmTicks);
+    put(sleeping.temperatureDelta);
+    put(sleeping.weightDelta);
+    put<std::uint64_t>(state.tiles.size());
+    for (auto [asleep, calmTicks] : state.tiles) {
+      put<std::uint8_t>(asleep);
+      put<std::int32_t>(calmTicks);
+    }
+  }
+
+  // buffers of network device follow its record, other subjects have none
+  void putPackets(const Subject::Plain & subject) {
+    auto device = dynamic_cast<const Subject::NetworkDevice *>(&subject);
+    if (!device) {
+      return;
+    }
+    for (const auto * packets :
+         {&device->getTransmitPackets(), &device->getReceivedPackets()}) {
+      put<std::uint32_t>(packets->size());
+      for (const auto & packet : *packets) {
+        putPacket(*packet);
+      }
+    }
+  }
+
+  void putHeader(const char (&magic)[8], Dimension dim) {
+    putBytes(magic, sizeof(magic));
+    put(SNAPSHOT_VERSION);
+    put<std::int32_t>(dim.width);
+    put<std::int32_t>(dim.height);
+  }
+};
+
+std::uint64_t SnapshotWriter::putCell(const Layers & layers, Coordinates c) {
+  auto start = mark();
+
+  const auto & obstruction = layers.obstructionLayer;
+  put(obstruction.getLightObstruction(c).get());
+  put(obstruction.getAirObstruction(c).get());
+  put(obstruction.getWirelessObstruction(c).get());
+  put<std::int32_t>(layers.illuminationLayer.getIllumination(c).get());
+
+  // container inserts to front, so reading in reverse keeps order
+  const auto & airList = layers.airLayer.getAirContainer(c).getList();
+  put<std::uint32_t>(airList.size());
+  for (auto it = airList.rbegin(); it != airList.rend(); ++it) {
+    putAir(**it);
+  }
+
+  const auto & subjectList = layers.subjectLayer.getSubjectList(c);
+  put<std::uint32_t>(subjectList.size());
+  for (const auto & subject : subjectList) {
+    putSubject(*subject);
+    putPackets(*subject);
+  }
+
+  return std::hash<std::string_view>{}(std::string_view(buffer_).substr(start));
+}
+
+std::vector<std::uint64_t> writeSnapshot(std::ostream & out,
+                                         const SimulationMap & map) {
+  SnapshotWriter writer(out);
+  const auto & layers = map.getLayers();
+  Dimension dim = map.getDimension();
+
+  std::vector<std::uint64_t> hashes;
+  hashes.reserve(static_cast<std::size_t>(dim.width) * dim.height);
+
+  writer.putHeader(SNAPSHOT_MAGIC, dim);
+  Coordinates c;
+  for (c.x = 0; c.x < dim.width; ++c.x) {
+    for (c.y = 0; c.y < dim.height; ++c.y) {
+      hashes.push_back(writer.putCell(layers, c));
+      writer.flushIfFull();
+    }
+  }
+  writer.putCables(layers);
+  writer.putAirState(layers.airLayer);
+  return hashes;
+}
+
+std::size_t writeSnapshotDelta(std::ostream & out, const SimulationMap & map,
+                               std::uint64_t baseId,
+                               std::span<const std::uint64_t> baseHashes) {
+  SnapshotWriter writer(out);
+  const auto & layers = map.getLayers();
+  Dimension dim = map.getDimension();
+  if (baseHashes.size() != static_cast<std::size_t>(dim.width) * dim.height) {
+    throw std::invalid_argument("snapshot: base has other dimension");
+  }
+
+  writer.putHeader(DELTA_MAGIC, dim);
+  writer.put(baseId);
+
+  // count is not known until cells are compared, so cells are ended with marker
+  std::size_t changed = 0;
+  std::size_t i = 0;
+  Coordinates c;
+  for (c.x = 0; c.x < dim.width; ++c.x) {
+    for (c.y = 0; c.y < dim.height; ++c.y, ++i) {
+      auto start = writer.mark();
+      writer.putCoordinates(c);
+      if (writer.putCell(layers, c) == baseHashes[i]) {
+        writer.rollback(start);
+        continue;
+      }
+      ++changed;
+      writer.flushIfFull();
+    }
+  }
+  writer.put<std::int32_t>(-1);
+  writer.putCables(layers);
+  writer.putAirState(layers.airLayer);
+  return changed;
+}
+
+template<typename Write>
+static void saveAtomically(const std::string & path, Write && write) {
+  std::string tmpPath = path + ".tmp";
+  {
+    std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      throw std::system_error(errno, std::generic_category(), tmpPath);
+    }
+    write(out);
+    out.flush();
+    if (!out) {
+      throw std::system_error(errno, std::generic_category(), tmpPath);
+    }
+  }
+  if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+    throw std::system_error(errno, std::generic_category(), path);
+  }
+}
+
+std::vector<std::uint64_t> saveSnapshot(const std::string & path,
+                                        const SimulationMap & map) {
+  std::vector<std::uint64_t> hashes;
+  saveAtomically(path, [&](std::ostream & out) { hashes = writeSnapshot(out, map); });
+  return hashes;
+}
+
+std::size_t saveSnapshotDelta(const std::string & path, const SimulationMap & map,
+                              std::uint64_t baseId,
+                              std::span<const std::uint64_t> baseHashes) {
+  std::size_t changed = 0;
+  saveAtomically(path, [&](std::ostream & out) {
+    changed = writeSnapshotDelta(out, map, baseId, baseHashes);
+  });
+  return changed;
+}
+
+/*
+ * Reads values straight from bytes of snapshot, subjects are appended to lists
+ * of cells in stored order and index of map is built once at the end
+ */
+class SnapshotReader final : public RecordReader {
+public:
+  explicit SnapshotReader(std::span<const std::byte> data)
+      : RecordReader(data, "snapshot") {}
+
+  std::unique_ptr<SimulationMap> read();
+  std::uint64_t readDelta(SimulationMap & map);
+  void readRegion(SimulationMap & map, Coordinates origin);
+
+private:
+  Dimension getHeader(const char (&magic)[8]);
+  // rejects dimension before anything is allocated for it
+  void checkCellCount(Dimension dim) const;
+  void getCell(Layers & layers, Coordinates c);
+  void getPackets(Subject::Plain & subject);
+  void getCables(Layers & layers);
+  // read after cells, which wake tiles of air they are written to
+  void getAirState(MapLayerAir & airLayer);
+  void finish(SimulationMap & map);
+};
+
+Dimension SnapshotReader::getHeader(const char (&magic)[8]) {
+  char stored[sizeof(magic)];
+  for (auto & ch : stored) {
+    ch = get<char>();
+  }
+  if (std::memcmp(stored, magic, sizeof(stored)) != 0) {
+    error("not a snapshot");
+  }
+  auto version = get<std::uint32_t>();
+  if (version != SNAPSHOT_VERSION) {
+    error("unsupported version " + std::to_string(version));
+  }
+
+  Dimension dim{get<std::int32_t>(), get<std::int32_t>()};
+  if (dim.width <= 0 || dim.height <= 0) {
+    error("bad dimension");
+  }
+  return dim;
+}
+
+void SnapshotReader::checkCellCount(Dimension dim) const {
+  // obstructions, illumination and counts of air and subjects
+  constexpr std::size_t minCellSize = 3 * sizeof(double) + 3 * sizeof(std::int32_t);
+  auto cells = static_cast<std::uint64_t>(dim.width) * dim.height;
+  if (cells > getRemaining() / minCellSize) {
+    error("dimension is larger than data");
+  }
+}
+
+void SnapshotReader::getCell(Layers & layers, Coordinates c) {
+  auto & obstruction = layers.obstructionLayer;
+  obstruction.setLightObstruction(c, Obstruction{get<double>()});
+  obstruction.setAirObstruction(c, Obstruction{get<double>()});
+  obstruction.setWirelessObstruction(c, Obstruction{get<double>()});
+  layers.illuminationLayer.setIllumination(c, Illumination{get<std::int32_t>()});
+
+  // container normalizes temperature on insert, stored values are set back after
+  std::vector<std::pair<Air::Plain *, Temperature>> airTemperatures;
+  auto & container = layers.airLayer.accessAirContainer(c);
+  container = Air::Container();
+
+  auto airCount = get<std::uint32_t>();
+  for (std::uint32_t i = 0; i < airCount; ++i) {
+    auto air = getAir();
+    if (container.findOrNull(*air) != nullptr) {
+      error("air is repeated in cell");
+    }
+    airTemperatures.emplace_back(air.get(), air->getTemperature());
+    container.add(std::move(air));
+  }
+  for (auto [air, temperature] : airTemperatures) {
+    air->setTemperature(temperature);
+  }
+
+  auto & subjectList = layers.subjectLayer.accessSubjectList(c);
+  subjectList.clear();
+
+  auto subjectCount = get<std::uint32_t>();
+  for (std::uint32_t i = 0; i < subjectCount; ++i) {
+    subjectList.push_back(getSubject());
+    getPackets(*subjectList.back());
+  }
+}
+
+void SnapshotReader::getPackets(Subject::Plain & subject) {
+  auto device = dynamic_cast<Subject::NetworkDevice *>(&subject);
+  if (!device) {
+    return;
+  }
+  std::list<Subject::NetworkDevice::PacketUPTR> transmit;
+  for (auto count = get<std::uint32_t>(); count > 0; --count) {
+    transmit.push_back(getPacket());
+  }
+  std::list<Subject::NetworkDevice::PacketUPTR> received;
+  for (auto count = get<std::uint32_t>(); count > 0; --count) {
+    received.push_back(getPacket());
+  }
+  device->transmitPackets(std::move(transmit));
+  device->setReceivedPackets(std::move(received));
+}
+
+void SnapshotReader::getCables(Layers & layers) {
+  for (const auto & [first, second] : layers.networkWired.getCables()) {
+    layers.networkWired.disconnect(first, second);
+  }
+
+  auto cableCount = get<std::uint64_t>();
+  for (std::uint64_t i = 0; i < cableCount; ++i) {
+    auto first = getSubjectId();
+    auto second = getSubjectId();
+    layers.networkWired.connect(first, second);
+  }
+}
+
+void SnapshotReader::getAirState(MapLayerAir & airLayer) {
+  MapLayerAir::State state;
+  auto & stepping = state.stepping;
+  stepping.adaptive = get<std::uint8_t>() != 0;
+  stepping.maxSubsteps = get<std::int32_t>();
+  stepping.maxSkippedTicks = get<std::int32_t>();
+  stepping.equilibriumRatio = get<double>();
+  stepping.equilibriumTemperature = get<double>();
+  state.pendingTicks = get<std::int32_t>();
+  state.equilibrium = get<std::uint8_t>() != 0;
+  state.disturbedSteps = get<std::int32_t>();
+  state.stiffness = get<double>();
+  state.heating = get<double>();
+
+  auto & sleeping = state.sleeping;
+  sleeping.enabled = get<std::uint8_t>() != 0;
+  sleeping.tileSize = get<std::int32_t>();
+  sleeping.calmTicks = get<std::int32_t>();
+  sleeping.temperatureDelta = get<double>();
+  sleeping.weightDelta = get<double>();
+  auto tileCount = get<std::uint64_t>();
+  if (tileCount > getRemaining() / (sizeof(std::uint8_t) + sizeof(std::int32_t))) {
+    error("tile count is larger than data");
+  }
+  state.tiles.reserve(tileCount);
+  for (std::uint64_t i = 0; i < tileCount; ++i) {
+    bool asleep = get<std::uint8_t>() != 0;
+    state.tiles.emplace_back(asleep, get<std::int32_t>());
+  }
+
+  try {
+    airLayer.setState(state);
+  } catch (const std::invalid_argument & e) {
+    error(e.what());
+  }
+}
+
+void SnapshotReader::finish(SimulationMap & map) {
+  if (offset_ != data_.size()) {
+    error("unexpected data after end");
+  }
+
+  map.rebuildSubjectIndex();
+  // sensors and cameras are set up as after tick
+  auto & layers = map.layers;
+  layers.subjectLayer.setupSubjects(layers.airLayer, layers.obstructionLayer,
+                                    layers.illuminationLayer);
+}
+
+std::unique_ptr<SimulationMap> SnapshotReader::read() {
+  Dimension dim = getHeader(SNAPSHOT_MAGIC);
+  checkCellCount(dim);
+  auto map = std::make_unique<SimulationMap>(dim);
+
+  Coordinates c;
+  for (c.x = 0; c.x < dim.width; ++c.x) {
+    for (c.y = 0; c.y < dim.height; ++c.y) {
+      getCell(map->layers, c);
+    }
+  }
+  getCables(map->layers);
+  getAirState(map->layers.airLayer);
+
+  finish(*map);
+  return map;
+}
+
+std::uint64_t SnapshotReader::readDelta(SimulationMap & map) {
+  Dimension dim = getHeader(DELTA_MAGIC);
+  Dimension mapDim = map.getDimension();
+  if (dim.width != mapDim.width || dim.height != mapDim.height) {
+    error("delta has other dimension");
+  }
+  auto baseId = get<std::uint64_t>();
+
+  while (true) {
+    auto x = get<std::int32_t>();
+    if (x < 0) {
+      break;
+    }
+    Coordinates c{x, get<std::int32_t>()};
+    if (c.x >= dim.width || c.y < 0 || c.y >= dim.height) {
+      error("coordinates out of bounds");
+    }
+    getCell(map.layers, c);
+  }
+  getCables(map.layers);
+  getAirState(map.layers.airLayer);
+
+  finish(map);
+  return baseId;
+}
+
+void SnapshotReader::readRegion(SimulationMap & map, Coordinates origin) {
+  Dimension dim = getHeader(REGION_MAGIC);
+  Dimension mapDim = map.getDimension();
+  if (origin.x < 0 || origin.y < 0 || origin.x + dim.width > mapDim.width ||
+      origin.y + dim.height > mapDim.height) {
+    error("region is out of map");
+  }
+
+  Coordinates c;
+  for (c.x = origin.x; c.x < origin.x + dim.width; ++c.x) {
+    for (c.y = origin.y; c.y < origin.y + dim.height; ++c.y) {
+      map.unindexCell(c);
+      getCell(map.layers, c);
+      map.indexCell(c);
+    }
+  }
+  if (offset_ != data_.size()) {
+    error("unexpected data after end");
+  }
+}
+
+std::unique_ptr<SimulationMap> readSnapshot(std::span<const std::byte> data) {
+  return SnapshotReader(data).read();
+}
+
+std::uint64_t readSnapshotDelta(SimulationMap & map, std::span<const std::byte> data) {
+  return SnapshotReader(data).readDelta(map);
+}
+
+std::string writeSnapshotRegion(const SimulationMap & map, Coordinates origin,
+                                Dimension size) {
+  Dimension dim = map.getDimension();
+  Coordinates end{std::min(origin.x + size.width, dim.width),
+                  std::min(origin.y + size.height, dim.height)};
+  origin = {std::max(origin.x, 0), std::max(origin.y, 0)};
+  size = {std::max(end.x - origin.x, 0), std::max(end.y - origin.y, 0)};
+
+  std::ostringstream out;
+  {
+    SnapshotWriter writer(out);
+    const auto & layers = map.getLayers();
+    writer.putHeader(REGION_MAGIC, size);
+    Coordinates c;
+    for (c.x = origin.x; c.x < end.x; ++c.x) {
+      for (c.y = origin.y; c.y < end.y; ++c.y) {
+        writer.putCell(layers, c);
+        writer.flushIfFull();
+      }
+    }
+  }
+  return std::move(out).str();
+}
+
+void readSnapshotRegion(SimulationMap & map, Coordinates origin,
+                        std::span<const std::byte> data) {
+  SnapshotReader(data).readRegion(map, origin);
+}
+
+// file is mapped for the time of `read` only
+template<typename Read>
+static auto readMapped(const std::string & path, Read && read) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::system_error(errno, std::generic_category(), path);
+  }
+
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    int err = errno;
+    ::close(fd);
+    throw std::system_error(err, std::generic_category(), path);
+  }
+
+  auto size = static_cast<std::size_t>(st.st_size);
+  if (size == 0) {
+    ::close(fd);
+    return read(std::span<const std::byte>());
+  }
+
+  void * data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  int err = errno;
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    throw std::system_error(err, std::generic_category(), path);
+  }
+  ::madvise(data, size, MADV_SEQUENTIAL);
+
+  try {
+    auto result = read(std::span(static_cast<const std::byte *>(data), size));
+    ::munmap(data, size);
+    return result;
+  } catch (...) {
+    ::munmap(data, size);
+    throw;
+  }
+}
+
+std::unique_ptr<SimulationMap> loadSnapshot(const std::string & path) {
+  return readMapped(path, [](std::span<const std::byte> data) {
+    return readSnapshot(data);
+  });
+}
+
+std::uint64_t loadSnapshotDelta(SimulationMap & map, const std::string & path) {
+  return readMapped(path, [&map](std::span<const std::byte> data) {
+    return readSnapshotDelta(map, data);
+  });
+}
@@ -0,0 +1,70 @@
+#include "cws/simulation/workers.hpp"
+
+#include <algorithm>
+
+ParallelWorkers::ParallelWorkers(unsigned threads) {
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  threadCount_ = threads;
+  for (unsigned i = 1; i < threads; ++i) {
+    workers_.emplace_back(std::bind_front(&ParallelWorkers::execute, this));
+  }
+}
+
+void ParallelWorkers::run(std::size_t count,
+                          const std::function<void(std::size_t)> & task) {
+  std::unique_lock runLock(runMutex_);
+  {
+    std::unique_lock lock(mutex_);
+    task_ = &task;
+    count_ = count;
+    next_ = 0;
+    running_ = workers_.size();
+    error_ = nullptr;
+    ++loop_;
+  }
+  started_.notify_all();
+
+  work();
+
+  std::unique_lock lock(mutex_);
+  finished_.wait(lock, [&] { return running_ == 0; });
+  task_ = nullptr;
+  if (error_) {
+    std::rethrow_exception(error_);
+  }
+}
+
+void ParallelWorkers::execute(std::stop_token stoken) {
+  std::size_t seen = 0;
+  while (true) {
+    {
+      std::unique_lock lock(mutex_);
+      if (!started_.wait(lock, stoken, [&] { return loop_ != seen; })) {
+        return;
+      }
+      seen = loop_;
+    }
+
+    work();
+
+    std::unique_lock lock(mutex_);
+    if (--running_ == 0) {
+      finished_.notify_one();
+    }
+  }
+}
+
+void ParallelWorkers::work() {
+  for (auto i = next_++; i < count_; i = next_++) {
+    try {
+      (*task_)(i);
+    } catch (...) {
+      std::unique_lock lock(mutex_);
+      if (!error_) {
+        error_ = std::current_exception();
+      }
+    }
+  }
+}
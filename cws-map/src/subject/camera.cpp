@@ -1,7 +1,11 @@
 #include "cws/subject/camera.hpp"
 #include "cws/common.hpp"
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <deque>
+#include <limits>
+#include <numbers>
 #include <queue>
 
 namespace Subject {
@@ -15,6 +19,14 @@ using GetResidualPowerFn = double (*)(Coordinates, double cellPower,
 
 using FilterCellFn = bool (*)(Coordinates, const BaseCamera & baseCamera);
 
+/*
+ * Search is limited to box around camera of view range, so buffer of visited cells
+ * and work depend on range rather than on size of map. Cells farther than range
+ * are never queued, thus they stop search as obstruction does. Cone of fov is
+ * searched with margin of cells around it, as narrow cone may hold no neighbour of
+ * camera and path towards camera may leave it, but only subjects inside of cone
+ * are visible
+ */
 std::list<PCoordPlain> getVisibleSubjectsGen(const BaseCamera & camera,
                                              IsCellFitFn isCellFit,
                                              GetResidualPowerFn getResidualPower,
@@ -24,25 +36,86 @@ std::list<PCoordPlain> getVisibleSubjectsGen(const BaseCamera & camera,
   auto subjectLayer = camera.getLayerSubject();
   auto cameraCoords = camera.getCameraCoords();
   auto cameraPower = camera.getPower();
+  const auto & view = camera.getView();
+
+  assert(subjectLayer != nullptr);
 
   Dimension dim = subjectLayer->getDimension();
 
-  assert(subjectLayer != nullptr);
+  Coordinates boxBegin{0, 0};
+  Coordinates boxEnd{dim.width, dim.height};
+  if (view.range > 0) {
+    boxBegin = {std::max(cameraCoords.x - view.range, 0),
+                std::max(cameraCoords.y - view.range, 0)};
+    boxEnd = {std::min(cameraCoords.x + view.range + 1, dim.width),
+              std::min(cameraCoords.y + view.range + 1, dim.height)};
+  }
+  int boxHeight = boxEnd.y - boxBegin.y;
 
   // -2 - not touched, -1 - in queue, >=0 - calculated
-  std::vector<std::vector<double>> infoV(dim.width,
-                                         std::vector<double>(dim.height, -2));
+  std::vector<double> infoV(
+      static_cast<std::size_t>(boxEnd.x - boxBegin.x) * boxHeight, -2);
+  auto info = [&](Coordinates c) -> double & {
+    return infoV[(c.x - boxBegin.x) * boxHeight + (c.y - boxBegin.y)];
+  };
+
+  bool limitFov = view.fov < 360;
+  double halfFov = view.fov / 2 * std::numbers::pi / 180;
+  double direction = view.direction * std::numbers::pi / 180;
+  double dirX = std::cos(direction);
+  double dirY = std::sin(direction);
+  long long rangeSquare = static_cast<long long>(view.range) * view.range;
+  constexpr double coneMargin = 1.5;// cells, more than deviation of path from line
+
+  auto isInRange = [&](Coordinates c) -> bool {
+    long long dx = c.x - cameraCoords.x;
+    long long dy = c.y - cameraCoords.y;
+    return view.range <= 0 || dx * dx + dy * dy <= rangeSquare;
+  };
+
+  // euclidean distance from cell to cone, 0 inside of it
+  auto getConeDistance = [&](Coordinates c) -> double {
+    double dx = c.x - cameraCoords.x;
+    double dy = c.y - cameraCoords.y;
+    double angle = std::atan2(std::abs(dx * dirY - dy * dirX), dx * dirX + dy * dirY);
+    if (angle <= halfFov + 1e-9) {
+      return 0;
+    }
+    double dist = std::hypot(dx, dy);
+    return angle - halfFov < std::numbers::pi / 2 ? dist * std::sin(angle - halfFov)
+                                                  : dist;
+  };
+
+  auto isSearched = [&](Coordinates c) -> bool {
+    return isInRange(c) && (!limitFov || getConeDistance(c) <= coneMargin);
+  };
+  auto isInView = [&](Coordinates c) -> bool {
+    return isInRange(c) && (!limitFov || getConeDistance(c) == 0);
+  };
+
+  // neighbours in the same order as getNeighbours, bounded by box
+  auto forNeighbours = [&](Coordinates c, auto && fn) -> void {
+    for (int x = std::max(c.x - 1, boxBegin.x); x <= std::min(c.x + 1, boxEnd.x - 1);
+         ++x) {
+      for (int y = std::max(c.y - 1, boxBegin.y);
+           y <= std::min(c.y + 1, boxEnd.y - 1); ++y) {
+        if (x != c.x || y != c.y) {
+          fn(Coordinates{x, y});
+        }
+      }
+    }
+  };
 
   std::queue<Coordinates> queue;
 
   auto addNeighboursQV = [&](Coordinates c) -> void {
-    for (const auto & neigh : getNeighbours(dim, c)) {
-      auto & infoVN = infoV[neigh.x][neigh.y];
-      if (infoVN == -2) {
+    forNeighbours(c, [&](Coordinates neigh) {
+      auto & infoVN = info(neigh);
+      if (infoVN == -2 && isSearched(neigh)) {
         queue.push(neigh);
         infoVN = -1;
       }
-    }
+    });
   };
 
   auto addSubjectsRes = [&](Coordinates c) -> void {
@@ -54,10 +127,10 @@ std::list<PCoordPlain> getVisibleSubjectsGen(const BaseCamera & camera,
   // process camera cell
   {
     double cellPower = getResidualPower(cameraCoords, cameraPower, camera);
-    infoV[cameraCoords.x][cameraCoords.y] = cellPower;
+    info(cameraCoords) = cellPower;
     if (isCellFit(cellPower, camera)) {
       addNeighboursQV(cameraCoords);
-      if (filterCell(cameraCoords, camera)) {
+      if (filterCell(cameraCoords, camera) && isInView(cameraCoords)) {
         addSubjectsRes(cameraCoords);
       }
     }
@@ -67,14 +140,17 @@ std::list<PCoordPlain> getVisibleSubjectsGen(const BaseCamera & camera,
     Coordinates u = queue.front();
     queue.pop();
 
-    auto uNeighs = getNeighbours(dim, u);
     auto v_ucam = getVector(u, cameraCoords);
 
+    // processed neighbour towards camera, one which queued u is always there
     Coordinates best_n;
-    auto best_sm = -1;
+    auto best_sm = std::numeric_limits<int>::min();
     auto best_d_un = 0;
 
-    for (const auto & n : uNeighs) {
+    forNeighbours(u, [&](Coordinates n) {
+      if (info(n) < 0) {
+        return;
+      }
       auto v_un = getVector(u, n);
       auto sm_n = getScalarMultiplication(v_ucam, v_un);
       auto d_un = getDistanceSquare(v_un);
@@ -84,13 +160,13 @@ std::list<PCoordPlain> getVisibleSubjectsGen(const BaseCamera & camera,
         best_sm = sm_n;
         best_d_un = d_un;
       }
-    }
+    });
 
-    double uResPower = getResidualPower(u, infoV[best_n.x][best_n.y], camera);
-    infoV[u.x][u.y] = uResPower;
+    double uResPower = getResidualPower(u, info(best_n), camera);
+    info(u) = uResPower;
     if (isCellFit(uResPower, camera)) {
       addNeighboursQV(u);
-      if (filterCell(u, camera)) {
+      if (filterCell(u, camera) && isInView(u)) {
         addSubjectsRes(u);
       }
     }
@@ -99,6 +175,15 @@ std::list<PCoordPlain> getVisibleSubjectsGen(const BaseCamera & camera,
   return result;
 }
 
+const std::vector<BaseCamera::VisibleSubject> & BaseCamera::getVisible() const {
+  std::call_once(visible_->filled, [this] {
+    for (const auto & [coord, sub] : getVisibleSubjects()) {
+      visible_->subjects.push_back(VisibleSubject{coord, sub.getId()});
+    }
+  });
+  return visible_->subjects;
+}
+
 std::list<PCoordPlain> InfraredCamera::getVisibleSubjects() const {
 
   auto isCellFit = [](double cellPower, const BaseCamera & baseCamera) -> bool {
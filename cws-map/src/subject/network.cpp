@@ -37,4 +37,31 @@ void WirelessNetworkDevice::placeNetworkContainers(
   }
 }
 
+std::list<std::unique_ptr<Container>>
+WiredNetworkDevice::collectNetworkContainers(Network::Type type) const {
+  std::list<std::unique_ptr<Container>> result;
+
+  if (type == Network::Type::WIRED) {
+    for (const auto & packet : transmitPackets_) {
+      result.push_back(std::make_unique<WiredContainer>(
+          std::unique_ptr<Packet>(packet->clone()), getId()));
+    }
+  }
+
+  return result;
+}
+
+void WiredNetworkDevice::placeNetworkContainers(
+    const std::list<std::unique_ptr<Container>> & containerList, Network::Type type) {
+
+  if (type == Network::Type::WIRED) {
+    for (const auto & container : containerList) {
+      auto wired = static_cast<const WiredContainer *>(container.get());
+      if (wired->getDestination() == getId()) {
+        receivedPackets_.push_back(std::unique_ptr<Packet>(wired->getPacket()->clone()));
+      }
+    }
+  }
+}
+
 };// namespace Subject
@@ -1,4 +1,5 @@
 #include "gtest/gtest.h"
+#include <limits>
 
 #include "cws/map_layer/air.hpp"
 #include "cws/map_layer/subject.hpp"
@@ -18,6 +19,14 @@ TEST(AirPlain, OperatorAdd) {
   ASSERT_EQ(exp.getHeatCapacity(), res.getHeatCapacity());
   ASSERT_EQ(exp.getTemperature().value, res.getTemperature().value);
   ASSERT_EQ(exp.getCurLightObstruction().value, res.getCurLightObstruction().value);
+
+  // heat capacity of the same air is kept by many small flows in and out
+  Plain air(Physical(1.2, 1005, {20}), 0, 0.3);
+  for (int i = 0; i < 1000; ++i) {
+    air = air + Plain(Physical(0.00317, 1005, {20}), 0, 0.3);
+    air = air + Plain(Physical(-0.00317, 1005, {20}), 0, 0.3);
+  }
+  ASSERT_EQ(1005, air.getHeatCapacity());
 }
 
 TEST(AirContainer, addRemoveEraseUSE) {
@@ -337,3 +346,202 @@ TEST(MapLayerAir, nextCirculation) {
     curLayerAir = MapLayerAir(nextLayerAir);
   }
 }
+
+TEST(MapLayerAir, regionSpans) {
+  Dimension dim{6, 4};
+
+  // clipped by map
+  auto spans = getCellSpans(CellRegion{{4, -1}, {5, 3}}, dim);
+  ASSERT_EQ(2, spans.size());
+  EXPECT_EQ(4, spans[0].x);
+  EXPECT_EQ(0, spans[0].yBegin);
+  EXPECT_EQ(2, spans[0].yEnd);
+  EXPECT_EQ(5, spans[1].x);
+
+  // cells with centers on shared hypotenuse belong to the lower triangle only
+  CellRegion triangle{.polygon = {{0, 0}, {4, 0}, {0, 4}}};
+  std::size_t cells = 0;
+  for (const auto & span : getCellSpans(triangle, dim)) {
+    EXPECT_LT(span.x + span.yBegin, 4);
+    cells += span.yEnd - span.yBegin;
+  }
+  EXPECT_EQ(6, cells);
+
+  CellRegion lower{.polygon = {{4, 0}, {4, 4}, {0, 4}}};
+  for (const auto & span : getCellSpans(lower, dim)) {
+    cells += span.yEnd - span.yBegin;
+  }
+  EXPECT_EQ(16, cells);
+
+  // ends out of range of int are clipped
+  constexpr int maxInt = std::numeric_limits<int>::max();
+  constexpr int minInt = std::numeric_limits<int>::min();
+  spans = getCellSpans(CellRegion{{2, 1}, {maxInt, maxInt}}, dim);
+  ASSERT_EQ(4, spans.size());
+  EXPECT_EQ(4, spans[0].yEnd);
+  CellRegion huge;
+  huge.polygon = {
+      {minInt, minInt}, {maxInt, minInt}, {maxInt, maxInt}, {minInt, maxInt}};
+  cells = 0;
+  for (const auto & span : getCellSpans(huge, dim)) {
+    cells += span.yEnd - span.yBegin;
+  }
+  EXPECT_EQ(24, cells);
+}
+
+TEST(MapLayerAir, regionFillScaleTemperature) {
+  MapLayerAir layer({4, 4});
+  auto spans = getCellSpans(CellRegion{{1, 1}, {2, 3}}, {4, 4});
+
+  Air::Plain air(Physical(1.2, 1005, Temperature{20}), 0, 0.3);
+  layer.fill(spans, air);
+  layer.fill(spans, air);
+  EXPECT_TRUE(layer.getAirContainer({0, 0}).empty());
+  ASSERT_EQ(1, layer.getAirContainer({2, 3}).getList().size());
+  EXPECT_DOUBLE_EQ(2.4, layer.getAirContainer({2, 3}).getWeight());
+
+  layer.scaleWeight(spans, 0.5);
+  EXPECT_DOUBLE_EQ(1.2, layer.getAirContainer({1, 1}).getWeight());
+  EXPECT_DOUBLE_EQ(20, layer.getAirContainer({1, 1}).getTemperature().get());
+
+  layer.setTemperature(spans, Temperature{25});
+  EXPECT_DOUBLE_EQ(25, layer.getAirContainer({2, 2}).getTemperature().get());
+
+  layer.scaleWeight(spans, 0);
+  EXPECT_TRUE(layer.getAirContainer({1, 1}).empty());
+}
+
+static double getTotalWeight(const MapLayerAir & layer) {
+  double weight = 0;
+  Dimension dim = layer.getDimension();
+  Coordinates c;
+  for (c.x = 0; c.x < dim.width; ++c.x) {
+    for (c.y = 0; c.y < dim.height; ++c.y) {
+      weight += layer.getAirContainer(c).getWeight();
+    }
+  }
+  return weight;
+}
+
+TEST(MapLayerAir, adaptiveStepping) {
+  Dimension dim{6, 6};
+  MapLayerObstruction obstruction(dim);
+  MapLayerAir layer(dim);
+  layer.fill(getCellSpans(CellRegion{{0, 0}, dim}, dim),
+             Air::Plain(Physical(1.2, 1005, Temperature{20}), 0, 0.3));
+
+  // next state is computed from current one
+  auto nextTick = [&] {
+    MapLayerAir cur(layer);
+    layer.nextCirculation(cur, obstruction);
+  };
+
+  nextTick();
+  EXPECT_EQ(1, layer.getSubsteps());
+
+  // equilibrium is found by steps after air was filled, time of ticks skipped then
+  // is stepped at once
+  layer.setStepping(
+      AirStepping{.adaptive = true, .maxSubsteps = 8, .maxSkippedTicks = 4});
+  for (int tick = 0; tick < 2; ++tick) {
+    nextTick();
+    EXPECT_EQ(1, layer.getSubsteps());
+  }
+  for (int tick = 1; tick < 4; ++tick) {
+    nextTick();
+    EXPECT_EQ(0, layer.getSubsteps());
+  }
+  nextTick();
+  EXPECT_LT(0, layer.getSubsteps());
+
+  // hot heavy air is spread by sub-steps without overshoot
+  layer.accessAirContainer({0, 0}).add(
+      std::make_unique<Air::Plain>(Physical(120, 1005, Temperature{80}), 0, 0.3));
+  double total = getTotalWeight(layer);
+  nextTick();
+  EXPECT_LT(1, layer.getSubsteps());
+  EXPECT_NEAR(total, getTotalWeight(layer), total * 1e-9);
+  EXPECT_GT(layer.getAirContainer({0, 0}).getTemperature().get(),
+            layer.getAirContainer({1, 0}).getTemperature().get());
+  EXPECT_GT(layer.getAirContainer({1, 0}).getTemperature().get(), 20);
+}
+
+TEST(MapLayerAir, sleepingTiles) {
+  Dimension dim{20, 8};
+  MapLayerObstruction obstruction(dim);
+  MapLayerSubject subjects(dim);
+  MapLayerAir layer(dim);
+  layer.fill(getCellSpans(CellRegion{{0, 0}, dim}, dim),
+             Air::Plain(Physical(1.2, 1005, Temperature{20}), 0, 0.3));
+  EXPECT_THROW(layer.setSleeping(AirSleeping{.enabled = true, .tileSize = 0}),
+               std::invalid_argument);
+  layer.setSleeping(AirSleeping{.enabled = true, .tileSize = 8, .calmTicks = 2});
+  ASSERT_EQ(3, layer.getActiveTiles());
+
+  auto nextTick = [&](const MapLayerObstruction & curObstruction) {
+    MapLayerAir cur(layer);
+    layer.nextConvection(subjects);
+    layer.wakeObstructed(curObstruction, obstruction);
+    layer.nextCirculation(cur, obstruction);
+  };
+
+  // air at equilibrium falls asleep after calm ticks
+  nextTick(obstruction);
+  EXPECT_EQ(0, layer.getSleepingTiles());
+  nextTick(obstruction);
+  EXPECT_EQ(3, layer.getSleepingTiles());
+
+  // air written to cell wakes its tile only, heat reaches neighbour over border
+  layer.accessAirContainer({6, 4}).setTemperature(Temperature{40});
+  EXPECT_FALSE(layer.isSleeping({6, 4}));
+  nextTick(obstruction);
+  EXPECT_EQ(1, layer.getActiveTiles());
+  for (int tick = 0; tick < 4; ++tick) {
+    nextTick(obstruction);
+  }
+  EXPECT_FALSE(layer.isSleeping({8, 4}));
+  EXPECT_GT(layer.getAirContainer({8, 4}).getTemperature().get(), 20);
+  EXPECT_TRUE(layer.isSleeping({19, 4}));
+  EXPECT_EQ(20, layer.getAirContainer({19, 4}).getTemperature().get());
+
+  // changed obstruction and hot subject wake sleeping tile
+  MapLayerObstruction curObstruction(obstruction);
+  obstruction.setAirObstruction({18, 1}, Obstruction{0.5});
+  nextTick(curObstruction);
+  EXPECT_FALSE(layer.isSleeping({19, 4}));
+  for (int tick = 0; tick < 2; ++tick) {
+    nextTick(obstruction);
+  }
+  ASSERT_TRUE(layer.isSleeping({19, 4}));
+
+  subjects.accessCell({17, 2}).accessElement().accessSubjectList().emplace_back(
+      std::make_unique<Subject::Plain>(Physical(10, 1000, {60}, {}), 1, 10,
+                                       Obstruction{}));
+  nextTick(obstruction);
+  EXPECT_FALSE(layer.isSleeping({19, 4}));
+  EXPECT_GT(layer.getAirContainer({17, 2}).getTemperature().get(), 20);
+
+  // colder cell wakes neighbours as hotter one does, air follows layer without tiles
+  subjects.accessCell({17, 2}).accessElement().accessSubjectList().clear();
+  MapLayerAir awake(dim);
+  awake.fill(getCellSpans(CellRegion{{0, 0}, dim}, dim),
+             Air::Plain(Physical(1.2, 1005, Temperature{20}), 0, 0.3));
+  layer = MapLayerAir(awake);
+  layer.setSleeping(AirSleeping{.enabled = true, .tileSize = 8, .calmTicks = 2});
+  for (int tick = 0; tick < 2; ++tick) {
+    nextTick(obstruction);
+  }
+  ASSERT_EQ(3, layer.getSleepingTiles());
+
+  awake.accessAirContainer({6, 4}).setTemperature(Temperature{0});
+  layer.accessAirContainer({6, 4}).setTemperature(Temperature{0});
+  for (int tick = 0; tick < 200; ++tick) {
+    MapLayerAir cur(awake);
+    awake.nextConvection(subjects);
+    awake.nextCirculation(cur, obstruction);
+    nextTick(obstruction);
+  }
+  double temp = awake.getAirContainer({8, 4}).getTemperature().get();
+  EXPECT_LT(temp, 19.9);
+  EXPECT_NEAR(temp, layer.getAirContainer({8, 4}).getTemperature().get(), 0.05);
+}
@@ -0,0 +1,222 @@
+#include "gtest/gtest.h"
+
+#include "cws/scenario/scenario.hpp"
+#include "cws/simulation/building.hpp"
+#include "cws/simulation/callback.hpp"
+#include "cws/subject/network.hpp"
+#include <sstream>
+
+static SimulationMap readFloor(const std::string & text) {
+  std::istringstream in(text);
+  auto scenario = readScenario(in);
+  SimulationMap floor(scenario.getDimension());
+  scenario.apply(floor, 0);
+  return floor;
+}
+
+static double getTotalWeight(const SimulationMap & floor) {
+  double weight = 0;
+  Dimension dim = floor.getDimension();
+  Coordinates c;
+  for (c.x = 0; c.x < dim.width; ++c.x) {
+    for (c.y = 0; c.y < dim.height; ++c.y) {
+      weight += floor.getLayers().airLayer.getAirContainer(c).getWeight();
+    }
+  }
+  return weight;
+}
+
+// next state is computed from current one and becomes current
+static void nextTick(Building & building) {
+  Building cur(building);
+  building.next(cur, 2);
+}
+
+TEST(Building, portalChecked) {
+  Building building;
+  building.addFloor(SimulationMap({4, 4}));
+  building.addFloor(SimulationMap({2, 2}));
+
+  EXPECT_THROW(building.addPortal(Portal{0, {1, 1}, 2, {1, 1}, 0.5}),
+               std::invalid_argument);
+  EXPECT_THROW(building.addPortal(Portal{0, {1, 1}, 0, {2, 2}, 0.5}),
+               std::invalid_argument);
+  EXPECT_THROW(building.addPortal(Portal{0, {3, 3}, 1, {3, 3}, 0.5}),
+               std::invalid_argument);
+  EXPECT_THROW(building.addPortal(Portal{0, {1, 1}, 1, {1, 1}, 1.5}),
+               std::invalid_argument);
+  building.addPortal(Portal{0, {3, 3}, 1, {1, 1}, 0.5});
+  EXPECT_EQ(1, building.getPortals().size());
+
+  Building other;
+  other.addFloor(SimulationMap({4, 4}));
+  EXPECT_THROW(building.next(other), std::invalid_argument);
+}
+
+TEST(Building, portalAir) {
+  Building building;
+  building.addFloor(readFloor("dimension 3 3\n"
+                              "air x=1 y=1 idx=0 weight=10 heat_capacity=1000 "
+                              "temp=40 transfer=0.3\n"));
+  building.addFloor(readFloor("dimension 3 3\n"
+                              "air x=2 y=2 idx=0 weight=4 heat_capacity=1000 "
+                              "temp=20 transfer=0.3\n"));
+  building.addPortal(Portal{0, {1, 1}, 1, {1, 1}, 0.5});
+
+  double total = getTotalWeight(building.getFloor(0)) +
+                 getTotalWeight(building.getFloor(1));
+  for (int tick = 0; tick < 5; ++tick) {
+    nextTick(building);
+  }
+
+  // air came up through portal and is warmer than air of upper floor
+  const auto & upper = building.getFloor(1).getLayers().airLayer;
+  EXPECT_GT(upper.getAirContainer({1, 1}).getWeight(), 0);
+  EXPECT_GT(upper.getAirContainer({1, 1}).getTemperature().get(), 20);
+  EXPECT_NEAR(total,
+              getTotalWeight(building.getFloor(0)) +
+                  getTotalWeight(building.getFloor(1)),
+              total * 1e-6);
+}
+
+TEST(Building, portalLight) {
+  Building building;
+  building.addFloor(readFloor("dimension 4 4\n"
+                              "subject light_emitter x=0 y=0 idx=1 weight=1 "
+                              "heat_capacity=400 temp=20 illumination=300\n"));
+  building.addFloor(readFloor("dimension 4 4\n"));
+  building.addPortal(Portal{0, {3, 3}, 1, {2, 2}, 0, 0.5});
+
+  nextTick(building);
+  const auto & lower = building.getFloor(0).getLayers().illuminationLayer;
+  const auto & upper = building.getFloor(1).getLayers().illuminationLayer;
+  auto lowerPortal = lower.getIllumination({3, 3});
+  ASSERT_GT(lowerPortal.get(), 0);
+  EXPECT_EQ(0, upper.getIllumination({2, 2}).get());
+
+  // spread from portal cell on next tick and not passed back
+  for (int tick = 0; tick < 3; ++tick) {
+    nextTick(building);
+    EXPECT_EQ(lowerPortal.get() / 2, upper.getIllumination({2, 2}).get());
+    EXPECT_GT(upper.getIllumination({0, 0}).get(), 0);
+    EXPECT_EQ(lowerPortal, lower.getIllumination({3, 3}));
+  }
+}
+
+TEST(Building, portalWireless) {
+  Building building;
+  building.addFloor(readFloor("dimension 4 4\n"
+                              "subject wireless_network_device x=0 y=0 idx=1 "
+                              "transmit_power=100\n"));
+  building.addFloor(readFloor("dimension 4 4\n"
+                              "subject wireless_network_device x=3 y=3 idx=2\n"));
+  building.addPortal(Portal{0, {1, 1}, 1, {1, 1}, 0, 0, 0.5});
+
+  const Subject::Id lowerId{Subject::Type::WIRELESS_NETWORK_DEVICE, 1};
+  const Subject::Id upperId{Subject::Type::WIRELESS_NETWORK_DEVICE, 2};
+  auto getReceived = [&](std::size_t floor, Subject::Id id) {
+    auto subject = building.getFloor(floor).select(id);
+    return static_cast<const Subject::NetworkDevice *>(subject)
+        ->getReceivedPackets()
+        .size();
+  };
+
+  PacketList packets;
+  packets.push_back(std::make_unique<Network::Packet>(std::vector<std::byte>(4)));
+  building.accessFloor(0).modify(SubjectCallbackQuery<PacketList>(
+      SubjectSelectQuery({0, 0}, lowerId), addPacketToTransmitQueue,
+      std::move(packets)));
+
+  nextTick(building);
+  EXPECT_EQ(1, getReceived(0, lowerId));
+  EXPECT_EQ(0, getReceived(1, upperId));
+
+  // relayed on next tick only once
+  nextTick(building);
+  EXPECT_EQ(0, getReceived(0, lowerId));
+  EXPECT_EQ(1, getReceived(1, upperId));
+
+  nextTick(building);
+  EXPECT_EQ(0, getReceived(0, lowerId));
+  EXPECT_EQ(0, getReceived(1, upperId));
+}
+
+TEST(Building, scenarioFloors) {
+  std::istringstream in("dimension 3 3\n"
+                        "air x=1 y=1 idx=0 weight=10 heat_capacity=1000 temp=40 "
+                        "transfer=0.3\n"
+                        "floor\n"
+                        "air x=2 y=2 idx=0 weight=4 heat_capacity=1000 temp=20 "
+                        "transfer=0.3\n"
+                        "@2 air x=0 y=0 idx=1 weight=1 heat_capacity=1000 temp=20 "
+                        "transfer=0.3\n"
+                        "portal lower=0:1:1 upper=1:1:1 air=0.5\n");
+  auto scenario = readScenario(in);
+  ASSERT_EQ(2, scenario.getFloorCount());
+  EXPECT_EQ(1, scenario.getEvents(0).size());
+  EXPECT_EQ(2, scenario.getEvents(1).size());
+  ASSERT_EQ(1, scenario.getPortals().size());
+
+  auto building = scenario.makeBuilding();
+  ASSERT_EQ(2, building.getFloorCount());
+  for (std::size_t tick = 0; tick < 2; ++tick) {
+    scenario.apply(building, tick);
+    nextTick(building);
+  }
+
+  // event of floor 1 is applied to it only
+  scenario.apply(building, 2);
+  AirSelectQuery added({0, 0}, {Air::Type::PLAIN, 1});
+  EXPECT_EQ(nullptr, building.getFloor(0).select(added));
+  EXPECT_NE(nullptr, building.getFloor(1).select(added));
+  nextTick(building);
+
+  // air of floor 0 came up through portal
+  const auto & upper = building.getFloor(1).getLayers().airLayer;
+  EXPECT_GT(upper.getAirContainer({1, 1}).getTemperature().get(), 20);
+  EXPECT_NEAR(15,
+              getTotalWeight(building.getFloor(0)) +
+                  getTotalWeight(building.getFloor(1)),
+              1e-6);
+
+  auto read = [](const std::string & text) {
+    std::istringstream in(text);
+    return readScenario(in);
+  };
+  // floors of portal should be declared before it
+  EXPECT_THROW(read("dimension 3 3\nportal lower=0:1:1 upper=1:1:1\n"),
+               std::invalid_argument);
+  EXPECT_THROW(read("dimension 3 3\nfloor\nportal lower=0:1:1 upper=1:3:1\n"),
+               std::invalid_argument);
+  EXPECT_THROW(read("dimension 3 3\nfloor\nportal lower=0:1 upper=1:1:1\n"),
+               std::invalid_argument);
+  EXPECT_THROW(read("dimension 3 3\nfloor\nportal lower=0:1:1 upper=1:1:1 air=2\n"),
+               std::invalid_argument);
+  EXPECT_THROW(read("dimension 3 3\n@1 floor\n"), std::invalid_argument);
+}
+
+TEST(Building, workersKeptBetweenLoops) {
+  ParallelWorkers workers(3);
+  EXPECT_EQ(3, workers.getThreadCount());
+
+  std::vector<std::atomic<int>> counts(50);
+  for (int loop = 0; loop < 20; ++loop) {
+    workers.run(counts.size(), [&](std::size_t i) { ++counts[i]; });
+  }
+  for (const auto & count : counts) {
+    EXPECT_EQ(20, count);
+  }
+
+  // other tasks of loop are run, error is passed to caller
+  std::atomic<int> done = 0;
+  EXPECT_THROW(workers.run(10,
+                           [&](std::size_t i) {
+                             if (i == 3) {
+                               throw std::runtime_error("task");
+                             }
+                             ++done;
+                           }),
+               std::runtime_error);
+  EXPECT_EQ(9, done);
+  workers.run(0, [](std::size_t) {});
+}
@@ -0,0 +1,41 @@
+#include "cws/log.hpp"
+#include "gtest/gtest.h"
+
+#include <sstream>
+
+using namespace Log;
+
+TEST(Log, writeRecords) {
+  std::ostringstream out;
+  {
+    Logger logger(out, 16);
+
+    RecordStream stream(Level::INFO, "test");
+    stream << "tick " << 42 << " \"done\"";
+    ASSERT_TRUE(logger.push(stream.getRecord()));
+
+    logger.flush();
+  }
+
+  std::string line = out.str();
+  ASSERT_EQ(0, line.find("time="));
+  ASSERT_NE(std::string::npos,
+            line.find(" level=info source=test msg=\"tick 42 \\\"done\\\"\"\n"));
+}
+
+TEST(Log, cutLongMessage) {
+  RecordStream stream(Level::DEBUG, "test");
+  stream << std::string(MESSAGE_SIZE * 2, 'a');
+
+  const auto & record = stream.getRecord();
+  ASSERT_EQ(MESSAGE_SIZE, record.length);
+}
+
+TEST(Log, level) {
+  std::ostringstream out;
+  Logger logger(out);
+
+  logger.setLevel(Level::WARN);
+  ASSERT_FALSE(logger.isEnabled(Level::INFO));
+  ASSERT_TRUE(logger.isEnabled(Level::ERROR));
+}
@@ -2,6 +2,7 @@
 #include "cws/common.hpp"
 #include "cws/map_layer/network.hpp"
 #include "cws/map_layer/obstruction.hpp"
+#include "cws/simulation/simulation_map.hpp"
 #include "gtest/gtest.h"
 
 TEST(MapLayersNetworkWireless, updateNetworkUSE) {
@@ -72,3 +73,189 @@ TEST(MapLayersNetworkWireless, updateNetworkUSE) {
     std::cout << s << std::endl;
   }
 }
+
+TEST(MapLayersNetworkWireless, updateNetworkSeveralTransmitters) {
+  using namespace Subject;
+
+  Dimension dim{8, 8};
+
+  MapLayerObstruction obstruction(dim);
+  MapLayerSubject layerSubject(dim);
+
+  auto addDevice = [&](Coordinates c, int idx) {
+    auto device = new WirelessNetworkDevice(Plain({}, idx, 10, {}), 100, 20);
+    layerSubject.accessSubjectList(c).emplace_back(device);
+    return device;
+  };
+
+  auto transmitter1 = addDevice({0, 0}, 1);
+  auto transmitter2 = addDevice({7, 7}, 2);
+  auto transmitter3 = addDevice({0, 7}, 3);
+  auto receiver = addDevice({5, 2}, 4);
+
+  for (auto transmitter : {transmitter1, transmitter2, transmitter3}) {
+    std::list<std::unique_ptr<Network::Packet>> packetList;
+    packetList.push_back(std::make_unique<Network::Packet>(std::vector<std::byte>(4)));
+    transmitter->transmitPackets(std::move(packetList));
+  }
+
+  MapLayerNetworkWireless wirelessNetwork(dim);
+  wirelessNetwork.clearNetwork();
+  wirelessNetwork.collectTransmittableContainers(layerSubject);
+  wirelessNetwork.updateNetwork(obstruction);
+  layerSubject.receiveContainers(wirelessNetwork);
+
+  // each packet is received once
+  ASSERT_EQ(3, receiver->getReceivedPackets().size());
+  const auto & constNetwork = wirelessNetwork;
+  ASSERT_EQ(3, constNetwork.getReceivableContainers({3, 4}).size());
+}
+
+TEST(MapLayersNetworkWireless, payloadShared) {
+  using namespace Subject;
+
+  Dimension dim{4, 4};
+
+  MapLayerObstruction obstruction(dim);
+  MapLayerSubject layerSubject(dim);
+
+  auto transmitter = new WirelessNetworkDevice(Plain({}, 1, 10, {}), 100, 20);
+  auto receiver = new WirelessNetworkDevice(Plain({}, 2, 10, {}), 100, 20);
+  layerSubject.accessSubjectList({0, 0}).emplace_back(transmitter);
+  layerSubject.accessSubjectList({3, 3}).emplace_back(receiver);
+
+  auto payload = std::make_shared<const Network::Packet::Payload>(16);
+  std::list<std::unique_ptr<Network::Packet>> packetList;
+  packetList.push_back(std::make_unique<Network::Packet>(payload));
+  transmitter->transmitPackets(std::move(packetList));
+
+  MapLayerNetworkWireless wirelessNetwork(dim);
+  wirelessNetwork.clearNetwork();
+  wirelessNetwork.collectTransmittableContainers(layerSubject);
+  wirelessNetwork.updateNetwork(obstruction);
+  layerSubject.receiveContainers(wirelessNetwork);
+
+  ASSERT_EQ(1, receiver->getReceivedPackets().size());
+  EXPECT_EQ(payload, receiver->getReceivedPackets().front()->getPayload());
+
+  // copy of map refers to the same content
+  MapLayerSubject copy(layerSubject);
+  auto receiverCopy =
+      static_cast<const NetworkDevice *>(copy.getSubjectList({3, 3}).begin()->get());
+  EXPECT_EQ(payload, receiverCopy->getReceivedPackets().front()->getPayload());
+}
+
+TEST(MapLayersNetworkWired, routesThroughSwitch) {
+  using namespace Subject;
+
+  Dimension dim{4, 4};
+
+  MapLayerObstruction obstruction(dim);
+  MapLayerSubject layerSubject(dim);
+
+  auto addDevice = [&](Coordinates c, int idx) {
+    auto device = new WiredNetworkDevice(Plain({}, idx, 10, {}));
+    layerSubject.accessSubjectList(c).emplace_back(device);
+    return device;
+  };
+
+  auto sender = addDevice({0, 0}, 1);
+  auto receiver = addDevice({3, 3}, 2);
+  auto unplugged = addDevice({3, 3}, 3);
+  auto switchPlain = std::make_unique<Plain>(Physical(), 4, 0, Obstruction{});
+  auto switchId = switchPlain->getId();
+  layerSubject.accessSubjectList({2, 2}).push_back(std::move(switchPlain));
+
+  // cells of devices are kept by SimulationMap on map
+  MapLayerNetworkWired wiredNetwork(dim);
+  wiredNetwork.addDevice(sender->getId(), {0, 0});
+  wiredNetwork.addDevice(receiver->getId(), {3, 3});
+  wiredNetwork.addDevice(unplugged->getId(), {3, 3});
+  wiredNetwork.addDevice(switchId, {2, 2});
+  ASSERT_TRUE(wiredNetwork.connect(sender->getId(), switchId));
+  ASSERT_TRUE(wiredNetwork.connect(switchId, receiver->getId()));
+  ASSERT_FALSE(wiredNetwork.connect(receiver->getId(), switchId));
+
+  auto tick = [&]() {
+    std::list<std::unique_ptr<Network::Packet>> packetList;
+    packetList.push_back(std::make_unique<Network::Packet>(std::vector<std::byte>(4)));
+    sender->transmitPackets(std::move(packetList));
+
+    wiredNetwork.clearNetwork();
+    wiredNetwork.collectTransmittableContainers(layerSubject);
+    wiredNetwork.updateNetwork(obstruction);
+    layerSubject.clearNetworkBuffers();
+    layerSubject.receiveContainers(wiredNetwork);
+  };
+
+  tick();
+  EXPECT_EQ(1, receiver->getReceivedPackets().size());
+  EXPECT_EQ(0, unplugged->getReceivedPackets().size());
+  EXPECT_EQ(0, sender->getReceivedPackets().size());
+
+  const auto & routes = wiredNetwork.getRoutes(sender->getId());
+  ASSERT_EQ(2, routes.size());
+  EXPECT_EQ(receiver->getId(), routes.back().destination);
+  EXPECT_EQ(2, routes.back().hops);
+
+  // copy shares routes until its cables change
+  MapLayerNetworkWired copy(wiredNetwork);
+  EXPECT_EQ(&routes, &copy.getRoutes(sender->getId()));
+  ASSERT_TRUE(copy.disconnect(sender->getId(), switchId));
+  copy.updateNetwork(obstruction);
+  EXPECT_TRUE(copy.getRoutes(sender->getId()).empty());
+  EXPECT_EQ(2, wiredNetwork.getRoutes(sender->getId()).size());
+
+  // routes are rebuilt after cable is removed
+  ASSERT_TRUE(wiredNetwork.disconnect(receiver->getId(), switchId));
+  tick();
+  EXPECT_EQ(0, receiver->getReceivedPackets().size());
+  const auto & constNetwork = wiredNetwork;
+  EXPECT_TRUE(constNetwork.getReceivableContainers({3, 3}).empty());
+}
+
+TEST(MapLayersNetworkWired, devicesOfSimulationMap) {
+  using namespace Subject;
+
+  auto makeDevice = [](int idx, bool transmit) {
+    auto device = std::make_unique<WiredNetworkDevice>(Plain({}, idx, 10, {}));
+    if (transmit) {
+      std::list<std::unique_ptr<Network::Packet>> packetList;
+      packetList.push_back(
+          std::make_unique<Network::Packet>(std::vector<std::byte>(4)));
+      device->transmitPackets(std::move(packetList));
+    }
+    return device;
+  };
+  auto countReceived = [](const SimulationMap & map, int idx) {
+    auto device = static_cast<const NetworkDevice *>(
+        map.select(Id{Type::WIRED_NETWORK_DEVICE, idx}));
+    return device->getReceivedPackets().size();
+  };
+
+  SimulationMap map({4, 4});
+  map.modify(SubjectModifyQuery(INSERT, {0, 0}, makeDevice(1, true)));
+  map.modify(SubjectModifyQuery(INSERT, {3, 1}, makeDevice(2, false)));
+  map.modify(CableModifyQuery{CableModifyType::CONNECT,
+                              {Type::WIRED_NETWORK_DEVICE, 1},
+                              {Type::WIRED_NETWORK_DEVICE, 2}});
+
+  SimulationMap next(map);
+  next.next(map);
+  EXPECT_EQ(1, countReceived(next, 2));
+
+  // moved receiver is found in its new cell
+  next.modify(SubjectModifyQuery(DELETE, {3, 1}, makeDevice(2, false)));
+  next.modify(SubjectModifyQuery(INSERT, {2, 2}, makeDevice(2, false)));
+  next.modify(SubjectModifyQuery(UPDATE, {0, 0}, makeDevice(1, true)));
+  SimulationMap after(next);
+  after.next(next);
+  EXPECT_EQ(1, countReceived(after, 2));
+
+  after.modify(SubjectModifyQuery(DELETE, {2, 2}, makeDevice(2, false)));
+  after.modify(SubjectModifyQuery(UPDATE, {0, 0}, makeDevice(1, true)));
+  SimulationMap last(after);
+  last.next(after);
+  EXPECT_EQ(nullptr, last.select(Id{Type::WIRED_NETWORK_DEVICE, 2}));
+  EXPECT_TRUE(last.getLayers().networkWired.getReceiveCells().empty());
+}
@@ -0,0 +1,186 @@
+#include "gtest/gtest.h"
+
+#include "cws/scenario/generator.hpp"
+#include "cws/simulation/callback.hpp"
+#include "cws/simulation/partition.hpp"
+#include "cws/simulation/snapshot.hpp"
+#include "cws/subject/network.hpp"
+#include "cws/subject/turnable.hpp"
+#include <sstream>
+
+TEST(Partition, splitMap) {
+  auto rects = splitMap({10, 7}, 3, 2);
+  ASSERT_EQ(6, rects.size());
+
+  // every cell belongs to one rectangle
+  int cells = 0;
+  for (const auto & rect : rects) {
+    cells += rect.size.width * rect.size.height;
+    for (const auto & other : rects) {
+      if (&rect != &other) {
+        EXPECT_TRUE(rect.intersect(other).empty());
+      }
+    }
+  }
+  EXPECT_EQ(70, cells);
+  EXPECT_EQ(Coordinates({3, 0}), rects[1].origin);
+  EXPECT_EQ(4, rects[2].size.width);
+  EXPECT_EQ(4, rects[5].size.height);
+
+  auto halo = rects[0].expand(2, {10, 7});
+  EXPECT_EQ(Coordinates({0, 0}), halo.origin);
+  EXPECT_EQ(5, halo.size.width);
+  EXPECT_EQ(5, halo.size.height);
+
+  EXPECT_THROW(splitMap({10, 7}, 11, 1), std::invalid_argument);
+  EXPECT_THROW(splitMap({10, 7}, 1, 0), std::invalid_argument);
+}
+
+TEST(Partition, snapshotRegion) {
+  SimulationMap map({12, 12});
+  generateFloor(map, FloorParams{.seed = 5, .roomSize = 6});
+
+  auto cells = writeSnapshotRegion(map, {4, 2}, {5, 20});
+  std::span<const std::byte> data(reinterpret_cast<const std::byte *>(cells.data()),
+                                  cells.size());
+
+  SimulationMap copy({12, 12});
+  readSnapshotRegion(copy, {4, 2}, data);
+  EXPECT_EQ(writeSnapshotRegion(map, {4, 2}, {5, 10}),
+            writeSnapshotRegion(copy, {4, 2}, {5, 10}));
+  EXPECT_TRUE(copy.getLayers().subjectLayer.getSubjectList({3, 3}).empty());
+
+  // subjects of replaced cells are indexed again
+  readSnapshotRegion(copy, {4, 2}, data);
+  for (const auto & subject : map.getLayers().subjectLayer.getSubjectList({5, 5})) {
+    Coordinates c{-1, -1};
+    ASSERT_NE(nullptr, copy.select(subject->getId(), &c));
+  }
+
+  EXPECT_THROW(readSnapshotRegion(copy, {8, 2}, data), std::invalid_argument);
+}
+
+// subjects of type with their cells, x outer
+static std::vector<std::pair<Coordinates, Subject::Id>>
+findSubjects(const SimulationMap & map, Subject::Type type) {
+  std::vector<std::pair<Coordinates, Subject::Id>> found;
+  Dimension dim = map.getDimension();
+  Coordinates c;
+  for (c.x = 0; c.x < dim.width; ++c.x) {
+    for (c.y = 0; c.y < dim.height; ++c.y) {
+      for (const auto & subject : map.getLayers().subjectLayer.getSubjectList(c)) {
+        if (subject->getId().type == type) {
+          found.emplace_back(c, subject->getId());
+        }
+      }
+    }
+  }
+  return found;
+}
+
+static std::size_t getReceived(const SimulationMap & map, Coordinates c,
+                               const Subject::Id & id) {
+  Coordinates found = c;
+  auto device = dynamic_cast<const Subject::NetworkDevice *>(map.select(id, &found));
+  return device ? device->getReceivedPackets().size() : 0;
+}
+
+// workers are separate processes, so partitions are checked against one map. Lamps,
+// wireless devices and cameras are kept, light and signal cross partitions
+TEST(Partition, sameAsOneMap) {
+  SimulationMap map({24, 18});
+  generateFloor(map, FloorParams{.seed = 11, .roomSize = 6, .airKinds = 2});
+
+  PartitionedMap partitioned(map, PartitionOptions{.columns = 3, .rows = 2});
+  ASSERT_EQ(6, partitioned.getPartitionCount());
+
+  auto lamps = findSubjects(map, Subject::Type::TURNABLE_LIGHT_EMITTER);
+  auto devices = findSubjects(map, Subject::Type::WIRELESS_NETWORK_DEVICE);
+  ASSERT_FALSE(lamps.empty());
+  ASSERT_GE(devices.size(), 2);
+  auto [lampCell, lampId] = lamps.front();
+  auto [sourceCell, sourceId] = devices.front();
+  auto [receiverCell, receiverId] = devices.back();
+  // the other end of map
+  ASSERT_GE(receiverCell.x, 16);
+
+  // the same queries are applied to both before tick
+  auto modify = [&](auto & target, int tick) {
+    if (tick == 3) {
+      target.modify(SubjectCallbackQuery<Subject::TurnableStatus>(
+          SubjectSelectQuery(lampCell, lampId), setTurnableStatus,
+          Subject::TurnableStatus::OFF));
+      target.modify(SubjectModifyQuery(
+          SubjectModifyType::INSERT, {8, 6},
+          std::make_unique<Subject::Plain>(
+              Physical(10, 900, Temperature{40}, Obstruction{0.5}, Obstruction{0}), 700,
+              1, Obstruction{0.5})));
+      target.modify(AirRegionQuery{AirRegionModifyType::SET_TEMPERATURE,
+                                   CellRegion{{}, {}, {{6, 4}, {18, 7}, {10, 16}}},
+                                   nullptr,
+                                   1,
+                                   Temperature{30}});
+    }
+    if (tick == 5) {
+      PacketList packets;
+      packets.push_back(std::make_unique<Network::Packet>(std::vector<std::byte>(4)));
+      target.modify(SubjectCallbackQuery<PacketList>(
+          SubjectSelectQuery(sourceCell, sourceId), addPacketToTransmitQueue,
+          std::move(packets)));
+    }
+  };
+
+  SimulationMap curMap(map);
+  SimulationMap nextMap(map);
+  MapStageTimes times;
+  for (int tick = 0; tick < 6; ++tick) {
+    modify(nextMap, tick);
+    nextMap.next(curMap);
+    curMap = nextMap;
+    modify(partitioned, tick);
+    partitioned.next(&times);
+  }
+  EXPECT_GT(times.getTotal().count(), 0);
+
+  SimulationMap gathered(map);
+  partitioned.gather(gathered);
+
+  const auto & expected = curMap.getLayers();
+  const auto & result = gathered.getLayers();
+  Coordinates c;
+  for (c.x = 0; c.x < 24; ++c.x) {
+    for (c.y = 0; c.y < 18; ++c.y) {
+      const auto & expectedAir = expected.airLayer.getAirContainer(c);
+      const auto & resultAir = result.airLayer.getAirContainer(c);
+      ASSERT_EQ(expectedAir.getList().size(), resultAir.getList().size()) << c;
+      EXPECT_DOUBLE_EQ(expectedAir.getWeight(), resultAir.getWeight()) << c;
+      if (!expectedAir.empty()) {
+        EXPECT_DOUBLE_EQ(expectedAir.getTemperature().get(),
+                         resultAir.getTemperature().get())
+            << c;
+      }
+      EXPECT_EQ(expected.obstructionLayer.getAirObstruction(c).get(),
+                result.obstructionLayer.getAirObstruction(c).get())
+          << c;
+      EXPECT_EQ(expected.illuminationLayer.getIllumination(c).get(),
+                result.illuminationLayer.getIllumination(c).get())
+          << c;
+      EXPECT_EQ(expected.subjectLayer.getSubjectList(c).size(),
+                result.subjectLayer.getSubjectList(c).size())
+          << c;
+    }
+  }
+
+  // packet sent in the first partition is received in the last one
+  EXPECT_EQ(1, getReceived(curMap, receiverCell, receiverId));
+  EXPECT_EQ(1, getReceived(gathered, receiverCell, receiverId));
+
+  // loaded cells keep packets in buffers of devices
+  partitioned.load(gathered);
+  SimulationMap reloaded(map);
+  partitioned.gather(reloaded);
+  EXPECT_EQ(1, getReceived(reloaded, receiverCell, receiverId));
+  const auto & reloadedAir = reloaded.getLayers().airLayer;
+  EXPECT_EQ(result.airLayer.getAirContainer({10, 8}).getTemperature().get(),
+            reloadedAir.getAirContainer({10, 8}).getTemperature().get());
+}
@@ -0,0 +1,60 @@
+#include "cws/profiler.hpp"
+#include "gtest/gtest.h"
+
+#include <sstream>
+
+using namespace std::chrono;
+
+static MapStageTimes makeTimes(microseconds stageDuration) {
+  MapStageTimes times{};
+  auto start = MapStageTimes::Clock::now();
+  for (std::size_t i = 0; i < MAP_STAGE_COUNT; ++i) {
+    times.start[i] = start + stageDuration * i;
+    times.duration[i] = stageDuration;
+  }
+  return times;
+}
+
+TEST(TickProfiler, rollingWindow) {
+  TickProfiler profiler(4);
+
+  for (std::size_t tick = 0; tick < 6; ++tick) {
+    profiler.record(tick, makeTimes(microseconds(tick + 1)));
+  }
+
+  auto profile = profiler.getProfile();
+  ASSERT_EQ(4, profile.window);
+  ASSERT_EQ(5, profile.lastTick);
+
+  // ticks 2..5 are kept
+  const auto & stage = profile.stages[std::size_t(MapStage::AIR_CIRCULATION)];
+  ASSERT_EQ(4, stage.count);
+  ASSERT_EQ(microseconds(3), stage.min);
+  ASSERT_EQ(microseconds(6), stage.max);
+  ASSERT_EQ(microseconds(6), stage.p99);
+
+  std::size_t inHistogram = 0;
+  for (auto count : stage.histogram) {
+    inHistogram += count;
+  }
+  ASSERT_EQ(4, inHistogram);
+  // 3us is in [2, 4), 4..6us are in [4, 8)
+  ASSERT_EQ(1, stage.histogram[2]);
+  ASSERT_EQ(3, stage.histogram[3]);
+
+  ASSERT_EQ(microseconds(6 * MAP_STAGE_COUNT), profile.tick.max);
+}
+
+TEST(TickProfiler, chromeTrace) {
+  TickProfiler profiler(8);
+  profiler.record(7, makeTimes(microseconds(10)));
+
+  std::ostringstream out;
+  profiler.writeChromeTrace(out);
+  std::string trace = out.str();
+
+  ASSERT_EQ(0, trace.find("{\"traceEvents\":["));
+  ASSERT_NE(std::string::npos, trace.find("\"name\":\"air_circulation\""));
+  ASSERT_NE(std::string::npos, trace.find("\"args\":{\"tick\":7}"));
+  ASSERT_NE(std::string::npos, trace.find("\"dur\":10"));
+}
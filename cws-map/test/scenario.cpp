@@ -0,0 +1,160 @@
+#include "gtest/gtest.h"
+
+#include "cws/scenario/generator.hpp"
+#include "cws/scenario/scenario.hpp"
+#include "cws/subject/turnable.hpp"
+#include <sstream>
+
+TEST(Scenario, readApply) {
+  std::istringstream in(R"(
+    # comment
+    dimension 4 3
+    ticks 5
+    subject plain x=1 y=2 idx=7 weight=10 heat_capacity=400 temp=20
+    air x=0 y=0 idx=0 weight=10 heat_capacity=1000 temp=25 transfer=0.3
+    subject turnable x=3 y=0 idx=1 status=on off_light_obs=0.1
+    @2 turn turnable x=3 y=0 idx=1 status=off
+  )");
+
+  Scenario scenario = readScenario(in);
+
+  ASSERT_EQ(4, scenario.getDimension().width);
+  ASSERT_EQ(3, scenario.getDimension().height);
+  ASSERT_EQ(5, scenario.getTicks());
+  ASSERT_EQ(4, scenario.getEvents().size());
+
+  SimulationMap map(scenario.getDimension());
+  scenario.apply(map, 0);
+  const auto & cmap = map;
+
+  auto plain = cmap.select(SubjectSelectQuery({1, 2}, {Subject::Type::PLAIN, 7}));
+  ASSERT_NE(nullptr, plain);
+  EXPECT_EQ(20, plain->getTemperature().get());
+
+  auto air = cmap.select(AirSelectQuery({0, 0}, {Air::Type::PLAIN, 0}));
+  ASSERT_NE(nullptr, air);
+  EXPECT_EQ(25, air->getTemperature().get());
+
+  auto turnable = dynamic_cast<const Subject::Turnable *>(
+      cmap.select(SubjectSelectQuery({3, 0}, {Subject::Type::TURNABLE, 1})));
+  ASSERT_NE(nullptr, turnable);
+  EXPECT_EQ(Subject::TurnableStatus::ON, turnable->getStatus());
+
+  scenario.apply(map, 2);
+  EXPECT_EQ(Subject::TurnableStatus::OFF, turnable->getStatus());
+}
+
+TEST(Scenario, readErrors) {
+  auto read = [](const std::string & text) {
+    std::istringstream in(text);
+    return readScenario(in);
+  };
+
+  EXPECT_THROW(read(""), std::invalid_argument);
+  EXPECT_THROW(read("subject plain x=0 y=0 idx=0"), std::invalid_argument);
+  EXPECT_THROW(read("dimension 2 2\nsubject lamp x=0 y=0 idx=0"), std::invalid_argument);
+  EXPECT_THROW(read("dimension 2 2\nsubject plain x=2 y=0 idx=0"), std::invalid_argument);
+  EXPECT_THROW(read("dimension 2 2\nsubject plain x=0 y=0"), std::invalid_argument);
+  EXPECT_THROW(read("dimension 2 2\nair x=0 y=0 idx=0 wieght=1"), std::invalid_argument);
+}
+
+TEST(Scenario, readAirRegion) {
+  std::istringstream in(R"(
+    dimension 8 8
+    air_region fill x=0 y=0 width=8 height=4 idx=0 weight=1.2 heat_capacity=1005 temp=20
+    air_region fill polygon=0:4,8:4,8:8 idx=1 weight=1 heat_capacity=1005 temp=30
+    @1 air_region scale x=0 y=0 width=8 height=8 factor=2
+    @1 air_region temperature x=0 y=0 width=1 height=1 temp=15
+  )");
+  Scenario scenario = readScenario(in);
+  ASSERT_EQ(4, scenario.getEvents().size());
+
+  SimulationMap map(scenario.getDimension());
+  scenario.apply(map, 0);
+  const auto & cmap = map;
+  EXPECT_NE(nullptr, cmap.select(AirSelectQuery({7, 3}, {Air::Type::PLAIN, 0})));
+  EXPECT_NE(nullptr, cmap.select(AirSelectQuery({7, 5}, {Air::Type::PLAIN, 1})));
+  EXPECT_EQ(nullptr, cmap.select(AirSelectQuery({0, 7}, {Air::Type::PLAIN, 1})));
+
+  scenario.apply(map, 1);
+  auto air = cmap.select(AirSelectQuery({0, 0}, {Air::Type::PLAIN, 0}));
+  ASSERT_NE(nullptr, air);
+  EXPECT_DOUBLE_EQ(2.4, air->getWeight());
+  EXPECT_DOUBLE_EQ(15, air->getTemperature().get());
+
+  auto read = [](const std::string & text) {
+    std::istringstream in(text);
+    return readScenario(in);
+  };
+  EXPECT_THROW(read("dimension 2 2\nair_region fill x=0 y=0 width=0 height=1 idx=0"),
+               std::invalid_argument);
+  EXPECT_THROW(read("dimension 2 2\nair_region scale polygon=0:0,1:1 factor=2"),
+               std::invalid_argument);
+  EXPECT_THROW(read("dimension 2 2\nair_region move x=0 y=0 width=1 height=1"),
+               std::invalid_argument);
+}
+
+static std::vector<Subject::Id> collectSubjectIds(const SimulationMap & map) {
+  std::vector<Subject::Id> ids;
+  Dimension dim = map.getDimension();
+  Coordinates c;
+  for (c.x = 0; c.x < dim.width; ++c.x) {
+    for (c.y = 0; c.y < dim.height; ++c.y) {
+      for (const auto & sub : map.getLayers().subjectLayer.getSubjectList(c)) {
+        ids.push_back(sub->getId());
+      }
+    }
+  }
+  return ids;
+}
+
+TEST(Scenario, generateFloor) {
+  FloorParams params{.seed = 7, .roomSize = 6, .density = 0.3, .airKinds = 3};
+
+  SimulationMap map1({30, 20});
+  generateFloor(map1, params);
+
+  Scenario scenario({30, 20});
+  generateFloor(scenario, params);
+  SimulationMap map2({30, 20});
+  scenario.apply(map2, 0);
+
+  auto ids1 = collectSubjectIds(map1);
+  auto ids2 = collectSubjectIds(map2);
+  ASSERT_EQ(ids1.size(), ids2.size());
+  for (std::size_t i = 0; i < ids1.size(); ++i) {
+    ASSERT_EQ(ids1[i].type, ids2[i].type);
+    ASSERT_EQ(ids1[i].idx, ids2[i].idx);
+  }
+
+  const auto & layers = map1.getLayers();
+  // corner is a wall, first room cell has a heater and door is in the middle
+  EXPECT_EQ(Subject::Type::PLAIN,
+            layers.subjectLayer.getSubjectList({0, 0}).front()->getId().type);
+  EXPECT_EQ(Subject::Type::TURNABLE_TEMP_EMITTER,
+            layers.subjectLayer.getSubjectList({1, 1}).front()->getId().type);
+  EXPECT_EQ(Subject::Type::TURNABLE,
+            layers.subjectLayer.getSubjectList({6, 3}).front()->getId().type);
+
+  // every cell has air, rooms use different kinds
+  EXPECT_FALSE(layers.airLayer.getAirContainer({29, 19}).empty());
+  EXPECT_EQ(1, layers.airLayer.getAirContainer({7, 1}).getList().front()->getId().idx);
+
+  params.seed = 8;
+  SimulationMap map3({30, 20});
+  generateFloor(map3, params);
+  EXPECT_NE(ids1.size(), collectSubjectIds(map3).size());
+}
+
+TEST(Scenario, readGenerate) {
+  std::istringstream in(R"(
+    dimension 24 24
+    generate seed=3 room=8 lamps=3 density=0.2 air_kinds=2
+    @1 turn turnable_temp_emitter x=1 y=1 idx=1 status=off
+  )");
+  Scenario scenario = readScenario(in);
+  ASSERT_GT(scenario.getEvents().size(), 24 * 24);
+
+  std::istringstream bad("dimension 10 10\ngenerate room=1\n");
+  EXPECT_THROW(readScenario(bad), std::invalid_argument);
+}
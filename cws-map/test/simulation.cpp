@@ -2,8 +2,25 @@
 
 #include "cws/common.hpp"
 #include "cws/map.hpp"
+#include "cws/scenario/generator.hpp"
+#include "cws/scenario/scenario.hpp"
 #include "cws/simulation/interface.hpp"
+#include "cws/simulation/callback.hpp"
+#include "cws/simulation/checkpoint.hpp"
+#include "cws/simulation/import.hpp"
+#include "cws/simulation/journal.hpp"
+#include "cws/simulation/pool.hpp"
 #include "cws/simulation/simulation.hpp"
+#include "cws/simulation/snapshot.hpp"
+#include "cws/subject/camera.hpp"
+#include "cws/subject/network.hpp"
+#include "cws/subject/plain.hpp"
+#include "cws/subject/turnable.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
 #include <thread>
 
 TEST(Simulation, SimulateMapEmptyUSE) {
@@ -103,3 +120,551 @@ TEST(Simulation, SimulationMapUSE) {
 
   interface.exit();
 }
+
+TEST(Simulation, waitMap) {
+  SimulationInterface interface;
+
+  SimulationMaster master(interface);
+  interface.setSimulationMaster(&master);
+
+  interface.run();
+
+  SimulationStateIn state;
+  state.simType.set(SimulationType::INFINITE);
+  state.simStatus.set(SimulationStatus::RUNNING);
+  state.currentTick.set(0);
+  state.taskFrequency.set(50);
+
+  interface.setDimension({4, 4});
+  interface.setState(state);
+
+  auto first = interface.waitMap(0, std::chrono::seconds(2));
+  ASSERT_LT(0, first.version);
+  ASSERT_NE(nullptr, first.map);
+
+  auto next = interface.waitMap(first.version, std::chrono::seconds(2));
+  ASSERT_LT(first.version, next.version);
+  ASSERT_LT(first.tick, next.tick);
+
+  interface.exit();
+}
+
+TEST(Simulation, pool) {
+  SimulationInterface fast;
+  SimulationInterface capped;
+  SimulationMaster fastMaster(fast);
+  SimulationMaster cappedMaster(capped);
+  fast.setSimulationMaster(&fastMaster);
+  capped.setSimulationMaster(&cappedMaster);
+
+  capped.setMaxCells(16);
+  EXPECT_FALSE(capped.setDimension({5, 4}));
+  EXPECT_FALSE(capped.setMap(std::make_unique<SimulationMap>(Dimension{8, 8})));
+  EXPECT_TRUE(capped.setDimension({4, 4}));
+  EXPECT_TRUE(fast.setDimension({8, 8}));
+
+  SimulationStateIn state;
+  state.simType.set(SimulationType::INFINITE);
+  state.simStatus.set(SimulationStatus::RUNNING);
+  state.currentTick.set(0);
+  state.taskFrequency.set(50);
+  fast.setState(state);
+  capped.setState(state);
+
+  // both share one thread, capped one is stepped at its own rate
+  SimulationPool pool(1);
+  auto start = std::chrono::steady_clock::now();
+  pool.add(fastMaster);
+  pool.add(cappedMaster, 10);
+
+  // waits for ticks instead of time, so slow machine only takes longer
+  auto deadline = start + std::chrono::seconds(10);
+  MapSnapshot published;
+  while (published.tick < 20 && std::chrono::steady_clock::now() < deadline) {
+    published = fast.waitMap(published.version, std::chrono::seconds(1));
+  }
+  pool.remove(fastMaster);
+  pool.remove(cappedMaster);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  EXPECT_EQ(0, pool.size());
+
+  // cap bounds ticks from above whatever the load is, 100 ms per tick
+  auto fastTicks = fast.getState().currentTick;
+  auto cappedTicks = capped.getState().currentTick;
+  EXPECT_GE(fastTicks, 20);
+  EXPECT_GT(cappedTicks, 0);
+  EXPECT_LE(cappedTicks, elapsed / std::chrono::milliseconds(100) + 1u);
+  ASSERT_NE(nullptr, capped.getMap());
+
+  // removed masters aren't stepped anymore
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(fastTicks, fast.getState().currentTick);
+}
+
+static std::unique_ptr<Subject::Plain> makeIndexedPlain(int idx, double weight) {
+  return std::make_unique<Subject::Plain>(
+      Physical(weight, 400, Temperature{20}, Obstruction{0}, Obstruction{0}), idx, 1,
+      Obstruction{0});
+}
+
+TEST(Simulation, subjectIndex) {
+  SimulationMap map({3, 3});
+  map.modify(SubjectModifyQuery(INSERT, {1, 2}, makeIndexedPlain(5, 10)));
+  map.modify(SubjectModifyQuery(INSERT, {2, 0}, makeIndexedPlain(5, 20)));
+
+  const auto & cmap = map;
+  Subject::Id id{Subject::Type::PLAIN, 5};
+
+  auto first = cmap.select(SubjectSelectQuery({1, 2}, id));
+  ASSERT_NE(nullptr, first);
+  EXPECT_EQ(10, first->getWeight());
+  EXPECT_EQ(nullptr, cmap.select(SubjectSelectQuery({0, 0}, id)));
+
+  Coordinates found;
+  ASSERT_NE(nullptr, cmap.select(id, &found));
+
+  // copy points to own subjects
+  SimulationMap copy(map);
+  const auto & ccopy = copy;
+  auto copied = ccopy.select(SubjectSelectQuery({1, 2}, id));
+  ASSERT_NE(nullptr, copied);
+  EXPECT_NE(first, copied);
+
+  map.modify(SubjectModifyQuery(UPDATE, {1, 2}, makeIndexedPlain(5, 30)));
+  EXPECT_EQ(30, cmap.select(SubjectSelectQuery({1, 2}, id))->getWeight());
+  EXPECT_EQ(10, ccopy.select(SubjectSelectQuery({1, 2}, id))->getWeight());
+
+  map.modify(SubjectModifyQuery(DELETE, {1, 2}, makeIndexedPlain(5, 0)));
+  EXPECT_EQ(nullptr, cmap.select(SubjectSelectQuery({1, 2}, id)));
+  ASSERT_NE(nullptr, cmap.select(id, &found));
+  EXPECT_EQ(Coordinates({2, 0}), found);
+  EXPECT_EQ(1, map.getLayers().subjectLayer.getSubjectList({2, 0}).size());
+  EXPECT_EQ(0, map.getLayers().subjectLayer.getSubjectList({1, 2}).size());
+
+  // crowded cell is remapped by walking its list, copy assigned over older copy
+  for (int idx = 10; idx < 50; ++idx) {
+    map.modify(SubjectModifyQuery(INSERT, {0, 1}, makeIndexedPlain(idx, idx)));
+  }
+  copy = map;
+  for (int idx = 10; idx < 50; ++idx) {
+    auto select = SubjectSelectQuery({0, 1}, {Subject::Type::PLAIN, idx});
+    auto subject = ccopy.select(select);
+    ASSERT_NE(nullptr, subject);
+    EXPECT_NE(cmap.select(select), subject);
+    EXPECT_EQ(idx, subject->getWeight());
+  }
+  copy.modify(SubjectModifyQuery(DELETE, {0, 1}, makeIndexedPlain(30, 0)));
+  EXPECT_EQ(39, copy.getLayers().subjectLayer.getSubjectList({0, 1}).size());
+  EXPECT_EQ(40, map.getLayers().subjectLayer.getSubjectList({0, 1}).size());
+  EXPECT_NE(nullptr, ccopy.select(id));
+}
+
+TEST(Simulation, cameraOfCopyLooksAtCopy) {
+  SimulationMap map({4, 4});
+  map.modify(SubjectModifyQuery(
+      INSERT, {0, 0},
+      std::make_unique<Subject::InfraredCamera>(
+          Subject::Plain(Physical(), 1, 0, Obstruction{0}), 100, 20)));
+  map.modify(SubjectModifyQuery(INSERT, {2, 3}, makeIndexedPlain(7, 10)));
+
+  SimulationMap next(map);
+  next.next(map);
+
+  // published copy keeps subjects of its own layers while next map changes
+  SimulationMap published(next);
+  next.modify(SubjectModifyQuery(DELETE, {2, 3}, makeIndexedPlain(7, 0)));
+
+  auto countVisible = [](const SimulationMap & m) {
+    auto camera = static_cast<const Subject::InfraredCamera *>(
+        m.select(Subject::Id{Subject::Type::INFRARED_CAMERA, 1}));
+    return std::ranges::count_if(camera->getVisible(),
+                                 [](const auto & v) { return v.id.idx == 7; });
+  };
+  EXPECT_EQ(1, countVisible(published));
+  EXPECT_EQ(0, countVisible(next));
+}
+
+TEST(Simulation, snapshotRoundTrip) {
+  Scenario scenario({24, 24});
+  generateFloor(scenario, FloorParams{.seed = 3, .roomSize = 8});
+
+  SimulationMap map(scenario.getDimension());
+  scenario.apply(map, 0);
+  map.modify(SubjectModifyQuery(
+      SubjectModifyType::INSERT, {5, 6},
+      std::make_unique<Subject::Plain>(Physical(), 1000, 0, Obstruction{})));
+  map.modify(CableModifyQuery{CableModifyType::CONNECT,
+                              {Subject::Type::PLAIN, 1000},
+                              {Subject::Type::PLAIN, 2}});
+  Subject::Id deviceId{Subject::Type::WIRELESS_NETWORK_DEVICE, 1001};
+  map.modify(SubjectModifyQuery(SubjectModifyType::INSERT, {7, 6},
+                                std::make_unique<Subject::WirelessNetworkDevice>(
+                                    Subject::Plain(Physical(), 1001, 0, Obstruction{}),
+                                    40, 5)));
+  // device receives its own packet sent on last tick and keeps the second one
+  auto transmit = [&map, &deviceId](std::size_t count) {
+    PacketList packets;
+    for (std::size_t i = 0; i < count; ++i) {
+      packets.push_back(std::make_unique<Network::Packet>(std::vector<std::byte>(3)));
+    }
+    map.modify(SubjectCallbackQuery<PacketList>(SubjectSelectQuery({7, 6}, deviceId),
+                                                addPacketToTransmitQueue,
+                                                std::move(packets)));
+  };
+  for (int i = 0; i < 3; ++i) {
+    if (i == 2) {
+      transmit(1);
+    }
+    SimulationMap cur(map);
+    map.next(cur);
+  }
+  transmit(2);
+
+  std::ostringstream out;
+  writeSnapshot(out, map);
+  auto bytes = out.str();
+  std::span<const std::byte> data(reinterpret_cast<const std::byte *>(bytes.data()),
+                                  bytes.size());
+
+  auto restored = readSnapshot(data);
+  ASSERT_EQ(map.getDimension().width, restored->getDimension().width);
+  ASSERT_EQ(map.getDimension().height, restored->getDimension().height);
+
+  // written again it gives the same bytes
+  std::ostringstream restoredOut;
+  writeSnapshot(restoredOut, *restored);
+  EXPECT_TRUE(bytes == restoredOut.str());
+
+  // index is rebuilt
+  Coordinates c{-1, -1};
+  ASSERT_NE(nullptr, restored->select(Subject::Id{Subject::Type::PLAIN, 1000}, &c));
+  EXPECT_EQ(Coordinates({5, 6}), c);
+
+  // packets in buffers of devices are kept
+  auto device =
+      dynamic_cast<const Subject::NetworkDevice *>(restored->select(deviceId, &c));
+  ASSERT_NE(nullptr, device);
+  EXPECT_EQ(2, device->getTransmitPackets().size());
+  ASSERT_EQ(1, device->getReceivedPackets().size());
+  EXPECT_EQ(3, device->getReceivedPackets().front()->getContent().size());
+
+  auto path = std::filesystem::temp_directory_path() / "cws_snapshot_test.bin";
+  saveSnapshot(path.string(), map);
+  auto loaded = loadSnapshot(path.string());
+  std::filesystem::remove(path);
+  std::ostringstream loadedOut;
+  writeSnapshot(loadedOut, *loaded);
+  EXPECT_TRUE(bytes == loadedOut.str());
+
+  EXPECT_THROW(readSnapshot(data.first(data.size() - 1)), std::invalid_argument);
+  EXPECT_THROW(readSnapshot(data.subspan(1)), std::invalid_argument);
+
+  // dimension of header is checked against size of data before map is allocated
+  auto huge = bytes;
+  std::int32_t side = 1 << 30;
+  std::memcpy(huge.data() + 12, &side, sizeof(side));
+  std::memcpy(huge.data() + 16, &side, sizeof(side));
+  EXPECT_THROW(readSnapshot(std::span<const std::byte>(
+                   reinterpret_cast<const std::byte *>(huge.data()), huge.size())),
+               std::invalid_argument);
+}
+
+TEST(Simulation, checkpointDeltaRestore) {
+  Scenario scenario({24, 24});
+  generateFloor(scenario, FloorParams{.seed = 5, .roomSize = 8});
+  SimulationMap map(scenario.getDimension());
+  scenario.apply(map, 0);
+
+  auto directory = std::filesystem::temp_directory_path() / "cws_checkpoint_test";
+  std::filesystem::remove_all(directory);
+
+  SimulationInterface interface;
+  Checkpointer checkpointer(
+      interface, CheckpointOptions{.directory = directory.string(), .keepFull = 1});
+
+  checkpointer.write(0, map);
+  for (std::size_t tick = 1; tick <= 2; ++tick) {
+    map.modify(SubjectModifyQuery(
+        SubjectModifyType::INSERT, {3, static_cast<int>(tick)},
+        std::make_unique<Subject::Plain>(Physical(), 1000 + tick, 0, Obstruction{})));
+    checkpointer.write(tick, map);
+  }
+
+  std::size_t fullSize = 0;
+  std::size_t deltaSize = 0;
+  for (const auto & entry : std::filesystem::directory_iterator(directory)) {
+    auto size = entry.file_size();
+    (entry.path().extension() == ".full" ? fullSize : deltaSize) += size;
+  }
+  // deltas are taken against full checkpoint, so they have one and two changed cells
+  EXPECT_LT(deltaSize * 20, fullSize);
+
+  auto restored = Checkpointer::restore(directory.string());
+  ASSERT_NE(nullptr, restored.map);
+  EXPECT_EQ(2, restored.tick);
+
+  std::ostringstream expected;
+  writeSnapshot(expected, map);
+  std::ostringstream actual;
+  writeSnapshot(actual, *restored.map);
+  EXPECT_TRUE(expected.str() == actual.str());
+
+  // only two newest full checkpoints are kept, older deltas go with their base
+  CheckpointOptions options{.directory = directory.string(), .deltasPerFull = 0};
+  Checkpointer next(interface, options);
+  next.write(3, map);
+  next.write(4, map);
+  std::size_t files = 0;
+  for ([[maybe_unused]] const auto & entry :
+       std::filesystem::directory_iterator(directory)) {
+    ++files;
+  }
+  EXPECT_EQ(2, files);
+  EXPECT_EQ(4, Checkpointer::restore(directory.string()).tick);
+
+  std::filesystem::remove_all(directory);
+}
+
+TEST(Simulation, journalReplay) {
+  Scenario scenario({16, 16});
+  generateFloor(scenario, FloorParams{.seed = 7, .roomSize = 8});
+  SimulationMap currMap(scenario.getDimension());
+  scenario.apply(currMap, 0);
+  SimulationMap checkpoint(currMap);
+  SimulationMap nextMap(currMap);
+
+  auto path = std::filesystem::temp_directory_path() / "cws_journal_test.bin";
+  std::filesystem::remove(path);
+
+  const Subject::Id turnableId{Subject::Type::TURNABLE, 500};
+  {
+    Journal journal(path.string());
+    journal.recordReset(0);
+
+    // queries are recorded and applied as master does
+    for (std::size_t tick = 0; tick < 6; ++tick) {
+      if (tick == 1) {
+        SubjectModifyQuery query(
+            SubjectModifyType::INSERT, {4, 4},
+            std::make_unique<Subject::Turnable>(
+                Subject::Plain(Physical(), 500, 0, Obstruction{0.2}),
+                Subject::TurnableStatus::ON, Obstruction{}, Obstruction{},
+                Obstruction{}));
+        journal.record(tick, query);
+        nextMap.modify(std::move(query));
+      }
+      if (tick == 2) {
+        AirInsertQuery query({5, 5}, std::make_unique<Air::Plain>(
+                                         Physical(1.2, 1005, Temperature{40}), 9, 0.3));
+        journal.record(tick, query);
+        nextMap.modify(std::move(query));
+
+        // queued for bigger map replaced before it was applied
+        AirInsertQuery outside({40, 5}, std::make_unique<Air::Plain>(
+                                            Physical(1.2, 1005, Temperature{40}), 9, 0.3));
+        journal.record(tick, outside);
+        nextMap.modify(std::move(outside));
+      }
+      if (tick == 3) {
+        SubjectCallbackQuery<Subject::TurnableStatus> query(
+            SubjectSelectQuery({4, 4}, turnableId), setTurnableStatus,
+            Subject::TurnableStatus::OFF);
+        journal.record(tick, query);
+        nextMap.modify(std::move(query));
+      }
+      if (tick == 4) {
+        MapImportQuery query;
+        query.subjects.emplace_back(INSERT, Coordinates{2, 2},
+                                    makeIndexedPlain(600, 5));
+        query.subjects.emplace_back(INSERT, Coordinates{2, 20},
+                                    makeIndexedPlain(601, 5));
+        query.air.emplace_back(Coordinates{6, 6},
+                               std::make_unique<Air::Plain>(
+                                   Physical(1.2, 1005, Temperature{30}), 10, 0.3));
+        journal.record(tick, query);
+        nextMap.modify(std::move(query));
+      }
+      if (tick == 5) {
+        AirRegionQuery query{AirRegionModifyType::SCALE,
+                             CellRegion{.polygon = {{0, 0}, {9, 0}, {0, 9}}}};
+        query.factor = 1.5;
+        journal.record(tick, query);
+        nextMap.modify(std::move(query));
+      }
+
+      nextMap.next(currMap);
+      currMap = nextMap;
+      journal.setTick(tick + 1);
+    }
+    journal.commit();
+  }
+
+  JournalReplay replay(path.string());
+  EXPECT_EQ(0, replay.getResetTick());
+  EXPECT_EQ(6, replay.getEndTick());
+
+  auto replayed = replay.replay(std::make_unique<SimulationMap>(checkpoint), 0, 6);
+  std::ostringstream expected;
+  writeSnapshot(expected, currMap);
+  std::ostringstream actual;
+  writeSnapshot(actual, *replayed);
+  EXPECT_TRUE(expected.str() == actual.str());
+
+  auto turnable = dynamic_cast<const Subject::Turnable *>(replayed->select(turnableId));
+  ASSERT_NE(nullptr, turnable);
+  EXPECT_EQ(Subject::TurnableStatus::OFF, turnable->getStatus());
+  EXPECT_NE(nullptr, replayed->select(Subject::Id{Subject::Type::PLAIN, 600}));
+  EXPECT_EQ(nullptr, replayed->select(Subject::Id{Subject::Type::PLAIN, 601}));
+
+  // torn batch is dropped on read and cut off when journal is opened again
+  auto size = std::filesystem::file_size(path);
+  {
+    std::ofstream out(path, std::ios::binary | std::ios::app);
+    out << "torn";
+  }
+  EXPECT_EQ(6, JournalReplay(path.string()).getEndTick());
+  { Journal journal(path.string()); }
+  EXPECT_EQ(size, std::filesystem::file_size(path));
+
+  std::filesystem::remove(path);
+}
+
+TEST(Simulation, journalReplayAirState) {
+  // uniform air, so tiles fall asleep and ticks are skipped
+  Dimension dim{16, 16};
+  SimulationMap currMap(dim);
+  currMap.modify(AirRegionQuery{
+      AirRegionModifyType::FILL, CellRegion{{0, 0}, dim},
+      std::make_unique<Air::Plain>(Physical(1.2, 1005, Temperature{20}), 0, 0.3)});
+  currMap.setAirStepping(AirStepping{.adaptive = true});
+  currMap.setAirSleeping(AirSleeping{.enabled = true, .tileSize = 4, .calmTicks = 2});
+  SimulationMap nextMap(currMap);
+
+  auto path = std::filesystem::temp_directory_path() / "cws_journal_air_test.bin";
+  std::filesystem::remove(path);
+
+  // tiles and skipped ticks of map saved midway are restored with it
+  std::string saved;
+  {
+    Journal journal(path.string());
+    journal.recordReset(0);
+    for (std::size_t tick = 0; tick < 40; ++tick) {
+      if (tick == 20) {
+        std::ostringstream out;
+        writeSnapshot(out, currMap);
+        saved = out.str();
+      }
+      if (tick == 30) {
+        AirInsertQuery query({5, 5}, std::make_unique<Air::Plain>(
+                                         Physical(1.2, 1005, Temperature{40}), 9, 0.3));
+        journal.record(tick, query);
+        nextMap.modify(std::move(query));
+      }
+      nextMap.next(currMap);
+      currMap = nextMap;
+      journal.setTick(tick + 1);
+    }
+    journal.commit();
+  }
+
+  auto restored = readSnapshot(std::span<const std::byte>(
+      reinterpret_cast<const std::byte *>(saved.data()), saved.size()));
+  const auto & airLayer = restored->getLayers().airLayer;
+  EXPECT_TRUE(airLayer.getStepping().adaptive);
+  EXPECT_EQ(4, airLayer.getSleeping().tileSize);
+  EXPECT_GT(airLayer.getSleepingTiles(), 0);
+  // master sets options of server again, tiles of the same size are kept
+  restored->setAirStepping(AirStepping{.adaptive = true});
+  restored->setAirSleeping(AirSleeping{.enabled = true, .tileSize = 4, .calmTicks = 2});
+  EXPECT_GT(airLayer.getSleepingTiles(), 0);
+
+  auto replayed = JournalReplay(path.string()).replay(std::move(restored), 20, 40);
+  std::ostringstream expected;
+  writeSnapshot(expected, currMap);
+  std::ostringstream actual;
+  writeSnapshot(actual, *replayed);
+  EXPECT_TRUE(expected.str() == actual.str());
+
+  std::filesystem::remove(path);
+}
+
+TEST(Simulation, mapImport) {
+  SimulationMap map({8, 8});
+  map.modify(SubjectModifyQuery(INSERT, {0, 0}, makeIndexedPlain(1, 10)));
+  SimulationMap expected(map);
+
+  MapImport import;
+  for (int i = 0; i < 40; ++i) {
+    Coordinates c{i % 8, i / 8};
+    import.query.subjects.emplace_back(INSERT, c, makeIndexedPlain(100 + i, i));
+    expected.modify(SubjectModifyQuery(INSERT, c, makeIndexedPlain(100 + i, i)));
+  }
+  for (int i = 0; i < 8; ++i) {
+    auto makeAir = [i] {
+      return std::make_unique<Air::Plain>(Physical(1.2, 1005, Temperature{20.0 + i}),
+                                          i, 0.3);
+    };
+    import.query.air.emplace_back(Coordinates{i, 7}, makeAir());
+    expected.modify(AirInsertQuery({i, 7}, makeAir()));
+  }
+
+  // small chunks, so they are read by several threads
+  std::ostringstream out;
+  writeMapImport(out, import, 6);
+  auto bytes = out.str();
+  std::span<const std::byte> data(reinterpret_cast<const std::byte *>(bytes.data()),
+                                  bytes.size());
+
+  auto read = readMapImport(data, &map);
+  EXPECT_FALSE(read.dimension.isSet());
+  ASSERT_EQ(40, read.query.subjects.size());
+  ASSERT_EQ(8, read.query.air.size());
+  map.modify(std::move(read.query));
+
+  std::ostringstream imported;
+  writeSnapshot(imported, map);
+  std::ostringstream oneByOne;
+  writeSnapshot(oneByOne, expected);
+  EXPECT_TRUE(imported.str() == oneByOne.str());
+
+  Coordinates c;
+  ASSERT_NE(nullptr, map.select(Subject::Id{Subject::Type::PLAIN, 139}, &c));
+  EXPECT_EQ(Coordinates({7, 4}), c);
+
+  // any broken item fails whole import
+  auto makeChunk = [](Coordinates c, int idx) {
+    return [c, idx] {
+      MapImportQuery query;
+      query.subjects.emplace_back(INSERT, c, makeIndexedPlain(idx, 1));
+      return query;
+    };
+  };
+  MapImporter repeated(map.getDimension(), &map);
+  repeated.add(makeChunk({1, 1}, 7));
+  repeated.add(makeChunk({1, 1}, 7));
+  EXPECT_THROW(repeated.build(2), std::invalid_argument);
+
+  MapImporter existing(map.getDimension(), &map);
+  existing.add(makeChunk({0, 0}, 100));
+  EXPECT_THROW(existing.build(), std::invalid_argument);
+
+  MapImporter outside(map.getDimension());
+  outside.add(makeChunk({8, 0}, 7));
+  EXPECT_THROW(outside.build(), std::invalid_argument);
+
+  EXPECT_THROW(readMapImport(data.first(data.size() - 1), &map), std::invalid_argument);
+  EXPECT_THROW(readMapImport(data, nullptr), std::invalid_argument);
+
+  // import checked against larger map drops items out of smaller one
+  SimulationMap smaller({4, 4});
+  MapImportQuery late;
+  late.subjects.emplace_back(INSERT, Coordinates{1, 1}, makeIndexedPlain(7, 1));
+  late.subjects.emplace_back(INSERT, Coordinates{6, 1}, makeIndexedPlain(8, 1));
+  auto air = std::make_unique<Air::Plain>(Physical(1.2, 1005, Temperature{20}), 0, 0.3);
+  late.air.emplace_back(Coordinates{2, 5}, std::move(air));
+  smaller.modify(std::move(late));
+  EXPECT_NE(nullptr, smaller.select(Subject::Id{Subject::Type::PLAIN, 7}));
+  EXPECT_EQ(nullptr, smaller.select(Subject::Id{Subject::Type::PLAIN, 8}));
+  smaller.modify(SubjectModifyQuery(INSERT, {4, 0}, makeIndexedPlain(9, 1)));
+  EXPECT_EQ(nullptr, smaller.select(Subject::Id{Subject::Type::PLAIN, 9}));
+}
@@ -5,6 +5,7 @@
 #include "cws/physical.hpp"
 #include "cws/subject/camera.hpp"
 #include "cws/subject/light_emitter.hpp"
+#include <set>
 
 TEST(Subject, TurnableLightEmitter) {
   using namespace Subject;
@@ -165,3 +166,126 @@ TEST(SubjectLightCamera, getVisibleSubjectsUSE) {
     std::cout << coord << " " << (int)sub.getId().type << std::endl;
   }
 }
+
+TEST(SubjectCamera, visibleSearchedOnFirstRead) {
+  using namespace Subject;
+
+  Dimension dim{4, 4};
+  MapLayerObstruction obstruction(dim);
+  MapLayerIllumination illumination(dim);
+  MapLayerAir airLayer(dim);
+  MapLayerSubject layerSubject(dim);
+
+  layerSubject.accessSubjectList({0, 0}).push_back(
+      std::make_unique<InfraredCamera>(Plain(Physical(), 1, 0, {}), 100, 20));
+  layerSubject.accessSubjectList({2, 3}).push_back(
+      std::make_unique<Plain>(Physical(), 7, 0, Obstruction{}));
+
+  obstruction.updateLightObstruction(layerSubject);
+  layerSubject.setupSubjects(airLayer, obstruction, illumination);
+
+  // subject moved after setup is found where it is at first read
+  layerSubject.accessSubjectList({3, 2}).splice(
+      layerSubject.accessSubjectList({3, 2}).end(),
+      layerSubject.accessSubjectList({2, 3}));
+
+  auto findPlain = [](const auto & visible) {
+    return std::find_if(visible.begin(), visible.end(),
+                        [](const auto & v) { return v.id.idx == 7; });
+  };
+
+  // copy shares result of search with source
+  MapLayerSubject copy(layerSubject);
+  auto camera =
+      static_cast<const InfraredCamera *>(copy.getSubjectList({0, 0}).begin()->get());
+
+  const auto & visible = camera->getVisible();
+  ASSERT_EQ(camera->getVisibleSubjects().size(), visible.size());
+  auto plain = findPlain(visible);
+  ASSERT_NE(visible.end(), plain);
+  EXPECT_EQ(Coordinates({3, 2}), plain->coordinates);
+
+  layerSubject.accessSubjectList({3, 2}).clear();
+  auto source = static_cast<const InfraredCamera *>(
+      layerSubject.getSubjectList({0, 0}).begin()->get());
+  EXPECT_NE(source->getVisible().end(), findPlain(source->getVisible()));
+
+  // next setup drops result
+  layerSubject.setupSubjects(airLayer, obstruction, illumination);
+  EXPECT_EQ(source->getVisible().end(), findPlain(source->getVisible()));
+}
+
+TEST(SubjectCamera, viewLimitsSearch) {
+  using namespace Subject;
+
+  Dimension dim{9, 9};
+  MapLayerObstruction obstruction(dim);
+  MapLayerIllumination illumination(dim);
+  MapLayerSubject layerSubject(dim);
+
+  auto camera = new InfraredCamera(Plain(Physical(), 1, 0, {}), 100, 20);
+  layerSubject.accessSubjectList({4, 4}).emplace_back(camera);
+  for (Coordinates c : {Coordinates{6, 4}, Coordinates{8, 4}, Coordinates{2, 4},
+                        Coordinates{4, 7}}) {
+    layerSubject.accessSubjectList(c).push_back(
+        std::make_unique<Plain>(Physical(), c.x * 10 + c.y, 0, Obstruction{}));
+  }
+  obstruction.updateLightObstruction(layerSubject);
+  camera->setup({4, 4}, layerSubject, obstruction);
+
+  auto visibleIdx = [&]() {
+    std::set<int> idx;
+    for (const auto & [coord, sub] : camera->getVisibleSubjects()) {
+      idx.insert(sub.getId().idx);
+    }
+    return idx;
+  };
+
+  EXPECT_EQ(std::set<int>({1, 64, 84, 24, 47}), visibleIdx());
+
+  camera->setView(CameraView{.range = 3});
+  EXPECT_EQ(std::set<int>({1, 64, 24, 47}), visibleIdx());
+
+  // 90 degrees cone along x
+  camera->setView(CameraView{.direction = 0, .fov = 90});
+  EXPECT_EQ(std::set<int>({1, 64, 84}), visibleIdx());
+
+  camera->setView(CameraView{.range = 2, .direction = 90, .fov = 90});
+  EXPECT_EQ(std::set<int>({1}), visibleIdx());
+}
+
+TEST(SubjectCamera, viewNarrowOffAxisCone) {
+  using namespace Subject;
+
+  Dimension dim{12, 6};
+  MapLayerObstruction obstruction(dim);
+  MapLayerSubject layerSubject(dim);
+
+  auto camera = new InfraredCamera(Plain(Physical(), 1, 0, {}), 100, 20);
+  layerSubject.accessSubjectList({0, 0}).emplace_back(camera);
+  // both are at 21.8 degrees, no neighbour of camera is inside of cone
+  for (Coordinates c : {Coordinates{5, 2}, Coordinates{10, 4}}) {
+    layerSubject.accessSubjectList(c).push_back(
+        std::make_unique<Plain>(Physical(), c.x * 10 + c.y, 0, Obstruction{}));
+  }
+  obstruction.updateLightObstruction(layerSubject);
+  camera->setup({0, 0}, layerSubject, obstruction);
+
+  auto visibleIdx = [&]() {
+    std::set<int> idx;
+    for (const auto & [coord, sub] : camera->getVisibleSubjects()) {
+      idx.insert(sub.getId().idx);
+    }
+    return idx;
+  };
+
+  camera->setView(CameraView{.direction = 20, .fov = 10});
+  EXPECT_EQ(std::set<int>({1, 52, 104}), visibleIdx());
+
+  camera->setView(CameraView{.range = 6, .direction = 20, .fov = 10});
+  EXPECT_EQ(std::set<int>({1, 52}), visibleIdx());
+
+  // margin around cone is searched, but subjects there aren't visible
+  camera->setView(CameraView{.direction = 30, .fov = 10});
+  EXPECT_EQ(std::set<int>({1}), visibleIdx());
+}
@@ -1,5 +1,9 @@
 #include "converters.hpp"
 
+#include <algorithm>
+#include <limits>
+#include <string_view>
+
 #include "cws/simulation/simulation_map.hpp"
 #include "cws/subject/camera.hpp"
 #include "cws/subject/light_emitter.hpp"
@@ -47,20 +51,38 @@ void toObstruction(pb::Obstruction & out, const Obstruction & in) {
 }
 
 void toCell(pb::Cell & out, const Layers & layers, const Coordinates c) {
+  toCell(out, layers, c, MAP_LAYER_MASK_ALL);
+}
+
+void toCell(pb::Cell & out, const Layers & layers, const Coordinates c,
+            std::uint32_t layerMask) {
+  constexpr std::uint32_t airMask = pb::MAP_LAYER_MASK_AIR |
+                                    pb::MAP_LAYER_MASK_AIR_TEMPERATURE;
+  constexpr std::uint32_t obstructionMask = pb::MAP_LAYER_MASK_LIGHT_OBSTRUCTION |
+                                            pb::MAP_LAYER_MASK_AIR_OBSTRUCTION |
+                                            pb::MAP_LAYER_MASK_WIRELESS_OBSTRUCTION;
   auto & mapLayerWireless = layers.networkWireless;
-  auto & airLayer = layers.airLayer.getCell(c).getElement();
-  auto & illuminationLayer = layers.illuminationLayer.getCell(c).getElement();
-  auto & obstructionLayer = layers.obstructionLayer.getCell(c).getElement();
-  auto & subjectLayer = layers.subjectLayer.getCell(c).getElement();
 
   toCoordinates(*out.mutable_coordinates(), c);
-  toLayerAir(*out.mutable_air(), airLayer);
-  toLayerIllumination(*out.mutable_illumination(), illuminationLayer);
-  toLayerNetworkWireless(*out.mutable_wireless_network(),
-                         mapLayerWireless.getTransmittableLayer(c),
-                         mapLayerWireless.getReceivableLayer(c));
-  toLayerObstruction(*out.mutable_obstruction(), obstructionLayer);
-  toLayerSubject(*out.mutable_subject(), subjectLayer);
+  if (layerMask & airMask) {
+    toLayerAir(*out.mutable_air(), layers.airLayer.getCell(c).getElement());
+  }
+  if (layerMask & pb::MAP_LAYER_MASK_ILLUMINATION) {
+    toLayerIllumination(*out.mutable_illumination(),
+                        layers.illuminationLayer.getCell(c).getElement());
+  }
+  if (layerMask & pb::MAP_LAYER_MASK_WIRELESS_NETWORK) {
+    toLayerNetworkWireless(*out.mutable_wireless_network(),
+                           mapLayerWireless.getTransmittableLayer(c),
+                           mapLayerWireless.getReceivableLayer(c));
+  }
+  if (layerMask & obstructionMask) {
+    toLayerObstruction(*out.mutable_obstruction(),
+                       layers.obstructionLayer.getCell(c).getElement());
+  }
+  if (layerMask & pb::MAP_LAYER_MASK_SUBJECT) {
+    toLayerSubject(*out.mutable_subject(), layers.subjectLayer.getCell(c).getElement());
+  }
 }
 
 void toMap(cwspb::Map & out, const Layers & layers, Dimension dim) {
@@ -73,6 +95,97 @@ void toMap(cwspb::Map & out, const Layers & layers, Dimension dim) {
   }
 }
 
+float toLayerScalar(const Layers & layers, Coordinates c, std::uint32_t layerBit) {
+  switch (layerBit) {
+  case pb::MAP_LAYER_MASK_AIR_TEMPERATURE: {
+    auto & container = layers.airLayer.getAirContainer(c);
+    return container.empty() ? std::numeric_limits<float>::quiet_NaN()
+                             : static_cast<float>(container.getTemperature().value);
+  }
+  case pb::MAP_LAYER_MASK_ILLUMINATION:
+    return layers.illuminationLayer.getIllumination(c).get();
+  case pb::MAP_LAYER_MASK_LIGHT_OBSTRUCTION:
+    return layers.obstructionLayer.getLightObstruction(c).get();
+  case pb::MAP_LAYER_MASK_AIR_OBSTRUCTION:
+    return layers.obstructionLayer.getAirObstruction(c).get();
+  case pb::MAP_LAYER_MASK_WIRELESS_OBSTRUCTION:
+    return layers.obstructionLayer.getWirelessObstruction(c).get();
+  case pb::MAP_LAYER_MASK_SUBJECT_COUNT:
+    return layers.subjectLayer.getSubjectList(c).size();
+  }
+  return std::numeric_limits<float>::quiet_NaN();
+}
+
+template<typename Column, typename ForEachCell>
+static void toLayerColumn(Column & out, const Layers & layers, std::uint32_t layerBit,
+                          ForEachCell forEachCell) {
+  using Value = typename Column::value_type;
+  forEachCell([&](Coordinates c) {
+    out.Add(static_cast<Value>(toLayerScalar(layers, c, layerBit)));
+  });
+}
+
+// MapTile and MapDelta share names of layer arrays
+template<typename Out, typename ForEachCell>
+static void toLayerColumns(Out & out, const Layers & layers, std::uint32_t layerMask,
+                           ForEachCell forEachCell) {
+  if (layerMask & pb::MAP_LAYER_MASK_AIR_TEMPERATURE) {
+    toLayerColumn(*out.mutable_air_temperature(), layers,
+                  pb::MAP_LAYER_MASK_AIR_TEMPERATURE, forEachCell);
+  }
+  if (layerMask & pb::MAP_LAYER_MASK_ILLUMINATION) {
+    toLayerColumn(*out.mutable_illumination(), layers, pb::MAP_LAYER_MASK_ILLUMINATION,
+                  forEachCell);
+  }
+  if (layerMask & pb::MAP_LAYER_MASK_LIGHT_OBSTRUCTION) {
+    toLayerColumn(*out.mutable_light_obstruction(), layers,
+                  pb::MAP_LAYER_MASK_LIGHT_OBSTRUCTION, forEachCell);
+  }
+  if (layerMask & pb::MAP_LAYER_MASK_AIR_OBSTRUCTION) {
+    toLayerColumn(*out.mutable_air_obstruction(), layers,
+                  pb::MAP_LAYER_MASK_AIR_OBSTRUCTION, forEachCell);
+  }
+  if (layerMask & pb::MAP_LAYER_MASK_WIRELESS_OBSTRUCTION) {
+    toLayerColumn(*out.mutable_wireless_obstruction(), layers,
+                  pb::MAP_LAYER_MASK_WIRELESS_OBSTRUCTION, forEachCell);
+  }
+  if (layerMask & pb::MAP_LAYER_MASK_SUBJECT_COUNT) {
+    toLayerColumn(*out.mutable_subject_count(), layers, pb::MAP_LAYER_MASK_SUBJECT_COUNT,
+                  forEachCell);
+  }
+}
+
+void toMapTile(cwspb::MapTile & out, const Layers & layers, const MapRegion & region,
+               std::uint32_t layerMask) {
+  toCoordinates(*out.mutable_origin(), region.origin);
+  toDimension(*out.mutable_size(), region.size);
+
+  toLayerColumns(out, layers, layerMask, [&](auto && fn) {
+    Coordinates c;
+    for (c.y = region.origin.y; c.y < region.origin.y + region.size.height; ++c.y) {
+      for (c.x = region.origin.x; c.x < region.origin.x + region.size.width; ++c.x) {
+        fn(c);
+      }
+    }
+  });
+}
+
+void toMapDelta(cwspb::MapDelta & out, const Layers & layers,
+                const std::vector<Coordinates> & cells, std::uint32_t layerMask) {
+  out.mutable_x()->Reserve(cells.size());
+  out.mutable_y()->Reserve(cells.size());
+  for (auto c : cells) {
+    out.add_x(c.x);
+    out.add_y(c.y);
+  }
+
+  toLayerColumns(out, layers, layerMask, [&](auto && fn) {
+    for (auto c : cells) {
+      fn(c);
+    }
+  });
+}
+
 void toLayerAir(pb::layer::Air & out, const LayerAir & in) {
   for (const auto & air : in.getAirContainer().getList()) {
     toAirPlain(*out.add_airs(), *air);
@@ -116,9 +229,7 @@ void toWirelessContainer(pb::network::WirelessContainer & out,
 }
 
 void toPacket(pb::network::Packet & out, const Network::Packet & in) {
-  std::string content(reinterpret_cast<const char *>(in.getContent().data()),
-                      in.getContent().size());
-  out.set_content(std::move(content));
+  out.set_content(in.getContent().data(), in.getContent().size());
 }
 
 void toPhysical(pb::Physical & out, const Physical & in) {
@@ -290,6 +401,40 @@ void toSubjectId(cwspb::SubjectId & out, const Subject::Id & id, Coordinates c)
 
 int toSubjectType(Subject::Type in) { return static_cast<int>(in); }
 
+static double toMicroseconds(std::chrono::nanoseconds in) {
+  return std::chrono::duration<double, std::micro>(in).count();
+}
+
+void toStageProfile(pb::StageProfile & out, const StageProfile & in,
+                    const char * stage) {
+  out.set_stage(stage);
+  out.set_count(in.count);
+  out.set_mean(toMicroseconds(in.mean));
+  out.set_min(toMicroseconds(in.min));
+  out.set_max(toMicroseconds(in.max));
+  out.set_p50(toMicroseconds(in.p50));
+  out.set_p90(toMicroseconds(in.p90));
+  out.set_p99(toMicroseconds(in.p99));
+  for (auto count : in.histogram) {
+    out.add_histogram(count);
+  }
+}
+
+void toTickProfile(pb::TickProfile & out, const TickProfile & in) {
+  out.set_window(in.window);
+  out.set_last_tick(in.lastTick);
+  for (std::size_t i = 0; i < MAP_STAGE_COUNT; ++i) {
+    toStageProfile(*out.add_stages(), in.stages[i], toString(static_cast<MapStage>(i)));
+  }
+  toStageProfile(*out.mutable_tick(), in.tick, "tick");
+  for (std::size_t i = 0; i < PROFILE_BUCKET_COUNT; ++i) {
+    out.add_bucket_bounds(toMicroseconds(TickProfiler::getBucketBound(i)));
+  }
+  out.set_active_air_tiles(in.activeAirTiles);
+  out.set_sleeping_air_tiles(in.sleepingAirTiles);
+  out.set_air_substeps(in.airSubsteps);
+}
+
 // From
 SimulationStatus fromSimulationStatus(const int status) {
   return static_cast<SimulationStatus>(status);
@@ -321,6 +466,45 @@ Dimension fromDimension(const pb::Dimension & in) {
   return out;
 }
 
+MapRegion fromMapRegion(const pb::RequestMapRegion & in, Dimension mapDim) {
+  MapRegion out;
+  out.origin = fromCoordinates(in.origin());
+
+  Dimension size = in.has_size() ? fromDimension(in.size()) : mapDim;
+  out.size.width = std::max(0, std::min(size.width, mapDim.width - out.origin.x));
+  out.size.height = std::max(0, std::min(size.height, mapDim.height - out.origin.y));
+  return out;
+}
+
+std::optional<std::uint32_t>
+fromFieldMask(const google::protobuf::RepeatedPtrField<std::string> & paths) {
+  static const std::pair<std::string_view, std::uint32_t> fields[] = {
+      {"air", pb::MAP_LAYER_MASK_AIR | pb::MAP_LAYER_MASK_AIR_TEMPERATURE},
+      {"air.temperature", pb::MAP_LAYER_MASK_AIR_TEMPERATURE},
+      {"illumination", pb::MAP_LAYER_MASK_ILLUMINATION},
+      {"obstruction", pb::MAP_LAYER_MASK_LIGHT_OBSTRUCTION |
+                          pb::MAP_LAYER_MASK_AIR_OBSTRUCTION |
+                          pb::MAP_LAYER_MASK_WIRELESS_OBSTRUCTION},
+      {"obstruction.light", pb::MAP_LAYER_MASK_LIGHT_OBSTRUCTION},
+      {"obstruction.air", pb::MAP_LAYER_MASK_AIR_OBSTRUCTION},
+      {"obstruction.wireless", pb::MAP_LAYER_MASK_WIRELESS_OBSTRUCTION},
+      {"subject", pb::MAP_LAYER_MASK_SUBJECT | pb::MAP_LAYER_MASK_SUBJECT_COUNT},
+      {"subject.count", pb::MAP_LAYER_MASK_SUBJECT_COUNT},
+      {"wireless_network", pb::MAP_LAYER_MASK_WIRELESS_NETWORK},
+  };
+
+  std::uint32_t out = 0;
+  for (const auto & path : paths) {
+    auto it = std::find_if(std::begin(fields), std::end(fields),
+                           [&](const auto & field) { return field.first == path; });
+    if (it == std::end(fields)) {
+      return std::nullopt;
+    }
+    out |= it->second;
+  }
+  return out;
+}
+
 Coordinates fromCoordinates(const pb::Coordinates & coord) {
   Coordinates out;
   out.x = coord.x();
@@ -564,8 +748,43 @@ std::unique_ptr<Air::Plain> fromAirPlain(const pb::air::Plain & in) {
 }
 
 std::unique_ptr<Network::Packet> fromPacket(const cwspb::network::Packet & in) {
+  // the only copy of content, packet and its clones share it afterwards
   auto & inStr = in.content();
   const std::byte * byteA = reinterpret_cast<const std::byte *>(inStr.data());
-  std::vector<std::byte> byteV(byteA, byteA + inStr.size());
-  return std::make_unique<Network::Packet>(std::move(byteV));
+  return std::make_unique<Network::Packet>(
+      std::make_shared<const Network::Packet::Payload>(byteA, byteA + inStr.size()));
+}
+
+MapImportQuery fromImportMap(const pb::RequestImportMap & in) {
+  MapImportQuery out;
+  out.subjects.reserve(in.subjects_size());
+  for (const auto & item : in.subjects()) {
+    Subject::Id id;
+    Coordinates coordinates;
+    fromSubjectId(id, coordinates, item.id());
+    out.subjects.emplace_back(SubjectModifyType::INSERT, coordinates,
+                              fromSubjectAny(item.subject()));
+  }
+
+  out.air.reserve(in.air_size());
+  for (const auto & item : in.air()) {
+    out.air.emplace_back(fromCoordinates(item.coordinates()), fromAirPlain(item.air()));
+  }
+  return out;
+}
+
+AirRegionQuery fromAirRegion(const pb::RequestModifyAirRegion & in) {
+  AirRegionQuery out{static_cast<AirRegionModifyType>(in.modify_type())};
+  out.region.origin = fromCoordinates(in.origin());
+  out.region.size = fromDimension(in.size());
+  out.region.polygon.reserve(in.polygon_size());
+  for (const auto & vertex : in.polygon()) {
+    out.region.polygon.push_back(fromCoordinates(vertex));
+  }
+  if (in.has_fill()) {
+    out.air = fromAirPlain(in.fill().air());
+  }
+  out.factor = in.factor();
+  out.temperature = Temperature{in.temperature()};
+  return out;
 }
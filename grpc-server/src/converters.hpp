@@ -3,6 +3,7 @@
 // To
 #include "cws/common.hpp"
 #include "cws/map.hpp"
+#include "cws/profiler.hpp"
 #include "cws/simulation/general.hpp"
 #include "cws/simulation/simulation_map.hpp"
 #include "cws/simulation/state.hpp"
@@ -11,7 +12,21 @@
 #include "cwspb/map.pb.h"
 #include "cwspb/service/common.pb.h"
 #include "cwspb/service/sv_map.pb.h"
+#include "cwspb/service/sv_map_import.pb.h"
+#include "cwspb/service/sv_map_region.pb.h"
+#include "cwspb/service/sv_profiler.pb.h"
 #include "cwspb/service/sv_simulation.pb.h"
+#include <optional>
+#include <vector>
+
+// Rectangle of map
+struct MapRegion final {
+  Coordinates origin;
+  Dimension size;
+};
+
+constexpr std::uint32_t MAP_LAYER_MASK_ALL = 0x1FF;
+constexpr std::uint32_t MAP_LAYER_MASK_SCALAR = 0x3F;
 
 int toSimulationStatus(const SimulationStatus status);
 int toSimulationType(const SimulationType type);
@@ -20,7 +35,17 @@ void toSimulationState(cwspb::SimulationState & out, const struct SimulationStat
 void toDimension(cwspb::Dimension & out, const Dimension & in);
 
 void toCell(cwspb::Cell & out, const Layers & layers, const Coordinates c);
+// only layers selected by cwspb::MapLayerMask bits
+void toCell(cwspb::Cell & out, const Layers & layers, const Coordinates c,
+            std::uint32_t layerMask);
 void toMap(cwspb::Map & out, const Layers & layers, Dimension dim);
+// layerMask is set of cwspb::MapLayerMask bits
+void toMapTile(cwspb::MapTile & out, const Layers & layers, const MapRegion & region,
+               std::uint32_t layerMask);
+void toMapDelta(cwspb::MapDelta & out, const Layers & layers,
+                const std::vector<Coordinates> & cells, std::uint32_t layerMask);
+// value of single scalar cwspb::MapLayerMask bit, NaN for air temperature without air
+float toLayerScalar(const Layers & layers, Coordinates c, std::uint32_t layerBit);
 
 void toCoordinates(cwspb::Coordinates & out, const Coordinates & in);
 void toTemperature(cwspb::Temperature & out, const Temperature & temp);
@@ -50,12 +75,21 @@ void toSubjectId(cwspb::subject::Id & out, const Subject::Id & id);
 void toSubjectId(cwspb::SubjectId & out, const Subject::Id & id, Coordinates c);
 int toSubjectType(Subject::Type in);
 
+void toStageProfile(cwspb::StageProfile & out, const StageProfile & in,
+                    const char * stage);
+void toTickProfile(cwspb::TickProfile & out, const TickProfile & in);
+
 // From
 SimulationStatus fromSimulationStatus(const int status);
 SimulationType fromSimulationType(const int type);
 SimulationStateIn fromSimulationState(const cwspb::SimulationState & in);
 
 Dimension fromDimension(const cwspb::Dimension & in);
+// region clipped by map dimension, may be empty
+MapRegion fromMapRegion(const cwspb::RequestMapRegion & in, Dimension mapDim);
+// cwspb::MapLayerMask bits of field mask paths, nullopt if some path is unknown
+std::optional<std::uint32_t>
+fromFieldMask(const google::protobuf::RepeatedPtrField<std::string> & paths);
 
 Coordinates fromCoordinates(const cwspb::Coordinates & coord);
 Temperature fromTemperature(const cwspb::Temperature & in);
@@ -75,3 +109,8 @@ void fromAirId(Air::Id & outId, Coordinates & outC, const cwspb::AirId & id);
 std::unique_ptr<Air::Plain> fromAirPlain(const cwspb::air::Plain & in);
 
 std::unique_ptr<Network::Packet> fromPacket(const cwspb::network::Packet & in);
+
+// items of chunk as inserts, subject is nullptr if its type is unknown
+MapImportQuery fromImportMap(const cwspb::RequestImportMap & in);
+// air is nullptr unless fill is set
+AirRegionQuery fromAirRegion(const cwspb::RequestModifyAirRegion & in);
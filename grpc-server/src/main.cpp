@@ -1,17 +1,141 @@
+#include <algorithm>
+#include <filesystem>
 #include <iostream>
 
+#include "cws/log.hpp"
+#include "registry.hpp"
 #include "service/sv_device.hpp"
+#include "service/sv_device_batch.hpp"
 #include "service/sv_map.hpp"
+#include "service/sv_map_import.hpp"
+#include "service/sv_map_region.hpp"
+#include "service/sv_profiler.hpp"
+#include "service/sv_registry.hpp"
 #include "service/sv_simulation.hpp"
+#include "service/sv_snapshot.hpp"
+#include <cws/simulation/checkpoint.hpp>
+#include <cws/simulation/journal.hpp>
 #include <cws/simulation/simulation.hpp>
 #include <grpcpp/completion_queue.h>
+#include <grpcpp/resource_quota.h>
 #include <grpcpp/security/server_credentials.h>
 #include <grpcpp/server_builder.h>
 
+// zero keeps grpc default
+struct ServerOptions final {
+  float deltaEpsilon = 0.01;// least change of layer value sent to subscribers
+
+  int completionQueues = 0;// of sync services, streaming map regions
+  int minPollers = 0;
+  int maxPollers = 0;
+
+  int maxThreads = 0;// resource quota for whole server
+  std::size_t memoryQuota = 0;
+  int maxStreams = 0;// concurrent streams per connection
+
+  std::string snapshotDir = ".";// where SnapshotService reads and writes files
+  std::string snapshot;         // loaded on start if set
+
+  // written in background if directory is set, newest is loaded on start
+  CheckpointOptions checkpoint;
+  std::string journal;// applied queries are appended, replayed after checkpoint
+
+  // simulations created by clients, besides default one
+  RegistryOptions registry;
+};
+
+ServerOptions parseOptions(int argc, char * argv[]) {
+  ServerOptions options;
+  for (int i = 3; i < argc; i += 2) {
+    std::string name = argv[i];
+    if (i + 1 == argc) {
+      throw std::invalid_argument("No value for option " + name);
+    }
+    std::string value = argv[i + 1];
+
+    if (name == "--delta-epsilon") {
+      options.deltaEpsilon = std::stof(value);
+    } else if (name == "--cqs") {
+      options.completionQueues = std::stoi(value);
+    } else if (name == "--min-pollers") {
+      options.minPollers = std::stoi(value);
+    } else if (name == "--max-pollers") {
+      options.maxPollers = std::stoi(value);
+    } else if (name == "--max-threads") {
+      options.maxThreads = std::stoi(value);
+    } else if (name == "--memory-quota") {
+      options.memoryQuota = std::stoull(value);
+    } else if (name == "--max-streams") {
+      options.maxStreams = std::stoi(value);
+    } else if (name == "--snapshot-dir") {
+      options.snapshotDir = value;
+    } else if (name == "--snapshot") {
+      options.snapshot = value;
+    } else if (name == "--checkpoint-dir") {
+      options.checkpoint.directory = value;
+    } else if (name == "--checkpoint-ticks") {
+      options.checkpoint.everyTicks = std::stoull(value);
+    } else if (name == "--checkpoint-seconds") {
+      options.checkpoint.every = std::chrono::seconds(std::stoll(value));
+    } else if (name == "--checkpoint-keep") {
+      options.checkpoint.keepFull = std::stoull(value);
+    } else if (name == "--journal") {
+      options.journal = value;
+    } else if (name == "--pool-threads") {
+      options.registry.poolThreads = std::stoul(value);
+    } else if (name == "--max-simulations") {
+      options.registry.maxSimulations = std::stoull(value);
+    } else if (name == "--tenant-max-cells") {
+      options.registry.limits.maxCells = std::stoull(value);
+    } else if (name == "--tenant-max-tick-rate") {
+      options.registry.limits.maxTickRate = std::stod(value);
+    } else if (name == "--air-sleep-tile") {
+      // tiles of air at equilibrium sleep, off if 0
+      int tileSize = std::stoi(value);
+      options.registry.airSleeping.enabled = tileSize > 0;
+      if (tileSize > 0) {
+        options.registry.airSleeping.tileSize = tileSize;
+      }
+    } else if (name == "--air-substeps") {
+      // adaptive air step, at most that many sub-steps a tick
+      options.registry.airStepping.adaptive = true;
+      options.registry.airStepping.maxSubsteps = std::max(std::stoi(value), 1);
+    } else {
+      throw std::invalid_argument("Unknown option " + name);
+    }
+  }
+  return options;
+}
+
 void buildServer(grpc::ServerBuilder & builder, const std::string & address,
-                 const int port) {
+                 const int port, const ServerOptions & options) {
   std::string uri = address + ":" + std::to_string(port);
   builder.AddListeningPort(uri, grpc::InsecureServerCredentials());
+
+  if (options.completionQueues > 0) {
+    builder.SetSyncServerOption(grpc::ServerBuilder::NUM_CQS, options.completionQueues);
+  }
+  if (options.minPollers > 0) {
+    builder.SetSyncServerOption(grpc::ServerBuilder::MIN_POLLERS, options.minPollers);
+  }
+  if (options.maxPollers > 0) {
+    builder.SetSyncServerOption(grpc::ServerBuilder::MAX_POLLERS, options.maxPollers);
+  }
+
+  if (options.maxThreads > 0 || options.memoryQuota > 0) {
+    grpc::ResourceQuota quota("cws-server");
+    if (options.maxThreads > 0) {
+      quota.SetMaxThreads(options.maxThreads);
+    }
+    if (options.memoryQuota > 0) {
+      quota.Resize(options.memoryQuota);
+    }
+    builder.SetResourceQuota(quota);
+  }
+
+  if (options.maxStreams > 0) {
+    builder.AddChannelArgument(GRPC_ARG_MAX_CONCURRENT_STREAMS, options.maxStreams);
+  }
 }
 
 template<typename T>
@@ -19,43 +143,95 @@ void registerService(grpc::ServerBuilder & builder, T & service) {
   builder.RegisterService(&service);
 }
 
-SimulationStateIn getDefaultState() {
-  SimulationStateIn state;
-  state.simType.set(SimulationType::INFINITE);
-  state.simStatus.set(SimulationStatus::STOPPED);
-  state.currentTick.set(0);
-  state.lastTick.set(0);
-  state.taskFrequency.set(1);
-  return state;
+/*
+ * Newest checkpoint, brought by journal to tick reached before server was stopped.
+ * Map is nullptr if there is no checkpoint
+ */
+RestoredCheckpoint resume(const ServerOptions & options) {
+  auto restored = Checkpointer::restore(options.checkpoint.directory);
+  if (!restored.map) {
+    return restored;
+  }
+  CWS_LOG_INFO("server", "checkpoint of tick " << restored.tick << " is loaded");
+
+  if (options.journal.empty() || !std::filesystem::exists(options.journal)) {
+    return restored;
+  }
+
+  JournalReplay replay(options.journal);
+  if (restored.tick < replay.getResetTick() || restored.tick >= replay.getEndTick()) {
+    return restored;
+  }
+
+  auto endTick = replay.getEndTick();
+  restored.map = replay.replay(std::move(restored.map), restored.tick, endTick);
+  restored.tick = endTick;
+  CWS_LOG_INFO("server", "journal is replayed to tick " << endTick);
+  return restored;
 }
 
-int run(const std::string & host, int port) {
-  SimulationInterface interface;
-  SimulationMaster master(interface);
+int run(const std::string & host, int port, ServerOptions options) {
+  options.registry.deltaEpsilon = options.deltaEpsilon;
+  SimulationRegistry registry(options.registry);
 
-  interface.setSimulationMaster(&master);
+  // checkpoints, journal and snapshot of options are of default simulation
+  auto & interface = registry.getDefault().interface;
   auto state = getDefaultState();
+
+  std::unique_ptr<Checkpointer> checkpointer;
+  if (!options.checkpoint.directory.empty()) {
+    checkpointer = std::make_unique<Checkpointer>(interface, options.checkpoint);
+  }
+
+  if (!options.snapshot.empty()) {
+    interface.setMap(loadSnapshot(options.snapshot));
+    CWS_LOG_INFO("server", "map loaded from " << options.snapshot);
+  } else if (checkpointer) {
+    auto [map, tick] = resume(options);
+    if (map) {
+      // chain of checkpoints and journal starts again from resumed map
+      checkpointer->write(tick, *map);
+      interface.setMap(std::move(map));
+      state.currentTick.set(tick);
+    }
+  }
   interface.setState(state);
 
+  std::unique_ptr<Journal> journal;
+  if (!options.journal.empty()) {
+    journal = std::make_unique<Journal>(options.journal);
+    interface.setJournal(journal.get());
+  }
+
   interface.run();
 
   grpc::ServerBuilder builder;
 
-  buildServer(builder, host, port);
+  buildServer(builder, host, port, options);
 
-  SimulationService simulationService(interface);
-  MapService mapService(interface);
-  DeviceService deviceService(interface);
+  SimulationService simulationService(registry);
+  MapService mapService(registry);
+  MapImportService mapImportService(registry);
+  MapRegionService mapRegionService(registry);
+  DeviceService deviceService(registry);
+  DeviceBatchService deviceBatchService(registry);
+  ProfilerService profilerService(registry);
+  SnapshotService snapshotService(registry, options.snapshotDir);
+  SimulationRegistryService registryService(registry);
 
   registerService(builder, simulationService);
   registerService(builder, mapService);
+  registerService(builder, mapImportService);
+  registerService(builder, mapRegionService);
   registerService(builder, deviceService);
+  registerService(builder, deviceBatchService);
+  registerService(builder, profilerService);
+  registerService(builder, snapshotService);
+  registerService(builder, registryService);
 
   auto server(builder.BuildAndStart());
 
-#ifndef NDEBUG
-  std::cout << "server: started" << std::endl;
-#endif
+  CWS_LOG_INFO("server", "started on " << host << ":" << port);
 
   server->Wait();
   interface.exit();
@@ -66,15 +242,18 @@ int run(const std::string & host, int port) {
 int main(int argc, char * argv[]) {
 
   try {
-    if (argc != 3) {
-      throw std::invalid_argument("Invalid count of arguments. Required 3.");
+    if (argc < 3) {
+      throw std::invalid_argument(
+          "Invalid count of arguments. Usage: host port [--option value]...");
     }
 
     std::string host = argv[1];
     int port = std::stoi(argv[2]);
-    return run(host, port);
+    return run(host, port, parseOptions(argc, argv));
 
   } catch (std::invalid_argument & e) {
     std::cout << e.what() << std::endl;
+  } catch (std::system_error & e) {
+    std::cout << e.what() << std::endl;
   }
 }
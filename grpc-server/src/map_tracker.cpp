@@ -0,0 +1,123 @@
+#include "map_tracker.hpp"
+
+#include <cmath>
+#include <functional>
+#include <limits>
+
+#include "converters.hpp"
+
+constexpr std::size_t SCALAR_LAYER_COUNT = 6;
+
+MapTracker::MapTracker(SimulationInterface & interface, float epsilon)
+    : interface_(interface), epsilon_(epsilon) {
+  worker_ = std::jthread(std::bind_front(&MapTracker::execute, this));
+}
+
+void MapTracker::subscribe() {
+  std::unique_lock lock(mutex_);
+  subscribers_ += 1;
+}
+
+void MapTracker::unsubscribe() {
+  std::unique_lock lock(mutex_);
+  subscribers_ -= 1;
+  if (subscribers_ == 0) {
+    history_.clear();
+  }
+}
+
+std::shared_ptr<const MapChanges> MapTracker::wait(std::size_t sequence,
+                                                   std::chrono::milliseconds timeout) {
+  std::unique_lock lock(mutex_);
+  bool published = published_.wait_for(lock, timeout, [&] {
+    return !history_.empty() && history_.back()->sequence > sequence;
+  });
+  if (!published) {
+    return nullptr;
+  }
+
+  for (const auto & changes : history_) {
+    if (sequence != 0 && changes->sequence == sequence + 1) {
+      return changes;
+    }
+  }
+  return history_.back();
+}
+
+void MapTracker::execute(std::stop_token stoken) {
+  std::size_t version = 0;
+
+  while (!stoken.stop_requested()) {
+    bool idle;
+    {
+      std::unique_lock lock(mutex_);
+      idle = subscribers_ == 0;
+    }
+
+    if (idle) {
+      baseline_.clear();
+      baseline_.shrink_to_fit();
+      baselineDim_ = Dimension{0, 0};
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      continue;
+    }
+
+    auto snapshot = interface_.waitMap(version, std::chrono::milliseconds(100));
+    if (snapshot.version == version || snapshot.map == nullptr) {
+      version = snapshot.version;
+      continue;
+    }
+    version = snapshot.version;
+
+    auto changes = compare(snapshot);
+
+    std::unique_lock lock(mutex_);
+    history_.push_back(std::move(changes));
+    if (history_.size() > HISTORY_SIZE) {
+      history_.pop_front();
+    }
+    published_.notify_all();
+  }
+}
+
+std::shared_ptr<MapChanges> MapTracker::compare(const MapSnapshot & snapshot) {
+  auto changes = std::make_shared<MapChanges>();
+  changes->sequence = ++sequence_;
+  changes->tick = snapshot.tick;
+  changes->map = snapshot.map;
+
+  auto dim = snapshot.map->getDimension();
+  changes->full = dim.width != baselineDim_.width || dim.height != baselineDim_.height;
+  if (changes->full) {
+    baseline_.assign(dim.width * dim.height * SCALAR_LAYER_COUNT,
+                     std::numeric_limits<float>::quiet_NaN());
+    baselineDim_ = dim;
+  }
+
+  const auto & layers = snapshot.map->getLayers();
+  float * base = baseline_.data();
+
+  Coordinates c;
+  for (c.y = 0; c.y < dim.height; ++c.y) {
+    for (c.x = 0; c.x < dim.width; ++c.x) {
+      std::uint32_t changed = 0;
+
+      for (std::size_t i = 0; i < SCALAR_LAYER_COUNT; ++i, ++base) {
+        std::uint32_t bit = 1u << i;
+        float value = toLayerScalar(layers, c, bit);
+        bool differs = std::isnan(value) != std::isnan(*base) ||
+                       std::fabs(value - *base) > epsilon_;
+        if (changes->full || differs) {
+          changed |= bit;
+          *base = value;
+        }
+      }
+
+      if (changed != 0) {
+        changes->cells.push_back(c);
+        changes->layers.push_back(changed);
+      }
+    }
+  }
+  return changes;
+}
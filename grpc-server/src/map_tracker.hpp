@@ -0,0 +1,65 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "cws/simulation/interface.hpp"
+
+struct MapChanges final {
+  std::size_t sequence;// incremented on every published changes
+  std::size_t tick;
+  bool full;// baseline is reset, every cell is changed
+  std::shared_ptr<const SimulationMap> map;
+  std::vector<Coordinates> cells;
+  std::vector<std::uint32_t> layers;// changed cwspb::MapLayerMask bits of cells
+};
+
+/*
+ * Compares every published map with values last reported for each cell and scalar
+ * layer. Value is reported once it differs more than epsilon, so slow drift is
+ * not lost. Changes are computed once per tick for all subscribers, while anyone
+ * is subscribed.
+ */
+class MapTracker final {
+  static constexpr std::size_t HISTORY_SIZE = 16;
+
+  SimulationInterface & interface_;
+  float epsilon_;
+
+  std::mutex mutex_;
+  std::condition_variable published_;
+  std::deque<std::shared_ptr<const MapChanges>> history_;
+  std::size_t subscribers_ = 0;
+
+  // accessed by worker only
+  std::vector<float> baseline_;// scalar layers of cell are stored together
+  Dimension baselineDim_{0, 0};
+  std::size_t sequence_ = 0;
+
+  std::jthread worker_;
+
+public:
+  MapTracker(SimulationInterface & interface, float epsilon);
+
+  MapTracker(const MapTracker &) = delete;
+  MapTracker & operator=(const MapTracker &) = delete;
+
+  void subscribe();
+  void unsubscribe();
+
+  /*
+   * Changes following `sequence`, or the latest ones when they are not kept
+   * anymore or `sequence` is 0. nullptr on timeout
+   */
+  std::shared_ptr<const MapChanges> wait(std::size_t sequence,
+                                         std::chrono::milliseconds timeout);
+
+private:
+  void execute(std::stop_token stoken);
+  std::shared_ptr<MapChanges> compare(const MapSnapshot & snapshot);
+};
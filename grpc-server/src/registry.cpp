@@ -0,0 +1,116 @@
+#include "registry.hpp"
+
+#include "cws/log.hpp"
+
+SimulationStateIn getDefaultState() {
+  SimulationStateIn state;
+  state.simType.set(SimulationType::INFINITE);
+  state.simStatus.set(SimulationStatus::STOPPED);
+  state.currentTick.set(0);
+  state.lastTick.set(0);
+  state.taskFrequency.set(1);
+  return state;
+}
+
+SimulationRegistry::Simulation::Simulation(SimulationPool * pool, float epsilon)
+    : pool_(pool), epsilon_(epsilon), master(interface) {
+  interface.setSimulationMaster(&master);
+  interface.setState(getDefaultState());
+}
+
+SimulationRegistry::Simulation::~Simulation() {
+  if (pool_) {
+    pool_->remove(master);
+  }
+}
+
+MapTracker & SimulationRegistry::Simulation::getTracker() {
+  std::call_once(trackerOnce_, [this] {
+    tracker_ = std::make_unique<MapTracker>(interface, epsilon_);
+  });
+  return *tracker_;
+}
+
+SimulationRegistry::SimulationRegistry(const RegistryOptions & options)
+    : options_(options), pool_(options.poolThreads),
+      default_(std::make_shared<Simulation>(nullptr, options.deltaEpsilon)) {
+  default_->interface.setAirSleeping(options_.airSleeping);
+  default_->interface.setAirStepping(options_.airStepping);
+}
+
+std::shared_ptr<SimulationRegistry::Simulation>
+SimulationRegistry::find(const grpc::ServerContextBase & context) const {
+  return find(getId(context));
+}
+
+std::shared_ptr<SimulationRegistry::Simulation>
+SimulationRegistry::find(const std::string & id) const {
+  if (id.empty()) {
+    return default_;
+  }
+  std::shared_lock lock(mutex_);
+  auto it = simulations_.find(id);
+  return it == simulations_.end() ? nullptr : it->second;
+}
+
+std::string SimulationRegistry::getId(const grpc::ServerContextBase & context) {
+  const auto & metadata = context.client_metadata();
+  auto it = metadata.find(ID_METADATA);
+  if (it == metadata.end()) {
+    return {};
+  }
+  return std::string(it->second.data(), it->second.size());
+}
+
+std::string SimulationRegistry::create(const std::string & id) {
+  if (id.empty()) {
+    return "simulation id is empty";
+  }
+  // id names directory of its snapshots
+  if (id == "." || id == ".." || id.find('/') != std::string::npos) {
+    return "simulation id is not a plain name";
+  }
+
+  std::unique_lock lock(mutex_);
+  if (simulations_.contains(id)) {
+    return "simulation already exists";
+  }
+  if (options_.maxSimulations > 0 && simulations_.size() >= options_.maxSimulations) {
+    return "simulation limit is reached";
+  }
+
+  auto simulation = std::make_shared<Simulation>(&pool_, options_.deltaEpsilon);
+  simulation->interface.setMaxCells(options_.limits.maxCells);
+  simulation->interface.setAirSleeping(options_.airSleeping);
+  simulation->interface.setAirStepping(options_.airStepping);
+  pool_.add(simulation->master, options_.limits.maxTickRate);
+  simulations_.emplace(id, std::move(simulation));
+  CWS_LOG_INFO("registry", "simulation " << id << " is created");
+  return {};
+}
+
+bool SimulationRegistry::remove(const std::string & id) {
+  // released out of lock, as it may wait for tick in progress
+  std::shared_ptr<Simulation> removed;
+  {
+    std::unique_lock lock(mutex_);
+    auto it = simulations_.find(id);
+    if (it == simulations_.end()) {
+      return false;
+    }
+    removed = std::move(it->second);
+    simulations_.erase(it);
+  }
+  CWS_LOG_INFO("registry", "simulation " << id << " is deleted");
+  return true;
+}
+
+std::vector<std::string> SimulationRegistry::list() const {
+  std::shared_lock lock(mutex_);
+  std::vector<std::string> ids;
+  ids.reserve(simulations_.size());
+  for (const auto & [id, simulation] : simulations_) {
+    ids.push_back(id);
+  }
+  return ids;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include "cws/simulation/interface.hpp"
+#include "cws/simulation/pool.hpp"
+#include "cws/simulation/simulation.hpp"
+#include "map_tracker.hpp"
+#include <grpcpp/server_context.h>
+#include <grpcpp/support/status.h>
+
+// zero is no limit
+struct TenantLimits final {
+  std::size_t maxCells = 0;// of map, memory of simulation grows with its cells
+  double maxTickRate = 0;  // ticks per second, below task frequency set by client
+};
+
+struct RegistryOptions final {
+  unsigned poolThreads = 0;     // hardware concurrency if 0
+  std::size_t maxSimulations = 0;// besides default one
+  TenantLimits limits;
+  float deltaEpsilon = 0.01;// of map trackers
+  AirSleeping airSleeping;  // of maps of every simulation
+  AirStepping airStepping;
+};
+
+// stopped infinite simulation at one tick per second
+SimulationStateIn getDefaultState();
+
+/*
+ * Simulations of server by id. Default one is run by own master threads, others are
+ * created by clients and stepped by shared pool within tenant limits. Simulation is
+ * kept alive by calls using it after it's deleted
+ */
+class SimulationRegistry final {
+public:
+  static constexpr const char * ID_METADATA = "cws-simulation-id";
+
+  class Simulation final {
+    SimulationPool * pool_;// stepped by pool if set
+    float epsilon_;
+
+  public:
+    SimulationInterface interface;
+    SimulationMaster master;
+
+  private:
+    // destroyed first, as it reads interface
+    std::once_flag trackerOnce_;
+    std::unique_ptr<MapTracker> tracker_;
+
+  public:
+
+    Simulation(SimulationPool * pool, float epsilon);
+    ~Simulation();
+
+    Simulation(const Simulation &) = delete;
+    Simulation & operator=(const Simulation &) = delete;
+
+    // created on first subscription, as tracker has own thread
+    MapTracker & getTracker();
+  };
+
+private:
+  RegistryOptions options_;
+  SimulationPool pool_;// outlives simulations stepped by it
+  std::shared_ptr<Simulation> default_;
+
+  mutable std::shared_mutex mutex_;
+  std::map<std::string, std::shared_ptr<Simulation>> simulations_;
+
+public:
+  explicit SimulationRegistry(const RegistryOptions & options);
+
+  SimulationRegistry(const SimulationRegistry &) = delete;
+  SimulationRegistry & operator=(const SimulationRegistry &) = delete;
+
+  Simulation & getDefault() { return *default_; }
+
+  // by metadata of call, default one without it, nullptr if id is unknown
+  std::shared_ptr<Simulation> find(const grpc::ServerContextBase & context) const;
+  std::shared_ptr<Simulation> find(const std::string & id) const;
+  // of metadata of call, empty for default one
+  static std::string getId(const grpc::ServerContextBase & context);
+
+  // error text if simulation is not created
+  std::string create(const std::string & id);
+  bool remove(const std::string & id);
+  std::vector<std::string> list() const;
+
+  static grpc::Status notFound() {
+    return grpc::Status(grpc::StatusCode::NOT_FOUND, "unknown simulation id");
+  }
+};
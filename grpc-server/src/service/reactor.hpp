@@ -0,0 +1,108 @@
+#pragma once
+
+#include "registry.hpp"
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <grpcpp/server_context.h>
+#include <grpcpp/support/server_callback.h>
+#include <grpcpp/support/status.h>
+
+/*
+ * Handlers of callback services run on threads of grpc and should not block,
+ * unary ones fill response and finish default reactor right away
+ */
+inline grpc::ServerUnaryReactor *
+reply(grpc::CallbackServerContext * context,
+      const grpc::Status & status = grpc::Status::OK) {
+  auto reactor = context->DefaultReactor();
+  reactor->Finish(status);
+  return reactor;
+}
+
+/*
+ * Writes responses filled by `next` one by one, next returns false when there is
+ * nothing to write. Deletes itself when call is done
+ */
+template<typename Response>
+class StreamWriter final : public grpc::ServerWriteReactor<Response> {
+  std::function<bool(Response &)> next_;
+  Response response_;
+
+public:
+  explicit StreamWriter(std::function<bool(Response &)> next) : next_(std::move(next)) {
+    writeNext();
+  }
+
+  void OnWriteDone(bool ok) override {
+    if (!ok) {
+      this->Finish(grpc::Status::CANCELLED);
+      return;
+    }
+    writeNext();
+  }
+
+  void OnDone() override { delete this; }
+
+private:
+  void writeNext() {
+    response_.Clear();
+    if (next_(response_)) {
+      this->StartWrite(&response_);
+    } else {
+      this->Finish(grpc::Status::OK);
+    }
+  }
+};
+
+// stream call finished right away, e.g. with error status. Deletes itself when done
+template<typename Reactor>
+class FinishedReactor final : public Reactor {
+public:
+  explicit FinishedReactor(const grpc::Status & status) { this->Finish(status); }
+
+  void OnDone() override { delete this; }
+};
+
+using SimulationPtr = std::shared_ptr<SimulationRegistry::Simulation>;
+
+// interface of simulation if handle takes it, otherwise simulation itself
+template<typename Handle>
+decltype(auto) handleSimulation(Handle && handle, SimulationPtr simulation) {
+  if constexpr (std::is_invocable_v<Handle, SimulationInterface &>) {
+    return handle(simulation->interface);
+  } else {
+    return handle(std::move(simulation));
+  }
+}
+
+/*
+ * Calls `handle` with interface of simulation chosen by metadata of call, or with
+ * simulation itself when handle doesn't take interface. Call of unknown simulation
+ * is finished with NOT_FOUND instead, by default reactor for unary calls
+ */
+template<typename Reactor = grpc::ServerUnaryReactor, typename Handle>
+Reactor * withSimulation(SimulationRegistry & registry,
+                         grpc::CallbackServerContext * context, Handle && handle) {
+  auto simulation = registry.find(*context);
+  if (!simulation) {
+    if constexpr (std::is_same_v<Reactor, grpc::ServerUnaryReactor>) {
+      return reply(context, SimulationRegistry::notFound());
+    } else {
+      return new FinishedReactor<Reactor>(SimulationRegistry::notFound());
+    }
+  }
+  return handleSimulation(std::forward<Handle>(handle), std::move(simulation));
+}
+
+// same for handlers of sync services, which return status of call
+template<typename Handle>
+grpc::Status withSimulation(SimulationRegistry & registry,
+                            grpc::ServerContext * context, Handle && handle) {
+  auto simulation = registry.find(*context);
+  if (!simulation) {
+    return SimulationRegistry::notFound();
+  }
+  return handleSimulation(std::forward<Handle>(handle), std::move(simulation));
+}
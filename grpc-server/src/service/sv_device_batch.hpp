@@ -0,0 +1,116 @@
+#pragma once
+
+#include "cwspb/service/sv_device_batch.grpc.pb.h"
+#include "registry.hpp"
+#include "service/reactor.hpp"
+#include "service/sv_device_op.hpp"
+#include "service/verify.hpp"
+#include <grpcpp/support/status.h>
+
+/*
+ * Same operations as DeviceService for list of devices, all of them use one map
+ * snapshot and every item gets its own status
+ */
+class DeviceBatchService final : public cwspb::DeviceBatchService::CallbackService {
+private:
+  SimulationRegistry & registry;
+
+public:
+  DeviceBatchService(SimulationRegistry & registry) : registry(registry) {}
+
+  grpc::ServerUnaryReactor *
+  GetAirTemperatures(::grpc::CallbackServerContext * context,
+                     const ::cwspb::RequestDevices * request,
+                     ::cwspb::ResponseAirTemperatures * response) override {
+    return withSimulation(registry, context, [&](SimulationInterface & interface) {
+      auto map = interface.getMap();
+      if (verifyMapCreated(map, *response->mutable_base())) {
+        response->mutable_items()->Reserve(request->items_size());
+        for (const auto & item : request->items()) {
+          getAirTemperature(*map, item, *response->add_items());
+        }
+      }
+      return reply(context);
+    });
+  }
+
+  grpc::ServerUnaryReactor *
+  GetIlluminations(::grpc::CallbackServerContext * context,
+                   const ::cwspb::RequestDevices * request,
+                   ::cwspb::ResponseIlluminations * response) override {
+    return withSimulation(registry, context, [&](SimulationInterface & interface) {
+      auto map = interface.getMap();
+      if (verifyMapCreated(map, *response->mutable_base())) {
+        response->mutable_items()->Reserve(request->items_size());
+        for (const auto & item : request->items()) {
+          getIllumination(*map, item, *response->add_items());
+        }
+      }
+      return reply(context);
+    });
+  }
+
+  grpc::ServerUnaryReactor *
+  GetCameraInfos(::grpc::CallbackServerContext * context,
+                 const ::cwspb::RequestDevices * request,
+                 ::cwspb::ResponseCameraInfos * response) override {
+    return withSimulation(registry, context, [&](SimulationInterface & interface) {
+      auto map = interface.getMap();
+      if (verifyMapCreated(map, *response->mutable_base())) {
+        response->mutable_items()->Reserve(request->items_size());
+        for (const auto & item : request->items()) {
+          getCameraInfo(*map, item, *response->add_items());
+        }
+      }
+      return reply(context);
+    });
+  }
+
+  grpc::ServerUnaryReactor *
+  ReceivePacketsBatch(::grpc::CallbackServerContext * context,
+                      const ::cwspb::RequestDevices * request,
+                      ::cwspb::ResponseReceivedPacketsBatch * response) override {
+    return withSimulation(registry, context, [&](SimulationInterface & interface) {
+      auto map = interface.getMap();
+      if (verifyMapCreated(map, *response->mutable_base())) {
+        response->mutable_items()->Reserve(request->items_size());
+        for (const auto & item : request->items()) {
+          receivePackets(*map, item, *response->add_items());
+        }
+      }
+      return reply(context);
+    });
+  }
+
+  grpc::ServerUnaryReactor *
+  TransmitPacketsBatch(::grpc::CallbackServerContext * context,
+                       const ::cwspb::RequestTransmitPacketsBatch * request,
+                       ::cwspb::ResponseBatch * response) override {
+    return withSimulation(registry, context, [&](SimulationInterface & interface) {
+      auto map = interface.getMap();
+      if (verifyMapCreated(map, *response->mutable_base())) {
+        response->mutable_items()->Reserve(request->items_size());
+        for (const auto & item : request->items()) {
+          transmitPackets(interface, *map, item, *response->add_items());
+        }
+      }
+      return reply(context);
+    });
+  }
+
+  grpc::ServerUnaryReactor *
+  TurnDevices(::grpc::CallbackServerContext * context,
+              const ::cwspb::RequestTurnDevices * request,
+              ::cwspb::ResponseBatch * response) override {
+    return withSimulation(registry, context, [&](SimulationInterface & interface) {
+      auto map = interface.getMap();
+      if (verifyMapCreated(map, *response->mutable_base())) {
+        response->mutable_items()->Reserve(request->items_size());
+        for (const auto & item : request->items()) {
+          turnDevice(interface, *map, item, *response->add_items());
+        }
+      }
+      return reply(context);
+    });
+  }
+};
@@ -0,0 +1,141 @@
+#include "service/sv_device_op.hpp"
+
+#include "converters.hpp"
+#include "cws/simulation/callback.hpp"
+#include "cws/subject/camera.hpp"
+#include "cws/subject/network.hpp"
+#include "cws/subject/sensor.hpp"
+#include "service/verify.hpp"
+
+/*
+ * Subject may be requested by id alone, then its coordinates are taken from
+ * index of snapshot. False and error are set if it can't be located
+ */
+static bool locateDevice(const SimulationMap & map, const cwspb::SubjectId & pbId,
+                         Subject::Id & id, Coordinates & coord,
+                         cwspb::Response & response) {
+  if (!pbId.has_coordinates()) {
+    id = fromSubjectId(pbId.id());
+    return verifySubjectExists(map.select(id, &coord), response);
+  }
+
+  fromSubjectId(id, coord, pbId);
+  return verifyCoordinates(coord, map.getDimension(), response);
+}
+
+// false if device can't be located, subject is nullptr if it doesn't exist
+static bool selectDevice(const SimulationMap & map, const cwspb::SubjectId & pbId,
+                         cwspb::Response & response, const Subject::Plain *& subject) {
+  Subject::Id id;
+  Coordinates coord;
+  if (!locateDevice(map, pbId, id, coord, response)) {
+    return false;
+  }
+
+  subject = map.select(SubjectSelectQuery(coord, id));
+  return true;
+}
+
+void getAirTemperature(const SimulationMap & map, const cwspb::RequestDevice & request,
+                       cwspb::ResponseSensorAirTemperature & response) {
+  auto & baseResp = *response.mutable_base();
+  const Subject::Plain * subject;
+  if (!selectDevice(map, request.id(), baseResp, subject)) {
+    return;
+  }
+
+  if (auto sensor = dynamic_cast<const Subject::SensorAirTemperature *>(subject)) {
+    toTemperature(*response.mutable_temp(), sensor->getAirTemperature());
+    return;
+  }
+
+  verifySubjectExists(nullptr, baseResp);
+}
+
+void getIllumination(const SimulationMap & map, const cwspb::RequestDevice & request,
+                     cwspb::ResponseSensorIllumination & response) {
+  auto & baseResp = *response.mutable_base();
+  const Subject::Plain * subject;
+  if (!selectDevice(map, request.id(), baseResp, subject)) {
+    return;
+  }
+
+  if (auto sensor = dynamic_cast<const Subject::SensorIllumination *>(subject)) {
+    toIllumination(*response.mutable_illumination(), sensor->getCellIllumination());
+    return;
+  }
+
+  verifySubjectExists(nullptr, baseResp);
+}
+
+void getCameraInfo(const SimulationMap & map, const cwspb::RequestDevice & request,
+                   cwspb::ResponseCameraInfo & response) {
+  auto & baseResp = *response.mutable_base();
+  const Subject::Plain * subject;
+  if (!selectDevice(map, request.id(), baseResp, subject)) {
+    return;
+  }
+
+  if (auto camera = dynamic_cast<const Subject::BaseCamera *>(subject)) {
+    for (const auto & visible : camera->getVisible()) {
+      toSubjectId(*response.add_visible_subjects(), visible.id, visible.coordinates);
+    }
+    return;
+  }
+
+  verifySubjectExists(nullptr, baseResp);
+}
+
+void receivePackets(const SimulationMap & map, const cwspb::RequestDevice & request,
+                    cwspb::ResponseReceivedPackets & response) {
+  auto & baseResp = *response.mutable_base();
+  const Subject::Plain * subject;
+  if (!selectDevice(map, request.id(), baseResp, subject)) {
+    return;
+  }
+
+  if (auto receiver = dynamic_cast<const Subject::ExtReceiver *>(subject)) {
+    for (const auto & packet : receiver->getReceivedPackets()) {
+      toPacket(*response.add_packets(), *packet);
+    }
+    return;
+  }
+
+  verifySubjectExists(nullptr, baseResp);
+}
+
+void transmitPackets(SimulationInterface & interface, const SimulationMap & map,
+                     const cwspb::RequestTransmitPackets & request,
+                     cwspb::Response & response) {
+  Subject::Id id;
+  Coordinates coord;
+  if (!locateDevice(map, request.id(), id, coord, response)) {
+    return;
+  }
+
+  PacketList packetList;
+  for (const auto & packet : request.packets()) {
+    packetList.emplace_back(fromPacket(packet));
+  }
+
+  std::function<void(Subject::Plain *, void *)> callback = addPacketToTransmitQueue;
+
+  interface.addModifyQuery(std::make_unique<SubjectCallbackQuery<PacketList>>(
+      SubjectSelectQuery(coord, id), std::move(callback), std::move(packetList)));
+}
+
+void turnDevice(SimulationInterface & interface, const SimulationMap & map,
+                const cwspb::RequestTurnDevice & request, cwspb::Response & response) {
+  Subject::Id id;
+  Coordinates coord;
+  if (!locateDevice(map, request.id(), id, coord, response)) {
+    return;
+  }
+
+  Subject::TurnableStatus status = fromTurnableStatus(request.turnable_status());
+  std::function<void(Subject::Plain *, void *)> callback = setTurnableStatus;
+
+  interface.addModifyQuery(
+      std::make_unique<SubjectCallbackQuery<Subject::TurnableStatus>>(
+          SubjectSelectQuery(coord, id), std::move(callback), std::move(status)));
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "cws/simulation/interface.hpp"
+#include "cws/simulation/simulation_map.hpp"
+#include "cwspb/service/sv_device.pb.h"
+
+/*
+ * Operations on single device of map snapshot shared by single and batch
+ * services. Errors are written to base of response. Device without coordinates
+ * in id is looked up by id alone
+ */
+void getAirTemperature(const SimulationMap & map, const cwspb::RequestDevice & request,
+                       cwspb::ResponseSensorAirTemperature & response);
+
+void getIllumination(const SimulationMap & map, const cwspb::RequestDevice & request,
+                     cwspb::ResponseSensorIllumination & response);
+
+void getCameraInfo(const SimulationMap & map, const cwspb::RequestDevice & request,
+                   cwspb::ResponseCameraInfo & response);
+
+void receivePackets(const SimulationMap & map, const cwspb::RequestDevice & request,
+                    cwspb::ResponseReceivedPackets & response);
+
+// queued to be applied on next tick
+void transmitPackets(SimulationInterface & interface, const SimulationMap & map,
+                     const cwspb::RequestTransmitPackets & request,
+                     cwspb::Response & response);
+
+void turnDevice(SimulationInterface & interface, const SimulationMap & map,
+                const cwspb::RequestTurnDevice & request, cwspb::Response & response);
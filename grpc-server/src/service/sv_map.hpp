@@ -1,226 +1,265 @@
 #pragma once
 
 #include "converters.hpp"
-#include "cws/simulation/interface.hpp"
+#include "cws/log.hpp"
 #include "cwspb/service/sv_map.grpc.pb.h"
+#include "registry.hpp"
+#include "service/reactor.hpp"
 #include "service/verify.hpp"
 #include <grpcpp/support/status.h>
 
-class MapService final : public cwspb::MapService::Service {
+class MapService final : public cwspb::MapService::CallbackService {
 private:
-  SimulationInterface & interface;
+  SimulationRegistry & registry;
 
 private:
 public:
-  MapService(SimulationInterface & interface) : interface(interface) {}
-
-  grpc::Status GetMapDimension(::grpc::ServerContext * context,
-                               const cwspb::Request * request,
-                               cwspb::ResponseDimension * response) override {
-    auto map = interface.getMap();
-    if (!verifyMapCreated(map, *response->mutable_base())) {
-      return grpc::Status::OK;
-    }
-
-    auto dim = map->getDimension();
-    auto out_dim = response->mutable_dimension();
-    toDimension(*out_dim, dim);
-    return grpc::Status::OK;
+  MapService(SimulationRegistry & registry) : registry(registry) {}
+
+  grpc::ServerUnaryReactor *
+  GetMapDimension(::grpc::CallbackServerContext * context,
+                  const cwspb::Request * request,
+                  cwspb::ResponseDimension * response) override {
+    return withSimulation(registry, context, [&](SimulationInterface & interface) {
+      auto map = interface.getMap();
+      if (!verifyMapCreated(map, *response->mutable_base())) {
+        return reply(context);
+      }
+
+      auto dim = map->getDimension();
+      auto out_dim = response->mutable_dimension();
+      toDimension(*out_dim, dim);
+      return reply(context);
+    });
   }
 
-  grpc::Status CreateMap(::grpc::ServerContext * context,
-                         const cwspb::RequestDimension * request,
-                         cwspb::Response * response) override {
+  grpc::ServerUnaryReactor *
+  CreateMap(::grpc::CallbackServerContext * context,
+            const cwspb::RequestDimension * request,
+            cwspb::Response * response) override {
+    return withSimulation(registry, context, [&](SimulationInterface & interface) {
 
-    auto & status = *response->mutable_status();
+      auto & status = *response->mutable_status();
 
-    if (!request->has_dimension()) {
-      status.set_text("dimension is not specified");
-      status.set_type(cwspb::ErrorType::ERROR_TYPE_BAD_REQUEST);
-      return grpc::Status::OK;
-    }
+      if (!request->has_dimension()) {
+        status.set_text("dimension is not specified");
+        status.set_type(cwspb::ErrorType::ERROR_TYPE_BAD_REQUEST);
+        return reply(context);
+      }
 
-    Dimension dimension = fromDimension(request->dimension());
-    interface.setDimension(dimension);
+      Dimension dimension = fromDimension(request->dimension());
+      if (!interface.setDimension(dimension)) {
+        status.set_text("map exceeds cell limit");
+        status.set_type(cwspb::ErrorType::ERROR_TYPE_BAD_REQUEST);
+      }
 
-    return grpc::Status::OK;
+      return reply(context);
+    });
   }
 
-  grpc::Status GetCell(::grpc::ServerContext * context,
-                       const cwspb::RequestCell * request,
-                       cwspb::ResponseCell * response) override {
-    auto map = interface.getMap();
-    if (!verifyMapCreated(map, *response->mutable_base())) {
-      return grpc::Status::OK;
-    }
+  grpc::ServerUnaryReactor *
+  GetCell(::grpc::CallbackServerContext * context,
+          const cwspb::RequestCell * request,
+          cwspb::ResponseCell * response) override {
+    return withSimulation(registry, context, [&](SimulationInterface & interface) {
+      auto map = interface.getMap();
+      if (!verifyMapCreated(map, *response->mutable_base())) {
+        return reply(context);
+      }
 
-    auto dimension = map->getDimension();
+      auto dimension = map->getDimension();
 
-    Coordinates coord = fromCoordinates(request->coordinates());
-    if (!verifyCoordinates(coord, dimension, *response->mutable_base())) {
-      return grpc::Status::OK;
-    }
+      Coordinates coord = fromCoordinates(request->coordinates());
+      if (!verifyCoordinates(coord, dimension, *response->mutable_base())) {
+        return reply(context);
+      }
 
-    const auto & layers = map->getLayers();
-    toCell(*response->mutable_cell(), map->getLayers(), coord);
+      const auto & layers = map->getLayers();
+      toCell(*response->mutable_cell(), map->getLayers(), coord);
 
-    return grpc::Status::OK;
+      return reply(context);
+    });
   }
 
-  grpc::Status GetMap(::grpc::ServerContext * context, const cwspb::Request * request,
-                      ::cwspb::ResponseMap * response) override {
-    grpc::WriteOptions options;
+  grpc::ServerUnaryReactor *
+  GetMap(::grpc::CallbackServerContext * context,
+         const cwspb::Request * request,
+         ::cwspb::ResponseMap * response) override {
+    return withSimulation(registry, context, [&](SimulationInterface & interface) {
+      grpc::WriteOptions options;
 
-    auto map = interface.getMap();
-    if (!verifyMapCreated(map, *response->mutable_base())) {
-      return grpc::Status::OK;
-    }
+      auto map = interface.getMap();
+      if (!verifyMapCreated(map, *response->mutable_base())) {
+        return reply(context);
+      }
 
-    auto dim = map->getDimension();
-    const auto & layers = map->getLayers();
+      auto dim = map->getDimension();
+      const auto & layers = map->getLayers();
 
-    toMap(*response->mutable_map(), layers, dim);
-    return grpc::Status::OK;
+      toMap(*response->mutable_map(), layers, dim);
+      return reply(context);
+    });
   }
 
-  grpc::Status
-  GetMapCells(::grpc::ServerContext * context, const cwspb::Request * request,
-              grpc::ServerWriter<::cwspb::ResponseCell> * writer) override {
-    grpc::WriteOptions options;
-    cwspb::ResponseCell response;
-
-    auto map = interface.getMap();
-    if (!verifyMapCreated(map, *response.mutable_base())) {
-      writer->WriteLast(response, options);
-      return grpc::Status::OK;
-    }
-
-    auto dimension = map->getDimension();
-    const auto & layers = map->getLayers();
-
-    Coordinates c;
-    for (c.x = 0; c.x < dimension.width; ++c.x) {
-      for (c.y = 0; c.y < dimension.height; ++c.y) {
-        cwspb::ResponseCell response;
-        toCell(*response.mutable_cell(), layers, c);
-        writer->Write(response);
-      }
-    }
-    return grpc::Status::OK;
+  grpc::ServerWriteReactor<::cwspb::ResponseCell> *
+  GetMapCells(::grpc::CallbackServerContext * context,
+              const cwspb::Request * request) override {
+    return withSimulation<grpc::ServerWriteReactor<cwspb::ResponseCell>>(
+        registry, context, [&](SimulationInterface & interface) {
+      cwspb::ResponseCell error;
+
+      auto map = interface.getMap();
+      bool failed = !verifyMapCreated(map, *error.mutable_base());
+      Dimension dim = failed ? Dimension{0, 0} : map->getDimension();
+
+      // cells are produced one by one while previous one is written
+      Coordinates c{0, 0};
+      auto next = [map, dim, c, failed, error](cwspb::ResponseCell & response) mutable {
+        if (failed) {
+          response = error;
+          failed = false;
+          return true;
+        }
+        if (c.x >= dim.width || c.y >= dim.height) {
+          return false;
+        }
+
+        toCell(*response.mutable_cell(), map->getLayers(), c);
+        if (++c.y == dim.height) {
+          c.y = 0;
+          ++c.x;
+        }
+        return true;
+      };
+
+      return new StreamWriter<cwspb::ResponseCell>(std::move(next));
+    });
   }
 
-  grpc::Status GetSubject(::grpc::ServerContext * context,
-                          const cwspb::RequestSelectSubject * request,
-                          cwspb::ResponseSelectSubject * response) override {
-    auto & respBase = *response->mutable_base();
+  grpc::ServerUnaryReactor *
+  GetSubject(::grpc::CallbackServerContext * context,
+             const cwspb::RequestSelectSubject * request,
+             cwspb::ResponseSelectSubject * response) override {
+    return withSimulation(registry, context, [&](SimulationInterface & interface) {
+      auto & respBase = *response->mutable_base();
 
-    auto map = interface.getMap();
-    if (!verifyMapCreated(map, respBase)) {
-      return grpc::Status::OK;
-    }
+      auto map = interface.getMap();
+      if (!verifyMapCreated(map, respBase)) {
+        return reply(context);
+      }
 
-    auto dimension = map->getDimension();
+      auto dimension = map->getDimension();
 
-    Coordinates coord = fromCoordinates(request->id().coordinates());
-    if (!verifyCoordinates(coord, dimension, respBase)) {
-      return grpc::Status::OK;
-    }
+      Coordinates coord = fromCoordinates(request->id().coordinates());
+      if (!verifyCoordinates(coord, dimension, respBase)) {
+        return reply(context);
+      }
 
-    Subject::Id id = fromSubjectId(request->id().id());
+      Subject::Id id = fromSubjectId(request->id().id());
 
-    SubjectSelectQuery query(coord, id);
-    auto res = map->select(std::move(query));
+      SubjectSelectQuery query(coord, id);
+      auto res = map->select(std::move(query));
 
-    if (res == nullptr) {
-      auto status = respBase.mutable_status();
-      status->set_text("subject doesn't exist");
-      status->set_type(cwspb::ErrorType::ERROR_TYPE_BAD_REQUEST);
-    } else {
-      toSubjectAny(*response->mutable_subject(), *res);
-    }
+      if (res == nullptr) {
+        auto status = respBase.mutable_status();
+        status->set_text("subject doesn't exist");
+        status->set_type(cwspb::ErrorType::ERROR_TYPE_BAD_REQUEST);
+      } else {
+        toSubjectAny(*response->mutable_subject(), *res);
+      }
 
-    return grpc::Status::OK;
+      return reply(context);
+    });
   }
 
-  grpc::Status SetSubject(::grpc::ServerContext * context,
-                          const cwspb::RequestModifySubject * request,
-                          cwspb::Response * response) override {
+  grpc::ServerUnaryReactor *
+  SetSubject(::grpc::CallbackServerContext * context,
+             const cwspb::RequestModifySubject * request,
+             cwspb::Response * response) override {
+    return withSimulation(registry, context, [&](SimulationInterface & interface) {
 
-    auto map = interface.getMap();
-    if (!verifyMapCreated(map, *response)) {
-      return grpc::Status::OK;
-    }
+      auto map = interface.getMap();
+      if (!verifyMapCreated(map, *response)) {
+        return reply(context);
+      }
 
-    SubjectModifyType queryType = fromSubjectModifyType(request->modify_type());
+      SubjectModifyType queryType = fromSubjectModifyType(request->modify_type());
 
-    Subject::Id id;
-    Coordinates coordinates;
-    fromSubjectId(id, coordinates, request->id());
+      Subject::Id id;
+      Coordinates coordinates;
+      fromSubjectId(id, coordinates, request->id());
 
-    if (!verifyCoordinates(coordinates, map->getDimension(), *response)) {
-      return grpc::Status::OK;
-    }
+      if (!verifyCoordinates(coordinates, map->getDimension(), *response)) {
+        return reply(context);
+      }
 
-    auto subject = fromSubjectAny(request->subject());
-    interface.addModifyQuery(
-        SubjectModifyQuery(queryType, coordinates, std::move(subject)));
+      auto subject = fromSubjectAny(request->subject());
+      interface.addModifyQuery(
+          SubjectModifyQuery(queryType, coordinates, std::move(subject)));
 
-    return grpc::Status::OK;
+      return reply(context);
+    });
   }
 
-  grpc::Status GetAir(::grpc::ServerContext * context,
-                      const cwspb::RequestSelectAir * request,
-                      cwspb::ResponseSelectAir * response) override {
-    auto & respBase = *response->mutable_base();
+  grpc::ServerUnaryReactor *
+  GetAir(::grpc::CallbackServerContext * context,
+         const cwspb::RequestSelectAir * request,
+         cwspb::ResponseSelectAir * response) override {
+    return withSimulation(registry, context, [&](SimulationInterface & interface) {
+      auto & respBase = *response->mutable_base();
 
-    auto map = interface.getMap();
-    if (!verifyMapCreated(map, respBase)) {
-      return grpc::Status::OK;
-    }
+      auto map = interface.getMap();
+      if (!verifyMapCreated(map, respBase)) {
+        return reply(context);
+      }
 
-    auto dimension = map->getDimension();
+      auto dimension = map->getDimension();
 
-    Coordinates coord = fromCoordinates(request->id().coordinates());
-    if (!verifyCoordinates(coord, dimension, respBase)) {
-      return grpc::Status::OK;
-    }
+      Coordinates coord = fromCoordinates(request->id().coordinates());
+      if (!verifyCoordinates(coord, dimension, respBase)) {
+        return reply(context);
+      }
 
-    Air::Id id = fromAirId(request->id().id());
+      Air::Id id = fromAirId(request->id().id());
 
-    AirSelectQuery query(coord, id);
-    auto res = map->select(std::move(query));
+      AirSelectQuery query(coord, id);
+      auto res = map->select(std::move(query));
 
-    if (res == nullptr) {
-      auto status = respBase.mutable_status();
-      status->set_text("subject doesn't exist");
-      status->set_type(cwspb::ErrorType::ERROR_TYPE_BAD_REQUEST);
-    } else {
-      toAirPlain(*response->mutable_air(), *res);
-    }
+      if (res == nullptr) {
+        auto status = respBase.mutable_status();
+        status->set_text("subject doesn't exist");
+        status->set_type(cwspb::ErrorType::ERROR_TYPE_BAD_REQUEST);
+      } else {
+        toAirPlain(*response->mutable_air(), *res);
+      }
 
-    return grpc::Status::OK;
+      return reply(context);
+    });
   }
 
-  grpc::Status InsertAir(::grpc::ServerContext * context,
-                         const cwspb::RequestInsertAir * request,
-                         cwspb::Response * response) override {
+  grpc::ServerUnaryReactor *
+  InsertAir(::grpc::CallbackServerContext * context,
+            const cwspb::RequestInsertAir * request,
+            cwspb::Response * response) override {
+    return withSimulation(registry, context, [&](SimulationInterface & interface) {
 
-    auto map = interface.getMap();
-    if (!verifyMapCreated(map, *response)) {
-      return grpc::Status::OK;
-    }
+      auto map = interface.getMap();
+      if (!verifyMapCreated(map, *response)) {
+        return reply(context);
+      }
 
-    Coordinates coordinates = fromCoordinates(request->coordinates());
-    if (!verifyCoordinates(coordinates, map->getDimension(), *response)) {
-      return grpc::Status::OK;
-    }
+      Coordinates coordinates = fromCoordinates(request->coordinates());
+      if (!verifyCoordinates(coordinates, map->getDimension(), *response)) {
+        return reply(context);
+      }
 
-    auto air = fromAirPlain(request->air());
-    std::cout << air->getId() << std::endl;
+      auto air = fromAirPlain(request->air());
+      CWS_LOG_DEBUG("map", "insert air " << air->getId() << " at " << coordinates);
 
-    interface.addModifyQuery(AirInsertQuery(coordinates, std::move(air)));
+      interface.addModifyQuery(AirInsertQuery(coordinates, std::move(air)));
 
-    return grpc::Status::OK;
+      return reply(context);
+    });
   }
 
 private:
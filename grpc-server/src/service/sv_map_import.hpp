@@ -0,0 +1,168 @@
+#pragma once
+
+#include "converters.hpp"
+#include "cws/log.hpp"
+#include "cws/simulation/import.hpp"
+#include "cwspb/service/sv_map_import.grpc.pb.h"
+#include "registry.hpp"
+#include "service/reactor.hpp"
+#include "service/verify.hpp"
+#include <cmath>
+#include <grpcpp/support/server_callback.h>
+#include <grpcpp/support/status.h>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+/*
+ * Reads chunks of import until client closes stream, then chunks are converted and
+ * checked by threads of importer and whole import is queued as one query. It is
+ * done on own thread, so grpc threads are not blocked. Deletes itself when call is
+ * done
+ */
+class MapImportReader final : public grpc::ServerReadReactor<cwspb::RequestImportMap> {
+  std::shared_ptr<SimulationRegistry::Simulation> simulation_;// kept until done
+  SimulationInterface & interface_;
+  grpc::CallbackServerContext * context_;
+  cwspb::ResponseImportMap & response_;
+
+  cwspb::RequestImportMap request_;
+  std::vector<std::shared_ptr<const cwspb::RequestImportMap>> chunks_;
+  Optional<Dimension> dimension_;
+
+public:
+  MapImportReader(std::shared_ptr<SimulationRegistry::Simulation> simulation,
+                  grpc::CallbackServerContext * context,
+                  cwspb::ResponseImportMap & response)
+      : simulation_(std::move(simulation)), interface_(simulation_->interface),
+        context_(context), response_(response) {
+    StartRead(&request_);
+  }
+
+  void OnReadDone(bool ok) override {
+    if (!ok) {
+      std::thread([this] { build(); }).detach();
+      return;
+    }
+
+    if (chunks_.empty() && request_.has_dimension()) {
+      dimension_.set(fromDimension(request_.dimension()));
+    }
+    chunks_.push_back(
+        std::make_shared<const cwspb::RequestImportMap>(std::move(request_)));
+    request_.Clear();
+    StartRead(&request_);
+  }
+
+  void OnDone() override { delete this; }
+
+private:
+  void build() {
+    if (context_->IsCancelled()) {
+      Finish(grpc::Status::CANCELLED);
+      return;
+    }
+
+    auto & respBase = *response_.mutable_base();
+    std::shared_ptr<const SimulationMap> map;
+    Dimension dimension{0, 0};
+    if (dimension_.isSet()) {
+      dimension = dimension_.get();
+    } else {
+      map = interface_.getMap();
+      if (!verifyMapCreated(map, respBase)) {
+        Finish(grpc::Status::OK);
+        return;
+      }
+      dimension = map->getDimension();
+    }
+
+    MapImporter importer(dimension, map.get());
+    for (auto & chunk : chunks_) {
+      importer.add([chunk] { return fromImportMap(*chunk); });
+    }
+    chunks_.clear();
+
+    try {
+      if (dimension.width <= 0 || dimension.height <= 0) {
+        throw std::invalid_argument("map import: bad dimension");
+      }
+      auto query = importer.build();
+      response_.set_subjects(query.subjects.size());
+      response_.set_air(query.air.size());
+
+      // dimension is taken first, so import is applied on new map
+      if (dimension_.isSet() && !interface_.setDimension(dimension)) {
+        throw std::invalid_argument("map import: map exceeds cell limit");
+      }
+      interface_.addModifyQuery(std::move(query));
+      CWS_LOG_INFO("map", "import queued, subjects: " << response_.subjects()
+                                                      << ", air: " << response_.air());
+    } catch (const std::invalid_argument & e) {
+      auto status = respBase.mutable_status();
+      status->set_text(e.what());
+      status->set_type(cwspb::ErrorType::ERROR_TYPE_BAD_REQUEST);
+    }
+    Finish(grpc::Status::OK);
+  }
+};
+
+class MapImportService final : public cwspb::MapImportService::CallbackService {
+private:
+  SimulationRegistry & registry;
+
+public:
+  MapImportService(SimulationRegistry & registry) : registry(registry) {}
+
+  grpc::ServerReadReactor<cwspb::RequestImportMap> *
+  ImportMap(::grpc::CallbackServerContext * context,
+            cwspb::ResponseImportMap * response) override {
+    return withSimulation<grpc::ServerReadReactor<cwspb::RequestImportMap>>(
+        registry, context, [&](SimulationPtr simulation) {
+          return new MapImportReader(std::move(simulation), context, *response);
+        });
+  }
+
+  grpc::ServerUnaryReactor *
+  ModifyAirRegion(::grpc::CallbackServerContext * context,
+                  const cwspb::RequestModifyAirRegion * request,
+                  cwspb::Response * response) override {
+    return withSimulation(registry, context, [&](SimulationInterface & interface) {
+      auto map = interface.getMap();
+      if (!verifyMapCreated(map, *response)) {
+        return reply(context);
+      }
+
+      auto query = fromAirRegion(*request);
+      const char * error = nullptr;
+      if (query.queryType < AirRegionModifyType::FILL ||
+          query.queryType > AirRegionModifyType::SET_TEMPERATURE) {
+        error = "modify type is not specified";
+      } else if (query.region.polygon.empty() &&
+                 (query.region.size.width <= 0 || query.region.size.height <= 0)) {
+        error = "region is empty";
+      } else if (!query.region.polygon.empty() && query.region.polygon.size() < 3) {
+        error = "polygon should have at least 3 vertices";
+      } else if (query.queryType == AirRegionModifyType::FILL && !query.air) {
+        error = "air to fill is not set";
+      } else if (query.queryType == AirRegionModifyType::SCALE &&
+                 (!std::isfinite(query.factor) || query.factor < 0)) {
+        error = "factor should be finite and not negative";
+      } else if (query.queryType == AirRegionModifyType::SET_TEMPERATURE &&
+                 !std::isfinite(query.temperature.get())) {
+        error = "temperature should be finite";
+      }
+
+      if (error) {
+        auto status = response->mutable_status();
+        status->set_text(error);
+        status->set_type(cwspb::ErrorType::ERROR_TYPE_BAD_REQUEST);
+        return reply(context);
+      }
+
+      interface.addModifyQuery(std::move(query));
+      return reply(context);
+    });
+  }
+};
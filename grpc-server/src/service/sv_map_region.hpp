@@ -0,0 +1,212 @@
+#pragma once
+
+#include "converters.hpp"
+#include "cwspb/service/sv_map_region.grpc.pb.h"
+#include "registry.hpp"
+#include "service/reactor.hpp"
+#include "service/verify.hpp"
+#include <algorithm>
+#include <grpcpp/support/status.h>
+
+/*
+ * Streams rectangle of map as tiles with packed arrays of requested layers, so
+ * neither server nor client holds message for whole map
+ */
+class MapRegionService final : public cwspb::MapRegionService::Service {
+private:
+  static constexpr int DEFAULT_CHUNK_SIZE = 64;
+  static constexpr int MAX_CHUNK_SIZE = 256;
+
+  SimulationRegistry & registry;
+
+public:
+  MapRegionService(SimulationRegistry & registry) : registry(registry) {}
+
+  grpc::Status
+  GetMapRegion(::grpc::ServerContext * context, const cwspb::RequestMapRegion * request,
+               grpc::ServerWriter<::cwspb::ResponseMapTile> * writer) override {
+    return withSimulation(registry, context, [&](SimulationInterface & interface) {
+      cwspb::ResponseMapTile response;
+
+      // all tiles are taken from single snapshot
+      auto map = interface.getMap();
+      MapRegion region;
+      std::uint32_t layerMask;
+      if (!verifyRegion(*request, map, region, layerMask, *response.mutable_base())) {
+        writer->WriteLast(response, grpc::WriteOptions());
+        return grpc::Status::OK;
+      }
+
+      // clamped while unsigned, values above INT_MAX would turn negative as int
+      int chunk = request->chunk_size() == 0
+                      ? DEFAULT_CHUNK_SIZE
+                      : static_cast<int>(std::min<std::uint32_t>(request->chunk_size(),
+                                                                 MAX_CHUNK_SIZE));
+
+      const auto & layers = map->getLayers();
+      int endX = region.origin.x + region.size.width;
+      int endY = region.origin.y + region.size.height;
+
+      MapRegion tile;
+      for (tile.origin.y = region.origin.y; tile.origin.y < endY;
+           tile.origin.y += chunk) {
+        for (tile.origin.x = region.origin.x; tile.origin.x < endX;
+             tile.origin.x += chunk) {
+          if (context->IsCancelled()) {
+            return grpc::Status::CANCELLED;
+          }
+
+          tile.size.width = std::min(chunk, endX - tile.origin.x);
+          tile.size.height = std::min(chunk, endY - tile.origin.y);
+
+          response.Clear();
+          response.mutable_base()->mutable_status();
+          toMapTile(*response.mutable_tile(), layers, tile, layerMask);
+          writer->Write(response);
+        }
+      }
+      return grpc::Status::OK;
+    });
+  }
+
+  grpc::Status
+  GetMapRegionCells(::grpc::ServerContext * context,
+                    const cwspb::RequestMapRegion * request,
+                    grpc::ServerWriter<::cwspb::ResponseCell> * writer) override {
+    return withSimulation(registry, context, [&](SimulationInterface & interface) {
+      cwspb::ResponseCell response;
+
+      auto map = interface.getMap();
+      MapRegion region;
+      std::uint32_t layerMask;
+      if (!verifyRegion(*request, map, region, layerMask, *response.mutable_base())) {
+        writer->WriteLast(response, grpc::WriteOptions());
+        return grpc::Status::OK;
+      }
+
+      const auto & layers = map->getLayers();
+
+      Coordinates c;
+      for (c.y = region.origin.y; c.y < region.origin.y + region.size.height; ++c.y) {
+        if (context->IsCancelled()) {
+          return grpc::Status::CANCELLED;
+        }
+        for (c.x = region.origin.x; c.x < region.origin.x + region.size.width; ++c.x) {
+          response.Clear();
+          toCell(*response.mutable_cell(), layers, c, layerMask);
+          writer->Write(response);
+        }
+      }
+      return grpc::Status::OK;
+    });
+  }
+
+  grpc::Status
+  SubscribeMap(::grpc::ServerContext * context,
+               const cwspb::RequestSubscribeMap * request,
+               grpc::ServerWriter<::cwspb::ResponseMapDelta> * writer) override {
+    return withSimulation(registry, context, [&](SimulationPtr simulation) {
+      auto & tracker = simulation->getTracker();
+      cwspb::ResponseMapDelta response;
+      auto & respBase = *response.mutable_base();
+
+      std::uint32_t layerMask =
+          request->layers() == 0 ? MAP_LAYER_MASK_SCALAR : request->layers();
+      if (request->fields_size() > 0) {
+        auto fieldMask = fromFieldMask(request->fields());
+        if (!fieldMask) {
+          auto status = respBase.mutable_status();
+          status->set_text("unknown field in mask");
+          status->set_type(cwspb::ErrorType::ERROR_TYPE_BAD_REQUEST);
+          writer->WriteLast(response, grpc::WriteOptions());
+          return grpc::Status::OK;
+        }
+        layerMask = *fieldMask;
+      }
+      layerMask &= MAP_LAYER_MASK_SCALAR;
+
+      tracker.subscribe();
+      std::size_t sequence = 0;
+      std::vector<Coordinates> cells;
+
+      while (!context->IsCancelled()) {
+        auto changes = tracker.wait(sequence, std::chrono::milliseconds(200));
+        if (changes == nullptr) {
+          continue;
+        }
+
+        // first message and missed changes are replaced with all cells
+        bool full = sequence == 0 || changes->full || changes->sequence != sequence + 1;
+        sequence = changes->sequence;
+
+        cells.clear();
+        if (full) {
+          auto dim = changes->map->getDimension();
+          Coordinates c;
+          for (c.y = 0; c.y < dim.height; ++c.y) {
+            for (c.x = 0; c.x < dim.width; ++c.x) {
+              cells.push_back(c);
+            }
+          }
+        } else {
+          for (std::size_t i = 0; i < changes->cells.size(); ++i) {
+            if (changes->layers[i] & layerMask) {
+              cells.push_back(changes->cells[i]);
+            }
+          }
+          if (cells.empty()) {
+            continue;
+          }
+        }
+
+        response.Clear();
+        response.mutable_base()->mutable_status();
+        auto & delta = *response.mutable_delta();
+        delta.set_tick(changes->tick);
+        delta.set_full(full);
+        toMapDelta(delta, changes->map->getLayers(), cells, layerMask);
+
+        if (!writer->Write(response)) {
+          break;
+        }
+      }
+
+      tracker.unsubscribe();
+      return grpc::Status::OK;
+    });
+  }
+
+private:
+  static bool verifyRegion(const cwspb::RequestMapRegion & request,
+                           const std::shared_ptr<const Map> & map, MapRegion & region,
+                           std::uint32_t & layerMask, cwspb::Response & respBase) {
+    if (!verifyMapCreated(map, respBase)) {
+      return false;
+    }
+
+    auto dimension = map->getDimension();
+    region = fromMapRegion(request, dimension);
+    if (!verifyCoordinates(region.origin, dimension, respBase)) {
+      return false;
+    }
+
+    auto status = respBase.mutable_status();
+    if (region.size.width == 0 || region.size.height == 0) {
+      status->set_text("region is empty");
+      status->set_type(cwspb::ErrorType::ERROR_TYPE_BAD_REQUEST);
+      return false;
+    }
+
+    layerMask = request.layers() == 0 ? MAP_LAYER_MASK_ALL : request.layers();
+    if (request.fields_size() > 0) {
+      auto fieldMask = fromFieldMask(request.fields());
+      if (!fieldMask) {
+        status->set_text("unknown field in mask");
+        status->set_type(cwspb::ErrorType::ERROR_TYPE_BAD_REQUEST);
+        return false;
+      }
+      layerMask = *fieldMask;
+    }
+    return true;
+  }
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "converters.hpp"
+#include "cwspb/service/sv_profiler.grpc.pb.h"
+#include "registry.hpp"
+#include "service/reactor.hpp"
+#include <grpcpp/support/status.h>
+#include <sstream>
+
+class ProfilerService final : public cwspb::ProfilerService::CallbackService {
+private:
+  SimulationRegistry & registry;
+
+public:
+  ProfilerService(SimulationRegistry & registry) : registry(registry) {}
+
+  grpc::ServerUnaryReactor *
+  GetTickProfile(::grpc::CallbackServerContext * context,
+                 const cwspb::Request * request,
+                 cwspb::ResponseTickProfile * response) override {
+    return withSimulation(registry, context, [&](SimulationInterface & interface) {
+      auto profile = interface.getProfiler().getProfile();
+      toTickProfile(*response->mutable_profile(), profile);
+      response->mutable_base()->mutable_status();
+
+      return reply(context);
+    });
+  }
+
+  grpc::ServerUnaryReactor *
+  GetTickTrace(::grpc::CallbackServerContext * context,
+               const cwspb::Request * request,
+               cwspb::ResponseTickTrace * response) override {
+    return withSimulation(registry, context, [&](SimulationInterface & interface) {
+      std::ostringstream trace;
+      interface.getProfiler().writeChromeTrace(trace);
+      response->set_trace(trace.str());
+      response->mutable_base()->mutable_status();
+
+      return reply(context);
+    });
+  }
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "cwspb/service/sv_registry.grpc.pb.h"
+#include "registry.hpp"
+#include "service/reactor.hpp"
+#include <grpcpp/support/status.h>
+
+class SimulationRegistryService final
+    : public cwspb::SimulationRegistryService::CallbackService {
+private:
+  SimulationRegistry & registry;
+
+public:
+  SimulationRegistryService(SimulationRegistry & registry) : registry(registry) {}
+
+  grpc::ServerUnaryReactor *
+  CreateSimulation(::grpc::CallbackServerContext * context,
+                   const cwspb::RequestSimulationId * request,
+                   cwspb::Response * response) override {
+    auto error = registry.create(request->id());
+    if (!error.empty()) {
+      auto status = response->mutable_status();
+      status->set_text(error);
+      status->set_type(cwspb::ErrorType::ERROR_TYPE_BAD_REQUEST);
+    }
+    return reply(context);
+  }
+
+  grpc::ServerUnaryReactor *
+  DeleteSimulation(::grpc::CallbackServerContext * context,
+                   const cwspb::RequestSimulationId * request,
+                   cwspb::Response * response) override {
+    if (!registry.remove(request->id())) {
+      auto status = response->mutable_status();
+      status->set_text("simulation doesn't exist");
+      status->set_type(cwspb::ErrorType::ERROR_TYPE_BAD_REQUEST);
+    }
+    return reply(context);
+  }
+
+  grpc::ServerUnaryReactor *
+  ListSimulations(::grpc::CallbackServerContext * context,
+                  const cwspb::Request * request,
+                  cwspb::ResponseSimulationIds * response) override {
+    for (auto & id : registry.list()) {
+      response->add_ids(std::move(id));
+    }
+    response->mutable_base()->mutable_status();
+    return reply(context);
+  }
+};
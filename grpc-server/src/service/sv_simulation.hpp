@@ -1,37 +1,44 @@
 #pragma once
 
 #include "converters.hpp"
-#include "cws/simulation/interface.hpp"
 #include "cwspb/service/sv_simulation.grpc.pb.h"
+#include "registry.hpp"
+#include "service/reactor.hpp"
 #include "service/verify.hpp"
 #include <grpcpp/support/status.h>
 
-class SimulationService final : public cwspb::SimulationService::Service {
+class SimulationService final : public cwspb::SimulationService::CallbackService {
 private:
-  SimulationInterface & interface;
+  SimulationRegistry & registry;
 
 public:
-  SimulationService(SimulationInterface & simulation) : interface(simulation) {}
+  SimulationService(SimulationRegistry & registry) : registry(registry) {}
 
-  grpc::Status GetSimulationState(::grpc::ServerContext * context,
-                                  const cwspb::Request * request,
-                                  cwspb::ResponseSimulationState * response) override {
-    auto stateI = interface.getState();
-    auto state = response->mutable_state();
-    toSimulationState(*state, stateI);
-    auto base = response->mutable_base();
-    auto status = base->mutable_status();
+  grpc::ServerUnaryReactor *
+  GetSimulationState(::grpc::CallbackServerContext * context,
+                     const cwspb::Request * request,
+                     cwspb::ResponseSimulationState * response) override {
+    return withSimulation(registry, context, [&](SimulationInterface & interface) {
+      auto stateI = interface.getState();
+      auto state = response->mutable_state();
+      toSimulationState(*state, stateI);
+      auto base = response->mutable_base();
+      auto status = base->mutable_status();
 
-    return grpc::Status::OK;
+      return reply(context);
+    });
   }
 
-  grpc::Status SetSimulationState(::grpc::ServerContext * context,
-                                  const cwspb::RequestSimulationState * request,
-                                  cwspb::Response * response) override {
-    const auto & stateI = request->state();
-    SimulationStateIn state = fromSimulationState(stateI);
-    interface.setState(state);
+  grpc::ServerUnaryReactor *
+  SetSimulationState(::grpc::CallbackServerContext * context,
+                     const cwspb::RequestSimulationState * request,
+                     cwspb::Response * response) override {
+    return withSimulation(registry, context, [&](SimulationInterface & interface) {
+      const auto & stateI = request->state();
+      SimulationStateIn state = fromSimulationState(stateI);
+      interface.setState(state);
 
-    return grpc::Status::OK;
+      return reply(context);
+    });
   }
 };
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "cws/simulation/import.hpp"
+#include "cws/simulation/snapshot.hpp"
+#include "cwspb/service/sv_snapshot.grpc.pb.h"
+#include "registry.hpp"
+#include "service/reactor.hpp"
+#include "service/verify.hpp"
+#include <filesystem>
+#include <grpcpp/support/status.h>
+#include <stdexcept>
+#include <system_error>
+
+/*
+ * Saves published map to file and restores it, imports subjects and air from file.
+ * Files are read and written on threads of sync server, so disk doesn't block
+ * callback services
+ */
+class SnapshotService final : public cwspb::SnapshotService::Service {
+private:
+  SimulationRegistry & registry;
+  std::filesystem::path directory;
+
+public:
+  SnapshotService(SimulationRegistry & registry, std::filesystem::path directory)
+      : registry(registry), directory(std::move(directory)) {}
+
+  grpc::Status SaveSnapshot(::grpc::ServerContext * context,
+                            const cwspb::RequestSnapshot * request,
+                            cwspb::ResponseSnapshot * response) override {
+    return withSimulation(registry, context, [&](SimulationInterface & interface) {
+      auto & respBase = *response->mutable_base();
+
+      std::filesystem::path path;
+      if (!verifyName(*context, request->name(), path, respBase)) {
+        return grpc::Status::OK;
+      }
+
+      auto snapshot = interface.waitMap(0, std::chrono::milliseconds(0));
+      if (!verifyMapCreated(snapshot.map, respBase)) {
+        return grpc::Status::OK;
+      }
+
+      try {
+        std::filesystem::create_directories(path.parent_path());
+        saveSnapshot(path.string(), *snapshot.map);
+        response->set_tick(snapshot.tick);
+        response->set_size(std::filesystem::file_size(path));
+      } catch (const std::exception & e) {
+        setError(e.what(), respBase);
+      }
+      return grpc::Status::OK;
+    });
+  }
+
+  grpc::Status LoadSnapshot(::grpc::ServerContext * context,
+                            const cwspb::RequestSnapshot * request,
+                            cwspb::ResponseSnapshot * response) override {
+    return withSimulation(registry, context, [&](SimulationInterface & interface) {
+      auto & respBase = *response->mutable_base();
+
+      std::filesystem::path path;
+      if (!verifyName(*context, request->name(), path, respBase)) {
+        return grpc::Status::OK;
+      }
+
+      try {
+        auto map = loadSnapshot(path.string());
+        response->set_size(std::filesystem::file_size(path));
+        if (!interface.setMap(std::move(map))) {
+          setError("map exceeds cell limit", respBase);
+        }
+      } catch (const std::exception & e) {
+        setError(e.what(), respBase);
+      }
+      return grpc::Status::OK;
+    });
+  }
+
+  grpc::Status ImportMapFile(::grpc::ServerContext * context,
+                             const cwspb::RequestSnapshot * request,
+                             cwspb::ResponseImportMap * response) override {
+    return withSimulation(registry, context, [&](SimulationInterface & interface) {
+      auto & respBase = *response->mutable_base();
+
+      std::filesystem::path path;
+      if (!verifyName(*context, request->name(), path, respBase)) {
+        return grpc::Status::OK;
+      }
+
+      try {
+        auto map = interface.getMap();
+        auto loaded = loadMapImport(path.string(), map.get());
+        response->set_subjects(loaded.query.subjects.size());
+        response->set_air(loaded.query.air.size());
+        if (loaded.dimension.isSet() &&
+            !interface.setDimension(loaded.dimension.get())) {
+          setError("map exceeds cell limit", respBase);
+          return grpc::Status::OK;
+        }
+        interface.addModifyQuery(std::move(loaded.query));
+      } catch (const std::exception & e) {
+        setError(e.what(), respBase);
+      }
+      return grpc::Status::OK;
+    });
+  }
+
+private:
+  static void setError(const std::string & text, cwspb::Response & respBase) {
+    auto status = respBase.mutable_status();
+    status->set_text(text);
+    status->set_type(cwspb::ErrorType::ERROR_TYPE_BAD_REQUEST);
+  }
+
+  /*
+   * Plain file name only, so clients can't reach outside of snapshot directory.
+   * Files of simulations created by clients are kept in subdirectory of their id
+   */
+  bool verifyName(const grpc::ServerContextBase & context, const std::string & name,
+                  std::filesystem::path & path, cwspb::Response & respBase) const {
+    if (name.empty() || name == "." || name == ".." ||
+        name.find('/') != std::string::npos) {
+      setError("bad snapshot name", respBase);
+      return false;
+    }
+    path = directory / SimulationRegistry::getId(context) / name;
+    return true;
+  }
+};
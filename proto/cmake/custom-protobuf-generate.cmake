@@ -3,8 +3,8 @@ function(custom_protobuf_generate)
   # find_program(protobuf::protoc)
 
   set(_options)
-  set(_singleargs LANGUAGE PROTOC_OUT_DIR PLUGIN PROTO_ROOT)
-  set(_multiargs IMPORT_DIRS GENERATE_EXTENSIONS)
+  set(_singleargs LANGUAGE PROTOC_OUT_DIR PLUGIN)
+  set(_multiargs IMPORT_DIRS GENERATE_EXTENSIONS PROTO_ROOT)
   if(COMMAND target_sources)
     list(APPEND _singleargs TARGET)
   endif()
@@ -33,7 +33,18 @@ function(custom_protobuf_generate)
   set(_generated_srcs_all)
 
   foreach(_source ${_proto_list})
-    file(RELATIVE_PATH _source_rel ${protobuf_generate_PROTO_ROOT} ${_source})
+    # path relative to the root source belongs to
+    set(_source_rel)
+    foreach(_root ${protobuf_generate_PROTO_ROOT})
+      file(RELATIVE_PATH _rel ${_root} ${_source})
+      if(NOT _rel MATCHES "^\\.\\./")
+        set(_source_rel ${_rel})
+        break()
+      endif()
+    endforeach()
+    if(NOT _source_rel)
+      message(FATAL_ERROR "${_source} is not under any of PROTO_ROOT")
+    endif()
 
     get_filename_component(_source_rel_dir ${_source_rel} DIRECTORY)
     get_filename_component(_source_name_we ${_source_rel} NAME_WE)